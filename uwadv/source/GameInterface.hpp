@@ -26,6 +26,7 @@ namespace Base
    class Settings;
    class ResourceManager;
    class SavegamesManager;
+   class PerformanceCounters;
 }
 namespace Audio
 {
@@ -105,6 +106,9 @@ public:
    /// returns user interface instance; may be null
    virtual IUserInterface* GetUserInterface() = 0;
 
+   /// returns performance counters object
+   virtual Base::PerformanceCounters& GetPerformanceCounters() = 0;
+
    /// initializes game; only called after all stuff is initialized and ready
    virtual void InitGame() = 0;
 
@@ -0,0 +1,67 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CpuFeatures.cpp
+/// \brief CPU feature detection for SIMD kernels
+//
+#include "pch.hpp"
+#include "CpuFeatures.hpp"
+#include <SDL_cpuinfo.h>
+
+bool Base::IsSimdKernelSupported(SimdKernel kernel)
+{
+   switch (kernel)
+   {
+   case kernelScalar:
+      return true;
+
+#ifdef HAVE_X86_INTRINSICS
+   case kernelSSE2:
+      return SDL_HasSSE2() == SDL_TRUE;
+
+   case kernelAVX2:
+      return SDL_HasAVX2() == SDL_TRUE;
+#endif
+
+   default:
+      return false;
+   }
+}
+
+/// The best kernel type is determined once, on the first call.
+Base::SimdKernel Base::GetBestSimdKernel()
+{
+   static SimdKernel s_bestKernel =
+      IsSimdKernelSupported(kernelAVX2) ? kernelAVX2 :
+      IsSimdKernelSupported(kernelSSE2) ? kernelSSE2 : kernelScalar;
+
+   return s_bestKernel;
+}
+
+const char* Base::GetSimdKernelName(SimdKernel kernel)
+{
+   switch (kernel)
+   {
+   case kernelScalar: return "scalar";
+   case kernelSSE2: return "SSE2";
+   case kernelAVX2: return "AVX2";
+   default:
+      UaAssertMsg(false, "invalid SIMD kernel");
+      return "unknown";
+   }
+}
@@ -0,0 +1,63 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CpuFeatures.hpp
+/// \brief CPU feature detection for SIMD kernels
+/// \details
+/// Defines HAVE_X86_INTRINSICS when compiling for x86 or x64, and includes
+/// the SSE2 and AVX2 intrinsics headers then. Functions using AVX2
+/// intrinsics must be marked with TARGET_AVX2, since gcc and clang only
+/// compile them with the target attribute when AVX2 isn't enabled for the
+/// whole project.
+//
+#pragma once
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define HAVE_X86_INTRINSICS
+#include <emmintrin.h>
+#include <immintrin.h>
+#endif
+
+#if defined(HAVE_X86_INTRINSICS) && defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+namespace Base
+{
+   /// \brief instruction set used by a SIMD kernel
+   /// The values are ordered; a CPU that supports a kernel type also
+   /// supports all kernel types with a lower value.
+   enum SimdKernel
+   {
+      kernelScalar = 0, ///< plain scalar loop; always available
+      kernelSSE2,       ///< kernel using SSE2 instructions
+      kernelAVX2,       ///< kernel using AVX2 instructions
+   };
+
+   /// returns if given kernel type is supported on this CPU
+   bool IsSimdKernelSupported(SimdKernel kernel);
+
+   /// returns best kernel type supported on this CPU
+   SimdKernel GetBestSimdKernel();
+
+   /// returns name of kernel type
+   const char* GetSimdKernelName(SimdKernel kernel);
+
+} // namespace Base
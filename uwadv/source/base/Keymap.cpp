@@ -127,6 +127,8 @@ namespace Detail
       { "ua-screenshot",  Base::keyUaScreenshot },
       { "ua-level-up",    Base::keyUaLevelUp },
       { "ua-level-down" , Base::keyUaLevelDown },
+      { "ua-performance-hud", Base::keyUaPerformanceHud },
+      { "ua-capture-frames",  Base::keyUaCaptureFrames },
    };
 
 
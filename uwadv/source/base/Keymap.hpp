@@ -118,6 +118,8 @@ namespace Base
       keyUaScreenshot,  ///< alt c, takes screenshot
       keyUaLevelUp,     ///< alt page up, only in debug mode
       keyUaLevelDown,   ///< alt page down, only in debug mode
+      keyUaPerformanceHud, ///< alt p, toggles performance HUD
+      keyUaCaptureFrames,  ///< alt v, starts or stops capturing frames
 
       keyNone
    };
@@ -0,0 +1,114 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PerformanceCounters.cpp
+/// \brief per-frame performance counters
+//
+#include "pch.hpp"
+#include "PerformanceCounters.hpp"
+#include <algorithm>
+
+using Base::PerformanceCounters;
+
+PerformanceCounters::PerformanceCounters()
+   :m_isEnabled(false),
+   m_ticksPerMillisecond(SDL_GetPerformanceFrequency() / 1000.0),
+   m_nextHistoryIndex(0)
+{
+   for (std::atomic<Uint64>& frameTime : m_currentFrameTimes)
+      frameTime = 0;
+}
+
+/// The history is allocated when the counters are enabled for the first time.
+/// \param enabled indicates if the counters should be enabled
+void PerformanceCounters::SetEnabled(bool enabled)
+{
+   m_isEnabled = enabled;
+
+   for (std::atomic<Uint64>& frameTime : m_currentFrameTimes)
+      frameTime = 0;
+   m_nextHistoryIndex = 0;
+
+   for (std::vector<float>& history : m_frameTimeHistory)
+      history.assign(enabled ? s_historySize : 0, 0.0f);
+}
+
+void PerformanceCounters::NextFrame()
+{
+   if (!m_isEnabled)
+      return;
+
+   for (size_t phase = 0; phase < phaseMax; phase++)
+   {
+      m_frameTimeHistory[phase][m_nextHistoryIndex] =
+         static_cast<float>(m_currentFrameTimes[phase].exchange(0) / m_ticksPerMillisecond);
+   }
+
+   m_nextHistoryIndex = (m_nextHistoryIndex + 1) % s_historySize;
+}
+
+/// \param phase phase to return time for
+/// \param frameIndex frame index in history; 0 is the oldest frame
+double PerformanceCounters::GetFrameTime(PerformancePhase phase, size_t frameIndex) const
+{
+   UaAssert(frameIndex < s_historySize);
+
+   const std::vector<float>& history = m_frameTimeHistory[phase];
+   if (history.empty())
+      return 0.0;
+
+   return history[(m_nextHistoryIndex + frameIndex) % s_historySize];
+}
+
+double PerformanceCounters::GetAverageTime(PerformancePhase phase) const
+{
+   const std::vector<float>& history = m_frameTimeHistory[phase];
+   if (history.empty())
+      return 0.0;
+
+   double sum = 0.0;
+   for (float time : history)
+      sum += time;
+
+   return sum / history.size();
+}
+
+double PerformanceCounters::GetMaxTime(PerformancePhase phase) const
+{
+   const std::vector<float>& history = m_frameTimeHistory[phase];
+   if (history.empty())
+      return 0.0;
+
+   return *std::max_element(history.begin(), history.end());
+}
+
+const char* PerformanceCounters::GetPhaseName(PerformancePhase phase)
+{
+   switch (phase)
+   {
+   case phaseTick: return "tick";
+   case phaseEvaluateUnderworld: return "logic";
+   case phaseEvaluatePhysics: return "physics";
+   case phaseLua: return "lua";
+   case phaseRender: return "render";
+   case phaseSwap: return "swap";
+   default:
+      UaAssertMsg(false, "invalid performance phase");
+      return "unknown";
+   }
+}
@@ -0,0 +1,146 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PerformanceCounters.hpp
+/// \brief per-frame performance counters
+//
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+namespace Base
+{
+   /// \brief phases of a frame that are timed
+   /// The phases may overlap; e.g. the tick phase contains the time for
+   /// evaluating the underworld and the physics.
+   enum PerformancePhase
+   {
+      phaseTick = 0,             ///< all game ticks of a frame
+      phaseEvaluateUnderworld,   ///< GameLogic::EvaluateUnderworld()
+      phaseEvaluatePhysics,      ///< PhysicsModel::EvaluatePhysics()
+      phaseLua,                  ///< calls into Lua scripts
+      phaseRender,               ///< drawing the current screen
+      phaseSwap,                 ///< swapping screen buffers
+      phaseMax                   ///< number of phases
+   };
+
+   /// \brief Performance counters for the phases of a frame
+   /// Times of a frame are accumulated using StartTiming() and StopTiming(),
+   /// or using a PerformanceTimer object. NextFrame() stores the accumulated
+   /// times in a history of the last frames. When the counters are disabled,
+   /// no timing is done at all. Timings may be accumulated from the
+   /// simulation thread, too; all other methods must be called from the main
+   /// thread.
+   class PerformanceCounters
+   {
+   public:
+      /// number of frames stored in history
+      static const size_t s_historySize = 128;
+
+      /// ctor
+      PerformanceCounters();
+
+      /// returns if performance counters are enabled
+      bool IsEnabled() const { return m_isEnabled; }
+
+      /// enables or disables performance counters; clears history
+      void SetEnabled(bool enabled);
+
+      /// starts timing a phase; returns start counter value
+      Uint64 StartTiming() const
+      {
+         return m_isEnabled ? SDL_GetPerformanceCounter() : 0;
+      }
+
+      /// stops timing a phase and adds the time to the current frame
+      void StopTiming(PerformancePhase phase, Uint64 start)
+      {
+         if (m_isEnabled)
+            m_currentFrameTimes[phase] += SDL_GetPerformanceCounter() - start;
+      }
+
+      /// stores times of the current frame in the history and starts a new frame
+      void NextFrame();
+
+      /// returns time of a phase in milliseconds, for a frame in the history;
+      /// frame 0 is the oldest, frame s_historySize - 1 the most recent one
+      double GetFrameTime(PerformancePhase phase, size_t frameIndex) const;
+
+      /// returns average time of a phase in milliseconds, over all frames in history
+      double GetAverageTime(PerformancePhase phase) const;
+
+      /// returns maximum time of a phase in milliseconds, over all frames in history
+      double GetMaxTime(PerformancePhase phase) const;
+
+      /// returns short display name of phase
+      static const char* GetPhaseName(PerformancePhase phase);
+
+   private:
+      /// indicates if counters are enabled
+      std::atomic<bool> m_isEnabled;
+
+      /// performance counter ticks per millisecond
+      double m_ticksPerMillisecond;
+
+      /// accumulated performance counter ticks of the current frame
+      std::array<std::atomic<Uint64>, phaseMax> m_currentFrameTimes;
+
+      /// ring buffer with frame times of the last frames, in milliseconds
+      std::array<std::vector<float>, phaseMax> m_frameTimeHistory;
+
+      /// index of the next frame to store in the ring buffer
+      size_t m_nextHistoryIndex;
+   };
+
+   /// \brief Times a phase as long as the object lives
+   class PerformanceTimer
+   {
+   public:
+      /// ctor; starts timing
+      PerformanceTimer(PerformanceCounters& counters, PerformancePhase phase)
+         :m_counters(counters),
+         m_phase(phase),
+         m_start(counters.StartTiming())
+      {
+      }
+
+      /// dtor; stops timing
+      ~PerformanceTimer()
+      {
+         m_counters.StopTiming(m_phase, m_start);
+      }
+
+      /// deleted copy ctor
+      PerformanceTimer(const PerformanceTimer&) = delete;
+      /// deleted assignment operator
+      PerformanceTimer& operator=(const PerformanceTimer&) = delete;
+
+   private:
+      /// performance counters to add time to
+      PerformanceCounters& m_counters;
+
+      /// phase to time
+      PerformancePhase m_phase;
+
+      /// start counter value
+      Uint64 m_start;
+   };
+
+} // namespace Base
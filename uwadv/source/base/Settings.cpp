@@ -51,6 +51,17 @@ namespace Detail
       { "cutscene-narration",    Base::settingCutsceneNarration },
       { "audio-enabled",         Base::settingAudioEnabled },
       { "win32-midi-device",     Base::settingWin32MidiDevice },
+      { "texture-cache-folder",  Base::settingTextureCacheFolder },
+      { "texture-cache-size",    Base::settingTextureCacheSize },
+      { "texture-memory-budget", Base::settingTextureMemoryBudget },
+      { "simulation-thread",     Base::settingSimulationThread },
+      { "max-frame-rate",        Base::settingMaxFrameRate },
+      { "capture-folder",        Base::settingCaptureFolder },
+      { "capture-interval",      Base::settingCaptureInterval },
+      { "palette-shader",        Base::settingPaletteShader },
+      { "palette-smoothing",     Base::settingPaletteSmoothing },
+      { "dynamic-resolution",    Base::settingDynamicResolution },
+      { "render-time-budget",    Base::settingRenderTimeBudget },
    };
 
 } // namespace Detail
@@ -69,6 +80,17 @@ Settings::Settings()
    SetValue(settingFullscreen, false);
    SetValue(settingCutsceneNarration, std::string("sound"));
    SetValue(settingWin32MidiDevice, -1);
+   SetValue(settingTextureCacheFolder, std::string("%uahome%/cache/"));
+   SetValue(settingTextureCacheSize, 64);
+   SetValue(settingTextureMemoryBudget, 256);
+   SetValue(settingSimulationThread, false);
+   SetValue(settingMaxFrameRate, 0);
+   SetValue(settingCaptureFolder, std::string("./captures/"));
+   SetValue(settingCaptureInterval, 2);
+   SetValue(settingPaletteShader, false);
+   SetValue(settingPaletteSmoothing, true);
+   SetValue(settingDynamicResolution, false);
+   SetValue(settingRenderTimeBudget, 12);
 }
 
 /// Can be called more than once; settings that are already set are
@@ -76,6 +76,45 @@ namespace Base
 
       /// int value with midi device to use; -1 for default
       settingWin32MidiDevice,
+
+      /// path to the folder where scaled textures are cached
+      settingTextureCacheFolder,
+
+      /// int value with max. size of the texture cache, in MB; 0 disables the cache
+      settingTextureCacheSize,
+
+      /// int value with max. size of uploaded textures, in MB; 0 means unlimited
+      settingTextureMemoryBudget,
+
+      /// boolean value that indicates if the game logic, physics and scripting
+      /// run on their own thread, decoupled from rendering
+      settingSimulationThread,
+
+      /// int value with max. frames per second; 0 means no cap, and frames
+      /// are paced by vsync or the display refresh rate
+      settingMaxFrameRate,
+
+      /// path to the folder where screenshots and captured frames are stored
+      settingCaptureFolder,
+
+      /// int value with the interval of frames that are captured when
+      /// streaming frames to disk; 1 captures every frame
+      settingCaptureInterval,
+
+      /// boolean value that indicates if stock textures are uploaded as
+      /// palette indices and rendered with a palette lookup shader
+      settingPaletteShader,
+
+      /// boolean value that indicates if the palette shader smoothes textures
+      settingPaletteSmoothing,
+
+      /// boolean value that indicates if the 3d view is rendered with a
+      /// resolution that is lowered when rendering takes too long
+      settingDynamicResolution,
+
+      /// integer value with the render time budget of the 3d view, in
+      /// milliseconds; used by dynamic resolution
+      settingRenderTimeBudget,
    };
 
    /// base game type enum
@@ -137,7 +137,8 @@ namespace Detail
          Base::settingSavegameFolder,
          Base::settingUw1Path,
          Base::settingUw2Path,
-         Base::settingCustomKeymap
+         Base::settingCustomKeymap,
+         Base::settingTextureCacheFolder
       };
 
       std::string path;
@@ -74,3 +74,26 @@ struct Triangle3dTextured
       return m_textureNumber > tri.m_textureNumber;
    }
 };
+
+/// \brief compact textured triangle
+/// Textured triangle made up with 3 Vertex3dFloat objects, about half the
+/// size of Triangle3dTextured. Used for rendering level tiles.
+struct Triangle3dTexturedFloat
+{
+   /// vertices
+   Vertex3dFloat m_vertices[3];
+
+   /// stock texture number used
+   Uint16 m_textureNumber = 0;
+
+   /// sets triangle point properties
+   void Set(unsigned int point, double x, double y, double z, double u, double v)
+   {
+      Vertex3dFloat& vertex = m_vertices[point];
+      vertex.x = static_cast<float>(x);
+      vertex.y = static_cast<float>(y);
+      vertex.z = static_cast<float>(z);
+      vertex.u = static_cast<float>(u);
+      vertex.v = static_cast<float>(v);
+   }
+};
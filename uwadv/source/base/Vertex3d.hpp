@@ -49,3 +49,16 @@ struct Vertex3d
    /// texture coordinates
    double u, v;
 };
+
+/// \brief compact vertex in 3D space
+/// Same as Vertex3d, but stores position and texture coordinates in single
+/// precision. Used for level geometry that is only rendered; collision
+/// detection uses Vertex3d.
+struct Vertex3dFloat
+{
+   /// vertex position
+   float x = 0.0f, y = 0.0f, z = 0.0f;
+
+   /// texture coordinates
+   float u = 0.0f, v = 0.0f;
+};
@@ -51,6 +51,18 @@ void Import::CrittersLoader::LoadCritters(std::vector<Critter>& allCritters,
    }
 }
 
+/// Decodes all frames of a critter, using the animation infos stored by
+/// LoadCritters(). Does nothing for critters without an animation.
+/// \param critter critter to decode frames for
+void Import::CrittersLoader::LoadCritterFrames(Critter& critter)
+{
+   if (!critter.HasAnimation())
+      return;
+
+   LoadCritterFrames(critter, critter.m_animationFilename.c_str(),
+      critter.m_animation, critter.m_auxPaletteIndex, critter.m_isUw2);
+}
+
 #ifdef DO_CRITLOAD_DEBUG
 extern unsigned int memory_used;
 #endif
@@ -361,6 +373,8 @@ void Import::CrittersLoader::LoadCritterFrames(Critter& critter, const char* fil
       // end of all page files
    }
    // end of all passes
+
+   critter.m_areFramesLoaded = true;
 }
 
 void Import::CrittersLoader::LoadCrittersUw1(std::vector<Critter>& allCritters,
@@ -369,7 +383,7 @@ void Import::CrittersLoader::LoadCrittersUw1(std::vector<Critter>& allCritters,
    allCritters.clear();
    allCritters.resize(0x0040);
 
-   UaTrace("loading all uw1 critter animations ... ");
+   UaTrace("loading all uw1 critter animation infos ... ");
    unsigned int now = SDL_GetTicks();
 
    // load infos from "assoc.anm"
@@ -427,8 +441,11 @@ void Import::CrittersLoader::LoadCrittersUw1(std::vector<Critter>& allCritters,
          critter.yres = critres[anim * 2 + 1];
          critter.maxframes = critframes[anim];
 #endif
-         // load it
-         LoadCritterFrames(critter, critterFile, anim, auxpal, false);
+         // frames are loaded on demand
+         critter.m_animationFilename = critterFile;
+         critter.m_animation = anim;
+         critter.m_auxPaletteIndex = auxpal;
+         critter.m_isUw2 = false;
 
          critter.SetPalette(palette0);
       }
@@ -443,7 +460,7 @@ void Import::CrittersLoader::LoadCrittersUw2(std::vector<Critter>& allCritters,
    allCritters.clear();
    allCritters.resize(0x0040);
 
-   UaTrace("loading all uw2 critter animations ... ");
+   UaTrace("loading all uw2 critter animation infos ... ");
    unsigned int now = SDL_GetTicks();
 
    // load infos from "as.an"
@@ -465,7 +482,11 @@ void Import::CrittersLoader::LoadCrittersUw2(std::vector<Critter>& allCritters,
       std::string critterFilename = Base::String::Format(
          "crit/cr%02o", animation); // yeah, octal!
 
-      LoadCritterFrames(critter, critterFilename.c_str(), animation, auxpal, true);
+      // frames are loaded on demand
+      critter.m_animationFilename = critterFilename;
+      critter.m_animation = animation;
+      critter.m_auxPaletteIndex = auxpal;
+      critter.m_isUw2 = true;
 
       critter.SetPalette(palette0);
    }
@@ -46,20 +46,23 @@ namespace Import
       {
       }
 
-      /// loads all critters
+      /// loads animation infos of all critters, without decoding any frames
       void LoadCritters(std::vector<Critter>& allCritters,
          Palette256Ptr palette0);
 
+      /// loads all frames of a critter, using the animation infos of the critter
+      void LoadCritterFrames(Critter& critter);
+
       /// loads all frames of a critter
       void LoadCritterFrames(Critter& critter, const char* filename,
          unsigned int anim, unsigned int usedAuxPalette, bool isUw2);
 
    private:
-      /// loads all uw1 critters
+      /// loads animation infos of all uw1 critters
       void LoadCrittersUw1(std::vector<Critter>& allCritters,
          Palette256Ptr palette0);
 
-      /// loads all uw2 critters
+      /// loads animation infos of all uw2 critters
       void LoadCrittersUw2(std::vector<Critter>& allCritters,
          Palette256Ptr palette0);
 
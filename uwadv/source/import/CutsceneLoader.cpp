@@ -133,8 +133,22 @@ void SkipPixel(Uint8*& dest, unsigned int& maxPixels, unsigned int size)
    maxPixels -= size;
 }
 
-void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, unsigned int maxPixels)
+/// Extracts the pixels of one frame; pixels that are skipped keep the value
+/// of the previous frame. The range of pixels that were written is returned,
+/// so that only the changed part of the frame has to be uploaded.
+/// \param source source data of frame record
+/// \param dest destination pixels
+/// \param maxPixels number of pixels in destination
+/// \param dirtyStart returns index of first pixel that was written
+/// \param dirtyEnd returns index after the last pixel that was written; when
+///        equal to dirtyStart, no pixel was written
+void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, unsigned int maxPixels,
+   unsigned int& dirtyStart, unsigned int& dirtyEnd)
 {
+   Uint8* destStart = dest;
+   Uint8* firstWritten = nullptr;
+   Uint8* lastWritten = nullptr;
+
    while (maxPixels > 0)
    {
       Sint8 cnt = static_cast<Sint8>(*source++);
@@ -144,7 +158,9 @@ void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, uns
       if (cnt > 0)
       {
          // short dump
+         if (firstWritten == nullptr) firstWritten = dest;
          DumpPixel(source, dest, maxPixels, cnt);
+         lastWritten = dest;
          continue;
       }
 
@@ -152,7 +168,9 @@ void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, uns
       {
          // short run
          Uint8 wordcnt = *source++;
+         if (firstWritten == nullptr) firstWritten = dest;
          RunPixel(source, dest, maxPixels, wordcnt);
+         lastWritten = dest;
          continue;
       }
 
@@ -190,6 +208,8 @@ void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, uns
       // remove sign bit
       wordcnt &= 0x7fff;
 
+      if (firstWritten == nullptr) firstWritten = dest;
+
       if (wordcnt >= 0x4000)
       {
          // clear "longRun" bit
@@ -203,5 +223,10 @@ void Import::CutsceneLoader::ExtractCutsceneData(Uint8* source, Uint8* dest, uns
          // long dump
          DumpPixel(source, dest, maxPixels, wordcnt);
       }
+
+      lastWritten = dest;
    }
+
+   dirtyStart = firstWritten == nullptr ? 0 : static_cast<unsigned int>(firstWritten - destStart);
+   dirtyEnd = lastWritten == nullptr ? 0 : static_cast<unsigned int>(lastWritten - destStart);
 }
@@ -43,8 +43,10 @@ namespace Import
          std::vector<Uint8>& largePages,
          unsigned int& numRecords);
 
-      /// extracts cutscene data from source data
-      static void ExtractCutsceneData(Uint8* source, Uint8* dest, unsigned int maxPixel);
+      /// extracts cutscene data from source data, returning the range of
+      /// written pixels
+      static void ExtractCutsceneData(Uint8* source, Uint8* dest, unsigned int maxPixel,
+         unsigned int& dirtyStart, unsigned int& dirtyEnd);
    };
 
 } // namespace Import
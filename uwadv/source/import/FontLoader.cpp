@@ -47,6 +47,9 @@ void Font::Load(Base::ResourceManager& resourceManager, FontId fontId)
    fontFilename.append(g_fontNames[fontId]);
 
    Import::FontLoader::LoadFont(resourceManager, fontFilename.c_str(), *this);
+
+   m_fontId = fontId;
+   PrepareGlyphs();
 }
 
 void Import::FontLoader::LoadFont(Base::ResourceManager& resourceManager, const char* fontFilename, Font& font)
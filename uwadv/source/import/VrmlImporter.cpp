@@ -42,8 +42,6 @@ std::shared_ptr<Model3DVrml> Import::VrmlImporter::ImportWrl(
    scale.Set(1.0, 1.0, 1.0);
    rotateAxis.Set(1.0, 0.0, 0.0);
 
-   std::string textureUrl;
-
    do
    {
       result = lexer.yylex();
@@ -71,6 +69,7 @@ std::shared_ptr<Model3DVrml> Import::VrmlImporter::ImportWrl(
             lexer.yylex(); // string: url
 
             lexer.yylex(); // url string
+            std::string& textureUrl = model->m_textureUrl;
             textureUrl.assign(lexer.GetString());
 
             // remove enclosing " chars
@@ -274,25 +273,41 @@ std::shared_ptr<Model3DVrml> Import::VrmlImporter::ImportWrl(
 
    // load texture
    if (result == 0)
-   {
-      model->m_texture.Init(1);
+      LoadTexture(*model, relativePath);
+   else
+      model->m_textureUrl.clear();
 
-      // construct texture name
-      std::string::size_type pos = relativePath.find_last_of("\\/");
+   return model;
+}
 
-      if (pos == std::string::npos) pos = 0;
-      else pos++;
+/// Reads the texture file into memory; the texture is uploaded when the model
+/// is rendered the first time.
+/// \param model model to load texture for
+/// \param relativePath relative path of the .wrl file
+void Import::VrmlImporter::LoadTexture(Model3DVrml& model, std::string relativePath)
+{
+   if (model.m_textureUrl.empty())
+      return;
 
-      relativePath.erase(pos);
-      relativePath.append(textureUrl);
+   // construct texture name
+   std::string::size_type pos = relativePath.find_last_of("\\/");
 
-      // load texture
-      Base::SDL_RWopsPtr textureRwops =
-         m_resourceManager.GetResourceFile(relativePath);
+   if (pos == std::string::npos) pos = 0;
+   else pos++;
 
-      model->m_texture.Load(textureRwops);
-      model->m_texture.Upload();
+   relativePath.erase(pos);
+   relativePath.append(model.m_textureUrl);
+
+   Base::SDL_RWopsPtr textureRwops =
+      m_resourceManager.GetResourceFile(relativePath);
+
+   if (textureRwops == nullptr)
+   {
+      UaTrace("couldn't load model texture %s\n", relativePath.c_str());
+      return;
    }
 
-   return model;
+   Base::File file{ textureRwops };
+   model.m_textureFileData.resize(file.FileLength());
+   file.ReadBuffer(model.m_textureFileData.data(), model.m_textureFileData.size());
 }
@@ -45,6 +45,9 @@ namespace Import
       /// loads VRML97 .wrl file
       std::shared_ptr<Model3DVrml> ImportWrl(SDL_RWops* rwops, std::string relativePath);
 
+      /// loads texture file of model, using the model's texture URL
+      void LoadTexture(Model3DVrml& model, std::string relativePath);
+
    private:
       /// resource manager
       const Base::ResourceManager& m_resourceManager;
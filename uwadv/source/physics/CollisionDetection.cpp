@@ -64,15 +64,19 @@ struct CollisionData
 
 CollisionDetection::CollisionDetection(const std::vector<Triangle3dTextured>& allTriangles,
    const PhysicsBody& body)
-   :m_allTriangles(allTriangles.begin(), allTriangles.end()),
-   m_collisionRecursionDepth(0)
+   :m_collisionRecursionDepth(0)
 {
    const Vector3d& ellipsoid = body.GetEllipsoid();
-   for (auto& triangle : m_allTriangles)
+
+   m_allTriangles.resize(allTriangles.size());
+   for (size_t index = 0; index < allTriangles.size(); index++)
    {
-      triangle.m_vertices[0].pos /= ellipsoid;
-      triangle.m_vertices[1].pos /= ellipsoid;
-      triangle.m_vertices[2].pos /= ellipsoid;
+      for (unsigned int point = 0; point < 3; point++)
+      {
+         Vector3d& ellipsoidPoint = m_allTriangles[index].m_points[point];
+         ellipsoidPoint = allTriangles[index].m_vertices[point].pos;
+         ellipsoidPoint /= ellipsoid;
+      }
    }
 }
 
@@ -252,12 +256,12 @@ void CollisionDetection::CheckCollision(CollisionData& data)
       if (data.debugOutput)
          UaTrace("    checking triangle %i...", index);
 
-      const Triangle3dTextured& tri = m_allTriangles[index];
+      const EllipsoidTriangle& tri = m_allTriangles[index];
 
       CheckTriangle(data,
-         tri.m_vertices[0].pos,
-         tri.m_vertices[1].pos,
-         tri.m_vertices[2].pos);
+         tri.m_points[0],
+         tri.m_points[1],
+         tri.m_points[2]);
    }
 }
 
@@ -72,8 +72,20 @@ private:
       const Vector3d& pa, const Vector3d& pb, const Vector3d& pc);
 
 private:
+   /// \brief triangle in ellipsoid space
+   /// Only stores the triangle points, since texture coordinates and colors
+   /// aren't needed for collision detection. The points are kept in double
+   /// precision; rounding them to float changes the collide and slide
+   /// response for almost parallel triangles (see CollisionDetectionTest), so
+   /// unlike the tile rendering triangles, these can't be stored as float.
+   struct EllipsoidTriangle
+   {
+      /// triangle points
+      Vector3d m_points[3];
+   };
+
    /// all triangles, in ellipsoid space
-   std::vector<Triangle3dTextured> m_allTriangles;
+   std::vector<EllipsoidTriangle> m_allTriangles;
 
    /// recursion depth for CollideWithWorld()
    int m_collisionRecursionDepth;
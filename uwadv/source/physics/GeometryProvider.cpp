@@ -28,6 +28,30 @@
 /// \param allTriangles vector of triangles the new triangles are added to
 void GeometryProvider::GetTileTriangles(unsigned int xpos,
    unsigned int ypos, std::vector<Triangle3dTextured>& allTriangles)
+{
+   AddTileTriangles(xpos, ypos, allTriangles);
+}
+
+/// Returns all triangles generated for tile with given coordinates, using
+/// the compact triangle format. The triangles are the same as the ones for
+/// collision detection, but in single precision, which is sufficient for
+/// rendering.
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \param allTriangles vector of triangles the new triangles are added to
+void GeometryProvider::GetTileTriangles(unsigned int xpos,
+   unsigned int ypos, std::vector<Triangle3dTexturedFloat>& allTriangles)
+{
+   AddTileTriangles(xpos, ypos, allTriangles);
+}
+
+/// Adds all triangles generated for tile with given coordinates.
+/// \param xpos x tile position
+/// \param ypos y tile position
+/// \param allTriangles vector of triangles the new triangles are added to
+template <typename TriangleType>
+void GeometryProvider::AddTileTriangles(unsigned int xpos,
+   unsigned int ypos, std::vector<TriangleType>& allTriangles)
 {
    const Underworld::TileInfo& tile = m_level.GetTilemap().GetTileInfo(xpos, ypos);
 
@@ -45,7 +69,7 @@ void GeometryProvider::GetTileTriangles(unsigned int xpos,
       // diagonal walls
       {
          bool diag_used = true;
-         Triangle3dTextured diag_tri1, diag_tri2;
+         TriangleType diag_tri1, diag_tri2;
          diag_tri1.m_textureNumber = walltex;
          diag_tri2.m_textureNumber = walltex;
 
@@ -170,7 +194,7 @@ void GeometryProvider::GetTileTriangles(unsigned int xpos,
          if (z1 == nz1 && z2 == nz2)
             continue;
 
-         Triangle3dTextured tri1, tri2;
+         TriangleType tri1, tri2;
          tri1.m_textureNumber = walltex;
          tri2.m_textureNumber = walltex;
 
@@ -190,11 +214,11 @@ void GeometryProvider::GetTileTriangles(unsigned int xpos,
    {
       double floor_slope_height = tile.m_floor + tile.m_slope;
 
-      Triangle3dTextured floor_tri1, floor_tri2;
+      TriangleType floor_tri1, floor_tri2;
       floor_tri1.m_textureNumber = tile.m_textureFloor;
       floor_tri2.m_textureNumber = tile.m_textureFloor;
 
-      Triangle3dTextured ceil_tri1, ceil_tri2;
+      TriangleType ceil_tri1, ceil_tri2;
       ceil_tri1.m_textureNumber = tile.m_textureCeiling;
       ceil_tri2.m_textureNumber = tile.m_textureCeiling;
       bool tri2_used = true;
@@ -306,7 +330,8 @@ void GeometryProvider::GetTileTriangles(unsigned int xpos,
    }
 }
 
-void GeometryProvider::AddWall(Triangle3dTextured& tri1, Triangle3dTextured& tri2,
+template <typename TriangleType>
+void GeometryProvider::AddWall(TriangleType& tri1, TriangleType& tri2,
    TileWallSide side,
    double x1, double y1, double z1,
    double x2, double y2, double z2,
@@ -46,9 +46,19 @@ public:
    void GetTileTriangles(unsigned int xpos, unsigned int ypos,
       std::vector<Triangle3dTextured>& allTriangles);
 
+   /// returns the list of all triangles for a given tile, for rendering
+   void GetTileTriangles(unsigned int xpos, unsigned int ypos,
+      std::vector<Triangle3dTexturedFloat>& allTriangles);
+
 private:
-   /// helper function for GetTileTriangles()
-   void AddWall(Triangle3dTextured& tri1, Triangle3dTextured& tri2,
+   /// adds all triangles for a given tile
+   template <typename TriangleType>
+   void AddTileTriangles(unsigned int xpos, unsigned int ypos,
+      std::vector<TriangleType>& allTriangles);
+
+   /// helper function for AddTileTriangles()
+   template <typename TriangleType>
+   void AddWall(TriangleType& tri1, TriangleType& tri2,
       TileWallSide side,
       double x1, double y1, double z1,
       double x2, double y2, double z2,
@@ -58,11 +58,11 @@ void PhysicsModel::TrackObject(PhysicsBody& body)
    unsigned int ypos = static_cast<unsigned int>(pos.y);
 
    // retrieve all tile triangles to check
-   std::vector<Triangle3dTextured> allTriangles;
+   m_allTriangles.clear();
 
    if (m_fnGetSurroundingTriangles != nullptr)
-      m_fnGetSurroundingTriangles(xpos, ypos, allTriangles);
+      m_fnGetSurroundingTriangles(xpos, ypos, m_allTriangles);
 
-   CollisionDetection detection{ allTriangles, body };
+   CollisionDetection detection{ m_allTriangles, body };
    detection.TrackObject(body);
 }
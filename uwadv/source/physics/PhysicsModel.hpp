@@ -93,4 +93,7 @@ private:
 
    /// list of pointer to bodies tracked by physics model
    std::vector<PhysicsBody*> m_trackedBodies;
+
+   /// surrounding triangles of the currently tracked body; reused for all bodies
+   std::vector<Triangle3dTextured> m_allTriangles;
 };
@@ -25,55 +25,26 @@
 #include "ObjectList.hpp"
 #include "CrittersLoader.hpp"
 #include "ImageManager.hpp"
+#include "RectanglePacker.hpp"
+#include "PaletteConverter.hpp"
+#include <algorithm>
 
 const double CritterFramesManager::s_critterFramesPerSecond = 3.0;
 
-Critter::Critter()
-   :m_xres(0), m_yres(0), m_maxFrames(0)
-{
-}
-
-/// Prepares textures for this critter.
-void Critter::Prepare()
-{
-   ResetPrepare();
+const unsigned int CritterFramesManager::s_atlasSize = 1024;
 
-   m_allTextures.resize(m_maxFrames);
-
-   for (unsigned int i = 0; i < m_maxFrames; i++)
-   {
-      Texture& currentTexture = m_allTextures[i];
-      currentTexture.Init(1);
-   }
-
-   m_frameUploadedFlags.clear();
-   m_frameUploadedFlags.resize(m_maxFrames, false);
-}
+const unsigned int CritterFramesManager::s_atlasPadding = 1;
 
-void Critter::ResetPrepare()
+Critter::Critter()
+   :m_animation(0), m_auxPaletteIndex(0), m_isUw2(false), m_areFramesLoaded(false),
+   m_xres(0), m_yres(0), m_maxFrames(0)
 {
-   m_allTextures.clear();
 }
 
-Texture& Critter::GetTexture(unsigned int frame)
+/// Resets frame preparation; the atlas locations of all frames are removed.
+void Critter::ResetPrepare()
 {
-   //UaAssert(frame < m_frameUploadedFlags.size() && frame != 0xFF);
-   if (frame == 0xff)
-      frame = 0;
-
-   if (!m_frameUploadedFlags[frame])
-   {
-      m_frameUploadedFlags[frame] = true;
-
-      m_allTextures[frame].Convert(&m_allFrameBytes[frame * m_xres * m_yres],
-         m_xres, m_yres, *m_palette.get(), 0);
-
-      m_allTextures[frame].Upload(0, false);
-      // using mipmapped textures (2nd param "true") disables the alpha
-      // channel somehow; might be a driver problem
-   }
-
-   return m_allTextures[frame];
+   m_frameLocations.clear();
 }
 
 /// Updates animation frame for given object. When the end of the animation is
@@ -92,18 +63,33 @@ void Critter::UpdateFrame(Underworld::Object& obj)
       animationFrame = 0;
 }
 
-/// Initializes critter frames manager. Imports all critter frames.
+CritterFramesManager::~CritterFramesManager()
+{
+   ResetAtlasTextures();
+}
+
+/// Initializes critter frames manager. Only the animation infos of all
+/// critters are imported; the frames are decoded in Prepare(), when a
+/// critter is used on a level.
 /// \param settings settings to use
 /// \param resourceManager resource manager to use
 /// \param imageManager image manager to load critters
-void CritterFramesManager::Init(Base::Settings& settings, Base::ResourceManager& resourceManager, ImageManager& imageManager)
+/// \param residencyManager residency manager for uploaded atlas textures; may be null
+void CritterFramesManager::Init(Base::Settings& settings, Base::ResourceManager& resourceManager, ImageManager& imageManager,
+   TextureResidencyManager* residencyManager)
 {
-   // load all critters' frames
+   m_settings = &settings;
+   m_resourceManager = &resourceManager;
+   m_residencyManager = residencyManager;
+
+   // load animation infos of all critters
    Import::CrittersLoader loader{ settings, resourceManager };
    loader.LoadCritters(m_allCritters, imageManager.GetPalette(0));
 }
 
-/// Prepares all critter frames for all critters in given map.
+/// Prepares all critter frames for all critters in given map. The frames of
+/// all critters that appear in the map are decoded, when not already done
+/// for an earlier map, and are packed into atlas textures.
 /// \param new_mapobjects object list with new map objects to prepare
 void CritterFramesManager::Prepare(Underworld::ObjectList* mapObjects)
 {
@@ -111,15 +97,14 @@ void CritterFramesManager::Prepare(Underworld::ObjectList* mapObjects)
    m_objectIndices.clear();
    m_objectFrameCount.clear();
 
+   ResetAtlasTextures();
+
    if (m_mapObjects == NULL)
       return;
 
-   // go through all critters and reset them
-   {
-      size_t max = m_allCritters.size();
-      for (size_t index = 0; index < max; index++)
-         m_allCritters[index].ResetPrepare();
-   }
+   Import::CrittersLoader loader{ *m_settings, *m_resourceManager };
+   unsigned int numLoadedCritters = 0;
+   unsigned int now = SDL_GetTicks();
 
    // go through object list and check which object frames have to be managed
    Uint16 max = m_mapObjects->GetObjectListSize();
@@ -140,10 +125,29 @@ void CritterFramesManager::Prepare(Underworld::ObjectList* mapObjects)
          m_objectIndices.push_back(i);
          m_objectFrameCount.push_back(0.0);
 
-         // prepare texture
-         m_allCritters[item_id - 0x0040].Prepare();
+         // mark critter as used; frames are placed in the atlas later
+         Critter& critter = m_allCritters[item_id - 0x0040];
+         if (!critter.IsPrepared())
+         {
+            // decode frames when the critter is used for the first time
+            if (!critter.AreFramesLoaded() && critter.HasAnimation())
+            {
+               loader.LoadCritterFrames(critter);
+               numLoadedCritters++;
+            }
+
+            critter.m_frameLocations.resize(critter.m_maxFrames);
+         }
       }
    }
+
+   if (numLoadedCritters > 0)
+   {
+      UaTrace("decoded frames of %u critters, needed %u ms\n",
+         numLoadedCritters, SDL_GetTicks() - now);
+   }
+
+   PrepareAtlasTextures();
 }
 
 /// Does tick processing for critter frames. Goes through all managed objects
@@ -168,8 +172,146 @@ void CritterFramesManager::Tick(double tickRate)
          Uint16 objectIndex = m_objectIndices[index];
          Underworld::ObjectPtr obj = m_mapObjects->GetObject(objectIndex);
 
+         // the object may have been replaced by a non-NPC object since
+         // PrepareLevel() was called
+         if (obj == NULL)
+            continue;
+
+         Uint16 itemID = obj->GetObjectInfo().m_itemID;
+         if (itemID < 0x0040 || itemID >= 0x0080)
+            continue;
+
+         Critter& critter = m_allCritters[itemID - 0x0040];
+         if (!critter.AreFramesLoaded())
+            continue; // critter wasn't in the level; frames weren't decoded
+
          // update
-         m_allCritters[(obj->GetObjectInfo().m_itemID - 0x0040) % 0x003f].UpdateFrame(*obj);
+         critter.UpdateFrame(*obj);
       }
    }
 }
+
+/// Packs the frames of all prepared critters into atlas textures. Critters
+/// are sorted by frame height, since all frames of a critter have the same
+/// size, and the rectangle packer gives the best results that way. The atlas
+/// textures are converted and uploaded, and the texture coordinates of all
+/// frames are calculated.
+void CritterFramesManager::PrepareAtlasTextures()
+{
+   std::vector<Critter*> preparedCritters;
+   for (Critter& critter : m_allCritters)
+   {
+      if (critter.m_xres == 0 || critter.m_yres == 0)
+         critter.ResetPrepare(); // no frames available
+
+      if (critter.IsPrepared())
+         preparedCritters.push_back(&critter);
+   }
+
+   std::stable_sort(preparedCritters.begin(), preparedCritters.end(),
+      [](const Critter* critter1, const Critter* critter2)
+      {
+         return critter1->m_yres > critter2->m_yres;
+      });
+
+   // place all frames
+   std::vector<RectanglePacker> allPackers;
+   for (Critter* critter : preparedCritters)
+   {
+      for (CritterFrameLocation& location : critter->m_frameLocations)
+      {
+         bool placed = false;
+         for (size_t atlasIndex = 0; atlasIndex < allPackers.size() && !placed; atlasIndex++)
+         {
+            placed = allPackers[atlasIndex].Insert(critter->m_xres, critter->m_yres,
+               location.m_xpos, location.m_ypos);
+
+            location.m_atlasIndex = static_cast<unsigned int>(atlasIndex);
+         }
+
+         if (!placed)
+         {
+            allPackers.push_back(RectanglePacker(s_atlasSize, s_atlasSize, s_atlasPadding));
+            location.m_atlasIndex = static_cast<unsigned int>(allPackers.size() - 1);
+
+            placed = allPackers.back().Insert(critter->m_xres, critter->m_yres,
+               location.m_xpos, location.m_ypos);
+
+            UaAssertMsg(placed, "critter frame is larger than atlas texture");
+         }
+      }
+   }
+
+   // convert frames to atlas texels
+   std::vector<std::vector<Uint32>> allAtlasTexels(allPackers.size());
+   for (size_t atlasIndex = 0; atlasIndex < allPackers.size(); atlasIndex++)
+      allAtlasTexels[atlasIndex].resize(s_atlasSize * allPackers[atlasIndex].GetUsedHeight(), 0);
+
+   for (Critter* critter : preparedCritters)
+   {
+      const Uint32* palette = reinterpret_cast<const Uint32*>(critter->m_palette->Get());
+      unsigned int frameSize = critter->m_xres * critter->m_yres;
+
+      for (unsigned int frame = 0; frame < critter->m_frameLocations.size(); frame++)
+      {
+         const CritterFrameLocation& location = critter->m_frameLocations[frame];
+         std::vector<Uint32>& atlasTexels = allAtlasTexels[location.m_atlasIndex];
+
+         for (unsigned int line = 0; line < critter->m_yres; line++)
+         {
+            PaletteConverter::Convert(
+               &critter->m_allFrameBytes[frame * frameSize + line * critter->m_xres],
+               &atlasTexels[(location.m_ypos + line) * s_atlasSize + location.m_xpos],
+               critter->m_xres,
+               palette);
+         }
+      }
+   }
+
+   // upload atlas textures
+   m_atlasTextures.resize(allPackers.size());
+   for (size_t atlasIndex = 0; atlasIndex < allPackers.size(); atlasIndex++)
+   {
+      Texture& atlasTexture = m_atlasTextures[atlasIndex];
+
+      atlasTexture.Init(1);
+      atlasTexture.SetResidencyManager(m_residencyManager);
+      atlasTexture.Convert(s_atlasSize, allPackers[atlasIndex].GetUsedHeight(),
+         allAtlasTexels[atlasIndex].data(), 0);
+      atlasTexture.Upload(0, false);
+      // using mipmapped textures (2nd param "true") disables the alpha
+      // channel somehow; might be a driver problem
+   }
+
+   // calculate texture coordinates
+   for (Critter* critter : preparedCritters)
+   {
+      for (CritterFrameLocation& location : critter->m_frameLocations)
+      {
+         const Texture& atlasTexture = m_atlasTextures[location.m_atlasIndex];
+         double xres = atlasTexture.GetXRes();
+         double yres = atlasTexture.GetYRes();
+
+         location.m_u1 = location.m_xpos / xres;
+         location.m_v1 = location.m_ypos / yres;
+         location.m_u2 = (location.m_xpos + critter->m_xres) / xres;
+         location.m_v2 = (location.m_ypos + critter->m_yres) / yres;
+      }
+   }
+
+   UaTrace("%u critter frame atlas textures for %u critters... ",
+      static_cast<unsigned int>(m_atlasTextures.size()),
+      static_cast<unsigned int>(preparedCritters.size()));
+}
+
+/// Frees all atlas textures and resets the frame locations of all critters.
+void CritterFramesManager::ResetAtlasTextures()
+{
+   for (Texture& atlasTexture : m_atlasTextures)
+      atlasTexture.Done();
+
+   m_atlasTextures.clear();
+
+   for (Critter& critter : m_allCritters)
+      critter.ResetPrepare();
+}
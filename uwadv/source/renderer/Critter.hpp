@@ -40,38 +40,65 @@ namespace Import
    class CrittersLoader;
 }
 
-/// critter animation frames for one critter
+class TextureResidencyManager;
+class CritterFramesManager;
+
+/// location of a critter animation frame in a texture atlas
+struct CritterFrameLocation
+{
+   /// index of atlas texture
+   unsigned int m_atlasIndex = 0;
+
+   /// position of the frame in the atlas, in pixels
+   unsigned int m_xpos = 0, m_ypos = 0;
+
+   /// texture coordinates of the upper left and lower right frame corner
+   double m_u1 = 0.0, m_v1 = 0.0, m_u2 = 0.0, m_v2 = 0.0;
+};
+
+/// \brief critter animation frames for one critter
+/// The frames are decoded on demand, when the critter is used on a level for
+/// the first time, and are kept for later levels.
 class Critter
 {
 public:
    /// ctor
    Critter();
 
-   /// prepares critter textures
-   void Prepare();
-
    /// resets frame preparation
    void ResetPrepare();
 
+   /// returns if the critter has an animation that frames can be loaded from
+   bool HasAnimation() const { return !m_animationFilename.empty(); }
+
+   /// returns if the frames of the critter were decoded
+   bool AreFramesLoaded() const { return m_areFramesLoaded; }
+
+   /// returns if the frames of the critter were placed in the atlas textures
+   bool IsPrepared() const { return !m_frameLocations.empty(); }
+
    /// returns critter texture index by frame
    unsigned int GetFrame(Uint8 animationState, Uint8 animationFrame)
    {
       return m_segmentList[animationState][animationFrame];
    }
 
-   /// returns texture object for a given frame
-   Texture& GetTexture(unsigned int frame);
+   /// returns atlas location for a given frame
+   const CritterFrameLocation& GetFrameLocation(unsigned int frame) const
+   {
+      return m_frameLocations[frame == 0xff ? 0 : frame];
+   }
 
-   /// returns hotspot u coordinate
+   /// returns hotspot u coordinate, relative to the frame
    double GetHotspotU(unsigned int frame) const
    {
-      return double(m_hotspotXYCoordinates[frame * 2 + 0]) / m_allTextures[frame].GetXRes();
+      return double(m_hotspotXYCoordinates[frame * 2 + 0]) / m_xres;
    }
 
-   /// returns hotspot v coordinate
+   /// returns hotspot v coordinate, relative to the frame
    double GetHotspotV(unsigned int frame) const
    {
-      return double(m_hotspotXYCoordinates[frame * 2 + 1]) / m_allTextures[frame].GetYRes();
+      return double(m_hotspotXYCoordinates[frame * 2 + 1]) / m_yres;
    }
 
    /// updates animation frame of object
@@ -82,6 +109,23 @@ public:
 
 protected:
    friend Import::CrittersLoader;
+   friend CritterFramesManager;
+
+   /// base filename of the animation page files; empty when the critter has
+   /// no animation
+   std::string m_animationFilename;
+
+   /// animation number
+   unsigned int m_animation;
+
+   /// auxiliary palette used by the critter
+   unsigned int m_auxPaletteIndex;
+
+   /// indicates if the animation is stored in the uw2 format
+   bool m_isUw2;
+
+   /// indicates if the frames were decoded
+   bool m_areFramesLoaded;
 
    /// slot list with segment indices
    std::vector<Uint8> m_slotList;
@@ -92,9 +136,6 @@ protected:
    /// array with all frame bytes
    std::vector<Uint8> m_allFrameBytes;
 
-   /// indicates if a frame was already uploaded
-   std::vector<bool> m_frameUploadedFlags;
-
    /// frame resolution
    unsigned int m_xres, m_yres;
 
@@ -107,23 +148,38 @@ protected:
    /// hotspot x/y coordinates for all frames
    std::vector<unsigned int> m_hotspotXYCoordinates;
 
-   /// texture with all critter images
-   std::vector<Texture> m_allTextures;
+   /// atlas locations for all frames; empty when not prepared
+   std::vector<CritterFrameLocation> m_frameLocations;
 
    /// palette to use
    Palette256Ptr m_palette;
 };
 
 
-/// critter frames manager class
+/// \brief critter frames manager class
+/// All frames of the critters used on a level are packed into a few atlas
+/// textures, so that rendering NPCs doesn't need a texture bind per frame.
 class CritterFramesManager
 {
 public:
    /// ctor
-   CritterFramesManager() {}
+   CritterFramesManager()
+      :m_settings(nullptr),
+      m_resourceManager(nullptr),
+      m_mapObjects(nullptr),
+      m_residencyManager(nullptr)
+   {
+   }
+   /// dtor
+   ~CritterFramesManager();
+   /// deleted copy ctor
+   CritterFramesManager(const CritterFramesManager&) = delete;
+   /// deleted assignment operator
+   CritterFramesManager& operator=(const CritterFramesManager&) = delete;
 
    /// initialize frames manager
-   void Init(Base::Settings& settings, Base::ResourceManager& resourceManager, ImageManager& imageManager);
+   void Init(Base::Settings& settings, Base::ResourceManager& resourceManager, ImageManager& imageManager,
+      TextureResidencyManager* residencyManager = nullptr);
 
    /// resets controlled object frames and prepares new critter objects
    void Prepare(Underworld::ObjectList* mapObjects);
@@ -137,11 +193,36 @@ public:
       return m_allCritters[index];
    }
 
+   /// returns atlas texture with critter frames
+   Texture& GetAtlasTexture(unsigned int atlasIndex)
+   {
+      return m_atlasTextures[atlasIndex];
+   }
+
+protected:
+   /// packs frames of all prepared critters into atlas textures
+   void PrepareAtlasTextures();
+
+   /// frees all atlas textures
+   void ResetAtlasTextures();
+
 protected:
    /// frames per second for critter animations
    static const double s_critterFramesPerSecond;
 
+   /// width and max. height of an atlas texture
+   static const unsigned int s_atlasSize;
+
+   /// padding between frames in atlas textures
+   static const unsigned int s_atlasPadding;
+
 protected:
+   /// settings to load critter frames with
+   Base::Settings* m_settings;
+
+   /// resource manager to load critter frames with
+   Base::ResourceManager* m_resourceManager;
+
    /// vector with critter animations
    std::vector<Critter> m_allCritters;
 
@@ -153,4 +234,10 @@ protected:
 
    /// currently managed map objects
    Underworld::ObjectList* m_mapObjects;
+
+   /// residency manager for uploaded atlas textures; may be null
+   TextureResidencyManager* m_residencyManager;
+
+   /// atlas textures with frames of all prepared critters
+   std::vector<Texture> m_atlasTextures;
 };
@@ -0,0 +1,546 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file DynamicResolution.cpp
+/// \brief dynamic resolution scaling for the 3d view
+//
+#include "pch.hpp"
+#include "DynamicResolution.hpp"
+#include "Settings.hpp"
+
+namespace Detail
+{
+   /// scale difference between two scale steps
+   const double c_scaleStepSize = 0.0625;
+
+   /// number of scale steps, including full resolution
+   const unsigned int c_numScaleSteps = 9;
+
+   /// weight of a new render time in the smoothed render time
+   const double c_averageWeight = 0.2;
+
+   /// number of consecutive frames over budget before the scale is lowered
+   const unsigned int c_framesBeforeDecrease = 3;
+
+   /// number of consecutive frames under budget before the scale is raised
+   const unsigned int c_framesBeforeIncrease = 30;
+
+   /// fraction of the budget the predicted render time at the next higher
+   /// scale must stay below, so that the scale is raised
+   const double c_increaseThreshold = 0.8;
+
+   /// number of frames skipped after a scale change
+   const unsigned int c_numSettleFrames = 4;
+
+   /// number of timer queries; render times are read this many frames later
+   const size_t c_numTimerQueries = 4;
+
+   // framebuffer object functions; loaded in DynamicResolution::Init()
+   PFNGLGENFRAMEBUFFERSPROC glGenFramebuffers = nullptr;
+   PFNGLDELETEFRAMEBUFFERSPROC glDeleteFramebuffers = nullptr;
+   PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
+   PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = nullptr;
+   PFNGLGENRENDERBUFFERSPROC glGenRenderbuffers = nullptr;
+   PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers = nullptr;
+   PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer = nullptr;
+   PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage = nullptr;
+   PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer = nullptr;
+   PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = nullptr;
+
+   // timer query functions; loaded in DynamicResolution::Init()
+   PFNGLGENQUERIESPROC glGenQueries = nullptr;
+   PFNGLDELETEQUERIESPROC glDeleteQueries = nullptr;
+   PFNGLBEGINQUERYPROC glBeginQuery = nullptr;
+   PFNGLENDQUERYPROC glEndQuery = nullptr;
+   PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv = nullptr;
+   PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = nullptr;
+
+   /// returns OpenGL function with given name, or its EXT variant
+   void* GetProcAddressOrExt(const char* name)
+   {
+      void* proc = SDL_GL_GetProcAddress(name);
+      if (proc == nullptr)
+         proc = SDL_GL_GetProcAddress((std::string(name) + "EXT").c_str());
+
+      return proc;
+   }
+
+   /// loads framebuffer object functions; returns false when not available
+   bool LoadFramebufferFunctions()
+   {
+      if (SDL_GL_ExtensionSupported("GL_ARB_framebuffer_object") != SDL_TRUE &&
+         SDL_GL_ExtensionSupported("GL_EXT_framebuffer_object") != SDL_TRUE)
+         return false;
+
+      glGenFramebuffers = reinterpret_cast<PFNGLGENFRAMEBUFFERSPROC>(GetProcAddressOrExt("glGenFramebuffers"));
+      glDeleteFramebuffers = reinterpret_cast<PFNGLDELETEFRAMEBUFFERSPROC>(GetProcAddressOrExt("glDeleteFramebuffers"));
+      glBindFramebuffer = reinterpret_cast<PFNGLBINDFRAMEBUFFERPROC>(GetProcAddressOrExt("glBindFramebuffer"));
+      glFramebufferTexture2D = reinterpret_cast<PFNGLFRAMEBUFFERTEXTURE2DPROC>(GetProcAddressOrExt("glFramebufferTexture2D"));
+      glGenRenderbuffers = reinterpret_cast<PFNGLGENRENDERBUFFERSPROC>(GetProcAddressOrExt("glGenRenderbuffers"));
+      glDeleteRenderbuffers = reinterpret_cast<PFNGLDELETERENDERBUFFERSPROC>(GetProcAddressOrExt("glDeleteRenderbuffers"));
+      glBindRenderbuffer = reinterpret_cast<PFNGLBINDRENDERBUFFERPROC>(GetProcAddressOrExt("glBindRenderbuffer"));
+      glRenderbufferStorage = reinterpret_cast<PFNGLRENDERBUFFERSTORAGEPROC>(GetProcAddressOrExt("glRenderbufferStorage"));
+      glFramebufferRenderbuffer = reinterpret_cast<PFNGLFRAMEBUFFERRENDERBUFFERPROC>(GetProcAddressOrExt("glFramebufferRenderbuffer"));
+      glCheckFramebufferStatus = reinterpret_cast<PFNGLCHECKFRAMEBUFFERSTATUSPROC>(GetProcAddressOrExt("glCheckFramebufferStatus"));
+
+      return glGenFramebuffers != nullptr && glDeleteFramebuffers != nullptr &&
+         glBindFramebuffer != nullptr && glFramebufferTexture2D != nullptr &&
+         glGenRenderbuffers != nullptr && glDeleteRenderbuffers != nullptr &&
+         glBindRenderbuffer != nullptr && glRenderbufferStorage != nullptr &&
+         glFramebufferRenderbuffer != nullptr && glCheckFramebufferStatus != nullptr;
+   }
+
+   /// loads timer query functions; returns false when not available
+   bool LoadTimerQueryFunctions()
+   {
+      if (SDL_GL_ExtensionSupported("GL_ARB_timer_query") != SDL_TRUE &&
+         SDL_GL_ExtensionSupported("GL_EXT_timer_query") != SDL_TRUE)
+         return false;
+
+      glGenQueries = reinterpret_cast<PFNGLGENQUERIESPROC>(SDL_GL_GetProcAddress("glGenQueries"));
+      glDeleteQueries = reinterpret_cast<PFNGLDELETEQUERIESPROC>(SDL_GL_GetProcAddress("glDeleteQueries"));
+      glBeginQuery = reinterpret_cast<PFNGLBEGINQUERYPROC>(SDL_GL_GetProcAddress("glBeginQuery"));
+      glEndQuery = reinterpret_cast<PFNGLENDQUERYPROC>(SDL_GL_GetProcAddress("glEndQuery"));
+      glGetQueryObjectiv = reinterpret_cast<PFNGLGETQUERYOBJECTIVPROC>(SDL_GL_GetProcAddress("glGetQueryObjectiv"));
+      glGetQueryObjectui64v = reinterpret_cast<PFNGLGETQUERYOBJECTUI64VPROC>(GetProcAddressOrExt("glGetQueryObjectui64v"));
+
+      return glGenQueries != nullptr && glDeleteQueries != nullptr &&
+         glBeginQuery != nullptr && glEndQuery != nullptr &&
+         glGetQueryObjectiv != nullptr && glGetQueryObjectui64v != nullptr;
+   }
+
+   /// returns if OpenGL is implemented in software; these implementations
+   /// usually rasterize when the commands are flushed, so that timer queries
+   /// only measure issuing the commands
+   bool IsSoftwareRenderer()
+   {
+      const char* rendererName = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+      if (rendererName == nullptr)
+         return false;
+
+      const char* softwareRendererNames[] = { "llvmpipe", "softpipe", "SwiftShader", "GDI Generic" };
+      for (const char* softwareRendererName : softwareRendererNames)
+      {
+         if (strstr(rendererName, softwareRendererName) != nullptr)
+            return true;
+      }
+
+      return false;
+   }
+
+   /// returns the smallest power of two that is greater or equal to the value
+   unsigned int NextPowerOfTwo(unsigned int value)
+   {
+      unsigned int powerOfTwo = 1;
+      while (powerOfTwo < value)
+         powerOfTwo <<= 1;
+
+      return powerOfTwo;
+   }
+} // namespace Detail
+
+const double DynamicResolutionController::c_minScale =
+   1.0 - (Detail::c_numScaleSteps - 1) * Detail::c_scaleStepSize;
+
+/// \param budgetMilliseconds render time budget, in milliseconds
+DynamicResolutionController::DynamicResolutionController(double budgetMilliseconds)
+   :m_budget(budgetMilliseconds),
+   m_scaleStep(0),
+   m_averageTime(0.0),
+   m_numFramesOverBudget(0),
+   m_numFramesUnderBudget(0),
+   m_numSettleFrames(0)
+{
+}
+
+void DynamicResolutionController::Reset()
+{
+   ChangeScaleStep(0);
+   m_numSettleFrames = 0;
+}
+
+/// The render time must have been measured with the scale that was current
+/// when the frame was rendered; render times that arrive shortly after a
+/// scale change are ignored.
+/// \param milliseconds render time of the frame, in milliseconds
+void DynamicResolutionController::AddRenderTime(double milliseconds)
+{
+   if (m_numSettleFrames > 0)
+   {
+      m_numSettleFrames--;
+      return;
+   }
+
+   m_averageTime = m_averageTime == 0.0 ? milliseconds :
+      m_averageTime + Detail::c_averageWeight * (milliseconds - m_averageTime);
+
+   if (m_averageTime > m_budget)
+   {
+      m_numFramesUnderBudget = 0;
+
+      if (++m_numFramesOverBudget >= Detail::c_framesBeforeDecrease &&
+         m_scaleStep + 1 < Detail::c_numScaleSteps)
+      {
+         ChangeScaleStep(m_scaleStep + 1);
+      }
+
+      return;
+   }
+
+   m_numFramesOverBudget = 0;
+
+   if (m_scaleStep == 0)
+      return;
+
+   // render time is proportional to the number of pixels
+   double pixelRatio = GetScale(m_scaleStep - 1) / GetScale(m_scaleStep);
+   double predictedTime = m_averageTime * pixelRatio * pixelRatio;
+
+   if (predictedTime < m_budget * Detail::c_increaseThreshold)
+   {
+      if (++m_numFramesUnderBudget >= Detail::c_framesBeforeIncrease)
+         ChangeScaleStep(m_scaleStep - 1);
+   }
+   else
+      m_numFramesUnderBudget = 0;
+}
+
+/// \param scaleStep scale step; 0 is full resolution
+double DynamicResolutionController::GetScale(unsigned int scaleStep)
+{
+   return 1.0 - scaleStep * Detail::c_scaleStepSize;
+}
+
+/// \param scaleStep new scale step
+void DynamicResolutionController::ChangeScaleStep(unsigned int scaleStep)
+{
+   m_scaleStep = scaleStep;
+   m_averageTime = 0.0;
+   m_numFramesOverBudget = 0;
+   m_numFramesUnderBudget = 0;
+   m_numSettleFrames = Detail::c_numSettleFrames;
+}
+
+DynamicResolution::DynamicResolution()
+   :m_isEnabled(false),
+   m_useTimerQueries(false),
+   m_framebuffer(0),
+   m_colorTexture(0),
+   m_depthBuffer(0),
+   m_framebufferXRes(0),
+   m_framebufferYRes(0),
+   m_viewportWidth(0),
+   m_viewportHeight(0),
+   m_viewportX(0),
+   m_viewportY(0),
+   m_renderXRes(0),
+   m_renderYRes(0),
+   m_nextTimerQuery(0),
+   m_activeTimerQuery(-1),
+   m_renderStart(0)
+{
+}
+
+DynamicResolution::~DynamicResolution()
+{
+   UaAssertMsg(m_framebuffer == 0 && m_timerQueries.empty(),
+      "DynamicResolution::Done() must be called before destroying the object");
+}
+
+/// \param settings settings to read dynamic resolution settings from
+void DynamicResolution::Init(const Base::Settings& settings)
+{
+   Done();
+
+   m_isEnabled = false;
+   if (!settings.GetBool(Base::settingDynamicResolution))
+      return;
+
+   if (!Detail::LoadFramebufferFunctions())
+   {
+      UaTrace("dynamic resolution: framebuffer objects not available, disabled\n");
+      return;
+   }
+
+   m_isEnabled = true;
+   m_controller.SetBudget(std::max(1, settings.GetInt(Base::settingRenderTimeBudget)));
+   m_controller.Reset();
+
+   m_useTimerQueries = !Detail::IsSoftwareRenderer() && Detail::LoadTimerQueryFunctions();
+   if (m_useTimerQueries)
+   {
+      GLuint queries[Detail::c_numTimerQueries] = {};
+      Detail::glGenQueries(Detail::c_numTimerQueries, queries);
+
+      for (GLuint query : queries)
+         m_timerQueries.push_back(TimerQuery{ query, false });
+
+      m_nextTimerQuery = 0;
+   }
+
+   UaTrace("dynamic resolution: render time budget %i ms, %s\n",
+      settings.GetInt(Base::settingRenderTimeBudget),
+      m_useTimerQueries ? "using timer queries" : "measuring render time with glFinish()");
+}
+
+void DynamicResolution::Done()
+{
+   DeleteFramebuffer();
+
+   if (!m_timerQueries.empty())
+   {
+      for (const TimerQuery& timerQuery : m_timerQueries)
+         Detail::glDeleteQueries(1, &timerQuery.m_query);
+
+      m_timerQueries.clear();
+   }
+
+   m_activeTimerQuery = -1;
+}
+
+/// Binds the offscreen framebuffer object and sets up the OpenGL viewport
+/// for the current render scale. The projection of the 3d view must
+/// already be set up, e.g. by Renderer::SetupFor3D().
+/// \param xpos x position of the 3d viewport, in OpenGL window coordinates
+/// \param ypos y position of the 3d viewport, in OpenGL window coordinates
+/// \param width width of the 3d viewport
+/// \param height height of the 3d viewport
+void DynamicResolution::Begin(int xpos, int ypos, unsigned int width, unsigned int height)
+{
+   UaAssert(m_isEnabled);
+
+   if (m_framebuffer == 0 || width != m_viewportWidth || height != m_viewportHeight)
+   {
+      DeleteFramebuffer();
+      if (!CreateFramebuffer(width, height))
+      {
+         UaTrace("dynamic resolution: couldn't create framebuffer object, disabled\n");
+         Done();
+         m_isEnabled = false;
+         return;
+      }
+
+      m_controller.Reset();
+   }
+
+   m_viewportX = xpos;
+   m_viewportY = ypos;
+
+   CollectRenderTimes();
+
+   double scale = m_controller.GetScale();
+   m_renderXRes = std::max(1u, static_cast<unsigned int>(width * scale + 0.5));
+   m_renderYRes = std::max(1u, static_cast<unsigned int>(height * scale + 0.5));
+
+   Detail::glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+   glViewport(0, 0, m_renderXRes, m_renderYRes);
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   if (m_useTimerQueries)
+   {
+      TimerQuery& timerQuery = m_timerQueries[m_nextTimerQuery];
+
+      // when all queries are still pending, skip measuring this frame
+      if (!timerQuery.m_isPending)
+      {
+         Detail::glBeginQuery(GL_TIME_ELAPSED, timerQuery.m_query);
+         m_activeTimerQuery = static_cast<int>(m_nextTimerQuery);
+      }
+   }
+   else
+      m_renderStart = SDL_GetPerformanceCounter();
+}
+
+/// Unbinds the offscreen framebuffer object and draws the rendered 3d view
+/// into the 3d viewport of the back buffer. The OpenGL viewport is set to
+/// the 3d viewport afterwards.
+void DynamicResolution::End()
+{
+   if (!m_isEnabled)
+      return;
+
+   if (m_useTimerQueries)
+   {
+      if (m_activeTimerQuery >= 0)
+      {
+         Detail::glEndQuery(GL_TIME_ELAPSED);
+         m_timerQueries[m_activeTimerQuery].m_isPending = true;
+         m_nextTimerQuery = (m_nextTimerQuery + 1) % m_timerQueries.size();
+         m_activeTimerQuery = -1;
+      }
+   }
+   else
+   {
+      glFinish();
+
+      Uint64 renderTime = SDL_GetPerformanceCounter() - m_renderStart;
+      m_controller.AddRenderTime(renderTime * 1000.0 / SDL_GetPerformanceFrequency());
+   }
+
+   Detail::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+   DrawScaledView();
+}
+
+/// \param width width of the 3d viewport
+/// \param height height of the 3d viewport
+/// \return true when the framebuffer object is complete
+bool DynamicResolution::CreateFramebuffer(unsigned int width, unsigned int height)
+{
+   m_viewportWidth = width;
+   m_viewportHeight = height;
+
+   m_framebufferXRes = Detail::NextPowerOfTwo(width);
+   m_framebufferYRes = Detail::NextPowerOfTwo(height);
+
+   glGenTextures(1, &m_colorTexture);
+   glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_framebufferXRes, m_framebufferYRes, 0,
+      GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+   // bilinear filtering is the cheapest filter that doesn't look blocky
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+   glBindTexture(GL_TEXTURE_2D, 0);
+
+   Detail::glGenRenderbuffers(1, &m_depthBuffer);
+   Detail::glBindRenderbuffer(GL_RENDERBUFFER, m_depthBuffer);
+   Detail::glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_framebufferXRes, m_framebufferYRes);
+   Detail::glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+   Detail::glGenFramebuffers(1, &m_framebuffer);
+   Detail::glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+   Detail::glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_colorTexture, 0);
+   Detail::glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_depthBuffer);
+
+   GLenum status = Detail::glCheckFramebufferStatus(GL_FRAMEBUFFER);
+   Detail::glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+   UaTrace("dynamic resolution: created %ux%u framebuffer for %ux%u viewport\n",
+      m_framebufferXRes, m_framebufferYRes, width, height);
+
+   return status == GL_FRAMEBUFFER_COMPLETE;
+}
+
+void DynamicResolution::DeleteFramebuffer()
+{
+   if (m_framebuffer != 0)
+   {
+      Detail::glDeleteFramebuffers(1, &m_framebuffer);
+      m_framebuffer = 0;
+   }
+
+   if (m_depthBuffer != 0)
+   {
+      Detail::glDeleteRenderbuffers(1, &m_depthBuffer);
+      m_depthBuffer = 0;
+   }
+
+   if (m_colorTexture != 0)
+   {
+      glDeleteTextures(1, &m_colorTexture);
+      m_colorTexture = 0;
+   }
+
+   m_viewportWidth = m_viewportHeight = 0;
+}
+
+void DynamicResolution::CollectRenderTimes()
+{
+   for (size_t index = 0; index < m_timerQueries.size(); index++)
+   {
+      // read results in the order the queries were issued
+      TimerQuery& timerQuery = m_timerQueries[(m_nextTimerQuery + index) % m_timerQueries.size()];
+      if (!timerQuery.m_isPending)
+         continue;
+
+      GLint isAvailable = GL_FALSE;
+      Detail::glGetQueryObjectiv(timerQuery.m_query, GL_QUERY_RESULT_AVAILABLE, &isAvailable);
+      if (isAvailable == GL_FALSE)
+         break;
+
+      GLuint64 elapsedNanoseconds = 0;
+      Detail::glGetQueryObjectui64v(timerQuery.m_query, GL_QUERY_RESULT, &elapsedNanoseconds);
+      timerQuery.m_isPending = false;
+
+      m_controller.AddRenderTime(elapsedNanoseconds / 1000000.0);
+   }
+}
+
+void DynamicResolution::DrawScaledView()
+{
+   glViewport(m_viewportX, m_viewportY, m_viewportWidth, m_viewportHeight);
+
+   glPushAttrib(GL_ENABLE_BIT | GL_CURRENT_BIT);
+
+   glDisable(GL_DEPTH_TEST);
+   glDisable(GL_FOG);
+   glDisable(GL_BLEND);
+   glDisable(GL_ALPHA_TEST);
+   glDisable(GL_CULL_FACE);
+   glEnable(GL_TEXTURE_2D);
+
+   glMatrixMode(GL_PROJECTION);
+   glPushMatrix();
+   glLoadIdentity();
+   glOrtho(0.0, 1.0, 0.0, 1.0, -1.0, 1.0);
+
+   glMatrixMode(GL_MODELVIEW);
+   glPushMatrix();
+   glLoadIdentity();
+
+   glBindTexture(GL_TEXTURE_2D, m_colorTexture);
+   glColor3ub(255, 255, 255);
+
+   // when the view is scaled up, bilinear filtering at the right and top
+   // edges would blend in half a texel of the unused framebuffer area, so
+   // the texture coordinates are pulled in by half a texel; the left and
+   // bottom edges are pulled in as well, so that the image isn't shifted
+   double u1 = 0.0, u2 = static_cast<double>(m_renderXRes) / m_framebufferXRes;
+   double v1 = 0.0, v2 = static_cast<double>(m_renderYRes) / m_framebufferYRes;
+
+   if (m_renderXRes < m_viewportWidth)
+   {
+      u1 += 0.5 / m_framebufferXRes;
+      u2 -= 0.5 / m_framebufferXRes;
+   }
+
+   if (m_renderYRes < m_viewportHeight)
+   {
+      v1 += 0.5 / m_framebufferYRes;
+      v2 -= 0.5 / m_framebufferYRes;
+   }
+
+   glBegin(GL_QUADS);
+   glTexCoord2d(u1, v1); glVertex2i(0, 0);
+   glTexCoord2d(u2, v1); glVertex2i(1, 0);
+   glTexCoord2d(u2, v2); glVertex2i(1, 1);
+   glTexCoord2d(u1, v2); glVertex2i(0, 1);
+   glEnd();
+
+   glBindTexture(GL_TEXTURE_2D, 0);
+
+   glPopMatrix();
+   glMatrixMode(GL_PROJECTION);
+   glPopMatrix();
+   glMatrixMode(GL_MODELVIEW);
+
+   glPopAttrib();
+}
@@ -0,0 +1,201 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file DynamicResolution.hpp
+/// \brief dynamic resolution scaling for the 3d view
+//
+#pragma once
+
+#include <vector>
+
+namespace Base
+{
+   class Settings;
+}
+
+/// \brief Chooses the render scale of the 3d view from measured render times
+/// The scale is lowered in steps when the smoothed render time exceeds the
+/// budget for a few frames, and is raised again when the render time that is
+/// predicted for the next higher scale stays clearly below the budget for a
+/// longer time. The render time is assumed to be proportional to the number
+/// of rendered pixels. After each change, some frames are skipped, since
+/// their render times may still have been measured with the previous scale.
+/// The different thresholds and frame counts prevent oscillating between two
+/// scales.
+class DynamicResolutionController
+{
+public:
+   /// ctor
+   DynamicResolutionController(double budgetMilliseconds = 12.0);
+
+   /// sets render time budget, in milliseconds
+   void SetBudget(double budgetMilliseconds) { m_budget = budgetMilliseconds; }
+
+   /// resets controller to full resolution
+   void Reset();
+
+   /// adds render time of a frame, rendered with the current scale
+   void AddRenderTime(double milliseconds);
+
+   /// returns current render scale, from c_minScale to 1.0
+   double GetScale() const { return GetScale(m_scaleStep); }
+
+   /// returns smoothed render time, in milliseconds
+   double GetAverageRenderTime() const { return m_averageTime; }
+
+   /// lowest render scale
+   static const double c_minScale;
+
+private:
+   /// returns render scale for given step
+   static double GetScale(unsigned int scaleStep);
+
+   /// changes current scale step
+   void ChangeScaleStep(unsigned int scaleStep);
+
+private:
+   /// render time budget, in milliseconds
+   double m_budget;
+
+   /// current scale step; 0 is full resolution
+   unsigned int m_scaleStep;
+
+   /// smoothed render time, in milliseconds; 0.0 when no time was added yet
+   double m_averageTime;
+
+   /// number of consecutive frames over budget
+   unsigned int m_numFramesOverBudget;
+
+   /// number of consecutive frames that would fit the budget at the next higher scale
+   unsigned int m_numFramesUnderBudget;
+
+   /// number of frames to skip after the scale changed
+   unsigned int m_numSettleFrames;
+};
+
+/// \brief Renders the 3d view with a dynamic resolution
+/// When enabled, the 3d view is rendered into an offscreen framebuffer
+/// object, with a resolution that is lowered when rendering takes longer
+/// than the budget, e.g. with a software OpenGL implementation that is
+/// limited by fill rate. The rendered image is then scaled up to the 3d
+/// viewport using bilinear filtering. Render times are measured with timer
+/// queries, which are read a few frames later, so that measuring doesn't
+/// stall the pipeline. Without timer queries, and with software OpenGL
+/// implementations, the render time is measured by waiting for OpenGL to
+/// finish rendering.
+class DynamicResolution
+{
+public:
+   /// ctor
+   DynamicResolution();
+   /// dtor
+   ~DynamicResolution();
+
+   /// deleted copy ctor
+   DynamicResolution(const DynamicResolution&) = delete;
+   /// deleted assignment operator
+   DynamicResolution& operator=(const DynamicResolution&) = delete;
+
+   /// initializes dynamic resolution; must be called with a current OpenGL context
+   void Init(const Base::Settings& settings);
+
+   /// frees framebuffer object and queries
+   void Done();
+
+   /// returns if dynamic resolution is used
+   bool IsEnabled() const { return m_isEnabled; }
+
+   /// starts rendering the 3d view into the offscreen framebuffer
+   void Begin(int xpos, int ypos, unsigned int width, unsigned int height);
+
+   /// finishes rendering and scales up the 3d view into the viewport
+   void End();
+
+   /// returns resolution the 3d view was last rendered with
+   void GetRenderResolution(unsigned int& width, unsigned int& height) const
+   {
+      width = m_renderXRes;
+      height = m_renderYRes;
+   }
+
+private:
+   /// timer query that measures the render time of a frame
+   struct TimerQuery
+   {
+      /// query name
+      GLuint m_query;
+
+      /// indicates if the query was issued and its result wasn't read yet
+      bool m_isPending;
+   };
+
+   /// creates framebuffer object for given viewport size
+   bool CreateFramebuffer(unsigned int width, unsigned int height);
+
+   /// deletes framebuffer object
+   void DeleteFramebuffer();
+
+   /// passes render times of finished timer queries to the controller
+   void CollectRenderTimes();
+
+   /// draws the rendered 3d view into the viewport
+   void DrawScaledView();
+
+private:
+   /// indicates if dynamic resolution is used
+   bool m_isEnabled;
+
+   /// indicates if timer queries are used to measure render times
+   bool m_useTimerQueries;
+
+   /// controller that determines the render scale
+   DynamicResolutionController m_controller;
+
+   /// framebuffer object
+   GLuint m_framebuffer;
+
+   /// color texture attached to the framebuffer object
+   GLuint m_colorTexture;
+
+   /// depth renderbuffer attached to the framebuffer object
+   GLuint m_depthBuffer;
+
+   /// size of the framebuffer textures; powers of two
+   unsigned int m_framebufferXRes, m_framebufferYRes;
+
+   /// viewport size the framebuffer object was created for
+   unsigned int m_viewportWidth, m_viewportHeight;
+
+   /// 3d viewport position, in OpenGL window coordinates
+   int m_viewportX, m_viewportY;
+
+   /// resolution the 3d view was last rendered with
+   unsigned int m_renderXRes, m_renderYRes;
+
+   /// timer queries; used as ring buffer
+   std::vector<TimerQuery> m_timerQueries;
+
+   /// index of the timer query to issue next
+   size_t m_nextTimerQuery;
+
+   /// index of the timer query issued in the current frame; -1 when none
+   int m_activeTimerQuery;
+
+   /// performance counter value when rendering started; without timer queries
+   Uint64 m_renderStart;
+};
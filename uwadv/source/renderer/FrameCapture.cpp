@@ -0,0 +1,476 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameCapture.cpp
+/// \brief asynchronous capturing of rendered frames
+//
+#include "pch.hpp"
+#include "FrameCapture.hpp"
+#include "Settings.hpp"
+#include "FileSystem.hpp"
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+namespace Detail
+{
+   /// max. number of jobs for the worker thread; when more jobs are pending,
+   /// streamed frames are dropped
+   const size_t c_maxPendingJobs = 8;
+
+   /// Determines the number of a capture file, e.g. 42 for
+   /// "capture00042.bmp". Returns false when the filename has no number.
+   bool GetFileNumber(const std::string& filename, unsigned int& fileNumber)
+   {
+      std::string::size_type endPos = filename.find_last_of('.');
+      if (endPos == std::string::npos)
+         return false;
+
+      std::string::size_type startPos = endPos;
+      while (startPos > 0 && isdigit(static_cast<unsigned char>(filename[startPos - 1])))
+         startPos--;
+
+      if (startPos == endPos)
+         return false;
+
+      fileNumber = static_cast<unsigned int>(strtoul(filename.substr(startPos, endPos - startPos).c_str(), nullptr, 10));
+      return true;
+   }
+
+   // pixel buffer object functions; loaded in FrameCapture::Init()
+   PFNGLGENBUFFERSPROC glGenBuffers = nullptr;
+   PFNGLDELETEBUFFERSPROC glDeleteBuffers = nullptr;
+   PFNGLBINDBUFFERPROC glBindBuffer = nullptr;
+   PFNGLBUFFERDATAPROC glBufferData = nullptr;
+   PFNGLMAPBUFFERPROC glMapBuffer = nullptr;
+   PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+
+   /// loads pixel buffer object functions; returns false when not available
+   bool LoadPixelBufferFunctions()
+   {
+      if (SDL_GL_ExtensionSupported("GL_ARB_pixel_buffer_object") != SDL_TRUE)
+         return false;
+
+      glGenBuffers = reinterpret_cast<PFNGLGENBUFFERSPROC>(SDL_GL_GetProcAddress("glGenBuffers"));
+      glDeleteBuffers = reinterpret_cast<PFNGLDELETEBUFFERSPROC>(SDL_GL_GetProcAddress("glDeleteBuffers"));
+      glBindBuffer = reinterpret_cast<PFNGLBINDBUFFERPROC>(SDL_GL_GetProcAddress("glBindBuffer"));
+      glBufferData = reinterpret_cast<PFNGLBUFFERDATAPROC>(SDL_GL_GetProcAddress("glBufferData"));
+      glMapBuffer = reinterpret_cast<PFNGLMAPBUFFERPROC>(SDL_GL_GetProcAddress("glMapBuffer"));
+      glUnmapBuffer = reinterpret_cast<PFNGLUNMAPBUFFERPROC>(SDL_GL_GetProcAddress("glUnmapBuffer"));
+
+      return glGenBuffers != nullptr && glDeleteBuffers != nullptr &&
+         glBindBuffer != nullptr && glBufferData != nullptr &&
+         glMapBuffer != nullptr && glUnmapBuffer != nullptr;
+   }
+
+   /// copies pixels read back by OpenGL, flipping rows so that the top row
+   /// comes first
+   void CopyFlipped(const Uint32* pixels, CapturedFrame& frame)
+   {
+      for (unsigned int y = 0; y < frame.m_yres; y++)
+      {
+         const Uint32* row = pixels + (frame.m_yres - 1 - y) * frame.m_xres;
+         std::copy(row, row + frame.m_xres, frame.m_pixels.begin() + y * frame.m_xres);
+      }
+   }
+} // namespace Detail
+
+FrameCapture::FrameCapture()
+   :m_usePixelBuffers(false),
+   m_captureInterval(1),
+   m_isStreaming(false),
+   m_isScreenshotRequested(false),
+   m_frameNumber(0),
+   m_nextFileNumber(0),
+   m_numDroppedFrames(0),
+   m_workerThread(nullptr),
+   m_lock(SDL_CreateMutex()),
+   m_jobCondition(SDL_CreateCond()),
+   m_stopWorker(false),
+   m_numPendingJobs(0)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+   if (m_workerThread != nullptr)
+   {
+      SDL_LockMutex(m_lock);
+      m_stopWorker = true;
+      SDL_CondBroadcast(m_jobCondition);
+      SDL_UnlockMutex(m_lock);
+
+      SDL_WaitThread(m_workerThread, nullptr);
+   }
+
+   SDL_DestroyCond(m_jobCondition);
+   SDL_DestroyMutex(m_lock);
+}
+
+void FrameCapture::Init(const Base::Settings& settings)
+{
+   m_captureFolder = settings.GetString(Base::settingCaptureFolder);
+   m_captureInterval = static_cast<unsigned int>(std::max(1, settings.GetInt(Base::settingCaptureInterval)));
+
+   // continue numbering after the highest numbered file of earlier runs,
+   // so that no file is overwritten when files were deleted in between
+   std::vector<std::string> fileList;
+   Base::FileSystem::FindFiles(m_captureFolder + "*.bmp", fileList, false);
+
+   m_nextFileNumber = 0;
+   for (const std::string& filename : fileList)
+   {
+      unsigned int fileNumber = 0;
+      if (Detail::GetFileNumber(filename, fileNumber))
+         m_nextFileNumber = std::max(m_nextFileNumber, fileNumber + 1);
+   }
+
+   m_usePixelBuffers = Detail::LoadPixelBufferFunctions();
+
+   UaTrace("frame capture: %s\n", m_usePixelBuffers ?
+      "using pixel buffer objects" : "pixel buffer objects not available, using synchronous readback");
+
+   if (m_workerThread == nullptr)
+      m_workerThread = SDL_CreateThread(ThreadProc, "capture-thread", this);
+}
+
+void FrameCapture::Done()
+{
+   SetStreaming(false);
+   Flush();
+
+   if (m_usePixelBuffers && !m_freeBuffers.empty())
+      Detail::glDeleteBuffers(static_cast<GLsizei>(m_freeBuffers.size()), m_freeBuffers.data());
+
+   m_freeBuffers.clear();
+}
+
+/// The area is read back from the current back buffer, so the frame to
+/// capture must already be rendered.
+/// \param xpos x position of area, in window coordinates
+/// \param ypos y position of area, in OpenGL window coordinates, where 0 is
+///        the bottom row
+/// \param xres width of area
+/// \param yres height of area
+/// \param targetXRes width of captured frame; the area is downscaled when
+///        the width is smaller than the area
+/// \param targetYRes height of captured frame
+/// \param callback callback that is called with the captured frame
+void FrameCapture::StartCapture(int xpos, int ypos, unsigned int xres, unsigned int yres,
+   unsigned int targetXRes, unsigned int targetYRes, CaptureCallback callback)
+{
+   CaptureJob job;
+   job.m_frame.m_xres = xres;
+   job.m_frame.m_yres = yres;
+   job.m_targetXRes = targetXRes;
+   job.m_targetYRes = targetYRes;
+   job.m_callback = callback;
+
+   StartReadback(xpos, ypos, std::move(job));
+}
+
+void FrameCapture::SetStreaming(bool streaming)
+{
+   if (streaming == m_isStreaming)
+      return;
+
+   m_isStreaming = streaming;
+
+   if (streaming)
+   {
+      m_numDroppedFrames = 0;
+      UaTrace("frame capture: streaming every %u. frame to %s\n", m_captureInterval, m_captureFolder.c_str());
+   }
+   else
+      UaTrace("frame capture: streaming stopped, %u frames dropped\n", m_numDroppedFrames);
+}
+
+/// Finishes readbacks started in earlier frames and starts capturing the
+/// current frame, when a screenshot was requested or when streaming.
+/// \param windowWidth width of the window, in pixels
+/// \param windowHeight height of the window, in pixels
+void FrameCapture::NextFrame(unsigned int windowWidth, unsigned int windowHeight)
+{
+   // map pixel buffers of readbacks started in earlier frames
+   for (size_t index = 0; index < m_readbacks.size();)
+   {
+      if (m_readbacks[index].m_frameNumber == m_frameNumber)
+      {
+         index++;
+         continue;
+      }
+
+      FinishReadback(m_readbacks[index]);
+      m_readbacks.erase(m_readbacks.begin() + index);
+   }
+
+   if (m_isScreenshotRequested)
+   {
+      m_isScreenshotRequested = false;
+      StartFileCapture("screenshot", windowWidth, windowHeight);
+   }
+   else if (m_isStreaming && (m_frameNumber % m_captureInterval) == 0)
+   {
+      SDL_LockMutex(m_lock);
+      size_t numPendingJobs = m_numPendingJobs + m_readbacks.size();
+      SDL_UnlockMutex(m_lock);
+
+      // don't block rendering when the worker can't keep up
+      if (numPendingJobs >= Detail::c_maxPendingJobs)
+         m_numDroppedFrames++;
+      else
+         StartFileCapture("capture", windowWidth, windowHeight);
+   }
+
+   m_frameNumber++;
+
+   CallFinishedCallbacks();
+}
+
+void FrameCapture::Flush()
+{
+   for (Readback& readback : m_readbacks)
+      FinishReadback(readback);
+
+   m_readbacks.clear();
+
+   SDL_LockMutex(m_lock);
+
+   while (m_numPendingJobs > 0)
+      SDL_CondWait(m_jobCondition, m_lock);
+
+   SDL_UnlockMutex(m_lock);
+
+   CallFinishedCallbacks();
+}
+
+/// Averages all source pixels that are covered by a target pixel, so that
+/// no detail is lost when downscaling by non-integer factors. The target
+/// frame must have its size set.
+/// \param source source frame
+/// \param target target frame; m_xres and m_yres must be set
+void FrameCapture::Downscale(const CapturedFrame& source, CapturedFrame& target)
+{
+   target.m_pixels.resize(target.m_xres * target.m_yres);
+
+   for (unsigned int targetY = 0; targetY < target.m_yres; targetY++)
+   {
+      unsigned int sourceY1 = targetY * source.m_yres / target.m_yres;
+      unsigned int sourceY2 = std::max(sourceY1 + 1, (targetY + 1) * source.m_yres / target.m_yres);
+
+      for (unsigned int targetX = 0; targetX < target.m_xres; targetX++)
+      {
+         unsigned int sourceX1 = targetX * source.m_xres / target.m_xres;
+         unsigned int sourceX2 = std::max(sourceX1 + 1, (targetX + 1) * source.m_xres / target.m_xres);
+
+         unsigned int sum[4] = { 0, 0, 0, 0 };
+
+         for (unsigned int sourceY = sourceY1; sourceY < sourceY2; sourceY++)
+            for (unsigned int sourceX = sourceX1; sourceX < sourceX2; sourceX++)
+            {
+               Uint32 pixel = source.m_pixels[sourceY * source.m_xres + sourceX];
+               for (unsigned int channel = 0; channel < 4; channel++)
+                  sum[channel] += (pixel >> (channel * 8)) & 0xff;
+            }
+
+         unsigned int count = (sourceX2 - sourceX1) * (sourceY2 - sourceY1);
+
+         Uint32 pixel = 0;
+         for (unsigned int channel = 0; channel < 4; channel++)
+            pixel |= ((sum[channel] + count / 2) / count) << (channel * 8);
+
+         target.m_pixels[targetY * target.m_xres + targetX] = pixel;
+      }
+   }
+}
+
+/// \param prefix filename prefix
+/// \param windowWidth width of the window, in pixels
+/// \param windowHeight height of the window, in pixels
+void FrameCapture::StartFileCapture(const char* prefix, unsigned int windowWidth, unsigned int windowHeight)
+{
+   char filename[64];
+   snprintf(filename, sizeof(filename), "%s%05u.bmp", prefix, m_nextFileNumber++);
+
+   CaptureJob job;
+   job.m_frame.m_xres = job.m_targetXRes = windowWidth;
+   job.m_frame.m_yres = job.m_targetYRes = windowHeight;
+   job.m_filename = m_captureFolder + filename;
+
+   StartReadback(0, 0, std::move(job));
+}
+
+/// \param xpos x position of area, in window coordinates
+/// \param ypos y position of area, in OpenGL window coordinates
+/// \param job job with frame size set
+void FrameCapture::StartReadback(int xpos, int ypos, CaptureJob&& job)
+{
+   unsigned int xres = job.m_frame.m_xres;
+   unsigned int yres = job.m_frame.m_yres;
+
+   glPixelStorei(GL_PACK_ALIGNMENT, 4);
+   glReadBuffer(GL_BACK);
+
+   if (!m_usePixelBuffers)
+   {
+      // read back whole area at once
+      std::vector<Uint32> pixels(xres * yres);
+      glReadPixels(xpos, ypos, xres, yres, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+      job.m_frame.m_pixels.resize(xres * yres);
+      Detail::CopyFlipped(pixels.data(), job.m_frame);
+
+      QueueJob(std::move(job));
+      return;
+   }
+
+   Readback readback;
+   readback.m_frameNumber = m_frameNumber;
+   readback.m_job = std::move(job);
+
+   if (m_freeBuffers.empty())
+      Detail::glGenBuffers(1, &readback.m_buffer);
+   else
+   {
+      readback.m_buffer = m_freeBuffers.back();
+      m_freeBuffers.pop_back();
+   }
+
+   Detail::glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.m_buffer);
+   Detail::glBufferData(GL_PIXEL_PACK_BUFFER, xres * yres * sizeof(Uint32), nullptr, GL_STREAM_READ);
+
+   // starts an asynchronous transfer into the pixel buffer
+   glReadPixels(xpos, ypos, xres, yres, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+   Detail::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   m_readbacks.push_back(std::move(readback));
+}
+
+void FrameCapture::FinishReadback(Readback& readback)
+{
+   CapturedFrame& frame = readback.m_job.m_frame;
+   frame.m_pixels.resize(frame.m_xres * frame.m_yres);
+
+   Detail::glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.m_buffer);
+
+   const Uint32* pixels = reinterpret_cast<const Uint32*>(
+      Detail::glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY));
+
+   if (pixels != nullptr)
+   {
+      Detail::CopyFlipped(pixels, frame);
+      Detail::glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+   }
+   else
+      UaTrace("frame capture: couldn't map pixel buffer\n");
+
+   Detail::glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+   m_freeBuffers.push_back(readback.m_buffer);
+
+   QueueJob(std::move(readback.m_job));
+}
+
+void FrameCapture::QueueJob(CaptureJob&& job)
+{
+   SDL_LockMutex(m_lock);
+
+   m_jobQueue.push_back(std::move(job));
+   m_numPendingJobs++;
+
+   SDL_CondBroadcast(m_jobCondition);
+   SDL_UnlockMutex(m_lock);
+}
+
+void FrameCapture::CallFinishedCallbacks()
+{
+   std::vector<CaptureJob> finishedJobs;
+
+   SDL_LockMutex(m_lock);
+   finishedJobs.swap(m_finishedJobs);
+   SDL_UnlockMutex(m_lock);
+
+   for (const CaptureJob& job : finishedJobs)
+      job.m_callback(job.m_frame);
+}
+
+int FrameCapture::ThreadProc(void* param)
+{
+   FrameCapture* frameCapture = reinterpret_cast<FrameCapture*>(param);
+   frameCapture->RunWorker();
+
+   return 0;
+}
+
+void FrameCapture::RunWorker()
+{
+   SDL_LockMutex(m_lock);
+
+   for (;;)
+   {
+      while (m_jobQueue.empty() && !m_stopWorker)
+         SDL_CondWait(m_jobCondition, m_lock);
+
+      if (m_stopWorker)
+         break;
+
+      CaptureJob job = std::move(m_jobQueue.front());
+      m_jobQueue.pop_front();
+
+      SDL_UnlockMutex(m_lock);
+
+      if (job.m_targetXRes != job.m_frame.m_xres || job.m_targetYRes != job.m_frame.m_yres)
+      {
+         CapturedFrame target;
+         target.m_xres = job.m_targetXRes;
+         target.m_yres = job.m_targetYRes;
+
+         Downscale(job.m_frame, target);
+         job.m_frame = std::move(target);
+      }
+
+      if (!job.m_filename.empty())
+         SaveBitmap(job.m_frame, job.m_filename);
+
+      SDL_LockMutex(m_lock);
+
+      if (job.m_callback)
+         m_finishedJobs.push_back(std::move(job));
+
+      m_numPendingJobs--;
+      SDL_CondBroadcast(m_jobCondition);
+   }
+
+   SDL_UnlockMutex(m_lock);
+}
+
+void FrameCapture::SaveBitmap(const CapturedFrame& frame, const std::string& filename)
+{
+   std::string folder = filename.substr(0, filename.find_last_of("/\\") + 1);
+   if (!folder.empty() && !Base::FileSystem::FolderExists(folder))
+      Base::FileSystem::MakeFolder(folder);
+
+   SDL_Surface* surface = SDL_CreateRGBSurfaceWithFormatFrom(
+      const_cast<Uint32*>(frame.m_pixels.data()), frame.m_xres, frame.m_yres,
+      32, frame.m_xres * sizeof(Uint32), SDL_PIXELFORMAT_RGBA32);
+
+   if (surface == nullptr || SDL_SaveBMP(surface, filename.c_str()) != 0)
+      UaTrace("frame capture: couldn't save %s: %s\n", filename.c_str(), SDL_GetError());
+
+   SDL_FreeSurface(surface);
+}
@@ -0,0 +1,218 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameCapture.hpp
+/// \brief asynchronous capturing of rendered frames
+//
+#pragma once
+
+#include <functional>
+#include <vector>
+#include <deque>
+#include <string>
+
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
+namespace Base
+{
+   class Settings;
+}
+
+/// \brief captured frame, in RGBA format; the first row is the top row
+struct CapturedFrame
+{
+   /// ctor
+   CapturedFrame()
+      :m_xres(0),
+      m_yres(0)
+   {
+   }
+
+   /// frame width
+   unsigned int m_xres;
+
+   /// frame height
+   unsigned int m_yres;
+
+   /// frame pixels
+   std::vector<Uint32> m_pixels;
+};
+
+/// \brief Captures rendered frames without stalling the rendering pipeline
+/// A capture reads back an area of the back buffer into a pixel buffer
+/// object, which is mapped one frame later, when the GPU has finished
+/// rendering. The pixels are then downscaled and stored to disk on a worker
+/// thread. When pixel buffer objects aren't available, the area is read
+/// back with a single glReadPixels() call. Callbacks are called on the main
+/// thread, in NextFrame() or Flush(). Captures can also stream every n-th
+/// frame to the capture folder.
+class FrameCapture
+{
+public:
+   /// callback that is called with the captured frame
+   typedef std::function<void(const CapturedFrame&)> CaptureCallback;
+
+   /// ctor
+   FrameCapture();
+   /// dtor; stops worker thread
+   ~FrameCapture();
+
+   /// deleted copy ctor
+   FrameCapture(const FrameCapture&) = delete;
+   /// deleted assignment operator
+   FrameCapture& operator=(const FrameCapture&) = delete;
+
+   /// initializes frame capture; must be called with a current OpenGL context
+   void Init(const Base::Settings& settings);
+
+   /// finishes all captures and frees pixel buffers
+   void Done();
+
+   /// starts capturing an area of the back buffer, in window coordinates
+   void StartCapture(int xpos, int ypos, unsigned int xres, unsigned int yres,
+      unsigned int targetXRes, unsigned int targetYRes, CaptureCallback callback);
+
+   /// saves the next rendered frame as screenshot to the capture folder
+   void SaveScreenshot() { m_isScreenshotRequested = true; }
+
+   /// starts or stops streaming every n-th frame to the capture folder
+   void SetStreaming(bool streaming);
+
+   /// returns if frames are streamed to the capture folder
+   bool IsStreaming() const { return m_isStreaming; }
+
+   /// called after a frame was rendered, before swapping buffers
+   void NextFrame(unsigned int windowWidth, unsigned int windowHeight);
+
+   /// waits until all captures are finished and calls their callbacks
+   void Flush();
+
+   /// downscales frame to target size, averaging all covered pixels
+   static void Downscale(const CapturedFrame& source, CapturedFrame& target);
+
+private:
+   /// capture that is processed by the worker thread
+   struct CaptureJob
+   {
+      /// captured frame
+      CapturedFrame m_frame;
+
+      /// target frame width
+      unsigned int m_targetXRes;
+
+      /// target frame height
+      unsigned int m_targetYRes;
+
+      /// filename to store frame to; empty when not storing
+      std::string m_filename;
+
+      /// callback to call with the downscaled frame; may be empty
+      CaptureCallback m_callback;
+   };
+
+   /// capture with a pending pixel buffer readback
+   struct Readback
+   {
+      /// pixel buffer object
+      GLuint m_buffer;
+
+      /// frame number the readback was started in
+      unsigned int m_frameNumber;
+
+      /// job to process when the readback finished; without pixels
+      CaptureJob m_job;
+   };
+
+   /// starts capturing the whole back buffer to a file in the capture folder
+   void StartFileCapture(const char* prefix, unsigned int windowWidth, unsigned int windowHeight);
+
+   /// starts reading back an area of the back buffer
+   void StartReadback(int xpos, int ypos, CaptureJob&& job);
+
+   /// maps pixel buffer of readback and queues its job
+   void FinishReadback(Readback& readback);
+
+   /// queues job for worker thread
+   void QueueJob(CaptureJob&& job);
+
+   /// calls callbacks of all finished jobs
+   void CallFinishedCallbacks();
+
+   /// worker thread procedure
+   static int ThreadProc(void* param);
+
+   /// processes jobs until stopped
+   void RunWorker();
+
+   /// stores frame as bitmap file
+   static void SaveBitmap(const CapturedFrame& frame, const std::string& filename);
+
+private:
+   /// indicates if pixel buffer objects are used
+   bool m_usePixelBuffers;
+
+   /// capture folder
+   std::string m_captureFolder;
+
+   /// interval of frames that are streamed
+   unsigned int m_captureInterval;
+
+   /// indicates if frames are streamed
+   bool m_isStreaming;
+
+   /// indicates if the next frame should be saved as screenshot
+   bool m_isScreenshotRequested;
+
+   /// current frame number
+   unsigned int m_frameNumber;
+
+   /// number of the next stored file
+   unsigned int m_nextFileNumber;
+
+   /// number of streamed frames that were dropped, since the worker was busy
+   unsigned int m_numDroppedFrames;
+
+   /// pending pixel buffer readbacks
+   std::vector<Readback> m_readbacks;
+
+   /// unused pixel buffer objects
+   std::vector<GLuint> m_freeBuffers;
+
+   /// worker thread
+   SDL_Thread* m_workerThread;
+
+   /// lock for the job queues
+   SDL_mutex* m_lock;
+
+   /// condition that is signaled when a job is queued or finished
+   SDL_cond* m_jobCondition;
+
+   /// indicates that the worker thread should stop
+   bool m_stopWorker;
+
+   /// number of jobs queued or processed by the worker thread
+   size_t m_numPendingJobs;
+
+   /// jobs to process by the worker thread
+   std::deque<CaptureJob> m_jobQueue;
+
+   /// processed jobs whose callback must be called
+   std::vector<CaptureJob> m_finishedJobs;
+};
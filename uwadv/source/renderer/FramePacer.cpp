@@ -0,0 +1,162 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FramePacer.cpp
+/// \brief frame pacing for the main game loop
+//
+#include "pch.hpp"
+#include "FramePacer.hpp"
+#include <cmath>
+
+namespace Detail
+{
+   /// refresh rate used when the display doesn't report one
+   const unsigned int c_defaultRefreshRate = 60;
+
+   /// weight of a new measurement in the sleep time estimate
+   const double c_sleepEstimateWeight = 0.05;
+
+   /// pacing error in milliseconds above which a frame counts as late
+   const double c_lateFrameMilliseconds = 1.0;
+} // namespace Detail
+
+FramePacer::FramePacer()
+   :FramePacer(SDL_GetPerformanceCounter, SDL_Delay, SDL_GetPerformanceFrequency())
+{
+}
+
+/// \param counterFunc function that returns the current performance counter value
+/// \param delayFunc function that sleeps for given number of milliseconds
+/// \param counterFrequency performance counter ticks per second
+FramePacer::FramePacer(T_counterFunc counterFunc, T_delayFunc delayFunc, Uint64 counterFrequency)
+   :m_counterFunc(counterFunc),
+   m_delayFunc(delayFunc),
+   m_counterFrequency(counterFrequency),
+   m_ticksPerMillisecond(counterFrequency / 1000.0),
+   m_frameInterval(counterFrequency / Detail::c_defaultRefreshRate),
+   m_nextFrame(m_counterFunc() + m_frameInterval),
+   m_refreshInterval(m_frameInterval),
+   m_lastFrame(m_counterFunc()),
+   m_sleepMean(m_ticksPerMillisecond),
+   m_sleepVariance(0.0)
+{
+}
+
+/// \param maxFrameRate max. frames per second; 0 means no cap
+/// \param isVsyncEnabled indicates if swapping buffers waits for vsync
+/// \param refreshRate display refresh rate; 0 when unknown
+void FramePacer::Init(unsigned int maxFrameRate, bool isVsyncEnabled, unsigned int refreshRate)
+{
+   if (refreshRate == 0)
+      refreshRate = Detail::c_defaultRefreshRate;
+
+   unsigned int frameRate = 0;
+   if (maxFrameRate != 0 && (!isVsyncEnabled || maxFrameRate < refreshRate))
+      frameRate = maxFrameRate;
+   else if (maxFrameRate == 0 && !isVsyncEnabled)
+      frameRate = refreshRate;
+
+   m_frameInterval = frameRate == 0 ? 0 : m_counterFrequency / frameRate;
+   m_refreshInterval = m_counterFrequency / refreshRate;
+   m_lastFrame = m_counterFunc();
+   m_nextFrame = m_lastFrame + m_frameInterval;
+
+   if (frameRate == 0)
+      UaTrace("frame pacing: paced by vsync, with %u Hz\n", refreshRate);
+   else
+      UaTrace("frame pacing: %u frames/s, vsync %s\n", frameRate, isVsyncEnabled ? "on" : "off");
+}
+
+void FramePacer::WaitForNextFrame()
+{
+   if (m_frameInterval == 0)
+   {
+      // vsync paces the frames; only wait when swapping buffers didn't block
+      Uint64 dueTime = m_lastFrame + m_refreshInterval;
+
+      Uint64 frameTime = m_counterFunc() - m_lastFrame;
+      if (frameTime < m_refreshInterval / 2)
+         WaitUntil(dueTime);
+
+      m_lastFrame = m_counterFunc();
+
+      RecordFrame(m_lastFrame, dueTime);
+      return;
+   }
+
+   WaitUntil(m_nextFrame);
+
+   Uint64 now = m_counterFunc();
+
+   RecordFrame(now, m_nextFrame);
+
+   // when the frame took longer than the interval, don't try to catch up
+   m_nextFrame += m_frameInterval;
+   if (now > m_nextFrame)
+      m_nextFrame = now + m_frameInterval;
+}
+
+/// Sleeps in 1 ms steps as long as the remaining time is longer than a
+/// sleep is expected to take, then spins until the deadline.
+/// \param deadline performance counter value to wait for
+void FramePacer::WaitUntil(Uint64 deadline)
+{
+   for (;;)
+   {
+      Uint64 now = m_counterFunc();
+      if (now >= deadline)
+         break;
+
+      // expect sleeps to take a bit longer than average
+      double expectedSleepTime = m_sleepMean + std::sqrt(m_sleepVariance);
+
+      if (static_cast<double>(deadline - now) > expectedSleepTime)
+      {
+         m_delayFunc(1);
+         UpdateSleepEstimate(m_counterFunc() - now);
+      }
+   }
+}
+
+/// Frames that started before they were due, e.g. when a buffer swap
+/// returned a bit before the refresh interval elapsed, have no error.
+/// \param now performance counter value when the frame started
+/// \param dueTime performance counter value when the frame was due
+void FramePacer::RecordFrame(Uint64 now, Uint64 dueTime)
+{
+   double errorMilliseconds = now > dueTime ? (now - dueTime) / m_ticksPerMillisecond : 0.0;
+
+   m_statistics.m_numFrames++;
+   m_statistics.m_totalErrorMilliseconds += errorMilliseconds;
+   m_statistics.m_maxErrorMilliseconds = std::max(m_statistics.m_maxErrorMilliseconds, errorMilliseconds);
+
+   if (errorMilliseconds > Detail::c_lateFrameMilliseconds)
+      m_statistics.m_numLateFrames++;
+}
+
+/// Uses an exponential moving average of mean and variance, so that the
+/// estimate follows changes of the timer resolution.
+/// \param sleepTime measured time of a 1 ms sleep, in performance counter ticks
+void FramePacer::UpdateSleepEstimate(Uint64 sleepTime)
+{
+   double delta = static_cast<double>(sleepTime) - m_sleepMean;
+
+   m_sleepMean += Detail::c_sleepEstimateWeight * delta;
+   m_sleepVariance = (1.0 - Detail::c_sleepEstimateWeight) *
+      (m_sleepVariance + Detail::c_sleepEstimateWeight * delta * delta);
+}
@@ -0,0 +1,151 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FramePacer.hpp
+/// \brief frame pacing for the main game loop
+//
+#pragma once
+
+#include <functional>
+
+/// \brief statistics about frame pacing
+/// The pacing error is the time between the point in time a frame should
+/// have started and the point in time the pacer returned. When vsync paces
+/// the frames, a frame should start one refresh interval after the last one,
+/// so frames that missed a vsync count as late.
+struct FramePacingStatistics
+{
+   /// ctor
+   FramePacingStatistics()
+   {
+      Reset();
+   }
+
+   /// resets statistics
+   void Reset()
+   {
+      m_numFrames = 0;
+      m_numLateFrames = 0;
+      m_totalErrorMilliseconds = 0.0;
+      m_maxErrorMilliseconds = 0.0;
+   }
+
+   /// returns average pacing error, in milliseconds
+   double GetAverageErrorMilliseconds() const
+   {
+      return m_numFrames == 0 ? 0.0 : m_totalErrorMilliseconds / m_numFrames;
+   }
+
+   /// number of paced frames
+   unsigned int m_numFrames;
+
+   /// number of frames that started more than a millisecond late
+   unsigned int m_numLateFrames;
+
+   /// sum of pacing errors, in milliseconds
+   double m_totalErrorMilliseconds;
+
+   /// max. pacing error, in milliseconds
+   double m_maxErrorMilliseconds;
+};
+
+/// \brief Paces frames of the main game loop
+/// Waits until the next frame is due, using the high resolution performance
+/// counter. The pacer sleeps as long as the remaining time is longer than
+/// the time a sleep usually takes, and spins for the rest of the time. The
+/// sleep time is measured continuously, so the pacer adapts to the timer
+/// resolution of the system. When vsync is enabled, swapping buffers
+/// already waits for the display, and the pacer only waits when the frame
+/// rate is capped below the display refresh rate, or when swapping buffers
+/// returned early, e.g. for a hidden window. Without vsync and without a
+/// cap, frames are paced with the display refresh rate. The clock can be
+/// replaced, e.g. by a simulated clock in tests.
+class FramePacer
+{
+public:
+   /// function that returns the current performance counter value
+   typedef std::function<Uint64()> T_counterFunc;
+
+   /// function that sleeps for given number of milliseconds
+   typedef std::function<void(Uint32 milliseconds)> T_delayFunc;
+
+   /// ctor; paces frames with the default refresh rate
+   FramePacer();
+
+   /// ctor; uses given clock functions instead of the performance counter
+   FramePacer(T_counterFunc counterFunc, T_delayFunc delayFunc, Uint64 counterFrequency);
+
+   /// sets up frame pacing
+   void Init(unsigned int maxFrameRate, bool isVsyncEnabled, unsigned int refreshRate);
+
+   /// returns frame interval in performance counter ticks; 0 when not pacing
+   Uint64 GetFrameInterval() const { return m_frameInterval; }
+
+   /// waits until the next frame is due
+   void WaitForNextFrame();
+
+   /// waits until the performance counter reaches given value
+   void WaitUntil(Uint64 deadline);
+
+   /// returns pacing statistics
+   const FramePacingStatistics& GetStatistics() const { return m_statistics; }
+
+   /// resets pacing statistics
+   void ResetStatistics() { m_statistics.Reset(); }
+
+private:
+   /// updates the estimated sleep time with a measured sleep time
+   void UpdateSleepEstimate(Uint64 sleepTime);
+
+   /// records pacing error of a frame in the statistics
+   void RecordFrame(Uint64 now, Uint64 dueTime);
+
+private:
+   /// function that returns the current performance counter value
+   T_counterFunc m_counterFunc;
+
+   /// function that sleeps for given number of milliseconds
+   T_delayFunc m_delayFunc;
+
+   /// performance counter ticks per second
+   Uint64 m_counterFrequency;
+
+   /// performance counter ticks per millisecond
+   double m_ticksPerMillisecond;
+
+   /// frame interval in performance counter ticks; 0 when not pacing
+   Uint64 m_frameInterval;
+
+   /// performance counter value when the next frame is due
+   Uint64 m_nextFrame;
+
+   /// display refresh interval in performance counter ticks
+   Uint64 m_refreshInterval;
+
+   /// performance counter value when the last frame started
+   Uint64 m_lastFrame;
+
+   /// mean time of a 1 ms sleep, in performance counter ticks
+   double m_sleepMean;
+
+   /// variance of the time of a 1 ms sleep
+   double m_sleepVariance;
+
+   /// pacing statistics
+   FramePacingStatistics m_statistics;
+};
@@ -34,21 +34,20 @@ LevelTilemapRenderer::LevelTilemapRenderer(const Underworld::Level& level,
 }
 
 /// Renders a single tile. The function renders all triangles of that tile.
-/// The function uses glPushName() to let the SelectPick() method know what
-/// triangles belong to what tile.
 /// \param xpos tile x coordinate of visible tile
 /// \param ypos tile y coordinate of visible tile
 void LevelTilemapRenderer::RenderTile(unsigned int xpos, unsigned int ypos)
 {
-   glPushName((ypos << 8) + xpos);
+   RenderStatistics& statistics = m_textureManager.GetRenderStatistics();
+   statistics.m_numVisibleTiles++;
 
-   std::vector<Triangle3dTextured> allTriangles;
-   m_geometryProvider.GetTileTriangles(xpos, ypos, allTriangles);
+   m_allTriangles.clear();
+   m_geometryProvider.GetTileTriangles(xpos, ypos, m_allTriangles);
 
-   size_t maxTriangles = allTriangles.size();
+   size_t maxTriangles = m_allTriangles.size();
    for (size_t triangleIndex = 0; triangleIndex < maxTriangles; triangleIndex++)
    {
-      Triangle3dTextured& triangle = allTriangles[triangleIndex];
+      const Triangle3dTexturedFloat& triangle = m_allTriangles[triangleIndex];
 
       m_textureManager.Use(triangle.m_textureNumber);
 
@@ -56,19 +55,16 @@ void LevelTilemapRenderer::RenderTile(unsigned int xpos, unsigned int ypos)
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
       glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
-      // remember used texture number
-      glPushName(triangle.m_textureNumber + 0x0400);
-
       glBegin(GL_TRIANGLES);
       for (size_t vertexIndex = 0; vertexIndex < 3; vertexIndex++)
       {
-         glTexCoord2d(triangle.m_vertices[vertexIndex].u, triangle.m_vertices[vertexIndex].v);
-         glVertex3d(triangle.m_vertices[vertexIndex].pos.x, triangle.m_vertices[vertexIndex].pos.y,
-            triangle.m_vertices[vertexIndex].pos.z * c_renderHeightScale);
+         const Vertex3dFloat& vertex = triangle.m_vertices[vertexIndex];
+
+         glTexCoord2f(vertex.u, vertex.v);
+         glVertex3f(vertex.x, vertex.y, vertex.z * static_cast<float>(c_renderHeightScale));
       }
       glEnd();
-      glPopName();
-   }
 
-   glPopName();
+      statistics.AddDrawCall(1);
+   }
 }
@@ -50,4 +50,7 @@ private:
 
    /// geometry provider for level
    GeometryProvider m_geometryProvider;
+
+   /// triangles of the current tile; reused for all tiles
+   std::vector<Triangle3dTexturedFloat> m_allTriangles;
 };
@@ -30,27 +30,36 @@ MainGameLoop::MainGameLoop(const char* windowTitle, bool updateFrameCount)
 {
 }
 
+/// Runs ticks with the given tick rate, and renders frames as paced by the
+/// frame pacer. Times are measured using the high resolution performance
+/// counter.
+/// \param tickRate number of game ticks per second
 void MainGameLoop::RunGameLoop(unsigned int tickRate)
 {
    UaTrace("main loop started\n");
 
-   Uint32 now, then;
-   Uint32 fcstart;
+   Uint64 now, then;
+   Uint64 fcstart;
    unsigned int ticks = 0, renders = 0;
 
-   fcstart = then = SDL_GetTicks();
+   const Uint64 frequency = SDL_GetPerformanceFrequency();
+   const Uint64 tickInterval = frequency / tickRate;
+
+   fcstart = then = SDL_GetPerformanceCounter();
 
    bool resetTickTimer = false;
 
    m_exitLoop = false;
 
+   m_framePacer.ResetStatistics();
+
    while (!m_exitLoop)
    {
-      now = SDL_GetTicks();
+      now = SDL_GetPerformanceCounter();
 
-      while ((now - then) > (1000.0 / tickRate))
+      while ((now - then) > tickInterval)
       {
-         then += Uint32(1000.0 / tickRate);
+         then += tickInterval;
 
          OnTick(resetTickTimer);
 
@@ -68,7 +77,7 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
       // reset timer when needed
       if (resetTickTimer)
       {
-         then = now = SDL_GetTicks();
+         then = now = SDL_GetPerformanceCounter();
          resetTickTimer = false;
       }
 
@@ -83,38 +92,50 @@ void MainGameLoop::RunGameLoop(unsigned int tickRate)
 
       renders++;
 
-      if ((now - then) > (1000.0 / tickRate))
-         then = now - Uint32(1000.0 / tickRate);
+      if ((now - then) > tickInterval)
+         then = now - tickInterval;
 
       if (m_updateFrameCount)
       {
-         now = SDL_GetTicks();
+         now = SDL_GetPerformanceCounter();
 
-         if (now - fcstart > 2000)
+         if (now - fcstart > 2 * frequency)
          {
+            double seconds = double(now - fcstart) / frequency;
+            const FramePacingStatistics& statistics = m_framePacer.GetStatistics();
+
             // set new caption
             char buffer[256];
-            snprintf(buffer, sizeof(buffer), "%s: %3.1f ticks/s, %3.1f frames/s",
+            snprintf(buffer, sizeof(buffer),
+               "%s: %3.1f ticks/s, %3.1f frames/s, pacing error %.2f ms avg, %.2f ms max",
                m_windowTitle.c_str(),
-               ticks * 1000.0 / (now - fcstart), renders * 1000.0 / (now - fcstart));
+               ticks / seconds, renders / seconds,
+               statistics.GetAverageErrorMilliseconds(), statistics.m_maxErrorMilliseconds);
 
             UpdateCaption(buffer);
 
             // restart counting
             ticks = renders = 0;
             fcstart = now;
+            m_framePacer.ResetStatistics();
 #ifdef HAVE_DEBUG
             // reset time count when rendering lasted longer than 5 seconds
             // it's likely that we just debugged through some code
-            if (now - then > 5000)
+            if (now - then > 5 * frequency)
                then = now;
 #endif
          }
       }
 
-      SDL_Delay(1); // give up time slice
+      // wait until next frame is due
+      m_framePacer.WaitForNextFrame();
    }
 
+   const FramePacingStatistics& statistics = m_framePacer.GetStatistics();
+   UaTrace("frame pacing: %u frames, %u late, error %.2f ms avg, %.2f ms max\n",
+      statistics.m_numFrames, statistics.m_numLateFrames,
+      statistics.GetAverageErrorMilliseconds(), statistics.m_maxErrorMilliseconds);
+
    UaTrace("main loop ended\n\n");
 }
 
@@ -23,6 +23,7 @@
 
 #include <string>
 #include <atomic>
+#include "FramePacer.hpp"
 
 union SDL_Event;
 
@@ -39,6 +40,9 @@ public:
    /// quits game loop; can be called from other threads
    void QuitLoop();
 
+   /// returns frame pacer
+   FramePacer& GetFramePacer() { return m_framePacer; }
+
    // new virtual methods
 
    /// called to update caption
@@ -69,4 +73,7 @@ private:
 
    /// indicates if the application is currently active (in foreground)
    bool m_appActive;
+
+   /// frame pacer
+   FramePacer m_framePacer;
 };
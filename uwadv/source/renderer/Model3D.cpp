@@ -37,6 +37,8 @@ void Model3DManager::Init(IGame& game)
 
    Base::Settings& settings = game.GetSettings();
 
+   m_modelCache.Init(settings);
+
    // loading builtin models
    std::string underworldExeFilename =
       settings.GetString(Base::settingUnderworldPath);
@@ -50,9 +52,40 @@ void Model3DManager::Init(IGame& game)
    else
       underworldExeFilename.append("uwdemo.exe");
 
-   DecodeBuiltInModels(underworldExeFilename.c_str(), m_allBuiltInModels, false, isUw2);
+   LoadBuiltInModels(underworldExeFilename, isUw2);
 
    LoadModelConfigFile(settings, game.GetResourceManager());
+
+   m_modelCache.DumpStatistics();
+}
+
+/// Loads the builtin models. The executable is hashed to find the decoded
+/// models in the model cache; only when they're not cached, the models are
+/// decoded and tessellated.
+/// \param underworldExeFilename filename of the executable
+/// \param isUw2 indicates if the executable is from uw2
+void Model3DManager::LoadBuiltInModels(const std::string& underworldExeFilename, bool isUw2)
+{
+   std::vector<Uint8> exeData;
+   if (m_modelCache.IsEnabled())
+   {
+      Base::File file{ underworldExeFilename, Base::modeRead };
+      if (file.IsOpen())
+      {
+         exeData.resize(file.FileLength());
+         file.ReadBuffer(exeData.data(), exeData.size());
+      }
+   }
+
+   Uint64 key = Model3DCache::CalcKey(exeData, Model3DCache::cachedModelBuiltIn, isUw2 ? 1 : 0);
+
+   if (!exeData.empty() &&
+      m_modelCache.LoadBuiltInModels(key, m_allBuiltInModels))
+      return;
+
+   if (DecodeBuiltInModels(underworldExeFilename.c_str(), m_allBuiltInModels, false, isUw2) &&
+      !exeData.empty())
+      m_modelCache.StoreBuiltInModels(key, m_allBuiltInModels);
 }
 
 void Model3DManager::LoadModelConfigFile(const Base::Settings& settings, const Base::ResourceManager& resourceManager)
@@ -107,9 +140,43 @@ void Model3DManager::AddModel(const std::string& name, const std::string& value,
       UaTrace(" loading model %s\n", modelPath.c_str());
 
       Base::SDL_RWopsPtr rwops = resourceManager.GetResourceFile(modelPath.c_str());
+      if (rwops == nullptr)
+      {
+         UaTrace(" model file not available\n");
+         return;
+      }
+
+      std::vector<Uint8> modelData;
+      {
+         Base::File file{ rwops };
+         modelData.resize(file.FileLength());
+         file.ReadBuffer(modelData.data(), modelData.size());
+      }
+
+      Uint64 key = Model3DCache::CalcKey(modelData, Model3DCache::cachedModelVrml);
 
       Import::VrmlImporter importer{ resourceManager };
-      Model3DPtr model = importer.ImportWrl(rwops.get(), modelPath);
+
+      std::shared_ptr<Model3DVrml> model = std::make_shared<Model3DVrml>();
+      if (m_modelCache.LoadVrmlModel(key, *model))
+      {
+         importer.LoadTexture(*model, modelPath);
+      }
+      else
+      {
+         Base::SDL_RWopsPtr modelRwops = Base::MakeRWopsPtr(
+            SDL_RWFromConstMem(modelData.data(), static_cast<int>(modelData.size())));
+
+         model = importer.ImportWrl(modelRwops.get(), modelPath);
+
+         if (!model->AreIndicesValid())
+         {
+            UaTrace(" model file has invalid coord or texture coord indices\n");
+            return;
+         }
+
+         m_modelCache.StoreVrmlModel(key, *model);
+      }
 
       m_allModels.insert(std::make_pair(itemId, model));
    }
@@ -120,9 +187,12 @@ bool Model3DManager::IsModelAvailable(Uint16 itemId) const
    return m_allModels.find(itemId) != m_allModels.end();
 }
 
-void Model3DManager::Render(const RenderOptions& renderOptions,
-   const Vector3d& viewerPos, const Underworld::Object& object,
-   TextureManager& textureManager, Vector3d& base)
+/// Adds a model instance for the object. Instances aren't rendered
+/// immediately, but are collected by model, so that all instances of the
+/// same model can be rendered at once in RenderInstances().
+/// \param object object to render
+/// \param base base position of model
+void Model3DManager::AddInstance(const Underworld::Object& object, const Vector3d& base)
 {
    Uint16 itemId = object.GetObjectInfo().m_itemID;
 
@@ -130,7 +200,33 @@ void Model3DManager::Render(const RenderOptions& renderOptions,
       m_allModels.find(itemId);
 
    if (iter != m_allModels.end())
-      iter->second->Render(renderOptions, viewerPos, object, textureManager, base);
+   {
+      m_frameInstances[iter->second.get()].push_back(Model3DInstance{ &object, base });
+      m_numFrameInstances++;
+   }
+}
+
+/// Renders all model instances added since the last call, one model at a
+/// time. The number of draw calls depends on the number of distinct models,
+/// not on the number of instances, for models that support batching.
+/// \param renderOptions render options to use
+/// \param viewerPos viewer position
+/// \param textureManager texture manager
+void Model3DManager::RenderInstances(const RenderOptions& renderOptions,
+   const Vector3d& viewerPos, TextureManager& textureManager)
+{
+   for (auto& iter : m_frameInstances)
+   {
+      std::vector<Model3DInstance>& allInstances = iter.second;
+      if (allInstances.empty())
+         continue;
+
+      iter.first->RenderInstances(renderOptions, viewerPos, allInstances, textureManager);
+
+      allInstances.clear();
+   }
+
+   m_numFrameInstances = 0;
 }
 
 void Model3DManager::GetBoundingTriangles(const Underworld::Object& object,
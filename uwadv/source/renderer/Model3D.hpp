@@ -25,13 +25,25 @@
 #include "Triangle3d.hpp"
 #include "Texture.hpp"
 #include "Object.hpp"
+#include "Model3DCache.hpp"
 #include <map>
 #include <vector>
 #include <memory>
 
 class IGame;
+class TextureManager;
 struct RenderOptions;
 
+/// \brief instance of a 3d model, collected for rendering
+struct Model3DInstance
+{
+   /// object that is rendered using the model
+   const Underworld::Object* m_object;
+
+   /// base position of model
+   Vector3d m_base;
+};
+
 /// \brief 3d model base class
 class Model3D
 {
@@ -57,6 +69,19 @@ public:
       UNUSED(base);
    }
 
+   /// renders all instances of the model; the default implementation renders
+   /// every instance on its own
+   virtual void RenderInstances(const RenderOptions& renderOptions,
+      const Vector3d& viewerPos, const std::vector<Model3DInstance>& allInstances,
+      TextureManager& textureManager)
+   {
+      for (const Model3DInstance& instance : allInstances)
+      {
+         Vector3d base{ instance.m_base };
+         Render(renderOptions, viewerPos, *instance.m_object, textureManager, base);
+      }
+   }
+
    /// returns bounding triangles for collision detection
    virtual void GetBoundingTriangles(const Underworld::Object& object,
       Vector3d& base, std::vector<Triangle3dTextured>& allTriangles)
@@ -75,7 +100,10 @@ class Model3DManager
 {
 public:
    /// ctor
-   Model3DManager() {}
+   Model3DManager()
+      :m_numFrameInstances(0)
+   {
+   }
 
    /// init manager
    void Init(IGame& game);
@@ -83,16 +111,24 @@ public:
    /// returns if a 3d model for a certain item_id is available
    bool IsModelAvailable(Uint16 itemId) const;
 
-   /// renders a model
-   void Render(const RenderOptions& renderOptions,
-      const Vector3d& viewerPos, const Underworld::Object& object,
-      TextureManager& textureManager, Vector3d& base);
+   /// adds a model instance for an object, to be rendered in this frame
+   void AddInstance(const Underworld::Object& object, const Vector3d& base);
+
+   /// returns if there are model instances that weren't rendered yet
+   bool HasInstances() const { return m_numFrameInstances > 0; }
+
+   /// renders all model instances added since the last call
+   void RenderInstances(const RenderOptions& renderOptions,
+      const Vector3d& viewerPos, TextureManager& textureManager);
 
    /// returns bounding triangles for collision detection with given item_id
    void GetBoundingTriangles(const Underworld::Object& obj, Vector3d& base,
       std::vector<Triangle3dTextured>& allTriangles);
 
 private:
+   /// loads builtin models from executable, or from model cache
+   void LoadBuiltInModels(const std::string& underworldExeFilename, bool isUw2);
+
    /// loads model3d.cfg file
    void LoadModelConfigFile(const Base::Settings& settings, const Base::ResourceManager& resourceManager);
 
@@ -105,4 +141,14 @@ private:
 
    /// all builtin models from the exe
    std::vector<Model3DPtr> m_allBuiltInModels;
+
+   /// cache for decoded models
+   Model3DCache m_modelCache;
+
+   /// model instances to render in this frame, by model; the instance lists
+   /// are only cleared, to reuse their memory in the next frame
+   std::map<Model3D*, std::vector<Model3DInstance>> m_frameInstances;
+
+   /// number of model instances that weren't rendered yet
+   size_t m_numFrameInstances;
 };
@@ -23,6 +23,8 @@
 #include "Model3DBuiltIn.hpp"
 #include "TextureManager.hpp"
 #include "RenderOptions.hpp"
+#include "PaletteShader.hpp"
+#include <algorithm>
 
 extern bool DecodeBuiltInModels(const char* filename,
    std::vector<Model3DPtr>& allModels, bool dump = false, bool isUw2 = false);
@@ -48,7 +50,10 @@ void Model3DBuiltIn::Render(const RenderOptions& renderOptions,
       }
 
       if (tri.m_textureNumber == 0)
+      {
+         PaletteShader::Deactivate();
          glDisable(GL_TEXTURE_2D);
+      }
       else
       {
          textureManager.Use(tri.m_textureNumber);
@@ -91,6 +96,8 @@ void Model3DBuiltIn::Render(const RenderOptions& renderOptions,
 
       glEnd();
 
+      textureManager.GetRenderStatistics().AddDrawCall(1);
+
       if (tri.m_textureNumber == 0)
          glEnable(GL_TEXTURE_2D);
    }
@@ -102,9 +109,174 @@ void Model3DBuiltIn::Render(const RenderOptions& renderOptions,
       DrawExtentsBox(base);
 }
 
+/// Renders all instances of the model. Instead of submitting every vertex of
+/// every instance separately, the triangles of all instances are merged into
+/// vertex arrays and drawn with one draw call per texture. Vertex colors are
+/// lit the same way as in Render().
+/// \param renderOptions render options to use
+/// \param viewerPos viewer position
+/// \param allInstances all model instances to render
+/// \param textureManager texture manager
+void Model3DBuiltIn::RenderInstances(const RenderOptions& renderOptions,
+   const Vector3d& viewerPos, const std::vector<Model3DInstance>& allInstances,
+   TextureManager& textureManager)
+{
+   if (m_batchTriangles.size() != m_triangles.size())
+      PrepareBatch();
+
+   size_t numVertices = m_batchTriangles.size() * allInstances.size() * 3;
+   if (numVertices == 0)
+      return;
+
+   m_positionArray.resize(numVertices * 3);
+   m_texCoordArray.resize(numVertices * 2);
+   m_normalArray.resize(numVertices * 3);
+   m_colorArray.resize(numVertices * 3);
+
+   // fill vertex arrays; all instances of a texture range are consecutive
+   size_t vertexIndex = 0;
+   for (const TextureRange& range : m_textureRanges)
+   {
+      for (const Model3DInstance& instance : allInstances)
+      {
+         const Vector3d& base = instance.m_base;
+
+         for (size_t triangleIndex = range.m_firstTriangle;
+            triangleIndex < range.m_firstTriangle + range.m_numTriangles; triangleIndex++)
+         {
+            const Triangle3dTextured& tri = m_batchTriangles[triangleIndex];
+            const Vector3d& normal = m_batchNormals[triangleIndex];
+
+            Uint8 color[3] = { 255, 255, 255 };
+            if (tri.m_colorIndex != 0)
+               textureManager.GetPaletteColor(tri.m_colorIndex, color[0], color[1], color[2]);
+
+            for (unsigned index = 0; index < 3; index++, vertexIndex++)
+            {
+               const Vertex3d& vertex = tri.m_vertices[index];
+
+               Vector3d lightDirection = -viewerPos - (base + vertex.pos);
+               lightDirection.Normalize();
+
+               double diffuseFactor = std::abs(normal.Dot(lightDirection));
+
+               GLubyte* colorPtr = &m_colorArray[vertexIndex * 3];
+               colorPtr[0] = static_cast<GLubyte>(color[0] * diffuseFactor);
+               colorPtr[1] = static_cast<GLubyte>(color[1] * diffuseFactor);
+               colorPtr[2] = static_cast<GLubyte>(color[2] * diffuseFactor);
+
+               GLfloat* positionPtr = &m_positionArray[vertexIndex * 3];
+               positionPtr[0] = static_cast<GLfloat>(base.x + vertex.pos.x);
+               positionPtr[1] = static_cast<GLfloat>(base.y + vertex.pos.y);
+               positionPtr[2] = static_cast<GLfloat>(base.z + vertex.pos.z);
+
+               GLfloat* normalPtr = &m_normalArray[vertexIndex * 3];
+               normalPtr[0] = static_cast<GLfloat>(normal.x);
+               normalPtr[1] = static_cast<GLfloat>(normal.y);
+               normalPtr[2] = static_cast<GLfloat>(normal.z);
+
+               m_texCoordArray[vertexIndex * 2 + 0] = static_cast<GLfloat>(vertex.u);
+               m_texCoordArray[vertexIndex * 2 + 1] = static_cast<GLfloat>(vertex.v);
+            }
+         }
+      }
+   }
+
+   glDisable(GL_CULL_FACE);
+
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+   glEnableClientState(GL_NORMAL_ARRAY);
+   glEnableClientState(GL_COLOR_ARRAY);
+
+   glVertexPointer(3, GL_FLOAT, 0, m_positionArray.data());
+   glTexCoordPointer(2, GL_FLOAT, 0, m_texCoordArray.data());
+   glNormalPointer(GL_FLOAT, 0, m_normalArray.data());
+   glColorPointer(3, GL_UNSIGNED_BYTE, 0, m_colorArray.data());
+
+   RenderStatistics& statistics = textureManager.GetRenderStatistics();
+
+   GLint firstVertex = 0;
+   for (const TextureRange& range : m_textureRanges)
+   {
+      GLsizei rangeVertices = static_cast<GLsizei>(range.m_numTriangles * allInstances.size() * 3);
+
+      if (range.m_textureNumber == 0)
+      {
+         PaletteShader::Deactivate();
+         glDisable(GL_TEXTURE_2D);
+      }
+      else
+         textureManager.Use(range.m_textureNumber);
+
+      glDrawArrays(GL_TRIANGLES, firstVertex, rangeVertices);
+
+      statistics.AddDrawCall(static_cast<unsigned int>(rangeVertices / 3));
+
+      if (range.m_textureNumber == 0)
+         glEnable(GL_TEXTURE_2D);
+
+      firstVertex += rangeVertices;
+   }
+
+   glDisableClientState(GL_COLOR_ARRAY);
+   glDisableClientState(GL_NORMAL_ARRAY);
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glDisableClientState(GL_VERTEX_ARRAY);
+
+   glEnable(GL_CULL_FACE);
+   glColor3ub(192, 192, 192);
+
+   if (renderOptions.m_renderBoundingBoxes)
+   {
+      for (const Model3DInstance& instance : allInstances)
+         DrawExtentsBox(instance.m_base);
+   }
+}
+
+/// Sorts the triangles by texture number, so that all triangles with the
+/// same texture can be drawn with a single draw call, and calculates the
+/// normal vectors, which don't change between frames.
+void Model3DBuiltIn::PrepareBatch()
+{
+   m_batchTriangles = m_triangles;
+
+   std::stable_sort(m_batchTriangles.begin(), m_batchTriangles.end(),
+      [](const Triangle3dTextured& tri1, const Triangle3dTextured& tri2)
+      {
+         return tri1.m_textureNumber < tri2.m_textureNumber;
+      });
+
+   m_batchNormals.clear();
+   m_textureRanges.clear();
+
+   for (size_t triangleIndex = 0; triangleIndex < m_batchTriangles.size(); triangleIndex++)
+   {
+      const Triangle3dTextured& tri = m_batchTriangles[triangleIndex];
+
+      // same normal as calculated in Render()
+      Vector3d normal, vec1(tri.m_vertices[1].pos), vec2(tri.m_vertices[2].pos);
+      vec1 -= tri.m_vertices[0].pos;
+      vec2 -= tri.m_vertices[0].pos;
+
+      normal = Vector3d::Cross(vec1, vec2);
+      normal.Normalize();
+      normal *= -1;
+
+      m_batchNormals.push_back(normal);
+
+      if (m_textureRanges.empty() ||
+         m_textureRanges.back().m_textureNumber != tri.m_textureNumber)
+         m_textureRanges.push_back(TextureRange{ tri.m_textureNumber, triangleIndex, 0 });
+
+      m_textureRanges.back().m_numTriangles++;
+   }
+}
+
 void Model3DBuiltIn::DrawExtentsBox(const Vector3d& base)
 {
    glColor3ub(255, 255, 255);
+   PaletteShader::Deactivate();
    glDisable(GL_TEXTURE_2D);
 
    Vector3d ext{ m_extents };
@@ -184,6 +356,8 @@ void Model3DSpecial::Render(const RenderOptions& renderOptions,
       glTexCoord2d(0.0, 1.0); glVertex3d(base.x - ext.x, base.y + ext.y, base.z);
       glTexCoord2d(1.0, 1.0); glVertex3d(base.x + ext.x, base.y + ext.y, base.z);
       glEnd();
+
+      textureManager.GetRenderStatistics().AddDrawCall(4);
    }
    else if (itemId >= 0x0140 && itemId < 0x0150)
    {
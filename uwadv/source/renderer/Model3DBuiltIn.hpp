@@ -29,22 +29,55 @@ class Model3DBuiltIn : public Model3D
 public:
    /// ctor
    Model3DBuiltIn() {}
+   /// ctor, taking already decoded model
+   Model3DBuiltIn(const Vector3d& extents, const std::vector<Triangle3dTextured>& triangles)
+      :m_extents(extents),
+      m_triangles(triangles)
+   {
+   }
    /// dtor
    virtual ~Model3DBuiltIn() {}
 
+   /// returns model extents
+   const Vector3d& GetExtents() const { return m_extents; }
+
+   /// returns all triangles
+   const std::vector<Triangle3dTextured>& GetTriangles() const { return m_triangles; }
+
    /// renders model
    virtual void Render(const RenderOptions& renderOptions,
       const Vector3d& viewerPos, const Underworld::Object& object,
       TextureManager& textureManager, Vector3d& base) override;
 
+   /// renders all instances of the model, batched by texture
+   virtual void RenderInstances(const RenderOptions& renderOptions,
+      const Vector3d& viewerPos, const std::vector<Model3DInstance>& allInstances,
+      TextureManager& textureManager) override;
+
    /// returns bounding triangles for collision detection
    virtual void GetBoundingTriangles(const Underworld::Object& object,
       Vector3d& base, std::vector<Triangle3dTextured>& allTriangles) override;
 
 private:
+   /// range of batch triangles that use the same texture
+   struct TextureRange
+   {
+      /// stock texture number; 0 when not textured
+      Uint16 m_textureNumber;
+
+      /// index of first triangle in m_batchTriangles
+      size_t m_firstTriangle;
+
+      /// number of triangles
+      size_t m_numTriangles;
+   };
+
    /// draws a wireframe extents bounding box around the 3D model
    void DrawExtentsBox(const Vector3d& base);
 
+   /// prepares triangles and normals for batched rendering
+   void PrepareBatch();
+
 private:
    /// model extents
    Vector3d m_extents;
@@ -52,6 +85,27 @@ private:
    /// all triangles
    std::vector<Triangle3dTextured> m_triangles;
 
+   /// all triangles, sorted by texture number; empty when not prepared yet
+   std::vector<Triangle3dTextured> m_batchTriangles;
+
+   /// normal vectors of batch triangles
+   std::vector<Vector3d> m_batchNormals;
+
+   /// texture ranges of batch triangles
+   std::vector<TextureRange> m_textureRanges;
+
+   /// vertex positions of all instances; reused every frame
+   std::vector<GLfloat> m_positionArray;
+
+   /// texture coordinates of all instances
+   std::vector<GLfloat> m_texCoordArray;
+
+   /// vertex normals of all instances
+   std::vector<GLfloat> m_normalArray;
+
+   /// vertex colors of all instances
+   std::vector<GLubyte> m_colorArray;
+
    // friend decoding function
    friend bool DecodeBuiltInModels(const char* filename,
       std::vector<Model3DPtr>& allModels, bool dump, bool isUw2);
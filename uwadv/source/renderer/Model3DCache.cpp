@@ -0,0 +1,524 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Model3DCache.cpp
+/// \brief on-disk cache for decoded 3d models
+//
+#include "pch.hpp"
+#include "Model3DCache.hpp"
+#include "Model3DBuiltIn.hpp"
+#include "Model3DVrml.hpp"
+#include "Settings.hpp"
+#include "File.hpp"
+#include "FileSystem.hpp"
+
+namespace Detail
+{
+   /// magic value at the start of each cached model file ("UAMC")
+   const Uint32 c_modelCacheFileMagic = 0x434d4155;
+
+   /// file format version of cache files; increase when the format, the
+   /// model decoder or the .wrl importer changes
+   const Uint32 c_modelCacheVersion = 1;
+
+   /// triangle as stored in the cache file; the array of triangles is read
+   /// with a single copy
+   struct CachedTriangle
+   {
+      /// vertex positions
+      double m_positions[3][3];
+
+      /// vertex texture coordinates
+      double m_texCoords[3][2];
+
+      /// stock texture number
+      Uint16 m_textureNumber;
+
+      /// color palette index
+      Uint8 m_colorIndex;
+
+      /// flat shaded flag
+      Uint8 m_flatShaded;
+   };
+
+   /// writes cache file contents to a memory buffer
+   class CacheWriter
+   {
+   public:
+      /// writes raw values, in host byte order
+      void Write(const void* data, size_t length)
+      {
+         const Uint8* bytes = static_cast<const Uint8*>(data);
+         m_buffer.insert(m_buffer.end(), bytes, bytes + length);
+      }
+
+      /// writes a 32-bit value
+      void Write32(Uint32 value)
+      {
+         Write(&value, sizeof(value));
+      }
+
+      /// returns written data
+      const std::vector<Uint8>& GetBuffer() const { return m_buffer; }
+
+   private:
+      /// buffer with written data
+      std::vector<Uint8> m_buffer;
+   };
+
+   /// reads cache file contents from a memory buffer, checking the bounds
+   class CacheReader
+   {
+   public:
+      /// ctor
+      CacheReader(const std::vector<Uint8>& buffer)
+         :m_buffer(buffer),
+         m_pos(0)
+      {
+      }
+
+      /// reads raw values; returns false when the buffer is too short
+      bool Read(void* data, size_t length)
+      {
+         if (length > m_buffer.size() - m_pos)
+            return false;
+
+         if (length > 0)
+            memcpy(data, m_buffer.data() + m_pos, length);
+
+         m_pos += length;
+         return true;
+      }
+
+      /// reads a 32-bit value
+      bool Read32(Uint32& value)
+      {
+         return Read(&value, sizeof(value));
+      }
+
+      /// returns if the whole buffer was read
+      bool IsAtEnd() const { return m_pos == m_buffer.size(); }
+
+   private:
+      /// buffer to read from
+      const std::vector<Uint8>& m_buffer;
+
+      /// current read position
+      size_t m_pos;
+   };
+
+   /// writes a vector of values with a count prefix
+   template <typename T>
+   void WriteArray(CacheWriter& writer, const std::vector<T>& values)
+   {
+      writer.Write32(static_cast<Uint32>(values.size()));
+      writer.Write(values.data(), values.size() * sizeof(T));
+   }
+
+   /// reads a vector of values with a count prefix
+   template <typename T>
+   bool ReadArray(CacheReader& reader, std::vector<T>& values, size_t maxCount)
+   {
+      Uint32 count = 0;
+      if (!reader.Read32(count) || count > maxCount)
+         return false;
+
+      values.resize(count);
+      return reader.Read(values.data(), count * sizeof(T));
+   }
+
+   /// reads whole file into memory
+   bool ReadFile(const std::string& filename, std::vector<Uint8>& data)
+   {
+      Base::File file{ filename, Base::modeRead };
+      if (!file.IsOpen())
+         return false;
+
+      long fileLength = file.FileLength();
+      if (fileLength <= 0)
+         return false;
+
+      data.resize(static_cast<size_t>(fileLength));
+      return file.ReadBuffer(data.data(), data.size()) == data.size();
+   }
+} // namespace Detail
+
+Model3DCache::Model3DCache()
+   :m_numHits(0),
+   m_numMisses(0),
+   m_numStores(0)
+{
+}
+
+/// Initializes the model cache. The cache files are stored in the texture
+/// cache folder; when no folder is set or the folder can't be created, the
+/// cache stays disabled.
+/// \param settings settings to read cache folder from
+void Model3DCache::Init(const Base::Settings& settings)
+{
+   m_cacheFolder = settings.GetString(Base::settingTextureCacheFolder);
+
+   if (m_cacheFolder.empty())
+      return;
+
+   try
+   {
+      if (!Base::FileSystem::FolderExists(m_cacheFolder))
+         Base::FileSystem::MakeFolder(m_cacheFolder);
+   }
+   catch (const Base::FileSystemException& ex)
+   {
+      UNUSED(ex);
+      UaTrace("model cache disabled; couldn't create folder %s (%s)\n",
+         m_cacheFolder.c_str(), ex.what());
+
+      m_cacheFolder.clear();
+   }
+}
+
+/// Calculates a cache key, using the 64-bit FNV-1a hash function over the
+/// source file contents, the model type and the cache file version.
+/// \param sourceData contents of the source file, e.g. the executable or the
+///        .wrl file
+/// \param modelType type of cached model
+/// \param variant additional value that determines decoding, e.g. if the
+///        models of uw2 are decoded
+/// \return calculated cache key
+Uint64 Model3DCache::CalcKey(const std::vector<Uint8>& sourceData, CachedModelType modelType,
+   Uint32 variant)
+{
+   const Uint64 fnvPrime = 0x00000100000001b3ULL;
+   Uint64 hash = 0xcbf29ce484222325ULL;
+
+   auto hashBytes = [&](const Uint8* data, size_t length)
+   {
+      for (size_t index = 0; index < length; index++)
+      {
+         hash ^= data[index];
+         hash *= fnvPrime;
+      }
+   };
+
+   Uint32 header[3] = { Detail::c_modelCacheVersion, static_cast<Uint32>(modelType), variant };
+   hashBytes(reinterpret_cast<const Uint8*>(header), sizeof(header));
+
+   hashBytes(sourceData.data(), sourceData.size());
+
+   return hash;
+}
+
+/// Loads all builtin models from the cache file. When the file is invalid,
+/// it is removed.
+/// \param key cache key, calculated with CalcKey()
+/// \param allModels model list to add loaded models to
+/// \return true when the models were loaded from cache
+bool Model3DCache::LoadBuiltInModels(Uint64 key, std::vector<Model3DPtr>& allModels)
+{
+   if (!IsEnabled())
+      return false;
+
+   std::string filename = GetCacheFilename(key);
+
+   std::vector<Uint8> data;
+   if (!Base::FileSystem::FileExists(filename) ||
+      !Detail::ReadFile(filename, data))
+   {
+      m_numMisses++;
+      return false;
+   }
+
+   Detail::CacheReader reader{ data };
+
+   Uint32 header[5] = {};
+   bool isValid = reader.Read(header, sizeof(header)) &&
+      header[0] == Detail::c_modelCacheFileMagic &&
+      header[1] == Detail::c_modelCacheVersion &&
+      header[2] == static_cast<Uint32>(key & 0xffffffff) &&
+      header[3] == static_cast<Uint32>(key >> 32) &&
+      header[4] == cachedModelBuiltIn;
+
+   Uint32 numModels = 0;
+   isValid = isValid && reader.Read32(numModels);
+
+   std::vector<Model3DPtr> loadedModels;
+   std::vector<Detail::CachedTriangle> cachedTriangles;
+
+   std::vector<Triangle3dTextured> triangles;
+
+   for (Uint32 modelIndex = 0; isValid && modelIndex < numModels; modelIndex++)
+   {
+      double extents[3] = {};
+      isValid = reader.Read(extents, sizeof(extents)) &&
+         Detail::ReadArray(reader, cachedTriangles, data.size() / sizeof(Detail::CachedTriangle));
+
+      if (!isValid)
+         break;
+
+      triangles.resize(cachedTriangles.size());
+      for (size_t triangleIndex = 0; triangleIndex < cachedTriangles.size(); triangleIndex++)
+      {
+         const Detail::CachedTriangle& cachedTriangle = cachedTriangles[triangleIndex];
+         Triangle3dTextured& triangle = triangles[triangleIndex];
+
+         for (unsigned int point = 0; point < 3; point++)
+         {
+            triangle.Set(point,
+               cachedTriangle.m_positions[point][0],
+               cachedTriangle.m_positions[point][1],
+               cachedTriangle.m_positions[point][2],
+               cachedTriangle.m_texCoords[point][0],
+               cachedTriangle.m_texCoords[point][1]);
+         }
+
+         triangle.m_textureNumber = cachedTriangle.m_textureNumber;
+         triangle.m_colorIndex = cachedTriangle.m_colorIndex;
+         triangle.m_flatShaded = cachedTriangle.m_flatShaded != 0;
+      }
+
+      loadedModels.push_back(std::make_shared<Model3DBuiltIn>(
+         Vector3d(extents[0], extents[1], extents[2]), triangles));
+   }
+
+   if (!isValid || !reader.IsAtEnd())
+   {
+      UaTrace("model cache: removing invalid cache file %s\n", filename.c_str());
+      Base::FileSystem::RemoveFile(filename);
+
+      m_numMisses++;
+      return false;
+   }
+
+   allModels.insert(allModels.end(), loadedModels.begin(), loadedModels.end());
+
+   m_numHits++;
+   return true;
+}
+
+/// Stores all builtin models in a cache file.
+/// \param key cache key, calculated with CalcKey()
+/// \param allModels builtin models to store
+void Model3DCache::StoreBuiltInModels(Uint64 key, const std::vector<Model3DPtr>& allModels)
+{
+   if (!IsEnabled())
+      return;
+
+   Detail::CacheWriter writer;
+   writer.Write32(Detail::c_modelCacheFileMagic);
+   writer.Write32(Detail::c_modelCacheVersion);
+   writer.Write32(static_cast<Uint32>(key & 0xffffffff));
+   writer.Write32(static_cast<Uint32>(key >> 32));
+   writer.Write32(cachedModelBuiltIn);
+   writer.Write32(static_cast<Uint32>(allModels.size()));
+
+   for (const Model3DPtr& modelPtr : allModels)
+   {
+      const Model3DBuiltIn* model = dynamic_cast<const Model3DBuiltIn*>(modelPtr.get());
+      UaAssert(model != nullptr);
+      if (model == nullptr)
+         return;
+
+      const Vector3d& modelExtents = model->GetExtents();
+      double extents[3] = { modelExtents.x, modelExtents.y, modelExtents.z };
+      writer.Write(extents, sizeof(extents));
+
+      const std::vector<Triangle3dTextured>& triangles = model->GetTriangles();
+
+      // value-initializing also clears the padding bytes
+      std::vector<Detail::CachedTriangle> cachedTriangles(triangles.size());
+
+      for (size_t triangleIndex = 0; triangleIndex < cachedTriangles.size(); triangleIndex++)
+      {
+         const Triangle3dTextured& triangle = triangles[triangleIndex];
+         Detail::CachedTriangle& cachedTriangle = cachedTriangles[triangleIndex];
+
+         for (unsigned int point = 0; point < 3; point++)
+         {
+            const Vertex3d& vertex = triangle.m_vertices[point];
+            cachedTriangle.m_positions[point][0] = vertex.pos.x;
+            cachedTriangle.m_positions[point][1] = vertex.pos.y;
+            cachedTriangle.m_positions[point][2] = vertex.pos.z;
+            cachedTriangle.m_texCoords[point][0] = vertex.u;
+            cachedTriangle.m_texCoords[point][1] = vertex.v;
+         }
+
+         cachedTriangle.m_textureNumber = triangle.m_textureNumber;
+         cachedTriangle.m_colorIndex = triangle.m_colorIndex;
+         cachedTriangle.m_flatShaded = triangle.m_flatShaded ? 1 : 0;
+      }
+
+      Detail::WriteArray(writer, cachedTriangles);
+   }
+
+   Base::File file{ GetCacheFilename(key), Base::modeWrite };
+   if (!file.IsOpen())
+      return;
+
+   file.WriteBuffer(writer.GetBuffer().data(), writer.GetBuffer().size());
+   m_numStores++;
+}
+
+/// Loads the vertex and index lists and the texture URL of a .wrl model from
+/// the cache file. The texture itself isn't cached. When the file is invalid,
+/// it is removed.
+/// \param key cache key, calculated with CalcKey()
+/// \param model model to load
+/// \return true when the model was loaded from cache
+bool Model3DCache::LoadVrmlModel(Uint64 key, Model3DVrml& model)
+{
+   if (!IsEnabled())
+      return false;
+
+   std::string filename = GetCacheFilename(key);
+
+   std::vector<Uint8> data;
+   if (!Base::FileSystem::FileExists(filename) ||
+      !Detail::ReadFile(filename, data))
+   {
+      m_numMisses++;
+      return false;
+   }
+
+   Detail::CacheReader reader{ data };
+
+   Uint32 header[5] = {};
+   std::vector<double> coords, texCoords;
+   std::vector<Uint32> coordIndex, texCoordIndex;
+   std::vector<char> textureUrl;
+
+   size_t maxCount = data.size();
+   bool isValid = reader.Read(header, sizeof(header)) &&
+      header[0] == Detail::c_modelCacheFileMagic &&
+      header[1] == Detail::c_modelCacheVersion &&
+      header[2] == static_cast<Uint32>(key & 0xffffffff) &&
+      header[3] == static_cast<Uint32>(key >> 32) &&
+      header[4] == cachedModelVrml &&
+      Detail::ReadArray(reader, coords, maxCount) &&
+      Detail::ReadArray(reader, texCoords, maxCount) &&
+      Detail::ReadArray(reader, coordIndex, maxCount) &&
+      Detail::ReadArray(reader, texCoordIndex, maxCount) &&
+      Detail::ReadArray(reader, textureUrl, maxCount) &&
+      reader.IsAtEnd() &&
+      coords.size() % 3 == 0 &&
+      texCoords.size() % 2 == 0;
+
+   if (!isValid)
+   {
+      UaTrace("model cache: removing invalid cache file %s\n", filename.c_str());
+      Base::FileSystem::RemoveFile(filename);
+
+      m_numMisses++;
+      return false;
+   }
+
+   model.m_coords.resize(coords.size() / 3);
+   for (size_t index = 0; index < model.m_coords.size(); index++)
+      model.m_coords[index].Set(coords[index * 3 + 0], coords[index * 3 + 1], coords[index * 3 + 2]);
+
+   model.m_texCoords.resize(texCoords.size() / 2);
+   for (size_t index = 0; index < model.m_texCoords.size(); index++)
+      model.m_texCoords[index].Set(texCoords[index * 2 + 0], texCoords[index * 2 + 1]);
+
+   model.m_coordIndex.assign(coordIndex.begin(), coordIndex.end());
+   model.m_texCoordIndex.assign(texCoordIndex.begin(), texCoordIndex.end());
+   model.m_textureUrl.assign(textureUrl.begin(), textureUrl.end());
+
+   if (!model.AreIndicesValid())
+   {
+      UaTrace("model cache: removing cache file %s with invalid coord or texture coord indices\n",
+         filename.c_str());
+      Base::FileSystem::RemoveFile(filename);
+
+      model.m_coords.clear();
+      model.m_texCoords.clear();
+      model.m_coordIndex.clear();
+      model.m_texCoordIndex.clear();
+      model.m_textureUrl.clear();
+
+      m_numMisses++;
+      return false;
+   }
+
+   m_numHits++;
+   return true;
+}
+
+/// Stores the vertex and index lists and the texture URL of a .wrl model in a
+/// cache file.
+/// \param key cache key, calculated with CalcKey()
+/// \param model model to store
+void Model3DCache::StoreVrmlModel(Uint64 key, const Model3DVrml& model)
+{
+   if (!IsEnabled())
+      return;
+
+   std::vector<double> coords;
+   coords.reserve(model.m_coords.size() * 3);
+   for (const Vector3d& coord : model.m_coords)
+   {
+      coords.push_back(coord.x);
+      coords.push_back(coord.y);
+      coords.push_back(coord.z);
+   }
+
+   std::vector<double> texCoords;
+   texCoords.reserve(model.m_texCoords.size() * 2);
+   for (const Vector2d& texCoord : model.m_texCoords)
+   {
+      texCoords.push_back(texCoord.x);
+      texCoords.push_back(texCoord.y);
+   }
+
+   std::vector<Uint32> coordIndex(model.m_coordIndex.begin(), model.m_coordIndex.end());
+   std::vector<Uint32> texCoordIndex(model.m_texCoordIndex.begin(), model.m_texCoordIndex.end());
+   std::vector<char> textureUrl(model.m_textureUrl.begin(), model.m_textureUrl.end());
+
+   Detail::CacheWriter writer;
+   writer.Write32(Detail::c_modelCacheFileMagic);
+   writer.Write32(Detail::c_modelCacheVersion);
+   writer.Write32(static_cast<Uint32>(key & 0xffffffff));
+   writer.Write32(static_cast<Uint32>(key >> 32));
+   writer.Write32(cachedModelVrml);
+
+   Detail::WriteArray(writer, coords);
+   Detail::WriteArray(writer, texCoords);
+   Detail::WriteArray(writer, coordIndex);
+   Detail::WriteArray(writer, texCoordIndex);
+   Detail::WriteArray(writer, textureUrl);
+
+   Base::File file{ GetCacheFilename(key), Base::modeWrite };
+   if (!file.IsOpen())
+      return;
+
+   file.WriteBuffer(writer.GetBuffer().data(), writer.GetBuffer().size());
+   m_numStores++;
+}
+
+void Model3DCache::DumpStatistics() const
+{
+   UaTrace("model cache statistics: folder: %s, hits: %u, misses: %u, stored: %u\n",
+      IsEnabled() ? m_cacheFolder.c_str() : "(disabled)",
+      m_numHits, m_numMisses, m_numStores);
+}
+
+std::string Model3DCache::GetCacheFilename(Uint64 key) const
+{
+   char buffer[32];
+   snprintf(buffer, sizeof(buffer), "%016" SDL_PRIx64 ".m3d", key);
+
+   return m_cacheFolder + buffer;
+}
@@ -0,0 +1,99 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Model3DCache.hpp
+/// \brief on-disk cache for decoded 3d models
+//
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+
+namespace Base
+{
+   class Settings;
+}
+
+class Model3D;
+class Model3DVrml;
+
+/// \brief on-disk cache for decoded 3d models
+/// Decoding the builtin models from the executable needs tessellating all
+/// polygons, and loading .wrl models needs running the VRML lexer. Both
+/// results only depend on the source file, so the decoded triangle lists,
+/// vertex and index lists and texture references are stored in a binary
+/// cache file, using a key that is calculated from the source file contents.
+/// When the source file changes, the key changes, too, and the model is
+/// decoded again. The cache files are stored in the texture cache folder and
+/// are only meant to be used on the machine that created them.
+class Model3DCache
+{
+public:
+   /// type of cached models; part of the cache key
+   enum CachedModelType
+   {
+      cachedModelBuiltIn = 1, ///< all builtin models of an executable
+      cachedModelVrml = 2,    ///< single .wrl model
+   };
+
+   /// ctor
+   Model3DCache();
+
+   /// initializes model cache; reads cache folder from settings
+   void Init(const Base::Settings& settings);
+
+   /// returns if the model cache is enabled
+   bool IsEnabled() const { return !m_cacheFolder.empty(); }
+
+   /// calculates cache key from source file contents and model type
+   static Uint64 CalcKey(const std::vector<Uint8>& sourceData, CachedModelType modelType,
+      Uint32 variant = 0);
+
+   /// loads all builtin models from cache; returns false when not cached
+   bool LoadBuiltInModels(Uint64 key, std::vector<std::shared_ptr<Model3D>>& allModels);
+
+   /// stores all builtin models in cache
+   void StoreBuiltInModels(Uint64 key, const std::vector<std::shared_ptr<Model3D>>& allModels);
+
+   /// loads .wrl model from cache; returns false when not cached
+   bool LoadVrmlModel(Uint64 key, Model3DVrml& model);
+
+   /// stores .wrl model in cache
+   void StoreVrmlModel(Uint64 key, const Model3DVrml& model);
+
+   /// dumps cache statistics
+   void DumpStatistics() const;
+
+private:
+   /// returns filename of cached model file
+   std::string GetCacheFilename(Uint64 key) const;
+
+private:
+   /// cache folder, ending with a path separator; empty when disabled
+   std::string m_cacheFolder;
+
+   /// number of models loaded from cache
+   unsigned int m_numHits;
+
+   /// number of models that weren't found in the cache
+   unsigned int m_numMisses;
+
+   /// number of models stored in the cache
+   unsigned int m_numStores;
+};
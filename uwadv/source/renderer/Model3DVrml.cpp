@@ -22,18 +22,15 @@
 #include "pch.hpp"
 #include "Model3DVrml.hpp"
 #include "Texture.hpp"
+#include "TextureManager.hpp"
 
 void Model3DVrml::Render(const RenderOptions& renderOptions,
    const Vector3d& viewerPos, const Underworld::Object& object,
    TextureManager& textureManager, Vector3d& base)
 {
-   m_texture.Use();
+   UseTexture(textureManager);
 
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+   RenderStatistics& statistics = textureManager.GetRenderStatistics();
 
    // render all triangles in list
    size_t max = m_coordIndex.size();
@@ -58,7 +55,64 @@ void Model3DVrml::Render(const RenderOptions& renderOptions,
       }
 
       glEnd();
+
+      statistics.AddDrawCall(1);
+   }
+}
+
+/// Renders all instances of the model. The triangles of all instances are
+/// merged into vertex arrays and drawn with a single draw call, since the
+/// model only uses one texture.
+/// \param renderOptions render options to use
+/// \param viewerPos viewer position
+/// \param allInstances all model instances to render
+/// \param textureManager texture manager
+void Model3DVrml::RenderInstances(const RenderOptions& /*renderOptions*/,
+   const Vector3d& /*viewerPos*/, const std::vector<Model3DInstance>& allInstances,
+   TextureManager& textureManager)
+{
+   size_t numModelVertices = m_coordIndex.size() - m_coordIndex.size() % 3;
+   size_t numVertices = numModelVertices * allInstances.size();
+   if (numVertices == 0)
+      return;
+
+   UseTexture(textureManager);
+
+   m_positionArray.resize(numVertices * 3);
+   m_texCoordArray.resize(numVertices * 2);
+
+   size_t vertexIndex = 0;
+   for (const Model3DInstance& instance : allInstances)
+   {
+      const Vector3d& base = instance.m_base;
+
+      for (size_t index = 0; index < numModelVertices; index++, vertexIndex++)
+      {
+         const Vector3d& vec3d = m_coords[m_coordIndex[index]];
+         const Vector2d& vec2d = m_texCoords[m_texCoordIndex[index]];
+
+         GLfloat* positionPtr = &m_positionArray[vertexIndex * 3];
+         positionPtr[0] = static_cast<GLfloat>(vec3d.x + base.x);
+         positionPtr[1] = static_cast<GLfloat>(vec3d.y + base.y);
+         positionPtr[2] = static_cast<GLfloat>(vec3d.z + base.z);
+
+         m_texCoordArray[vertexIndex * 2 + 0] = static_cast<GLfloat>(vec2d.x * m_texture.GetTexU());
+         m_texCoordArray[vertexIndex * 2 + 1] = static_cast<GLfloat>(vec2d.y * m_texture.GetTexV());
+      }
    }
+
+   glEnableClientState(GL_VERTEX_ARRAY);
+   glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+   glVertexPointer(3, GL_FLOAT, 0, m_positionArray.data());
+   glTexCoordPointer(2, GL_FLOAT, 0, m_texCoordArray.data());
+
+   glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(numVertices));
+
+   glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+   glDisableClientState(GL_VERTEX_ARRAY);
+
+   textureManager.GetRenderStatistics().AddDrawCall(static_cast<unsigned int>(numVertices / 3));
 }
 
 void Model3DVrml::GetBoundingTriangles(const Underworld::Object& object,
@@ -66,3 +120,60 @@ void Model3DVrml::GetBoundingTriangles(const Underworld::Object& object,
 {
    // TODO implement
 }
+
+/// Checks that the index lists describe whole triangles, that there is a
+/// texture coordinate index for every coordinate index, and that all indices
+/// are in range. Malformed or truncated .wrl files or cache files would
+/// otherwise lead to reading outside of the coordinate lists when rendering.
+/// \return true when all indices are valid
+bool Model3DVrml::AreIndicesValid() const
+{
+   if (m_coordIndex.size() % 3 != 0 ||
+      m_texCoordIndex.size() != m_coordIndex.size())
+      return false;
+
+   for (unsigned int coordIndex : m_coordIndex)
+      if (coordIndex >= m_coords.size())
+         return false;
+
+   for (unsigned int texCoordIndex : m_texCoordIndex)
+      if (texCoordIndex >= m_texCoords.size())
+         return false;
+
+   return true;
+}
+
+void Model3DVrml::UseTexture(TextureManager& textureManager)
+{
+   if (!m_isTextureUploaded)
+      UploadTexture();
+
+   m_texture.Use();
+
+   textureManager.GetRenderStatistics().m_numTextureBinds++;
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+}
+
+void Model3DVrml::UploadTexture()
+{
+   m_isTextureUploaded = true;
+
+   if (m_textureFileData.empty())
+      return;
+
+   m_texture.Init(1);
+
+   Base::SDL_RWopsPtr rwops = Base::MakeRWopsPtr(
+      SDL_RWFromConstMem(m_textureFileData.data(), static_cast<int>(m_textureFileData.size())));
+
+   m_texture.Load(rwops);
+   m_texture.Upload();
+
+   m_textureFileData.clear();
+   m_textureFileData.shrink_to_fit();
+}
@@ -28,12 +28,18 @@ namespace Import
    class VrmlImporter;
 }
 
-/// A model loaded from a .wrl file
+/// \brief A model loaded from a .wrl file
+/// The model texture is loaded when importing, but only uploaded when the
+/// model is rendered the first time, so that importing doesn't need an
+/// OpenGL context.
 class Model3DVrml : public Model3D
 {
 public:
    /// ctor
-   Model3DVrml() {}
+   Model3DVrml()
+      :m_isTextureUploaded(false)
+   {
+   }
    /// dtor
    virtual ~Model3DVrml() {}
 
@@ -42,12 +48,28 @@ public:
       const Vector3d& viewerPos, const Underworld::Object& object,
       TextureManager& textureManager, Vector3d& base) override;
 
+   /// renders all instances of the model in one draw call
+   virtual void RenderInstances(const RenderOptions& renderOptions,
+      const Vector3d& viewerPos, const std::vector<Model3DInstance>& allInstances,
+      TextureManager& textureManager) override;
+
    /// returns bounding triangles for collision detection
    virtual void GetBoundingTriangles(const Underworld::Object& object,
       Vector3d& base, std::vector<Triangle3dTextured>& allTriangles) override;
 
+   /// returns if all triangles only refer to existing coordinates
+   bool AreIndicesValid() const;
+
+private:
+   /// uploads texture from texture file data
+   void UploadTexture();
+
+   /// sets up model texture for rendering
+   void UseTexture(TextureManager& textureManager);
+
 private:
    friend Import::VrmlImporter;
+   friend class Model3DCache;
 
    /// vertex coordinates
    std::vector<Vector3d> m_coords;
@@ -61,6 +83,21 @@ private:
    /// texture coordinates indices
    std::vector<unsigned int> m_texCoordIndex;
 
+   /// texture URL, relative to the .wrl file
+   std::string m_textureUrl;
+
+   /// contents of texture file; cleared when uploaded
+   std::vector<Uint8> m_textureFileData;
+
+   /// indicates if texture was already uploaded
+   bool m_isTextureUploaded;
+
    /// model texture
    Texture m_texture;
+
+   /// vertex positions of all instances; reused every frame
+   std::vector<GLfloat> m_positionArray;
+
+   /// texture coordinates of all instances
+   std::vector<GLfloat> m_texCoordArray;
 };
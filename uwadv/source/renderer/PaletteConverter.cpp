@@ -0,0 +1,169 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteConverter.cpp
+/// \brief palette-indexed to 32-bit RGBA pixel conversion
+//
+#include "pch.hpp"
+#include "PaletteConverter.hpp"
+
+namespace Detail
+{
+   /// converts pixels using a plain scalar loop
+   void ConvertScalar(const Uint8* pixels, Uint32* texels, size_t numPixels,
+      const Uint32* palette, int transparentIndex)
+   {
+      if (transparentIndex == PaletteConverter::c_noTransparentIndex)
+      {
+         for (size_t index = 0; index < numPixels; index++)
+            texels[index] = palette[pixels[index]];
+      }
+      else
+      {
+         for (size_t index = 0; index < numPixels; index++)
+         {
+            Uint8 pixel = pixels[index];
+            texels[index] = pixel == transparentIndex ? 0 : palette[pixel];
+         }
+      }
+   }
+
+#ifdef HAVE_X86_INTRINSICS
+   /// converts pixels using SSE2; the palette lookup is done with scalar
+   /// loads, but four texels are stored at once
+   void ConvertSSE2(const Uint8* pixels, Uint32* texels, size_t numPixels,
+      const Uint32* palette, int transparentIndex)
+   {
+      size_t index = 0;
+      size_t numBlocks = numPixels & ~size_t(3);
+
+      if (transparentIndex == PaletteConverter::c_noTransparentIndex)
+      {
+         for (; index < numBlocks; index += 4)
+         {
+            const Uint8* pixel = pixels + index;
+
+            __m128i value = _mm_set_epi32(
+               palette[pixel[3]], palette[pixel[2]], palette[pixel[1]], palette[pixel[0]]);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + index), value);
+         }
+      }
+      else
+      {
+         __m128i transparent = _mm_set1_epi32(transparentIndex);
+
+         for (; index < numBlocks; index += 4)
+         {
+            const Uint8* pixel = pixels + index;
+
+            __m128i indices = _mm_set_epi32(pixel[3], pixel[2], pixel[1], pixel[0]);
+            __m128i value = _mm_set_epi32(
+               palette[pixel[3]], palette[pixel[2]], palette[pixel[1]], palette[pixel[0]]);
+
+            // clear all texels with transparent index
+            __m128i mask = _mm_cmpeq_epi32(indices, transparent);
+            value = _mm_andnot_si128(mask, value);
+
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(texels + index), value);
+         }
+      }
+
+      ConvertScalar(pixels + index, texels + index, numPixels - index, palette, transparentIndex);
+   }
+
+   /// converts pixels using AVX2; eight texels are loaded at once, using a
+   /// gather load from the palette
+   TARGET_AVX2
+   void ConvertAVX2(const Uint8* pixels, Uint32* texels, size_t numPixels,
+      const Uint32* palette, int transparentIndex)
+   {
+      size_t index = 0;
+      size_t numBlocks = numPixels & ~size_t(7);
+
+      const int* paletteInt = reinterpret_cast<const int*>(palette);
+
+      __m256i transparent = _mm256_set1_epi32(transparentIndex);
+      bool checkTransparent = transparentIndex != PaletteConverter::c_noTransparentIndex;
+
+      for (; index < numBlocks; index += 8)
+      {
+         __m128i indices8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixels + index));
+         __m256i indices = _mm256_cvtepu8_epi32(indices8);
+
+         __m256i value = _mm256_i32gather_epi32(paletteInt, indices, 4);
+
+         if (checkTransparent)
+         {
+            // clear all texels with transparent index
+            __m256i mask = _mm256_cmpeq_epi32(indices, transparent);
+            value = _mm256_andnot_si256(mask, value);
+         }
+
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(texels + index), value);
+      }
+
+      ConvertScalar(pixels + index, texels + index, numPixels - index, palette, transparentIndex);
+   }
+#endif
+
+} // namespace Detail
+
+/// \param pixels palette-indexed pixels to convert
+/// \param texels texel array to store converted texels; must have space for
+/// numPixels texels
+/// \param numPixels number of pixels to convert
+/// \param palette 256 color palette, in GL_RGBA format
+/// \param transparentIndex palette index that is converted to a texel with
+/// value 0, regardless of the palette entry; c_noTransparentIndex when all
+/// pixels should use the palette entry
+void PaletteConverter::Convert(const Uint8* pixels, Uint32* texels, size_t numPixels,
+   const Uint32* palette, int transparentIndex)
+{
+   Convert(Base::GetBestSimdKernel(), pixels, texels, numPixels, palette, transparentIndex);
+}
+
+/// Converts pixels using the given kernel. The kernel must be supported by
+/// the CPU; check with Base::IsSimdKernelSupported() first.
+/// \param kernel kernel to use for conversion
+/// \param pixels palette-indexed pixels to convert
+/// \param texels texel array to store converted texels
+/// \param numPixels number of pixels to convert
+/// \param palette 256 color palette, in GL_RGBA format
+/// \param transparentIndex palette index that is converted to a texel with
+/// value 0; c_noTransparentIndex when all pixels should use the palette entry
+void PaletteConverter::Convert(Base::SimdKernel kernel, const Uint8* pixels, Uint32* texels,
+   size_t numPixels, const Uint32* palette, int transparentIndex)
+{
+   switch (kernel)
+   {
+#ifdef HAVE_X86_INTRINSICS
+   case Base::kernelSSE2:
+      Detail::ConvertSSE2(pixels, texels, numPixels, palette, transparentIndex);
+      break;
+
+   case Base::kernelAVX2:
+      Detail::ConvertAVX2(pixels, texels, numPixels, palette, transparentIndex);
+      break;
+#endif
+
+   default:
+      Detail::ConvertScalar(pixels, texels, numPixels, palette, transparentIndex);
+      break;
+   }
+}
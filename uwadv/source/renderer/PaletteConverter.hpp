@@ -0,0 +1,44 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteConverter.hpp
+/// \brief palette-indexed to 32-bit RGBA pixel conversion
+//
+#pragma once
+
+#include "CpuFeatures.hpp"
+
+/// \brief Converts palette-indexed pixels to 32-bit RGBA texels
+/// The conversion has several kernels, using SSE2 128-bit stores or AVX2
+/// 256-bit gather loads, when available, or a plain scalar loop. The best
+/// kernel for the current CPU is selected at runtime, using
+/// Base::GetBestSimdKernel(). All kernels produce the same result.
+class PaletteConverter
+{
+public:
+   /// value for transparentIndex when no index should be transparent
+   static const int c_noTransparentIndex = -1;
+
+   /// converts pixels to texels, using the best available kernel
+   static void Convert(const Uint8* pixels, Uint32* texels, size_t numPixels,
+      const Uint32* palette, int transparentIndex = c_noTransparentIndex);
+
+   /// converts pixels to texels, using given kernel
+   static void Convert(Base::SimdKernel kernel, const Uint8* pixels, Uint32* texels,
+      size_t numPixels, const Uint32* palette, int transparentIndex = c_noTransparentIndex);
+};
@@ -0,0 +1,348 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteShader.cpp
+/// \brief shader for palette-indexed textures
+//
+#include "pch.hpp"
+#include "PaletteShader.hpp"
+#include "Palette256.hpp"
+#include <vector>
+
+namespace Detail
+{
+   // shader functions; loaded in PaletteShader::Init()
+   PFNGLCREATESHADERPROC glCreateShader = nullptr;
+   PFNGLSHADERSOURCEPROC glShaderSource = nullptr;
+   PFNGLCOMPILESHADERPROC glCompileShader = nullptr;
+   PFNGLGETSHADERIVPROC glGetShaderiv = nullptr;
+   PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog = nullptr;
+   PFNGLDELETESHADERPROC glDeleteShader = nullptr;
+   PFNGLCREATEPROGRAMPROC glCreateProgram = nullptr;
+   PFNGLATTACHSHADERPROC glAttachShader = nullptr;
+   PFNGLLINKPROGRAMPROC glLinkProgram = nullptr;
+   PFNGLGETPROGRAMIVPROC glGetProgramiv = nullptr;
+   PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog = nullptr;
+   PFNGLDELETEPROGRAMPROC glDeleteProgram = nullptr;
+   PFNGLUSEPROGRAMPROC glUseProgram = nullptr;
+   PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation = nullptr;
+   PFNGLUNIFORM1IPROC glUniform1i = nullptr;
+   PFNGLUNIFORM2FPROC glUniform2f = nullptr;
+   PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
+
+   /// loads shader functions; returns false when OpenGL 2.0 isn't available
+   bool LoadShaderFunctions()
+   {
+      const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+      if (version == nullptr || atoi(version) < 2)
+         return false;
+
+      glCreateShader = reinterpret_cast<PFNGLCREATESHADERPROC>(SDL_GL_GetProcAddress("glCreateShader"));
+      glShaderSource = reinterpret_cast<PFNGLSHADERSOURCEPROC>(SDL_GL_GetProcAddress("glShaderSource"));
+      glCompileShader = reinterpret_cast<PFNGLCOMPILESHADERPROC>(SDL_GL_GetProcAddress("glCompileShader"));
+      glGetShaderiv = reinterpret_cast<PFNGLGETSHADERIVPROC>(SDL_GL_GetProcAddress("glGetShaderiv"));
+      glGetShaderInfoLog = reinterpret_cast<PFNGLGETSHADERINFOLOGPROC>(SDL_GL_GetProcAddress("glGetShaderInfoLog"));
+      glDeleteShader = reinterpret_cast<PFNGLDELETESHADERPROC>(SDL_GL_GetProcAddress("glDeleteShader"));
+      glCreateProgram = reinterpret_cast<PFNGLCREATEPROGRAMPROC>(SDL_GL_GetProcAddress("glCreateProgram"));
+      glAttachShader = reinterpret_cast<PFNGLATTACHSHADERPROC>(SDL_GL_GetProcAddress("glAttachShader"));
+      glLinkProgram = reinterpret_cast<PFNGLLINKPROGRAMPROC>(SDL_GL_GetProcAddress("glLinkProgram"));
+      glGetProgramiv = reinterpret_cast<PFNGLGETPROGRAMIVPROC>(SDL_GL_GetProcAddress("glGetProgramiv"));
+      glGetProgramInfoLog = reinterpret_cast<PFNGLGETPROGRAMINFOLOGPROC>(SDL_GL_GetProcAddress("glGetProgramInfoLog"));
+      glDeleteProgram = reinterpret_cast<PFNGLDELETEPROGRAMPROC>(SDL_GL_GetProcAddress("glDeleteProgram"));
+      glUseProgram = reinterpret_cast<PFNGLUSEPROGRAMPROC>(SDL_GL_GetProcAddress("glUseProgram"));
+      glGetUniformLocation = reinterpret_cast<PFNGLGETUNIFORMLOCATIONPROC>(SDL_GL_GetProcAddress("glGetUniformLocation"));
+      glUniform1i = reinterpret_cast<PFNGLUNIFORM1IPROC>(SDL_GL_GetProcAddress("glUniform1i"));
+      glUniform2f = reinterpret_cast<PFNGLUNIFORM2FPROC>(SDL_GL_GetProcAddress("glUniform2f"));
+      glActiveTexture = reinterpret_cast<PFNGLACTIVETEXTUREPROC>(SDL_GL_GetProcAddress("glActiveTexture"));
+
+      return glCreateShader != nullptr && glShaderSource != nullptr &&
+         glCompileShader != nullptr && glGetShaderiv != nullptr &&
+         glGetShaderInfoLog != nullptr && glDeleteShader != nullptr &&
+         glCreateProgram != nullptr && glAttachShader != nullptr &&
+         glLinkProgram != nullptr && glGetProgramiv != nullptr &&
+         glGetProgramInfoLog != nullptr && glDeleteProgram != nullptr &&
+         glUseProgram != nullptr && glGetUniformLocation != nullptr &&
+         glUniform1i != nullptr && glUniform2f != nullptr &&
+         glActiveTexture != nullptr;
+   }
+
+   /// GLSL version line; GLSL 1.10 is available with every OpenGL 2.0
+   /// implementation, including Mesa's software renderers
+   const char* c_shaderVersion = "#version 110\n";
+
+   /// vertex shader; transforms vertices like the fixed-function pipeline
+   /// and passes on the distance used for fog
+   const char* c_vertexShaderSource = R"(
+void main()
+{
+   gl_Position = ftransform();
+   gl_TexCoord[0] = gl_TextureMatrix[0] * gl_MultiTexCoord0;
+   gl_FrontColor = gl_Color;
+   gl_FogFragCoord = abs((gl_ModelViewMatrix * gl_Vertex).z);
+}
+)";
+
+   /// fragment shader; looks up texel colors in the palette texture, with
+   /// SMOOTHING defined filters the four nearest texel colors, and applies
+   /// GL_EXP2 fog as set up by Renderer::SetupFor3D()
+   const char* c_fragmentShaderSource = R"(
+uniform sampler2D indexTexture;
+uniform sampler2D paletteTexture;
+uniform vec2 textureSize;
+uniform bool useFog;
+
+vec4 LookupColor(vec2 texelPos)
+{
+   // sample at texel centers, so that the texture filter doesn't matter
+   float index = texture2D(indexTexture, (texelPos + 0.5) / textureSize).r;
+   return texture2D(paletteTexture, vec2((index * 255.0 + 0.5) / 256.0, 0.5));
+}
+
+void main()
+{
+   vec2 texelPos = gl_TexCoord[0].xy * textureSize;
+
+#ifdef SMOOTHING
+   texelPos -= 0.5;
+   vec2 basePos = floor(texelPos);
+   vec2 weight = texelPos - basePos;
+
+   vec4 color = mix(
+      mix(LookupColor(basePos), LookupColor(basePos + vec2(1.0, 0.0)), weight.x),
+      mix(LookupColor(basePos + vec2(0.0, 1.0)), LookupColor(basePos + vec2(1.0, 1.0)), weight.x),
+      weight.y);
+#else
+   vec4 color = LookupColor(floor(texelPos));
+#endif
+
+   color *= gl_Color;
+
+   if (useFog)
+   {
+      float fogFactor = exp(-pow(gl_Fog.density * gl_FogFragCoord, 2.0));
+      color.rgb = mix(gl_Fog.color.rgb, color.rgb, clamp(fogFactor, 0.0, 1.0));
+   }
+
+   gl_FragColor = color;
+}
+)";
+
+} // namespace Detail
+
+PaletteShader* PaletteShader::s_activeShader = nullptr;
+
+PaletteShader::PaletteShader()
+   :m_program(0),
+   m_paletteTexture(0),
+   m_textureSizeLocation(-1),
+   m_useFogLocation(-1),
+   m_lastXRes(0),
+   m_lastYRes(0)
+{
+}
+
+PaletteShader::~PaletteShader()
+{
+   Done();
+}
+
+/// Compiles and links the shader program and uploads the palette to the
+/// palette texture. Must be called with a current OpenGL context. When the
+/// shader program isn't available, e.g. because OpenGL 2.0 isn't supported
+/// or compiling failed, textures must be converted to RGBA instead.
+/// \param palette palette to use
+/// \param smoothing when true, the shader smoothes textures
+/// \return true when the shader program is available
+bool PaletteShader::Init(Palette256& palette, bool smoothing)
+{
+   Done();
+
+   if (!Detail::LoadShaderFunctions())
+   {
+      UaTrace("palette shader: OpenGL 2.0 not available\n");
+      return false;
+   }
+
+   const char* smoothingDefine = smoothing ? "#define SMOOTHING\n" : "";
+   std::string fragmentSource = std::string(smoothingDefine) + Detail::c_fragmentShaderSource;
+
+   GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, Detail::c_vertexShaderSource);
+   GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource.c_str());
+
+   if (vertexShader != 0 && fragmentShader != 0)
+   {
+      m_program = Detail::glCreateProgram();
+      Detail::glAttachShader(m_program, vertexShader);
+      Detail::glAttachShader(m_program, fragmentShader);
+      Detail::glLinkProgram(m_program);
+
+      GLint linkStatus = GL_FALSE;
+      Detail::glGetProgramiv(m_program, GL_LINK_STATUS, &linkStatus);
+      if (linkStatus != GL_TRUE)
+      {
+         GLchar infoLog[1024] = {};
+         Detail::glGetProgramInfoLog(m_program, sizeof(infoLog), nullptr, infoLog);
+         UaTrace("palette shader: linking failed: %s\n", infoLog);
+
+         Detail::glDeleteProgram(m_program);
+         m_program = 0;
+      }
+   }
+
+   // the program keeps the shaders until it is deleted
+   if (vertexShader != 0)
+      Detail::glDeleteShader(vertexShader);
+   if (fragmentShader != 0)
+      Detail::glDeleteShader(fragmentShader);
+
+   if (m_program == 0)
+      return false;
+
+   m_textureSizeLocation = Detail::glGetUniformLocation(m_program, "textureSize");
+   m_useFogLocation = Detail::glGetUniformLocation(m_program, "useFog");
+
+   // index texture uses texture unit 0, as all other textures; the palette
+   // texture uses texture unit 1
+   Detail::glUseProgram(m_program);
+   Detail::glUniform1i(Detail::glGetUniformLocation(m_program, "indexTexture"), 0);
+   Detail::glUniform1i(Detail::glGetUniformLocation(m_program, "paletteTexture"), 1);
+   Detail::glUseProgram(0);
+
+   glGenTextures(1, &m_paletteTexture);
+   SetPalette(palette);
+
+   UaTrace("palette shader: using palette-indexed textures%s\n",
+      smoothing ? ", with smoothing" : "");
+
+   return true;
+}
+
+/// Frees the shader program and the palette texture.
+void PaletteShader::Done()
+{
+   if (m_program == 0)
+      return;
+
+   if (s_activeShader == this)
+      Deactivate();
+
+   Detail::glDeleteProgram(m_program);
+   m_program = 0;
+
+   glDeleteTextures(1, &m_paletteTexture);
+   m_paletteTexture = 0;
+
+   m_lastXRes = m_lastYRes = 0;
+}
+
+/// Uploads a new palette to the palette texture. All textures using the
+/// shader are rendered with the new palette, without uploading them again.
+/// \param palette palette to upload
+void PaletteShader::SetPalette(Palette256& palette)
+{
+   if (m_program == 0)
+      return;
+
+   Detail::glActiveTexture(GL_TEXTURE1);
+   glBindTexture(GL_TEXTURE_2D, m_paletteTexture);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette.Get());
+
+   Detail::glActiveTexture(GL_TEXTURE0);
+
+   GLenum error = glGetError();
+   if (error != GL_NO_ERROR)
+      UaTrace("palette shader: error during uploading palette! (%u)\n", error);
+}
+
+/// Activates the shader program, unless it's already in use. The texture
+/// must be bound to texture unit 0, as usual.
+/// \param textureXRes x resolution of the texture that is used
+/// \param textureYRes y resolution of the texture that is used
+void PaletteShader::Activate(unsigned int textureXRes, unsigned int textureYRes)
+{
+   UaAssert(m_program != 0);
+
+   if (s_activeShader != this)
+   {
+      Detail::glUseProgram(m_program);
+
+      Detail::glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, m_paletteTexture);
+      Detail::glActiveTexture(GL_TEXTURE0);
+
+      // fog is only enabled for the 3d view
+      Detail::glUniform1i(m_useFogLocation, glIsEnabled(GL_FOG) == GL_TRUE ? 1 : 0);
+
+      s_activeShader = this;
+   }
+
+   if (textureXRes != m_lastXRes || textureYRes != m_lastYRes)
+   {
+      Detail::glUniform2f(m_textureSizeLocation,
+         static_cast<GLfloat>(textureXRes), static_cast<GLfloat>(textureYRes));
+
+      m_lastXRes = textureXRes;
+      m_lastYRes = textureYRes;
+   }
+}
+
+/// Deactivates the palette shader program currently in use, so that the
+/// fixed-function pipeline is used again. Must be called before rendering
+/// with RGBA textures or without texturing; Texture::Use() already does this
+/// for RGBA textures.
+void PaletteShader::Deactivate()
+{
+   if (s_activeShader == nullptr)
+      return;
+
+   Detail::glUseProgram(0);
+   s_activeShader = nullptr;
+}
+
+/// \param type shader type, GL_VERTEX_SHADER or GL_FRAGMENT_SHADER
+/// \param source shader source, without version line
+/// \return shader, or 0 when compiling failed
+GLuint PaletteShader::CompileShader(GLenum type, const char* source)
+{
+   const GLchar* allSources[2] = { Detail::c_shaderVersion, source };
+
+   GLuint shader = Detail::glCreateShader(type);
+   Detail::glShaderSource(shader, 2, allSources, nullptr);
+   Detail::glCompileShader(shader);
+
+   GLint compileStatus = GL_FALSE;
+   Detail::glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus);
+   if (compileStatus != GL_TRUE)
+   {
+      GLchar infoLog[1024] = {};
+      Detail::glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+      UaTrace("palette shader: compiling %s shader failed: %s\n",
+         type == GL_VERTEX_SHADER ? "vertex" : "fragment", infoLog);
+
+      Detail::glDeleteShader(shader);
+      return 0;
+   }
+
+   return shader;
+}
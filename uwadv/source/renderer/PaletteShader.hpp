@@ -0,0 +1,90 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteShader.hpp
+/// \brief shader for palette-indexed textures
+//
+#pragma once
+
+#include <SDL_opengl.h>
+
+class Palette256;
+
+/// \brief Shader program that renders palette-indexed textures
+/// Textures that use the palette shader are uploaded as 8-bit textures that
+/// contain palette indices, and the shader looks up the colors in a palette
+/// texture. This needs a quarter of the texture memory of RGBA textures, and
+/// the palette can be changed without uploading the textures again. The
+/// palette alpha values are passed on, so that the fixed-function alpha test
+/// and blending work as for RGBA textures. The shader optionally smoothes
+/// the texture by filtering the colors of the four nearest texels, since
+/// palette indices can't be filtered by OpenGL. Fog is applied as with the
+/// fixed-function pipeline. The shader needs OpenGL 2.0.
+class PaletteShader
+{
+public:
+   /// ctor
+   PaletteShader();
+   /// dtor
+   ~PaletteShader();
+   /// deleted copy ctor
+   PaletteShader(const PaletteShader&) = delete;
+   /// deleted assignment operator
+   PaletteShader& operator=(const PaletteShader&) = delete;
+
+   /// compiles shader program and uploads palette; returns false when not available
+   bool Init(Palette256& palette, bool smoothing);
+
+   /// frees shader program and palette texture
+   void Done();
+
+   /// returns if the shader program is available
+   bool IsAvailable() const { return m_program != 0; }
+
+   /// uploads new palette
+   void SetPalette(Palette256& palette);
+
+   /// activates shader program for a texture with given size
+   void Activate(unsigned int textureXRes, unsigned int textureYRes);
+
+   /// deactivates shader program currently in use, if any
+   static void Deactivate();
+
+private:
+   /// compiles a shader; returns 0 when compiling failed
+   static GLuint CompileShader(GLenum type, const char* source);
+
+private:
+   /// shader program
+   GLuint m_program;
+
+   /// palette texture name
+   GLuint m_paletteTexture;
+
+   /// uniform location of texture size
+   GLint m_textureSizeLocation;
+
+   /// uniform location of fog flag
+   GLint m_useFogLocation;
+
+   /// texture size that was last set in the shader program
+   unsigned int m_lastXRes, m_lastYRes;
+
+   /// palette shader whose program is currently in use; may be null
+   static PaletteShader* s_activeShader;
+};
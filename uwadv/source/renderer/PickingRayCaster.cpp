@@ -0,0 +1,287 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PickingRayCaster.cpp
+/// \brief picking by casting a ray through the tile grid
+//
+#include "pch.hpp"
+#include "PickingRayCaster.hpp"
+#include "Tilemap.hpp"
+#include <limits>
+
+namespace Detail
+{
+   /// determinant below which a ray is considered parallel to a triangle
+   const double c_parallelEpsilon = 1e-9;
+
+   /// minimum distance of a hit; nearer hits are ignored
+   const double c_minHitDistance = 1e-6;
+}
+
+PickingRayCaster::PickingRayCaster(const T_fnCollectTriangles& collectTileTriangles,
+   const T_fnCollectTriangles& collectObjectTriangles)
+   :m_collectTileTriangles(collectTileTriangles),
+   m_collectObjectTriangles(collectObjectTriangles)
+{
+}
+
+/// Picks the nearest triangle along the ray. Tile triangles are tested for
+/// every traversed tile; object triangles for every traversed tile and its
+/// neighbours, since objects may extend over the tile border.
+/// \param origin ray origin, e.g. the camera position
+/// \param direction normalized ray direction
+/// \param maxDistance max. distance of a hit
+/// \param result picking result; only valid when true is returned
+/// \return true when a tile or object triangle was hit
+bool PickingRayCaster::Pick(const Vector3d& origin, const Vector3d& direction,
+   double maxDistance, PickResult& result) const
+{
+   const unsigned int tilemapSize = Underworld::c_underworldTilemapSize;
+
+   bool isHit = false;
+   std::vector<bool> objectTilesVisited(tilemapSize * tilemapSize, false);
+   std::vector<PickTriangle> allTriangles;
+
+   TraverseTiles(origin, direction, maxDistance,
+      [&](unsigned int tileX, unsigned int tileY, double enterDistance)
+      {
+         // all following tiles are behind the nearest hit
+         if (isHit && enterDistance > result.m_distance)
+            return false;
+
+         allTriangles.clear();
+         m_collectTileTriangles(tileX, tileY, allTriangles);
+         TestTriangles(origin, direction, maxDistance, tileX, tileY, allTriangles, isHit, result);
+
+         for (unsigned int objectTileX = tileX > 0 ? tileX - 1 : 0;
+            objectTileX <= tileX + 1 && objectTileX < tilemapSize; objectTileX++)
+         {
+            for (unsigned int objectTileY = tileY > 0 ? tileY - 1 : 0;
+               objectTileY <= tileY + 1 && objectTileY < tilemapSize; objectTileY++)
+            {
+               size_t tileIndex = objectTileY * tilemapSize + objectTileX;
+               if (objectTilesVisited[tileIndex])
+                  continue;
+
+               objectTilesVisited[tileIndex] = true;
+
+               allTriangles.clear();
+               m_collectObjectTriangles(objectTileX, objectTileY, allTriangles);
+               TestTriangles(origin, direction, maxDistance, objectTileX, objectTileY,
+                  allTriangles, isHit, result);
+            }
+         }
+
+         return true;
+      });
+
+   return isHit;
+}
+
+/// Calculates the direction of a ray from the camera through a point on the
+/// viewport, using the same camera setup as the renderer, which is a
+/// perspective projection and a camera rotated by pan and rotate angle.
+/// \param viewportX x position on the viewport, from -1.0 (left) to 1.0 (right)
+/// \param viewportY y position on the viewport, from -1.0 (bottom) to 1.0 (top)
+/// \param fieldOfView vertical field of view angle, in degrees
+/// \param aspectRatio viewport aspect ratio, width / height
+/// \param panAngle angle to pan up/down the view
+/// \param rotateAngle angle to rotate left/right the view
+/// \return normalized ray direction in world coordinates
+Vector3d PickingRayCaster::CalcRayDirection(double viewportX, double viewportY,
+   double fieldOfView, double aspectRatio, double panAngle, double rotateAngle)
+{
+   double tanHalfAngle = tan(Deg2rad(fieldOfView * 0.5));
+
+   // camera looks along the negative z axis
+   Vector3d direction(viewportX * tanHalfAngle * aspectRatio, viewportY * tanHalfAngle, -1.0);
+
+   direction = TransformCameraToWorld(direction, panAngle, rotateAngle);
+   direction.Normalize();
+
+   return direction;
+}
+
+/// Transforms a vector from camera coordinates to world coordinates. This is
+/// the inverse of the rotation that UnderworldRenderer::Render() sets up.
+/// \param vec vector in camera coordinates
+/// \param panAngle angle to pan up/down the view
+/// \param rotateAngle angle to rotate left/right the view
+/// \return vector in world coordinates
+Vector3d PickingRayCaster::TransformCameraToWorld(const Vector3d& vec,
+   double panAngle, double rotateAngle)
+{
+   Vector3d result(vec);
+   result.RotateX(-(panAngle + 270.0));
+   result.RotateZ(rotateAngle - 90.0);
+
+   return result;
+}
+
+/// Visits all tiles of the tilemap that the ray passes, in front-to-back
+/// order. The algorithm is described in "A Fast Voxel Traversal Algorithm for
+/// Ray Tracing" by John Amanatides and Andrew Woo. Only the x and y
+/// coordinates are used for traversal.
+/// \param origin ray origin
+/// \param direction ray direction
+/// \param maxDistance max. distance to traverse, in units of the direction
+/// \param visitTile function to call for every tile; the function is passed
+///        the distance where the ray enters the tile
+void PickingRayCaster::TraverseTiles(const Vector3d& origin, const Vector3d& direction,
+   double maxDistance, const T_fnVisitTile& visitTile)
+{
+   const double infinity = std::numeric_limits<double>::infinity();
+   const int tilemapSize = static_cast<int>(Underworld::c_underworldTilemapSize);
+
+   // clip ray against tilemap bounds
+   double minDistance = 0.0;
+   double maxClipDistance = maxDistance;
+
+   const double origins[2] = { origin.x, origin.y };
+   const double directions[2] = { direction.x, direction.y };
+
+   for (unsigned int axis = 0; axis < 2; axis++)
+   {
+      if (directions[axis] == 0.0)
+      {
+         if (origins[axis] < 0.0 || origins[axis] >= tilemapSize)
+            return;
+
+         continue;
+      }
+
+      double distance1 = (0.0 - origins[axis]) / directions[axis];
+      double distance2 = (tilemapSize - origins[axis]) / directions[axis];
+
+      minDistance = std::max(minDistance, std::min(distance1, distance2));
+      maxClipDistance = std::min(maxClipDistance, std::max(distance1, distance2));
+   }
+
+   if (minDistance > maxClipDistance)
+      return;
+
+   double startX = origin.x + direction.x * minDistance;
+   double startY = origin.y + direction.y * minDistance;
+
+   int tileX = std::min(std::max(static_cast<int>(floor(startX)), 0), tilemapSize - 1);
+   int tileY = std::min(std::max(static_cast<int>(floor(startY)), 0), tilemapSize - 1);
+
+   int stepX = direction.x > 0.0 ? 1 : -1;
+   int stepY = direction.y > 0.0 ? 1 : -1;
+
+   // distances to travel to cross one tile
+   double deltaX = direction.x != 0.0 ? fabs(1.0 / direction.x) : infinity;
+   double deltaY = direction.y != 0.0 ? fabs(1.0 / direction.y) : infinity;
+
+   // distances where the ray crosses the next tile border
+   double nextX = direction.x != 0.0
+      ? (tileX + (stepX > 0 ? 1 : 0) - origin.x) / direction.x : infinity;
+   double nextY = direction.y != 0.0
+      ? (tileY + (stepY > 0 ? 1 : 0) - origin.y) / direction.y : infinity;
+
+   double enterDistance = minDistance;
+
+   for (;;)
+   {
+      if (!visitTile(static_cast<unsigned int>(tileX), static_cast<unsigned int>(tileY), enterDistance))
+         return;
+
+      if (nextX < nextY)
+      {
+         enterDistance = nextX;
+         tileX += stepX;
+         nextX += deltaX;
+      }
+      else
+      {
+         enterDistance = nextY;
+         tileY += stepY;
+         nextY += deltaY;
+      }
+
+      if (enterDistance > maxClipDistance ||
+         tileX < 0 || tileX >= tilemapSize ||
+         tileY < 0 || tileY >= tilemapSize)
+         return;
+   }
+}
+
+/// Calculates the intersection of a ray with a triangle, using the algorithm
+/// from "Fast, Minimum Storage Ray/Triangle Intersection" by Tomas Moeller
+/// and Ben Trumbore. Both sides of the triangle can be hit.
+/// \param origin ray origin
+/// \param direction ray direction
+/// \param point1 first triangle point
+/// \param point2 second triangle point
+/// \param point3 third triangle point
+/// \param distance distance of hit point from origin, in units of the
+///        direction; only valid when true is returned
+/// \return true when the ray hits the triangle in front of the origin
+bool PickingRayCaster::IntersectTriangle(const Vector3d& origin, const Vector3d& direction,
+   const Vector3d& point1, const Vector3d& point2, const Vector3d& point3,
+   double& distance)
+{
+   Vector3d edge1 = point2 - point1;
+   Vector3d edge2 = point3 - point1;
+
+   Vector3d pvec = Vector3d::Cross(direction, edge2);
+   double determinant = edge1.Dot(pvec);
+
+   if (fabs(determinant) < Detail::c_parallelEpsilon)
+      return false; // ray is parallel to triangle, or triangle is degenerated
+
+   double invDeterminant = 1.0 / determinant;
+
+   Vector3d tvec = origin - point1;
+   double u = tvec.Dot(pvec) * invDeterminant;
+   if (u < 0.0 || u > 1.0)
+      return false;
+
+   Vector3d qvec = Vector3d::Cross(tvec, edge1);
+   double v = direction.Dot(qvec) * invDeterminant;
+   if (v < 0.0 || u + v > 1.0)
+      return false;
+
+   distance = edge2.Dot(qvec) * invDeterminant;
+
+   return distance > Detail::c_minHitDistance;
+}
+
+void PickingRayCaster::TestTriangles(const Vector3d& origin, const Vector3d& direction,
+   double maxDistance, unsigned int tileX, unsigned int tileY,
+   const std::vector<PickTriangle>& allTriangles, bool& isHit, PickResult& result)
+{
+   for (const PickTriangle& triangle : allTriangles)
+   {
+      double distance = 0.0;
+      if (!IntersectTriangle(origin, direction,
+         triangle.m_points[0], triangle.m_points[1], triangle.m_points[2], distance))
+         continue;
+
+      if (distance > maxDistance ||
+         (isHit && distance >= result.m_distance))
+         continue;
+
+      isHit = true;
+      result.m_tileX = tileX;
+      result.m_tileY = tileY;
+      result.m_isObject = triangle.m_isObject;
+      result.m_id = triangle.m_id;
+      result.m_distance = distance;
+   }
+}
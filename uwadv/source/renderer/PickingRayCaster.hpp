@@ -0,0 +1,146 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PickingRayCaster.hpp
+/// \brief picking by casting a ray through the tile grid
+//
+#pragma once
+
+#include "Math.hpp"
+#include <vector>
+#include <functional>
+
+/// \brief Triangle that can be picked
+/// The points are in OpenGL world coordinates, with already scaled z
+/// coordinates.
+struct PickTriangle
+{
+   /// ctor
+   PickTriangle()
+      :m_isObject(false),
+      m_id(0)
+   {
+   }
+
+   /// ctor, setting all values
+   PickTriangle(const Vector3d& point1, const Vector3d& point2, const Vector3d& point3,
+      bool isObject, unsigned int id)
+      :m_points{ point1, point2, point3 },
+      m_isObject(isObject),
+      m_id(id)
+   {
+   }
+
+   /// triangle points
+   Vector3d m_points[3];
+
+   /// indicates if triangle belongs to an object, or else to a tile
+   bool m_isObject;
+
+   /// object list position of object, or texture number of tile triangle
+   unsigned int m_id;
+};
+
+/// picking result
+struct PickResult
+{
+   /// ctor
+   PickResult()
+      :m_tileX(0),
+      m_tileY(0),
+      m_isObject(false),
+      m_id(0),
+      m_distance(0.0)
+   {
+   }
+
+   /// tile x coordinate of picked tile, or tile that the object is in
+   unsigned int m_tileX;
+
+   /// tile y coordinate
+   unsigned int m_tileY;
+
+   /// indicates if an object was picked, or else a tile triangle
+   bool m_isObject;
+
+   /// object list position of picked object, or texture number of picked
+   /// tile triangle
+   unsigned int m_id;
+
+   /// distance from ray origin to hit point
+   double m_distance;
+};
+
+/// \brief Picking ray caster
+/// Picks tiles and objects by casting a ray from the camera through the
+/// mouse position. The ray walks through the tile grid in front-to-back
+/// order (using a DDA, digital differential analyzer), and all triangles of
+/// the traversed tiles are tested against the ray. Since objects may extend
+/// into neighbouring tiles, the objects of all tiles around a traversed tile
+/// are tested, too. The walk stops as soon as the next tile is farther away
+/// than the nearest hit.
+class PickingRayCaster
+{
+public:
+   /// function type to collect triangles of a tile
+   typedef std::function<void(unsigned int tileX, unsigned int tileY,
+      std::vector<PickTriangle>& allTriangles)> T_fnCollectTriangles;
+
+   /// function type to visit a tile; returns false to stop traversal
+   typedef std::function<bool(unsigned int tileX, unsigned int tileY,
+      double enterDistance)> T_fnVisitTile;
+
+   /// ctor
+   PickingRayCaster(const T_fnCollectTriangles& collectTileTriangles,
+      const T_fnCollectTriangles& collectObjectTriangles);
+
+   /// picks nearest tile or object triangle along given ray
+   bool Pick(const Vector3d& origin, const Vector3d& direction,
+      double maxDistance, PickResult& result) const;
+
+   /// calculates ray direction in world coordinates for a camera
+   static Vector3d CalcRayDirection(double viewportX, double viewportY,
+      double fieldOfView, double aspectRatio, double panAngle, double rotateAngle);
+
+   /// transforms vector from camera (eye) to world coordinates
+   static Vector3d TransformCameraToWorld(const Vector3d& vec,
+      double panAngle, double rotateAngle);
+
+   /// visits all tiles along a ray, in front-to-back order
+   static void TraverseTiles(const Vector3d& origin, const Vector3d& direction,
+      double maxDistance, const T_fnVisitTile& visitTile);
+
+   /// calculates intersection of ray with triangle
+   static bool IntersectTriangle(const Vector3d& origin, const Vector3d& direction,
+      const Vector3d& point1, const Vector3d& point2, const Vector3d& point3,
+      double& distance);
+
+private:
+   /// tests all triangles against ray and updates result when a nearer hit
+   /// was found
+   static void TestTriangles(const Vector3d& origin, const Vector3d& direction,
+      double maxDistance, unsigned int tileX, unsigned int tileY,
+      const std::vector<PickTriangle>& allTriangles, bool& isHit, PickResult& result);
+
+private:
+   /// function to collect tile triangles
+   T_fnCollectTriangles m_collectTileTriangles;
+
+   /// function to collect object triangles
+   T_fnCollectTriangles m_collectObjectTriangles;
+};
@@ -0,0 +1,78 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file RectanglePacker.cpp
+/// \brief rectangle packer for texture atlases
+//
+#include "pch.hpp"
+#include "RectanglePacker.hpp"
+
+RectanglePacker::RectanglePacker(unsigned int width, unsigned int height, unsigned int padding)
+   :m_width(width),
+   m_height(height),
+   m_padding(padding)
+{
+}
+
+/// \param width width of rectangle to insert
+/// \param height height of rectangle to insert
+/// \param xpos x position where the rectangle was placed
+/// \param ypos y position where the rectangle was placed
+/// \return true when the rectangle was placed, or false when there's no room
+bool RectanglePacker::Insert(unsigned int width, unsigned int height, unsigned int& xpos, unsigned int& ypos)
+{
+   unsigned int paddedWidth = width + m_padding;
+   unsigned int paddedHeight = height + m_padding;
+
+   // search shelf with least unused height
+   Shelf* bestShelf = nullptr;
+   for (Shelf& shelf : m_shelves)
+   {
+      if (shelf.m_height >= paddedHeight &&
+         shelf.m_usedWidth + paddedWidth <= m_width &&
+         (bestShelf == nullptr || shelf.m_height < bestShelf->m_height))
+      {
+         bestShelf = &shelf;
+      }
+   }
+
+   if (bestShelf == nullptr)
+   {
+      // start a new shelf
+      unsigned int shelfPos = GetUsedHeight();
+      if (paddedWidth > m_width || shelfPos + paddedHeight > m_height)
+         return false;
+
+      Shelf newShelf = { shelfPos, paddedHeight, 0 };
+      m_shelves.push_back(newShelf);
+
+      bestShelf = &m_shelves.back();
+   }
+
+   xpos = bestShelf->m_usedWidth;
+   ypos = bestShelf->m_ypos;
+
+   bestShelf->m_usedWidth += paddedWidth;
+
+   return true;
+}
+
+unsigned int RectanglePacker::GetUsedHeight() const
+{
+   return m_shelves.empty() ? 0 : m_shelves.back().m_ypos + m_shelves.back().m_height;
+}
@@ -0,0 +1,70 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file RectanglePacker.hpp
+/// \brief rectangle packer for texture atlases
+//
+#pragma once
+
+#include <vector>
+
+/// \brief packs rectangles into a larger rectangle, e.g. a texture atlas
+/// The packer places rectangles on horizontal shelves. A new rectangle is
+/// put on the shelf with the least unused height that still has room for
+/// it; when there's no such shelf, a new shelf is started below the last
+/// one. Inserting rectangles sorted by descending height gives the best
+/// results. A padding can be kept between rectangles, e.g. to avoid bleeding
+/// of neighbouring images when textures are filtered.
+class RectanglePacker
+{
+public:
+   /// ctor; sets size of the area to pack rectangles into
+   RectanglePacker(unsigned int width, unsigned int height, unsigned int padding = 0);
+
+   /// inserts rectangle; returns false when the rectangle doesn't fit anymore
+   bool Insert(unsigned int width, unsigned int height, unsigned int& xpos, unsigned int& ypos);
+
+   /// returns height of the area used by all rectangles so far
+   unsigned int GetUsedHeight() const;
+
+private:
+   /// a single shelf that contains rectangles
+   struct Shelf
+   {
+      /// y position of the shelf
+      unsigned int m_ypos;
+
+      /// height of the shelf
+      unsigned int m_height;
+
+      /// width used by rectangles on the shelf, including padding
+      unsigned int m_usedWidth;
+   };
+
+   /// width of the area
+   unsigned int m_width;
+
+   /// height of the area
+   unsigned int m_height;
+
+   /// padding between rectangles
+   unsigned int m_padding;
+
+   /// all shelves, from top to bottom
+   std::vector<Shelf> m_shelves;
+};
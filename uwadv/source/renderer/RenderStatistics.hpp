@@ -0,0 +1,74 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file RenderStatistics.hpp
+/// \brief statistics about a rendered frame
+//
+#pragma once
+
+/// \brief Statistics about a rendered frame
+/// The statistics are collected by all code that issues OpenGL draw calls
+/// during UnderworldRenderer::Render(), and are reset at the start of every
+/// frame. Counting is cheap enough to be always on.
+struct RenderStatistics
+{
+   /// ctor
+   RenderStatistics()
+   {
+      Reset();
+   }
+
+   /// resets all counters, e.g. at the start of a new frame
+   void Reset()
+   {
+      m_numVisibleTiles = 0;
+      m_numDrawCalls = 0;
+      m_numTriangles = 0;
+      m_numTextureBinds = 0;
+      m_numTextureUploads = 0;
+      m_renderXRes = 0;
+      m_renderYRes = 0;
+   }
+
+   /// counts a single draw call (a glBegin()/glEnd() pair) with given number
+   /// of triangles
+   void AddDrawCall(unsigned int numTriangles)
+   {
+      m_numDrawCalls++;
+      m_numTriangles += numTriangles;
+   }
+
+   /// number of rendered tiles
+   unsigned int m_numVisibleTiles;
+
+   /// number of draw calls
+   unsigned int m_numDrawCalls;
+
+   /// number of rendered triangles; quads count as two triangles
+   unsigned int m_numTriangles;
+
+   /// number of texture binds
+   unsigned int m_numTextureBinds;
+
+   /// number of texture uploads and re-uploads of evicted textures
+   unsigned int m_numTextureUploads;
+
+   /// resolution the 3d view was rendered with; lower than the 3d viewport
+   /// size when dynamic resolution lowered the render scale
+   unsigned int m_renderXRes, m_renderYRes;
+};
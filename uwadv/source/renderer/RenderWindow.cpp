@@ -132,3 +132,17 @@ void RenderWindow::SwapBuffers()
 {
    SDL_GL_SwapWindow(m_window);
 }
+
+bool RenderWindow::IsVsyncEnabled() const
+{
+   return SDL_GL_GetSwapInterval() != 0;
+}
+
+unsigned int RenderWindow::GetRefreshRate() const
+{
+   SDL_DisplayMode displayMode;
+   if (SDL_GetWindowDisplayMode(m_window, &displayMode) != 0)
+      return 0;
+
+   return static_cast<unsigned int>(displayMode.refresh_rate);
+}
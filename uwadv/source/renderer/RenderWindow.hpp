@@ -52,6 +52,12 @@ public:
    /// swaps screen buffers
    void SwapBuffers();
 
+   /// returns if swapping buffers waits for vsync
+   bool IsVsyncEnabled() const;
+
+   /// returns refresh rate of the display the window is on; 0 when unknown
+   unsigned int GetRefreshRate() const;
+
 private:
    /// window width
    int m_width;
@@ -69,6 +69,9 @@ void Renderer::InitGame(IGame& game)
    glHint(GL_FOG_HINT, GL_DONT_CARE);
    glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
    glHint(GL_POLYGON_SMOOTH_HINT, GL_DONT_CARE);
+
+   m_frameCapture.Init(game.GetSettings());
+   m_dynamicResolution.Init(game.GetSettings());
 }
 
 void Renderer::PrintOpenGLDiagnostics()
@@ -116,6 +119,9 @@ void Renderer::PrintOpenGLDiagnostics()
 /// Cleans up renderer.
 void Renderer::Done()
 {
+   m_frameCapture.Done();
+   m_dynamicResolution.Done();
+
    delete m_rendererImpl;
    m_rendererImpl = NULL;
 
@@ -171,104 +177,116 @@ void Renderer::RenderUnderworld(const Underworld::Underworld& underworld)
 
    pos += m_viewOffset;
 
+   BeginRenderUnderworld();
+
    // render map
    m_rendererImpl->Render(m_renderOptions, underworld.GetCurrentLevel(), pos, player.GetPanAngle(),
       player.GetRotateAngle(), m_fieldOfView);
+
+   EndRenderUnderworld();
+}
+
+/// Renders given level, using the player pose and NPC positions from the
+/// snapshot. The level is only read, so it can be rendered while the
+/// simulation thread moves the player.
+/// \param level level to render
+/// \param snapshot snapshot, usually interpolated between two game ticks
+void Renderer::RenderUnderworld(const Underworld::Level& level, const WorldSnapshot& snapshot)
+{
+   Vector3d pos = snapshot.m_playerPos;
+   pos.z += 0.6;
+
+   pos += m_viewOffset;
+
+   BeginRenderUnderworld();
+
+   m_rendererImpl->Render(m_renderOptions, level, pos, snapshot.m_panAngle,
+      snapshot.m_rotateAngle, m_fieldOfView, &snapshot);
+
+   EndRenderUnderworld();
 }
 
-/// Finds out selected object or tile wall by picking.
+/// Starts rendering the 3d view. With dynamic resolution, the 3d view is
+/// rendered into an offscreen framebuffer with a possibly lower resolution.
+void Renderer::BeginRenderUnderworld()
+{
+   if (m_dynamicResolution.IsEnabled())
+   {
+      int xpos = 0, ypos = 0, width = 0, height = 0;
+      m_viewport->GetViewport3D(xpos, ypos, width, height);
+
+      m_dynamicResolution.Begin(xpos, ypos,
+         static_cast<unsigned int>(width), static_cast<unsigned int>(height));
+   }
+}
+
+/// Finishes rendering the 3d view. With dynamic resolution, the rendered
+/// 3d view is scaled up into the 3d viewport.
+void Renderer::EndRenderUnderworld()
+{
+   RenderStatistics& statistics = m_rendererImpl->GetRenderStatistics();
+
+   if (m_dynamicResolution.IsEnabled())
+   {
+      m_dynamicResolution.End();
+      m_dynamicResolution.GetRenderResolution(statistics.m_renderXRes, statistics.m_renderYRes);
+   }
+   else
+   {
+      int xpos = 0, ypos = 0, width = 0, height = 0;
+      m_viewport->GetViewport3D(xpos, ypos, width, height);
+
+      statistics.m_renderXRes = static_cast<unsigned int>(width);
+      statistics.m_renderYRes = static_cast<unsigned int>(height);
+   }
+}
+
+/// Finds out selected object or tile wall by picking. A ray is cast from the
+/// camera through the mouse position, and the nearest tile triangle or object
+/// along the ray is picked.
 /// \param underworld underworld object
 /// \param xpos mouse x position in real window coordinates
 /// \param ypos mouse y position in real window coordinates
 /// \param tilex tile x coordinate of picked target
 /// \param tiley tile y coordinate of picked target
-/// \param isobj true is returned if an object was picked; otherwise tile
+/// \param isObject true is returned if an object was picked; otherwise tile
 ///              walls were picked
 /// \param id object list pos of picked object, or texture number of picked
 ///           tile wall
-/// picking tutorial:
-/// http://www.lighthouse3d.com/opengl/picking/index.php3
 /// \returns true when an object or texture was found, or false when not
 bool Renderer::SelectPick(const Underworld::Underworld& underworld, unsigned int xpos,
    unsigned int ypos, unsigned int& tilex, unsigned int& tiley, bool& isObject,
    unsigned int& id)
 {
-   // set selection buffer
-   GLuint selectionBuffer[64];
-   {
-      glSelectBuffer(64, selectionBuffer);
-
-      // render objects in selection mode
-      glRenderMode(GL_SELECT);
-
-      // init name stack
-      glInitNames();
-   }
-
-   // save projection matrix on stack
-   glMatrixMode(GL_PROJECTION);
-   glPushMatrix();
-
-   // set up projection matrix for selection rendering
-   m_viewport->SetupCamera3D(m_fieldOfView, m_farDistance,
-      true, xpos, ypos);
+   double viewportX = 0.0, viewportY = 0.0;
+   if (!m_viewport->MapWindowToViewport3D(xpos, ypos, viewportX, viewportY))
+      return false;
 
-   // render scene
-   m_rendererImpl->SetSelectionMode(true);
-   RenderUnderworld(underworld);
-   m_rendererImpl->SetSelectionMode(false);
+   int viewportXPos = 0, viewportYPos = 0, viewportWidth = 0, viewportHeight = 0;
+   m_viewport->GetViewport3D(viewportXPos, viewportYPos, viewportWidth, viewportHeight);
 
-   // switch off selection mode
-   GLint hits = glRenderMode(GL_RENDER);
+   const Underworld::Player& player = underworld.GetPlayer();
 
-   // restore previous projection matrix
-   glMatrixMode(GL_PROJECTION);
-   glPopMatrix();
-   glMatrixMode(GL_MODELVIEW);
+   double playerHeight = 0.6 + player.GetHeight();
+   Vector3d pos(player.GetXPos(), player.GetYPos(), playerHeight);
 
-   // find out hit object
-   GLint hitIndex = 0;
-   if (hits > 0)
-   {
-      GLuint min = 0xffffffff;
-      unsigned int idx = 0;
-
-      for (int i = 0; i < hits && idx < 64; i++)
-      {
-         // get count of names stored in this record
-         GLuint namecount = selectionBuffer[idx++];
-
-         // check min. hit dist.
-         if (selectionBuffer[idx] < min)
-         {
-            // new min. hit dist.
-            min = selectionBuffer[idx++];
-            idx++; // jump over max. hit dist.
-            if (namecount > 0 && namecount == 2)
-               hitIndex = idx; // hit index
-         }
-         else
-            idx += 2; // jump over min./max. hit dist.
-
-         // move idx to next record
-         idx += namecount;
-      }
-   }
+   pos += m_viewOffset;
 
-   if (hitIndex != 0)
-   {
-      GLuint coords = selectionBuffer[hitIndex];
-      GLuint renderId = selectionBuffer[hitIndex + 1];
+   double aspectRatio = double(viewportWidth) / viewportHeight;
+   Vector3d direction = PickingRayCaster::CalcRayDirection(viewportX, viewportY,
+      m_fieldOfView, aspectRatio, player.GetPanAngle(), player.GetRotateAngle());
 
-      tilex = coords & 0x00ff;
-      tiley = (coords >> 8) & 0x00ff;
-      isObject = renderId < 0x0400;
-      id = renderId - (isObject ? 0 : 0x0400);
+   PickResult result;
+   if (!m_rendererImpl->Pick(m_renderOptions, underworld.GetCurrentLevel(), pos,
+      player.GetPanAngle(), player.GetRotateAngle(), direction, m_farDistance, result))
+      return false;
 
-      return true;
-   }
+   tilex = result.m_tileX;
+   tiley = result.m_tileY;
+   isObject = result.m_isObject;
+   id = result.m_id;
 
-   return false;
+   return true;
 }
 
 /// Prepares renderer for new level.
@@ -286,6 +304,16 @@ void Renderer::Tick(double tickRate)
    m_rendererImpl->Tick(tickRate);
 }
 
+const TextureResidencyStatistics& Renderer::GetTextureResidencyStatistics() const
+{
+   return m_rendererImpl->GetTextureResidencyManager().GetStatistics();
+}
+
+const RenderStatistics& Renderer::GetRenderStatistics() const
+{
+   return m_rendererImpl->GetRenderStatistics();
+}
+
 void Renderer::GetModel3DBoundingTriangles(unsigned int x,
    unsigned int y, const Underworld::Object& object,
    std::vector<Triangle3dTextured>& allTriangles)
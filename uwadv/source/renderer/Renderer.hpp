@@ -26,6 +26,11 @@
 #include "Texture.hpp"
 #include "Settings.hpp"
 #include "RenderOptions.hpp"
+#include "TextureResidencyManager.hpp"
+#include "RenderStatistics.hpp"
+#include "WorldSnapshot.hpp"
+#include "FrameCapture.hpp"
+#include "DynamicResolution.hpp"
 
 namespace Underworld
 {
@@ -71,6 +76,9 @@ public:
    /// returns current render options
    RenderOptions& GetRenderOptions() { return m_renderOptions; }
 
+   /// returns frame capture
+   FrameCapture& GetFrameCapture() { return m_frameCapture; }
+
    /// sets up camera for 2d user interface rendering
    void SetupForUserInterface();
 
@@ -81,6 +89,10 @@ public:
    /// renders current view of the underworld
    void RenderUnderworld(const Underworld::Underworld& underworld);
 
+   /// renders view of a level, using player pose and object positions from
+   /// given snapshot
+   void RenderUnderworld(const Underworld::Level& level, const WorldSnapshot& snapshot);
+
    /// does selection/picking
    bool SelectPick(const Underworld::Underworld& underworld,
       unsigned int xpos, unsigned int ypos,
@@ -93,11 +105,24 @@ public:
    /// does renderer-specific tick processing
    void Tick(double tickRate);
 
+   /// returns statistics about uploaded textures
+   const TextureResidencyStatistics& GetTextureResidencyStatistics() const;
+
+   /// returns statistics about the last rendered frame
+   const RenderStatistics& GetRenderStatistics() const;
+
    /// returns 3d model bounding triangles if a 3d model exists
    void GetModel3DBoundingTriangles(unsigned int x, unsigned int y,
       const Underworld::Object& object,
       std::vector<Triangle3dTextured>& allTriangles);
 
+private:
+   /// starts rendering the 3d view; renders offscreen with dynamic resolution
+   void BeginRenderUnderworld();
+
+   /// finishes rendering the 3d view and updates render resolution statistics
+   void EndRenderUnderworld();
+
 private:
    /// current render options
    RenderOptions m_renderOptions;
@@ -116,4 +141,10 @@ private:
 
    /// distance of far plane
    double m_farDistance;
+
+   /// frame capture
+   FrameCapture m_frameCapture;
+
+   /// dynamic resolution scaling for the 3d view
+   DynamicResolution m_dynamicResolution;
 };
@@ -21,10 +21,15 @@
 //
 #include "pch.hpp"
 #include "Scaler.hpp"
+#include "CpuFeatures.hpp"
+#include <SDL_thread.h>
 
 extern "C"
 {
 #include <hqx.h>
+
+   /// RGB to YUV lookup table, filled by hqxInit()
+   extern uint32_t RGBtoYUV[16777216];
 }
 
 /// static class instance to init hqx once
@@ -37,6 +42,303 @@ public:
    }
 } s_scalerInit;
 
+namespace Detail
+{
+   /// minimum number of source pixels to use more than one band
+   const Uint32 c_minPixelsForBands = 128 * 128;
+
+   /// minimum number of rows in a band
+   const Uint32 c_minRowsPerBand = 16;
+
+   /// YUV difference thresholds and masks, as used by hqx
+   const Uint32 c_maskY = 0x00ff0000;
+   const Uint32 c_maskU = 0x0000ff00;
+   const Uint32 c_maskV = 0x000000ff;
+   const int c_thresholdY = 0x00300000;
+   const int c_thresholdU = 0x00000700;
+   const int c_thresholdV = 0x00000006;
+
+   /// neighbour pixels, in the order of the hqx pattern bits; the row is
+   /// relative to the rows array, the column is relative to the padded row
+   const struct { unsigned int m_row; unsigned int m_column; } c_neighbours[8] =
+   {
+      { 0, 0 }, { 0, 1 }, { 0, 2 },
+      { 1, 0 },           { 1, 2 },
+      { 2, 0 }, { 2, 1 }, { 2, 2 },
+   };
+
+   /// returns YUV value of color, ignoring the alpha channel
+   inline Uint32 RgbToYuv(Uint32 color)
+   {
+      return RGBtoYUV[color & 0x00ffffff];
+   }
+
+   /// returns if two YUV values differ; same as yuv_diff() in hqx
+   inline bool YuvDiff(Uint32 yuv1, Uint32 yuv2)
+   {
+      return
+         std::abs(static_cast<int>((yuv1 & c_maskY) - (yuv2 & c_maskY))) > c_thresholdY ||
+         std::abs(static_cast<int>((yuv1 & c_maskU) - (yuv2 & c_maskU))) > c_thresholdU ||
+         std::abs(static_cast<int>((yuv1 & c_maskV) - (yuv2 & c_maskV))) > c_thresholdV;
+   }
+
+   /// Source rows of a band, padded with one pixel on the left and right, and
+   /// with one row above and below the band; the padding repeats the edge
+   /// pixels, the same way that hqx handles image edges.
+   class PaddedRows
+   {
+   public:
+      /// ctor; copies rows and looks up YUV values of all pixels once
+      PaddedRows(const Uint32* source, Uint32 width, Uint32 height, Uint32 firstRow, Uint32 numRows)
+         :m_paddedWidth(width + 2)
+      {
+         m_rgb.resize((numRows + 2) * m_paddedWidth);
+         m_yuv.resize(m_rgb.size());
+
+         for (Uint32 row = 0; row < numRows + 2; row++)
+         {
+            // clamp row index to image
+            int sourceRow = static_cast<int>(firstRow + row) - 1;
+            sourceRow = std::max(0, std::min(sourceRow, static_cast<int>(height) - 1));
+
+            const Uint32* sourceLine = source + sourceRow * width;
+            Uint32* rgbLine = &m_rgb[row * m_paddedWidth];
+            Uint32* yuvLine = &m_yuv[row * m_paddedWidth];
+
+            rgbLine[0] = sourceLine[0];
+            std::copy(sourceLine, sourceLine + width, rgbLine + 1);
+            rgbLine[width + 1] = sourceLine[width - 1];
+
+            for (Uint32 column = 0; column < m_paddedWidth; column++)
+               yuvLine[column] = RgbToYuv(rgbLine[column]);
+         }
+      }
+
+      /// returns padded RGB row; row 0 is the row above the band
+      const Uint32* GetRgb(Uint32 row) const { return &m_rgb[row * m_paddedWidth]; }
+
+      /// returns padded YUV row; row 0 is the row above the band
+      const Uint32* GetYuv(Uint32 row) const { return &m_yuv[row * m_paddedWidth]; }
+
+   private:
+      /// padded row width
+      Uint32 m_paddedWidth;
+
+      /// RGB values
+      std::vector<Uint32> m_rgb;
+
+      /// YUV values
+      std::vector<Uint32> m_yuv;
+   };
+
+   /// calculates patterns of pixels of a single row, starting at given column
+   void CalcPatternsScalar(const Uint32* rgb[3], const Uint32* yuv[3], Uint8* patterns,
+      Uint32 startColumn, Uint32 width)
+   {
+      for (Uint32 column = startColumn; column < width; column++)
+      {
+         Uint32 color = rgb[1][column + 1];
+         Uint32 colorYuv = yuv[1][column + 1];
+
+         Uint8 pattern = 0;
+         for (unsigned int index = 0; index < 8; index++)
+         {
+            Uint32 neighbourColumn = column + c_neighbours[index].m_column;
+            unsigned int neighbourRow = c_neighbours[index].m_row;
+
+            if (rgb[neighbourRow][neighbourColumn] != color &&
+               YuvDiff(colorYuv, yuv[neighbourRow][neighbourColumn]))
+               pattern |= 1 << index;
+         }
+
+         patterns[column] = pattern;
+      }
+   }
+
+#ifdef HAVE_X86_INTRINSICS
+   /// returns mask with all bits set in lanes where the masked values differ
+   /// more than the threshold
+   inline __m128i DiffExceedsSSE2(__m128i yuv1, __m128i yuv2, __m128i mask, __m128i threshold,
+      __m128i negativeThreshold)
+   {
+      __m128i diff = _mm_sub_epi32(_mm_and_si128(yuv1, mask), _mm_and_si128(yuv2, mask));
+
+      return _mm_or_si128(
+         _mm_cmpgt_epi32(diff, threshold),
+         _mm_cmplt_epi32(diff, negativeThreshold));
+   }
+
+   /// calculates patterns of pixels of a single row, four pixels at once
+   void CalcPatternsSSE2(const Uint32* rgb[3], const Uint32* yuv[3], Uint8* patterns, Uint32 width)
+   {
+      const __m128i maskY = _mm_set1_epi32(static_cast<int>(c_maskY));
+      const __m128i maskU = _mm_set1_epi32(static_cast<int>(c_maskU));
+      const __m128i maskV = _mm_set1_epi32(static_cast<int>(c_maskV));
+      const __m128i thresholdY = _mm_set1_epi32(c_thresholdY);
+      const __m128i thresholdU = _mm_set1_epi32(c_thresholdU);
+      const __m128i thresholdV = _mm_set1_epi32(c_thresholdV);
+      const __m128i negativeThresholdY = _mm_set1_epi32(-c_thresholdY);
+      const __m128i negativeThresholdU = _mm_set1_epi32(-c_thresholdU);
+      const __m128i negativeThresholdV = _mm_set1_epi32(-c_thresholdV);
+
+      Uint32 column = 0;
+      Uint32 numBlocks = width & ~Uint32(3);
+
+      for (; column < numBlocks; column += 4)
+      {
+         __m128i color = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgb[1] + column + 1));
+         __m128i colorYuv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(yuv[1] + column + 1));
+
+         __m128i pattern = _mm_setzero_si128();
+         for (unsigned int index = 0; index < 8; index++)
+         {
+            Uint32 neighbourColumn = column + c_neighbours[index].m_column;
+            unsigned int neighbourRow = c_neighbours[index].m_row;
+
+            __m128i neighbour = _mm_loadu_si128(
+               reinterpret_cast<const __m128i*>(rgb[neighbourRow] + neighbourColumn));
+            __m128i neighbourYuv = _mm_loadu_si128(
+               reinterpret_cast<const __m128i*>(yuv[neighbourRow] + neighbourColumn));
+
+            __m128i differs = _mm_or_si128(
+               DiffExceedsSSE2(colorYuv, neighbourYuv, maskY, thresholdY, negativeThresholdY),
+               _mm_or_si128(
+                  DiffExceedsSSE2(colorYuv, neighbourYuv, maskU, thresholdU, negativeThresholdU),
+                  DiffExceedsSSE2(colorYuv, neighbourYuv, maskV, thresholdV, negativeThresholdV)));
+
+            // only pixels with a different color are compared
+            differs = _mm_andnot_si128(_mm_cmpeq_epi32(neighbour, color), differs);
+
+            pattern = _mm_or_si128(pattern, _mm_and_si128(differs, _mm_set1_epi32(1 << index)));
+         }
+
+         // pack four 32-bit patterns to bytes
+         pattern = _mm_packs_epi32(pattern, pattern);
+         pattern = _mm_packus_epi16(pattern, pattern);
+
+         Uint32 packed = static_cast<Uint32>(_mm_cvtsi128_si32(pattern));
+         memcpy(patterns + column, &packed, sizeof(packed));
+      }
+
+      CalcPatternsScalar(rgb, yuv, patterns, column, width);
+   }
+#endif
+
+   /// parameters for scaling a band of rows
+   struct ScaleBandParams
+   {
+      unsigned int m_scaleFactor;
+      Scaler::PatternKernel m_kernel;
+      const Uint32* m_source;
+      Uint32* m_dest;
+      Uint32 m_width;
+      Uint32 m_height;
+      Uint32 m_firstRow;
+      Uint32 m_numRows;
+   };
+
+   /// scales a band of rows
+   void ScaleBand(const ScaleBandParams& params)
+   {
+      std::vector<Uint8> patterns;
+
+      if (params.m_kernel != Scaler::kernelReference)
+      {
+         PaddedRows rows(params.m_source, params.m_width, params.m_height,
+            params.m_firstRow, params.m_numRows);
+
+         patterns.resize(params.m_numRows * params.m_width);
+
+         for (Uint32 row = 0; row < params.m_numRows; row++)
+         {
+            const Uint32* rgb[3] = { rows.GetRgb(row), rows.GetRgb(row + 1), rows.GetRgb(row + 2) };
+            const Uint32* yuv[3] = { rows.GetYuv(row), rows.GetYuv(row + 1), rows.GetYuv(row + 2) };
+            Uint8* rowPatterns = &patterns[row * params.m_width];
+
+#ifdef HAVE_X86_INTRINSICS
+            if (params.m_kernel == Scaler::kernelSSE2)
+               CalcPatternsSSE2(rgb, yuv, rowPatterns, params.m_width);
+            else
+#endif
+               CalcPatternsScalar(rgb, yuv, rowPatterns, 0, params.m_width);
+         }
+      }
+
+      const Uint8* patternsPtr = patterns.empty() ? nullptr : patterns.data();
+
+      Uint32 sourceRowBytes = params.m_width * sizeof(Uint32);
+      Uint32 destRowBytes = sourceRowBytes * params.m_scaleFactor;
+      int width = static_cast<int>(params.m_width);
+      int height = static_cast<int>(params.m_height);
+      int firstRow = static_cast<int>(params.m_firstRow);
+      int numRows = static_cast<int>(params.m_numRows);
+
+      switch (params.m_scaleFactor)
+      {
+      case 2:
+         hq2x_32_rows(params.m_source, sourceRowBytes, params.m_dest, destRowBytes,
+            width, height, firstRow, numRows, patternsPtr);
+         break;
+      case 3:
+         hq3x_32_rows(params.m_source, sourceRowBytes, params.m_dest, destRowBytes,
+            width, height, firstRow, numRows, patternsPtr);
+         break;
+      case 4:
+         hq4x_32_rows(params.m_source, sourceRowBytes, params.m_dest, destRowBytes,
+            width, height, firstRow, numRows, patternsPtr);
+         break;
+      default:
+         UaAssertMsg(false, "invalid scale factor");
+      }
+   }
+
+   /// thread procedure to scale a band of rows
+   int SDLCALL ScaleBandThreadProc(void* data)
+   {
+      ScaleBand(*reinterpret_cast<const ScaleBandParams*>(data));
+      return 0;
+   }
+
+} // namespace Detail
+
+/// The best kernel is determined once, on the first call.
+Scaler::PatternKernel Scaler::GetBestKernel()
+{
+   static PatternKernel s_bestKernel =
+      IsKernelSupported(kernelSSE2) ? kernelSSE2 : kernelScalar;
+
+   return s_bestKernel;
+}
+
+bool Scaler::IsKernelSupported(PatternKernel kernel)
+{
+   switch (kernel)
+   {
+   case kernelReference:
+   case kernelScalar:
+      return true;
+
+   case kernelSSE2:
+      return Base::IsSimdKernelSupported(Base::kernelSSE2);
+
+   default:
+      return false;
+   }
+}
+
+/// Small bitmaps, like the 64x64 wall textures, are scaled using one band, to
+/// avoid the thread creation overhead; larger bitmaps use one band per CPU
+/// core, but at least c_minRowsPerBand rows per band.
+unsigned int Scaler::GetNumBands(Uint32 sourceWidth, Uint32 sourceHeight)
+{
+   if (sourceWidth * sourceHeight < Detail::c_minPixelsForBands)
+      return 1;
+
+   static unsigned int s_numCpus = static_cast<unsigned int>(std::max(1, SDL_GetCPUCount()));
+
+   return std::max(1U, std::min(s_numCpus, sourceHeight / Detail::c_minRowsPerBand));
+}
+
 /// \param scaleFactor scale factor to use; allowed values are 2, 3 and 4
 /// \param source source pixel array, in the RGBA format
 /// \param dest destination pixel array, in the RGBA format
@@ -44,27 +346,75 @@ public:
 /// \param sourceHeight source height
 void Scaler::Scale(unsigned int scaleFactor, const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight)
 {
-   switch (scaleFactor)
+   Scale(scaleFactor, source, dest, sourceWidth, sourceHeight,
+      GetBestKernel(), GetNumBands(sourceWidth, sourceHeight));
+}
+
+/// Scales the bitmap in bands of rows; all bands but the last one are scaled
+/// in separate threads. Every band reads the rows above and below the band,
+/// but only writes its own destination rows, so the result doesn't depend on
+/// the number of bands.
+/// \param scaleFactor scale factor to use; allowed values are 2, 3 and 4
+/// \param source source pixel array, in the RGBA format
+/// \param dest destination pixel array, in the RGBA format
+/// \param sourceWidth source width
+/// \param sourceHeight source height
+/// \param kernel pattern kernel to use; must be supported by the CPU
+/// \param numBands number of bands to split the bitmap into
+void Scaler::Scale(unsigned int scaleFactor, const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight,
+   PatternKernel kernel, unsigned int numBands)
+{
+   UaAssertMsg(scaleFactor >= 2 && scaleFactor <= 4, "invalid scale factor");
+   UaAssert(IsKernelSupported(kernel));
+
+   if (sourceWidth == 0 || sourceHeight == 0)
+      return;
+
+   numBands = std::max(1U, std::min(numBands, static_cast<unsigned int>(sourceHeight)));
+
+   std::vector<Detail::ScaleBandParams> bands(numBands);
+   for (unsigned int bandIndex = 0; bandIndex < numBands; bandIndex++)
    {
-   case 2: Scale2x(source, dest, sourceWidth, sourceHeight); break;
-   case 3: Scale3x(source, dest, sourceWidth, sourceHeight); break;
-   case 4: Scale4x(source, dest, sourceWidth, sourceHeight); break;
-   default:
-      UaAssertMsg(false, "invalid scale factor");
+      Detail::ScaleBandParams& band = bands[bandIndex];
+      band.m_scaleFactor = scaleFactor;
+      band.m_kernel = kernel;
+      band.m_source = source;
+      band.m_dest = dest;
+      band.m_width = sourceWidth;
+      band.m_height = sourceHeight;
+      band.m_firstRow = sourceHeight * bandIndex / numBands;
+      band.m_numRows = sourceHeight * (bandIndex + 1) / numBands - band.m_firstRow;
    }
+
+   std::vector<SDL_Thread*> threads;
+   for (unsigned int bandIndex = 0; bandIndex + 1 < numBands; bandIndex++)
+   {
+      SDL_Thread* thread = SDL_CreateThread(Detail::ScaleBandThreadProc, "scaler-thread", &bands[bandIndex]);
+
+      // scale band in this thread when no thread could be created
+      if (thread == nullptr)
+         Detail::ScaleBand(bands[bandIndex]);
+      else
+         threads.push_back(thread);
+   }
+
+   Detail::ScaleBand(bands.back());
+
+   for (SDL_Thread* thread : threads)
+      SDL_WaitThread(thread, nullptr);
 }
 
 void Scaler::Scale2x(const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight)
 {
-   hq2x_32(source, dest, (int)sourceWidth, (int)sourceHeight);
+   Scale(2, source, dest, sourceWidth, sourceHeight);
 }
 
 void Scaler::Scale3x(const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight)
 {
-   hq3x_32(source, dest, (int)sourceWidth, (int)sourceHeight);
+   Scale(3, source, dest, sourceWidth, sourceHeight);
 }
 
 void Scaler::Scale4x(const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight)
 {
-   hq4x_32(source, dest, (int)sourceWidth, (int)sourceHeight);
+   Scale(4, source, dest, sourceWidth, sourceHeight);
 }
@@ -22,13 +22,38 @@
 #pragma once
 
 /// Scaler for 32-bit bitmaps, which uses hqx for scaling.
+/// The per-pixel neighbour difference patterns that hqx uses are calculated
+/// in a separate pass, using SSE2 when available, and large bitmaps are split
+/// into bands of rows that are scaled in parallel. All kernels and band
+/// counts produce the same result as the unmodified hqx implementation.
 /// \see https://en.wikipedia.org/wiki/Hqx
 class Scaler
 {
 public:
+   /// difference pattern kernel type
+   enum PatternKernel
+   {
+      kernelReference = 0, ///< unmodified hqx implementation; always available
+      kernelScalar,        ///< patterns calculated from a per-row YUV buffer
+      kernelSSE2,          ///< patterns calculated for four pixels at once
+   };
+
+   /// returns best pattern kernel available on this CPU
+   static PatternKernel GetBestKernel();
+
+   /// returns if given pattern kernel is supported on this CPU
+   static bool IsKernelSupported(PatternKernel kernel);
+
+   /// returns number of bands used to scale a bitmap of given size
+   static unsigned int GetNumBands(Uint32 sourceWidth, Uint32 sourceHeight);
+
    /// Scales 32-bit RGBA bitmap using scale factor
    static void Scale(unsigned int scaleFactor, const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight);
 
+   /// Scales 32-bit RGBA bitmap using scale factor, pattern kernel and number of bands
+   static void Scale(unsigned int scaleFactor, const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight,
+      PatternKernel kernel, unsigned int numBands);
+
    /// Scales 32-bit RGBA bitmap to 2x size; dest must be 4 times the size of source
    static void Scale2x(const Uint32* source, Uint32* dest, Uint32 sourceWidth, Uint32 sourceHeight);
 
@@ -0,0 +1,600 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SoftwareRasterizer.cpp
+/// \brief multithreaded tile-binned software rasterizer
+//
+#include "pch.hpp"
+#include "SoftwareRasterizer.hpp"
+#include "PickingRayCaster.hpp"
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+#include <cmath>
+
+namespace Detail
+{
+   /// number of sub-pixel steps per pixel, for 28.4 fixed point coordinates
+   const Sint64 c_subPixelSteps = 16;
+
+   /// number of fog table entries
+   const unsigned int c_fogTableSize = 256;
+
+   /// alpha value that texels must exceed to pass the alpha test; this
+   /// corresponds to glAlphaFunc(GL_GREATER, 0.1f) used by the renderer
+   const Uint32 c_alphaTestReference = 25;
+
+   /// modulates all four channels of a texel with a color
+   inline Uint32 ModulateColor(Uint32 texel, Uint32 color)
+   {
+      Uint32 result = 0;
+      for (unsigned int shift = 0; shift < 32; shift += 8)
+      {
+         Uint32 texelChannel = (texel >> shift) & 0xff;
+         Uint32 colorChannel = (color >> shift) & 0xff;
+         result |= ((texelChannel * (colorChannel + 1)) >> 8) << shift;
+      }
+
+      return result;
+   }
+
+   /// scales the color channels of a texel by a fog factor in the range 0..256;
+   /// the fog color is black, and alpha is left unchanged
+   inline Uint32 ApplyFog(Uint32 texel, unsigned int fogFactor)
+   {
+      Uint32 result = texel & 0xff000000;
+      for (unsigned int shift = 0; shift < 24; shift += 8)
+         result |= ((((texel >> shift) & 0xff) * fogFactor) >> 8) << shift;
+
+      return result;
+   }
+
+   /// returns texel of a texture, repeating the texture outside of [0; 1]
+   inline Uint32 SampleTexture(const SoftwareTexture& texture, float u, float v)
+   {
+      int x = static_cast<int>(std::floor(u * texture.m_xres)) % static_cast<int>(texture.m_xres);
+      int y = static_cast<int>(std::floor(v * texture.m_yres)) % static_cast<int>(texture.m_yres);
+
+      if (x < 0)
+         x += texture.m_xres;
+      if (y < 0)
+         y += texture.m_yres;
+
+      return texture.m_texels[y * texture.m_xres + x];
+   }
+} // namespace Detail
+
+SoftwareRasterizer::SoftwareRasterizer()
+   :m_xres(0),
+   m_yres(0),
+   m_numBinsX(0),
+   m_numBinsY(0),
+   m_projectX(1.0),
+   m_projectY(1.0),
+   m_nearDistance(0.05),
+   m_farDistance(16.0),
+   m_fogDensity(0.0),
+   m_fogTableScale(0.0f),
+   m_nextBin(0),
+   m_startSemaphore(nullptr),
+   m_doneSemaphore(nullptr),
+   m_stopThreads(false)
+{
+}
+
+SoftwareRasterizer::~SoftwareRasterizer()
+{
+   StopThreads();
+}
+
+/// Initializes the color and depth buffers and starts the worker threads.
+/// \param xres color buffer width
+/// \param yres color buffer height
+/// \param numThreads number of threads to use for rasterizing, including the
+/// thread that calls EndFrame(); 0 uses one thread per CPU
+void SoftwareRasterizer::Init(unsigned int xres, unsigned int yres, unsigned int numThreads)
+{
+   UaAssert(xres > 0 && yres > 0);
+
+   StopThreads();
+
+   m_xres = xres;
+   m_yres = yres;
+
+   m_numBinsX = (xres + c_binSize - 1) / c_binSize;
+   m_numBinsY = (yres + c_binSize - 1) / c_binSize;
+
+   m_colorBuffer.resize(xres * yres);
+   m_depthBuffer.resize(xres * yres);
+
+   m_binTriangles.clear();
+   m_binTriangles.resize(m_numBinsX * m_numBinsY);
+
+   if (numThreads == 0)
+      numThreads = static_cast<unsigned int>(std::max(1, SDL_GetCPUCount()));
+
+   if (numThreads > 1)
+   {
+      m_startSemaphore = SDL_CreateSemaphore(0);
+      m_doneSemaphore = SDL_CreateSemaphore(0);
+
+      m_stopThreads = false;
+
+      for (unsigned int threadIndex = 1; threadIndex < numThreads; threadIndex++)
+      {
+         SDL_Thread* thread = SDL_CreateThread(ThreadProc, "rasterizer-thread", this);
+         if (thread == nullptr)
+         {
+            UaTrace("couldn't create rasterizer thread: %s\n", SDL_GetError());
+            break;
+         }
+
+         m_workerThreads.push_back(thread);
+      }
+   }
+
+   UaTrace("software rasterizer initialized, %ux%u pixels, %u bins, %u threads\n",
+      xres, yres, m_numBinsX * m_numBinsY, GetNumThreads());
+}
+
+/// Sets up the camera the same way Renderer::SetupFor3D() and
+/// UnderworldRenderer::Render() set up the OpenGL matrices.
+/// \param pos camera position
+/// \param panAngle angle to pan up/down the view
+/// \param rotateAngle angle to rotate left/right the view
+/// \param fieldOfView vertical field of view angle, in degrees
+/// \param nearDistance near plane distance
+/// \param farDistance far plane distance
+void SoftwareRasterizer::SetCamera(const Vector3d& pos, double panAngle, double rotateAngle,
+   double fieldOfView, double nearDistance, double farDistance)
+{
+   UaAssert(m_xres > 0 && m_yres > 0);
+   UaAssert(nearDistance > 0.0 && farDistance > nearDistance);
+
+   m_cameraPos = pos;
+
+   m_cameraRight = PickingRayCaster::TransformCameraToWorld(Vector3d(1.0, 0.0, 0.0), panAngle, rotateAngle);
+   m_cameraUp = PickingRayCaster::TransformCameraToWorld(Vector3d(0.0, 1.0, 0.0), panAngle, rotateAngle);
+   m_cameraBack = PickingRayCaster::TransformCameraToWorld(Vector3d(0.0, 0.0, 1.0), panAngle, rotateAngle);
+
+   double aspectRatio = double(m_xres) / m_yres;
+   m_projectY = 1.0 / tan(Deg2rad(fieldOfView * 0.5));
+   m_projectX = m_projectY / aspectRatio;
+
+   m_nearDistance = nearDistance;
+   m_farDistance = farDistance;
+}
+
+/// Starts a new frame; the color buffer is cleared with the given color and
+/// the depth buffer is cleared to the far plane.
+/// \param clearColor color to clear the color buffer with
+void SoftwareRasterizer::BeginFrame(Uint32 clearColor)
+{
+   std::fill(m_colorBuffer.begin(), m_colorBuffer.end(), clearColor);
+   std::fill(m_depthBuffer.begin(), m_depthBuffer.end(), static_cast<float>(1.0 / m_farDistance));
+
+   m_allTriangles.clear();
+   for (std::vector<unsigned int>& binTriangles : m_binTriangles)
+      binTriangles.clear();
+
+   // EXP2 fog, like GL_EXP2: f = exp(-(density * distance)^2)
+   m_fogTable.resize(Detail::c_fogTableSize);
+   m_fogTableScale = static_cast<float>((Detail::c_fogTableSize - 1) / m_farDistance);
+
+   for (unsigned int index = 0; index < Detail::c_fogTableSize; index++)
+   {
+      double distance = index / double(m_fogTableScale);
+      double fogFactor = exp(-(m_fogDensity * distance) * (m_fogDensity * distance));
+      m_fogTable[index] = static_cast<unsigned int>(fogFactor * 256.0 + 0.5);
+   }
+}
+
+/// Adds a triangle to the current frame. The triangle is transformed, clipped
+/// against the near plane and sorted into all bins that it touches.
+/// Rasterizing happens in EndFrame().
+/// \param vertex0 first vertex
+/// \param vertex1 second vertex
+/// \param vertex2 third vertex
+/// \param texture texture to use; null for untextured triangles; the texture
+/// must stay valid until EndFrame() returns
+/// \param color color that texels are modulated with, in texture format
+/// \param cullBackFace when true, triangles with clockwise vertex order on
+/// screen are culled, like glFrontFace(GL_CCW) and glCullFace(GL_BACK) do
+void SoftwareRasterizer::AddTriangle(const SoftwareVertex& vertex0, const SoftwareVertex& vertex1,
+   const SoftwareVertex& vertex2, const SoftwareTexture* texture, Uint32 color, bool cullBackFace)
+{
+   const SoftwareVertex* vertices[3] = { &vertex0, &vertex1, &vertex2 };
+
+   EyeVertex eyeVertices[3];
+   unsigned int numBehindNearPlane = 0;
+
+   for (unsigned int index = 0; index < 3; index++)
+   {
+      Vector3d rel = vertices[index]->m_pos;
+      rel -= m_cameraPos;
+
+      EyeVertex& eyeVertex = eyeVertices[index];
+      eyeVertex.m_x = rel.Dot(m_cameraRight);
+      eyeVertex.m_y = rel.Dot(m_cameraUp);
+      eyeVertex.m_z = rel.Dot(m_cameraBack);
+      eyeVertex.m_u = vertices[index]->m_u;
+      eyeVertex.m_v = vertices[index]->m_v;
+
+      if (-eyeVertex.m_z < m_nearDistance)
+         numBehindNearPlane++;
+   }
+
+   if (numBehindNearPlane == 3)
+      return;
+
+   if (numBehindNearPlane == 0)
+   {
+      SetupAndBinTriangle(eyeVertices[0], eyeVertices[1], eyeVertices[2], texture, color, cullBackFace);
+      return;
+   }
+
+   // clip polygon against the near plane; the result has 3 or 4 vertices
+   EyeVertex clipped[4];
+   unsigned int numClipped = 0;
+
+   for (unsigned int index = 0; index < 3; index++)
+   {
+      const EyeVertex& current = eyeVertices[index];
+      const EyeVertex& next = eyeVertices[(index + 1) % 3];
+
+      double currentDistance = -current.m_z - m_nearDistance;
+      double nextDistance = -next.m_z - m_nearDistance;
+
+      if (currentDistance >= 0.0)
+         clipped[numClipped++] = current;
+
+      if ((currentDistance >= 0.0) != (nextDistance >= 0.0))
+      {
+         double t = currentDistance / (currentDistance - nextDistance);
+
+         EyeVertex& intersection = clipped[numClipped++];
+         intersection.m_x = current.m_x + t * (next.m_x - current.m_x);
+         intersection.m_y = current.m_y + t * (next.m_y - current.m_y);
+         intersection.m_z = -m_nearDistance;
+         intersection.m_u = current.m_u + t * (next.m_u - current.m_u);
+         intersection.m_v = current.m_v + t * (next.m_v - current.m_v);
+      }
+   }
+
+   UaAssert(numClipped == 3 || numClipped == 4);
+
+   for (unsigned int index = 2; index < numClipped; index++)
+      SetupAndBinTriangle(clipped[0], clipped[index - 1], clipped[index], texture, color, cullBackFace);
+}
+
+/// Projects a triangle in eye space to the screen, calculates edge functions
+/// and attribute gradients and adds the triangle to all bins that its
+/// bounding box touches. All vertices must be in front of the near plane.
+void SoftwareRasterizer::SetupAndBinTriangle(const EyeVertex& vertex0, const EyeVertex& vertex1,
+   const EyeVertex& vertex2, const SoftwareTexture* texture, Uint32 color, bool cullBackFace)
+{
+   const EyeVertex* eyeVertices[3] = { &vertex0, &vertex1, &vertex2 };
+
+   SetupTriangle triangle;
+   double screenX[3], screenY[3], attribs[3][3];
+
+   for (unsigned int index = 0; index < 3; index++)
+   {
+      const EyeVertex& eyeVertex = *eyeVertices[index];
+
+      double invW = 1.0 / -eyeVertex.m_z;
+      double ndcX = m_projectX * eyeVertex.m_x * invW;
+      double ndcY = m_projectY * eyeVertex.m_y * invW;
+
+      // screen y axis points down
+      double x = (ndcX + 1.0) * 0.5 * m_xres;
+      double y = (1.0 - ndcY) * 0.5 * m_yres;
+
+      ScreenVertex& screenVertex = triangle.m_vertices[index];
+      screenVertex.m_x = static_cast<Sint64>(std::lround(x * Detail::c_subPixelSteps));
+      screenVertex.m_y = static_cast<Sint64>(std::lround(y * Detail::c_subPixelSteps));
+
+      screenX[index] = double(screenVertex.m_x) / Detail::c_subPixelSteps;
+      screenY[index] = double(screenVertex.m_y) / Detail::c_subPixelSteps;
+
+      attribs[index][0] = invW;
+      attribs[index][1] = eyeVertex.m_u * invW;
+      attribs[index][2] = eyeVertex.m_v * invW;
+   }
+
+   const ScreenVertex* v = triangle.m_vertices;
+   Sint64 area =
+      (v[1].m_x - v[0].m_x) * (v[2].m_y - v[0].m_y) -
+      (v[1].m_y - v[0].m_y) * (v[2].m_x - v[0].m_x);
+
+   if (area == 0)
+      return;
+
+   // since the y axis points down, counter-clockwise triangles have a
+   // negative area; these are front facing
+   if (area > 0 && cullBackFace)
+      return;
+
+   // order vertices so that the edge functions are positive inside
+   if (area < 0)
+   {
+      std::swap(triangle.m_vertices[1], triangle.m_vertices[2]);
+      std::swap(screenX[1], screenX[2]);
+      std::swap(screenY[1], screenY[2]);
+      std::swap(attribs[1], attribs[2]);
+   }
+
+   // bounding box, clipped to the screen
+   Sint64 minX = std::min({ v[0].m_x, v[1].m_x, v[2].m_x });
+   Sint64 minY = std::min({ v[0].m_y, v[1].m_y, v[2].m_y });
+   Sint64 maxX = std::max({ v[0].m_x, v[1].m_x, v[2].m_x });
+   Sint64 maxY = std::max({ v[0].m_y, v[1].m_y, v[2].m_y });
+
+   triangle.m_minX = static_cast<int>(std::max<Sint64>(0, minX / Detail::c_subPixelSteps));
+   triangle.m_minY = static_cast<int>(std::max<Sint64>(0, minY / Detail::c_subPixelSteps));
+   triangle.m_maxX = static_cast<int>(std::min<Sint64>(m_xres - 1, maxX / Detail::c_subPixelSteps));
+   triangle.m_maxY = static_cast<int>(std::min<Sint64>(m_yres - 1, maxY / Detail::c_subPixelSteps));
+
+   if (triangle.m_minX > triangle.m_maxX || triangle.m_minY > triangle.m_maxY)
+      return;
+
+   // attribute plane equations
+   double dx1 = screenX[1] - screenX[0], dy1 = screenY[1] - screenY[0];
+   double dx2 = screenX[2] - screenX[0], dy2 = screenY[2] - screenY[0];
+   double det = dx1 * dy2 - dx2 * dy1;
+
+   for (unsigned int attrib = 0; attrib < 3; attrib++)
+   {
+      double delta1 = attribs[1][attrib] - attribs[0][attrib];
+      double delta2 = attribs[2][attrib] - attribs[0][attrib];
+
+      double gradientX = (delta1 * dy2 - delta2 * dy1) / det;
+      double gradientY = (delta2 * dx1 - delta1 * dx2) / det;
+
+      triangle.m_attribDx[attrib] = gradientX;
+      triangle.m_attribDy[attrib] = gradientY;
+      triangle.m_attribOrigin[attrib] = attribs[0][attrib] -
+         gradientX * screenX[0] - gradientY * screenY[0];
+   }
+
+   triangle.m_texture = texture;
+   triangle.m_color = color;
+
+   unsigned int triangleIndex = static_cast<unsigned int>(m_allTriangles.size());
+   m_allTriangles.push_back(triangle);
+
+   unsigned int minBinX = triangle.m_minX / c_binSize;
+   unsigned int minBinY = triangle.m_minY / c_binSize;
+   unsigned int maxBinX = triangle.m_maxX / c_binSize;
+   unsigned int maxBinY = triangle.m_maxY / c_binSize;
+
+   for (unsigned int binY = minBinY; binY <= maxBinY; binY++)
+      for (unsigned int binX = minBinX; binX <= maxBinX; binX++)
+         m_binTriangles[binY * m_numBinsX + binX].push_back(triangleIndex);
+}
+
+/// Rasterizes all bins of the current frame. The worker threads and the
+/// calling thread take bins until all bins are done.
+void SoftwareRasterizer::EndFrame()
+{
+   m_nextBin = 0;
+
+   for (size_t threadIndex = 0; threadIndex < m_workerThreads.size(); threadIndex++)
+      SDL_SemPost(m_startSemaphore);
+
+   RasterizeBins();
+
+   for (size_t threadIndex = 0; threadIndex < m_workerThreads.size(); threadIndex++)
+      SDL_SemWait(m_doneSemaphore);
+}
+
+/// The surface doesn't own the pixels; it must be freed with SDL_FreeSurface()
+/// before the rasterizer is destroyed or initialized again.
+/// \return created surface, or null when the surface couldn't be created
+SDL_Surface* SoftwareRasterizer::CreateSurface()
+{
+   return SDL_CreateRGBSurfaceWithFormatFrom(
+      m_colorBuffer.data(),
+      m_xres, m_yres,
+      32,
+      m_xres * sizeof(Uint32),
+      SDL_PIXELFORMAT_RGBA32);
+}
+
+void SoftwareRasterizer::RasterizeBins()
+{
+   unsigned int numBins = m_numBinsX * m_numBinsY;
+
+   for (;;)
+   {
+      unsigned int binIndex = m_nextBin++;
+      if (binIndex >= numBins)
+         break;
+
+      const std::vector<unsigned int>& binTriangles = m_binTriangles[binIndex];
+      if (binTriangles.empty())
+         continue;
+
+      int binMinX = (binIndex % m_numBinsX) * c_binSize;
+      int binMinY = (binIndex / m_numBinsX) * c_binSize;
+      int binMaxX = std::min<int>(binMinX + c_binSize, m_xres) - 1;
+      int binMaxY = std::min<int>(binMinY + c_binSize, m_yres) - 1;
+
+      for (unsigned int triangleIndex : binTriangles)
+         RasterizeTriangle(m_allTriangles[triangleIndex], binMinX, binMinY, binMaxX, binMaxY);
+   }
+}
+
+/// Rasterizes the part of a triangle that lies in a bin. Pixels are covered
+/// when their center lies inside the triangle; pixel centers on an edge are
+/// covered when the edge is a top or left edge, so that pixels on edges
+/// shared by two triangles are only drawn once.
+void SoftwareRasterizer::RasterizeTriangle(const SetupTriangle& triangle,
+   int binMinX, int binMinY, int binMaxX, int binMaxY)
+{
+   int minX = std::max(binMinX, triangle.m_minX);
+   int minY = std::max(binMinY, triangle.m_minY);
+   int maxX = std::min(binMaxX, triangle.m_maxX);
+   int maxY = std::min(binMaxY, triangle.m_maxY);
+
+   if (minX > maxX || minY > maxY)
+      return;
+
+   // edge function of edge a->b: (b.x - a.x) * (p.y - a.y) - (b.y - a.y) * (p.x - a.x)
+   Sint64 edgeStepX[3], edgeStepY[3], edgeRowStart[3];
+
+   const Sint64 startX = minX * Detail::c_subPixelSteps + Detail::c_subPixelSteps / 2;
+   const Sint64 startY = minY * Detail::c_subPixelSteps + Detail::c_subPixelSteps / 2;
+
+   for (unsigned int edge = 0; edge < 3; edge++)
+   {
+      const ScreenVertex& a = triangle.m_vertices[edge];
+      const ScreenVertex& b = triangle.m_vertices[(edge + 1) % 3];
+
+      Sint64 deltaX = b.m_x - a.m_x;
+      Sint64 deltaY = b.m_y - a.m_y;
+
+      edgeStepX[edge] = -deltaY * Detail::c_subPixelSteps;
+      edgeStepY[edge] = deltaX * Detail::c_subPixelSteps;
+
+      edgeRowStart[edge] = deltaX * (startY - a.m_y) - deltaY * (startX - a.m_x);
+
+      // top-left fill rule; pixel centers on other edges are outside
+      bool isTopLeft = deltaY < 0 || (deltaY == 0 && deltaX > 0);
+      if (!isTopLeft)
+         edgeRowStart[edge]--;
+   }
+
+   const SoftwareTexture* texture = triangle.m_texture;
+   const Uint32 color = triangle.m_color;
+   const bool useFog = m_fogDensity > 0.0;
+
+   const float invWdx = static_cast<float>(triangle.m_attribDx[0]);
+   const float uOverWdx = static_cast<float>(triangle.m_attribDx[1]);
+   const float vOverWdx = static_cast<float>(triangle.m_attribDx[2]);
+
+   for (int y = minY; y <= maxY; y++)
+   {
+      Sint64 edge0 = edgeRowStart[0];
+      Sint64 edge1 = edgeRowStart[1];
+      Sint64 edge2 = edgeRowStart[2];
+
+      double pixelX = minX + 0.5, pixelY = y + 0.5;
+      float invW = static_cast<float>(triangle.m_attribOrigin[0] +
+         triangle.m_attribDx[0] * pixelX + triangle.m_attribDy[0] * pixelY);
+      float uOverW = static_cast<float>(triangle.m_attribOrigin[1] +
+         triangle.m_attribDx[1] * pixelX + triangle.m_attribDy[1] * pixelY);
+      float vOverW = static_cast<float>(triangle.m_attribOrigin[2] +
+         triangle.m_attribDx[2] * pixelX + triangle.m_attribDy[2] * pixelY);
+
+      Uint32* colorPtr = &m_colorBuffer[y * m_xres + minX];
+      float* depthPtr = &m_depthBuffer[y * m_xres + minX];
+
+      for (int x = minX; x <= maxX; x++)
+      {
+         if ((edge0 | edge1 | edge2) >= 0 && invW > *depthPtr)
+         {
+            float w = 1.0f / invW;
+
+            Uint32 texel = texture != nullptr
+               ? Detail::SampleTexture(*texture, uOverW * w, vOverW * w)
+               : 0xffffffff;
+
+            if ((texel >> 24) > Detail::c_alphaTestReference)
+            {
+               texel = Detail::ModulateColor(texel, color);
+
+               if (useFog)
+               {
+                  unsigned int fogIndex = std::min(
+                     static_cast<unsigned int>(w * m_fogTableScale), Detail::c_fogTableSize - 1);
+                  texel = Detail::ApplyFog(texel, m_fogTable[fogIndex]);
+               }
+
+               *colorPtr = texel;
+               *depthPtr = invW;
+            }
+         }
+
+         edge0 += edgeStepX[0];
+         edge1 += edgeStepX[1];
+         edge2 += edgeStepX[2];
+
+         invW += invWdx;
+         uOverW += uOverWdx;
+         vOverW += vOverWdx;
+
+         colorPtr++;
+         depthPtr++;
+      }
+
+      edgeRowStart[0] += edgeStepY[0];
+      edgeRowStart[1] += edgeStepY[1];
+      edgeRowStart[2] += edgeStepY[2];
+   }
+}
+
+/// Waits for the start semaphore, rasterizes bins and signals the done
+/// semaphore, until the rasterizer is stopped.
+/// \param param pointer to rasterizer
+/// \return thread exit code; always 0
+int SoftwareRasterizer::ThreadProc(void* param)
+{
+   SoftwareRasterizer& rasterizer = *reinterpret_cast<SoftwareRasterizer*>(param);
+
+   for (;;)
+   {
+      SDL_SemWait(rasterizer.m_startSemaphore);
+
+      if (rasterizer.m_stopThreads)
+         break;
+
+      rasterizer.RasterizeBins();
+
+      SDL_SemPost(rasterizer.m_doneSemaphore);
+   }
+
+   return 0;
+}
+
+void SoftwareRasterizer::StopThreads()
+{
+   if (!m_workerThreads.empty())
+   {
+      m_stopThreads = true;
+
+      for (size_t threadIndex = 0; threadIndex < m_workerThreads.size(); threadIndex++)
+         SDL_SemPost(m_startSemaphore);
+
+      for (SDL_Thread* thread : m_workerThreads)
+         SDL_WaitThread(thread, nullptr);
+
+      m_workerThreads.clear();
+   }
+
+   if (m_startSemaphore != nullptr)
+   {
+      SDL_DestroySemaphore(m_startSemaphore);
+      m_startSemaphore = nullptr;
+   }
+
+   if (m_doneSemaphore != nullptr)
+   {
+      SDL_DestroySemaphore(m_doneSemaphore);
+      m_doneSemaphore = nullptr;
+   }
+}
@@ -0,0 +1,233 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SoftwareRasterizer.hpp
+/// \brief multithreaded tile-binned software rasterizer
+//
+#pragma once
+
+#include "Math.hpp"
+#include <vector>
+#include <atomic>
+
+struct SDL_Thread;
+struct SDL_semaphore;
+struct SDL_Surface;
+
+/// \brief texture used by the software rasterizer
+struct SoftwareTexture
+{
+   /// texture width
+   unsigned int m_xres = 0;
+
+   /// texture height
+   unsigned int m_yres = 0;
+
+   /// texels, in the same RGBA format that PaletteConverter produces
+   std::vector<Uint32> m_texels;
+};
+
+/// \brief vertex passed to the software rasterizer
+struct SoftwareVertex
+{
+   /// vertex position, in world coordinates
+   Vector3d m_pos;
+
+   /// texture coordinates; textures are repeated outside of [0; 1]
+   double m_u = 0.0, m_v = 0.0;
+};
+
+/// \brief Multithreaded tile-binned software rasterizer
+/// Rasterizes textured triangles into a 32-bit color buffer, with a depth
+/// buffer, alpha test and exponential fog, like the fixed-function OpenGL
+/// setup used by Renderer. The camera uses the same pan and rotate angles as
+/// the OpenGL renderer.
+///
+/// Triangles are transformed, clipped against the near plane and set up when
+/// they are added, and are sorted into bins of c_binSize x c_binSize pixels.
+/// EndFrame() rasterizes all bins in parallel, on worker threads and the
+/// calling thread. A bin is always rasterized by a single thread, and its
+/// triangles are rasterized in the order they were added, so the result
+/// doesn't depend on the number of threads.
+class SoftwareRasterizer
+{
+public:
+   /// size of a bin, in pixels
+   static const unsigned int c_binSize = 32;
+
+   /// ctor
+   SoftwareRasterizer();
+   /// dtor; stops worker threads
+   ~SoftwareRasterizer();
+
+   /// deleted copy ctor
+   SoftwareRasterizer(const SoftwareRasterizer&) = delete;
+   /// deleted assignment operator
+   SoftwareRasterizer& operator=(const SoftwareRasterizer&) = delete;
+
+   /// initializes color and depth buffers and starts worker threads
+   void Init(unsigned int xres, unsigned int yres, unsigned int numThreads = 0);
+
+   /// returns color buffer x resolution
+   unsigned int GetXRes() const { return m_xres; }
+
+   /// returns color buffer y resolution
+   unsigned int GetYRes() const { return m_yres; }
+
+   /// returns number of threads used for rasterizing, including the calling thread
+   unsigned int GetNumThreads() const { return static_cast<unsigned int>(m_workerThreads.size()) + 1; }
+
+   /// sets camera position and orientation, and the perspective projection
+   void SetCamera(const Vector3d& pos, double panAngle, double rotateAngle,
+      double fieldOfView, double nearDistance, double farDistance);
+
+   /// sets density of black exponential fog; 0.0 disables fog
+   void SetFogDensity(double fogDensity) { m_fogDensity = fogDensity; }
+
+   /// starts a new frame and clears color and depth buffers
+   void BeginFrame(Uint32 clearColor = 0xff000000);
+
+   /// adds a triangle to the current frame
+   void AddTriangle(const SoftwareVertex& vertex0, const SoftwareVertex& vertex1,
+      const SoftwareVertex& vertex2, const SoftwareTexture* texture,
+      Uint32 color = 0xffffffff, bool cullBackFace = true);
+
+   /// rasterizes all triangles of the current frame
+   void EndFrame();
+
+   /// returns color buffer, in the same RGBA format as the textures
+   const std::vector<Uint32>& GetColorBuffer() const { return m_colorBuffer; }
+
+   /// creates an SDL surface that uses the color buffer as pixels
+   SDL_Surface* CreateSurface();
+
+   /// returns number of triangles set up in the current frame, after clipping
+   unsigned int GetNumSetupTriangles() const { return static_cast<unsigned int>(m_allTriangles.size()); }
+
+private:
+   /// vertex in eye space, used for clipping
+   struct EyeVertex
+   {
+      double m_x, m_y, m_z;
+      double m_u, m_v;
+   };
+
+   /// triangle vertex in screen space, in 28.4 fixed point format
+   struct ScreenVertex
+   {
+      Sint64 m_x, m_y;
+   };
+
+   /// triangle that was set up for rasterizing
+   struct SetupTriangle
+   {
+      /// screen space vertices, ordered so that the edge functions are
+      /// positive inside the triangle
+      ScreenVertex m_vertices[3];
+
+      /// bounding box in pixels; max. values are inclusive
+      int m_minX, m_minY, m_maxX, m_maxY;
+
+      /// 1/w, u/w and v/w at the screen origin
+      double m_attribOrigin[3];
+
+      /// screen space x gradients of 1/w, u/w and v/w
+      double m_attribDx[3];
+
+      /// screen space y gradients of 1/w, u/w and v/w
+      double m_attribDy[3];
+
+      /// texture; may be null for untextured triangles
+      const SoftwareTexture* m_texture;
+
+      /// color that texels are modulated with
+      Uint32 m_color;
+   };
+
+   /// sets up a triangle that was already clipped, and bins it
+   void SetupAndBinTriangle(const EyeVertex& vertex0, const EyeVertex& vertex1,
+      const EyeVertex& vertex2, const SoftwareTexture* texture, Uint32 color, bool cullBackFace);
+
+   /// rasterizes bins until all bins of the frame are taken
+   void RasterizeBins();
+
+   /// rasterizes a triangle into the pixels of a bin
+   void RasterizeTriangle(const SetupTriangle& triangle,
+      int binMinX, int binMinY, int binMaxX, int binMaxY);
+
+   /// worker thread procedure
+   static int ThreadProc(void* param);
+
+   /// stops all worker threads
+   void StopThreads();
+
+private:
+   /// color buffer resolution
+   unsigned int m_xres, m_yres;
+
+   /// number of bins in x and y direction
+   unsigned int m_numBinsX, m_numBinsY;
+
+   /// color buffer
+   std::vector<Uint32> m_colorBuffer;
+
+   /// depth buffer, storing 1/w; larger values are nearer
+   std::vector<float> m_depthBuffer;
+
+   /// camera position
+   Vector3d m_cameraPos;
+
+   /// camera right, up and backward vectors, in world coordinates
+   Vector3d m_cameraRight, m_cameraUp, m_cameraBack;
+
+   /// projection scale factors for x and y
+   double m_projectX, m_projectY;
+
+   /// near and far plane distance
+   double m_nearDistance, m_farDistance;
+
+   /// fog density; 0.0 when disabled
+   double m_fogDensity;
+
+   /// fog factors, in the range 0..256, indexed by scaled eye distance
+   std::vector<unsigned int> m_fogTable;
+
+   /// scale factor from eye distance to fog table index
+   float m_fogTableScale;
+
+   /// all triangles of the current frame
+   std::vector<SetupTriangle> m_allTriangles;
+
+   /// triangle indices of all bins, in the order the triangles were added
+   std::vector<std::vector<unsigned int>> m_binTriangles;
+
+   /// index of the next bin to rasterize
+   std::atomic<unsigned int> m_nextBin;
+
+   /// worker threads
+   std::vector<SDL_Thread*> m_workerThreads;
+
+   /// semaphore to start rasterizing on the worker threads
+   SDL_semaphore* m_startSemaphore;
+
+   /// semaphore that worker threads signal when they're done rasterizing
+   SDL_semaphore* m_doneSemaphore;
+
+   /// indicates that the worker threads should stop
+   std::atomic<bool> m_stopThreads;
+};
@@ -0,0 +1,264 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SoftwareRenderer.cpp
+/// \brief software renderer for the underworld
+//
+#include "pch.hpp"
+#include "SoftwareRenderer.hpp"
+#include "UnderworldRenderer.hpp"
+#include "PaletteConverter.hpp"
+#include "GeometryProvider.hpp"
+#include "Quadtree.hpp"
+#include "Viewport.hpp"
+#include "Underworld.hpp"
+#include "GameInterface.hpp"
+#include "ImageManager.hpp"
+
+namespace Detail
+{
+   /// color used for tile triangles; same as glColor3ub(192, 192, 192)
+   const Uint32 c_tileColor = 0xffc0c0c0;
+
+   /// fog density; same as used in Renderer::SetupFor3D()
+   const double c_fogDensity = 0.2;
+
+   /// converts a vertex of a triangle to a rasterizer vertex
+   SoftwareVertex ToSoftwareVertex(const Vertex3d& vertex, double zScale)
+   {
+      SoftwareVertex softwareVertex;
+      softwareVertex.m_pos.Set(vertex.pos.x, vertex.pos.y, vertex.pos.z * zScale);
+      softwareVertex.m_u = vertex.u;
+      softwareVertex.m_v = vertex.v;
+      return softwareVertex;
+   }
+
+   /// converts a compact vertex of a tile triangle to a rasterizer vertex
+   SoftwareVertex ToSoftwareVertex(const Vertex3dFloat& vertex, double zScale)
+   {
+      SoftwareVertex softwareVertex;
+      softwareVertex.m_pos.Set(vertex.x, vertex.y, vertex.z * zScale);
+      softwareVertex.m_u = vertex.u;
+      softwareVertex.m_v = vertex.v;
+      return softwareVertex;
+   }
+} // namespace Detail
+
+SoftwareRenderer::SoftwareRenderer()
+   :m_viewOffset(0.0, 0.0, 0.0),
+   m_fieldOfView(90.0),
+   m_farDistance(16.0)
+{
+}
+
+/// Initializes the renderer. The stock texture images are loaded, but are
+/// only converted to textures when they are first used.
+/// \param game game interface
+/// \param xres color buffer width
+/// \param yres color buffer height
+/// \param numThreads number of threads to use for rasterizing; 0 uses one
+/// thread per CPU
+void SoftwareRenderer::Init(IGame& game, unsigned int xres, unsigned int yres, unsigned int numThreads)
+{
+   m_rasterizer.Init(xres, yres, numThreads);
+   m_rasterizer.SetFogDensity(Detail::c_fogDensity);
+
+   m_palette0 = game.GetImageManager().GetPalette(0);
+
+   TextureManager::LoadStockTextureImages(game, m_stockTextureImages);
+
+   m_stockTextures.clear();
+   m_stockTextures.resize(m_stockTextureImages.size());
+
+   m_modelManager.Init(game);
+}
+
+/// Sets up the camera for 3d rendering, with the same parameters as
+/// Renderer::SetupFor3D().
+/// \param viewOffset offset of view from player position
+/// \param fieldOfView vertical field of view angle, in degrees
+/// \param farDistance far plane distance
+void SoftwareRenderer::SetupFor3D(const Vector3d& viewOffset, double fieldOfView,
+   double farDistance)
+{
+   m_viewOffset = viewOffset;
+   m_fieldOfView = fieldOfView;
+   m_farDistance = farDistance;
+}
+
+/// Renders the underworld using the current player's view. All triangles of
+/// the visible tiles are added to the rasterizer, which renders them in
+/// parallel when the frame ends.
+/// \param underworld underworld object
+void SoftwareRenderer::RenderUnderworld(const Underworld::Underworld& underworld)
+{
+   const Underworld::Player& player = underworld.GetPlayer();
+   const Underworld::Level& level = underworld.GetCurrentLevel();
+
+   double playerHeight = 0.6 + player.GetHeight();
+   Vector3d pos(player.GetXPos(), player.GetYPos(), playerHeight);
+
+   pos += m_viewOffset;
+
+   m_renderStatistics.Reset();
+
+   Vector3d cameraPos(pos.x, pos.y, pos.z * c_renderHeightScale);
+
+   m_rasterizer.SetCamera(cameraPos, player.GetPanAngle(), player.GetRotateAngle(),
+      m_fieldOfView, Viewport::c_nearDistance, m_farDistance);
+
+   m_rasterizer.BeginFrame();
+
+   Frustum2d fr(pos.x, pos.y, player.GetRotateAngle(), m_fieldOfView, 8.0);
+
+   Quad q(0, 64, 0, 64);
+   q.FindVisibleTiles(fr,
+      [&](unsigned int tilePosX, unsigned int tilePosY)
+      {
+         RenderTile(level, tilePosX, tilePosY);
+         RenderObjects(level, cameraPos, tilePosX, tilePosY);
+      });
+
+   m_rasterizer.EndFrame();
+}
+
+/// Converts the stock texture image using its palette when the texture is
+/// used for the first time. Animated textures always show their first frame.
+/// \param index stock texture index
+/// \return converted texture, or null when no such texture exists
+const SoftwareTexture* SoftwareRenderer::GetStockTexture(unsigned int index)
+{
+   if (index >= m_stockTextureImages.size())
+      return nullptr;
+
+   SoftwareTexture& texture = m_stockTextures[index];
+   if (texture.m_texels.empty())
+   {
+      IndexedImage& image = m_stockTextureImages[index];
+      if (image.GetPixels().empty() || image.GetPalette() == nullptr)
+         return nullptr;
+
+      texture.m_xres = image.GetXRes();
+      texture.m_yres = image.GetYRes();
+      texture.m_texels.resize(texture.m_xres * texture.m_yres);
+
+      PaletteConverter::Convert(image.GetPixels().data(), texture.m_texels.data(),
+         texture.m_texels.size(), reinterpret_cast<Uint32*>(image.GetPalette()->Get()));
+
+      m_renderStatistics.m_numTextureUploads++;
+   }
+
+   return &texture;
+}
+
+/// \param paletteIndex palette index
+/// \return color, in the same format as texels
+Uint32 SoftwareRenderer::GetPaletteColor(Uint8 paletteIndex) const
+{
+   return reinterpret_cast<const Uint32*>(m_palette0->Get())[paletteIndex] | 0xff000000;
+}
+
+/// Adds all triangles of a tile, the same ones that LevelTilemapRenderer
+/// renders.
+/// \param level level to render
+/// \param xpos tile x coordinate of visible tile
+/// \param ypos tile y coordinate of visible tile
+void SoftwareRenderer::RenderTile(const Underworld::Level& level, unsigned int xpos, unsigned int ypos)
+{
+   m_renderStatistics.m_numVisibleTiles++;
+
+   m_allTileTriangles.clear();
+   GeometryProvider geometryProvider{ level };
+   geometryProvider.GetTileTriangles(xpos, ypos, m_allTileTriangles);
+
+   for (const Triangle3dTexturedFloat& triangle : m_allTileTriangles)
+   {
+      m_rasterizer.AddTriangle(
+         Detail::ToSoftwareVertex(triangle.m_vertices[0], c_renderHeightScale),
+         Detail::ToSoftwareVertex(triangle.m_vertices[1], c_renderHeightScale),
+         Detail::ToSoftwareVertex(triangle.m_vertices[2], c_renderHeightScale),
+         GetStockTexture(triangle.m_textureNumber),
+         Detail::c_tileColor);
+
+      m_renderStatistics.AddDrawCall(1);
+   }
+}
+
+/// Adds the triangles of all objects on a tile that have a 3d model. The
+/// models are lit the same way as in Model3DBuiltIn::RenderInstances(), but
+/// with a single diffuse factor per triangle. Back faces aren't culled, since
+/// the models aren't closed.
+/// \param level level to render
+/// \param viewerPos viewer position, in world coordinates
+/// \param xpos tile x coordinate of visible tile
+/// \param ypos tile y coordinate of visible tile
+void SoftwareRenderer::RenderObjects(const Underworld::Level& level, const Vector3d& viewerPos,
+   unsigned int xpos, unsigned int ypos)
+{
+   const Underworld::ObjectList& objectList = level.GetObjectList();
+
+   for (Uint16 link = objectList.GetListStart(xpos, ypos); link != 0;)
+   {
+      const Underworld::Object& obj = *objectList.GetObject(link);
+      link = obj.GetObjectInfo().m_link;
+
+      if (obj.GetObjectInfo().m_isHidden ||
+         !m_modelManager.IsModelAvailable(obj.GetObjectInfo().m_itemID))
+         continue;
+
+      Vector3d base = UnderworldRenderer::CalcObjectPosition(xpos, ypos, obj);
+      base.z = obj.GetPosInfo().m_zpos * c_renderHeightScale;
+
+      m_allTriangles.clear();
+      m_modelManager.GetBoundingTriangles(obj, base, m_allTriangles);
+
+      for (const Triangle3dTextured& triangle : m_allTriangles)
+      {
+         Vector3d normal, vec1(triangle.m_vertices[1].pos), vec2(triangle.m_vertices[2].pos);
+         vec1 -= triangle.m_vertices[0].pos;
+         vec2 -= triangle.m_vertices[0].pos;
+
+         normal = Vector3d::Cross(vec1, vec2);
+         if (normal.Length() == 0.0)
+            continue;
+
+         normal.Normalize();
+
+         Vector3d lightDirection = viewerPos;
+         lightDirection -= triangle.m_vertices[0].pos;
+         lightDirection.Normalize();
+
+         unsigned int diffuse = static_cast<unsigned int>(std::abs(normal.Dot(lightDirection)) * 255.0);
+
+         Uint32 color = triangle.m_colorIndex != 0 ? GetPaletteColor(triangle.m_colorIndex) : 0xffffffff;
+         Uint32 litColor = 0xff000000;
+         for (unsigned int shift = 0; shift < 24; shift += 8)
+            litColor |= ((((color >> shift) & 0xff) * diffuse) / 255) << shift;
+
+         m_rasterizer.AddTriangle(
+            Detail::ToSoftwareVertex(triangle.m_vertices[0], 1.0),
+            Detail::ToSoftwareVertex(triangle.m_vertices[1], 1.0),
+            Detail::ToSoftwareVertex(triangle.m_vertices[2], 1.0),
+            triangle.m_textureNumber != 0 ? GetStockTexture(triangle.m_textureNumber) : nullptr,
+            litColor,
+            false);
+
+         m_renderStatistics.AddDrawCall(1);
+      }
+   }
+}
@@ -0,0 +1,120 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SoftwareRenderer.hpp
+/// \brief software renderer for the underworld
+//
+#pragma once
+
+#include "SoftwareRasterizer.hpp"
+#include "IndexedImage.hpp"
+#include "Model3D.hpp"
+#include "RenderStatistics.hpp"
+
+namespace Underworld
+{
+   class Underworld;
+   class Level;
+}
+
+class IGame;
+
+/// \brief Software renderer for the underworld
+/// Renders the same level geometry and stock textures as Renderer, using the
+/// multithreaded SoftwareRasterizer instead of OpenGL. The renderer needs no
+/// OpenGL context and can be used on machines without a GPU, e.g. to take
+/// screenshots or run render benchmarks.
+///
+/// This is a prototype that is only used by uwbench-render. It isn't a
+/// backend of Renderer, so the game itself always renders with OpenGL. Tiles
+/// and 3d models are rendered; object sprites and critters are not, so
+/// benchmark results aren't comparable to the OpenGL backend for levels with
+/// many objects.
+class SoftwareRenderer
+{
+public:
+   /// ctor
+   SoftwareRenderer();
+
+   /// initializes renderer; loads stock textures and 3d models
+   void Init(IGame& game, unsigned int xres, unsigned int yres, unsigned int numThreads = 0);
+
+   /// sets up camera for 3d rendering
+   void SetupFor3D(const Vector3d& viewOffset, double fieldOfView = 90.0,
+      double farDistance = 16.0);
+
+   /// renders the underworld using the current player's view
+   void RenderUnderworld(const Underworld::Underworld& underworld);
+
+   /// returns rasterizer, e.g. to access the color buffer
+   const SoftwareRasterizer& GetRasterizer() const { return m_rasterizer; }
+
+   /// creates an SDL surface that uses the color buffer as pixels
+   SDL_Surface* CreateSurface() { return m_rasterizer.CreateSurface(); }
+
+   /// returns statistics about the last rendered frame
+   const RenderStatistics& GetRenderStatistics() const { return m_renderStatistics; }
+
+private:
+   /// returns stock texture, converting it on first use; may return null
+   const SoftwareTexture* GetStockTexture(unsigned int index);
+
+   /// returns color from palette 0, in texture format
+   Uint32 GetPaletteColor(Uint8 paletteIndex) const;
+
+   /// adds all triangles of a tile to the rasterizer
+   void RenderTile(const Underworld::Level& level, unsigned int xpos, unsigned int ypos);
+
+   /// adds all 3d model triangles of objects on a tile to the rasterizer
+   void RenderObjects(const Underworld::Level& level, const Vector3d& viewerPos,
+      unsigned int xpos, unsigned int ypos);
+
+private:
+   /// rasterizer
+   SoftwareRasterizer m_rasterizer;
+
+   /// image array of all stock textures
+   std::vector<IndexedImage> m_stockTextureImages;
+
+   /// converted stock textures; textures with no texels aren't converted yet
+   std::vector<SoftwareTexture> m_stockTextures;
+
+   /// palette 0 from image manager
+   Palette256Ptr m_palette0;
+
+   /// 3d models manager
+   Model3DManager m_modelManager;
+
+   /// view offset
+   Vector3d m_viewOffset;
+
+   /// field of view
+   double m_fieldOfView;
+
+   /// far plane distance
+   double m_farDistance;
+
+   /// triangles of the current tile; reused for all tiles
+   std::vector<Triangle3dTexturedFloat> m_allTileTriangles;
+
+   /// triangles of the current object; reused for all objects
+   std::vector<Triangle3dTextured> m_allTriangles;
+
+   /// render statistics of the last frame
+   RenderStatistics m_renderStatistics;
+};
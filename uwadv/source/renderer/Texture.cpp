@@ -23,6 +23,10 @@
 #include "Texture.hpp"
 #include "IndexedImage.hpp"
 #include "Scaler.hpp"
+#include "PaletteConverter.hpp"
+#include "TextureCache.hpp"
+#include "TextureResidencyManager.hpp"
+#include "PaletteShader.hpp"
 #include <gl/GLU.h>
 
 Texture::Texture()
@@ -30,7 +34,10 @@ Texture::Texture()
    m_yres(0),
    m_u(0.0),
    m_v(0.0),
-   m_scaleFactor(1)
+   m_scaleFactor(1),
+   m_textureCache(nullptr),
+   m_residencyManager(nullptr),
+   m_paletteShader(nullptr)
 {
 }
 
@@ -50,12 +57,27 @@ void Texture::Init(unsigned int numTextures, unsigned int scaleFactor)
    m_textureNames.resize(numTextures, 0);
    if (numTextures > 0)
       glGenTextures(numTextures, &m_textureNames[0]);
+
+   m_residencyInfos.resize(numTextures);
 }
 
 /// Frees texture pixels and OpenGL texture names.
 void Texture::Done()
 {
    m_texels.clear();
+   m_indexedTexels.clear();
+
+   // report freed texture memory
+   if (m_residencyManager != nullptr)
+   {
+      for (unsigned int textureIndex = 0; textureIndex < m_residencyInfos.size(); textureIndex++)
+      {
+         if (m_residencyInfos[textureIndex].m_isResident)
+            m_residencyManager->OnRelease(*this, textureIndex);
+      }
+   }
+
+   m_residencyInfos.clear();
 
    // delete all texture names
    if (!m_textureNames.empty())
@@ -68,7 +90,10 @@ void Texture::Done()
 /// \param txtureIndex index of texture to use for conversion
 void Texture::Convert(IndexedImage& image, unsigned int textureIndex)
 {
-   Convert(&image.GetPixels()[0], image.GetXRes(), image.GetYRes(),
+   // use const pixels, so that the image isn't marked as changed
+   const std::vector<Uint8>& pixels = static_cast<const IndexedImage&>(image).GetPixels();
+
+   Convert(pixels.data(), image.GetXRes(), image.GetYRes(),
       *image.GetPalette(), textureIndex);
 }
 
@@ -76,12 +101,15 @@ void Texture::Convert(IndexedImage& image, unsigned int textureIndex)
 /// a resolution of 2^n x 2^m. The texture resolution is determined when the
 /// first image is converted. There currently is a resolution limit of 2048 x
 /// 2048, mainly because graphics cards may not accept larger texture sizes.
+/// When the texture is scaled and a texture cache was set, the scaled texels
+/// are loaded from the cache, or are stored there after scaling. When a
+/// palette shader is set, the palette indices are just copied.
 /// \param pixels array with index values to convert
 /// \param origx x resolution of image stored in pixels
 /// \param origy y resolution of image stored in pixels
 /// \param palette 256 color palette to use in conversion
 /// \param textureIndex index of texture image to convert to
-void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
+void Texture::Convert(const Uint8* pixels, unsigned int origx, unsigned int origy,
    Palette256& palette, unsigned int textureIndex)
 {
    // only do resolution determination for the first texture
@@ -97,13 +125,42 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
       m_u = ((double)origx) / m_xres / m_scaleFactor;
       m_v = ((double)origy) / m_yres / m_scaleFactor;
 
-      m_texels.resize(m_textureNames.size() * m_xres * m_yres * m_scaleFactor * m_scaleFactor, 0x00000000);
+      if (m_paletteShader != nullptr)
+         m_indexedTexels.resize(m_textureNames.size() * m_xres * m_yres, 0);
+      else
+         m_texels.resize(m_textureNames.size() * m_xres * m_yres * m_scaleFactor * m_scaleFactor, 0x00000000);
+   }
+
+   if (m_paletteShader != nullptr)
+   {
+      // the palette is looked up by the shader
+      UaAssert(m_scaleFactor == 1);
+
+      Uint8* indexedTexels = &m_indexedTexels[textureIndex * m_xres * m_yres];
+      for (unsigned int y = 0; y < origy; y++)
+         memcpy(&indexedTexels[y * m_xres], &pixels[y * origx], origx);
+
+      return;
    }
 
    // convert color indices to 32-bit texture
    Uint32* palptr = reinterpret_cast<Uint32*>(palette.Get());
    Uint32* texelData = GetTexels(textureIndex);
 
+   bool useTextureCache = m_scaleFactor > 1 &&
+      m_textureCache != nullptr &&
+      m_textureCache->IsEnabled();
+
+   Uint64 cacheKey = 0;
+   size_t numScaledTexels = m_xres * m_yres * m_scaleFactor * m_scaleFactor;
+   if (useTextureCache)
+   {
+      cacheKey = TextureCache::CalcKey(pixels, origx, origy, palette.Get(), m_scaleFactor);
+
+      if (m_textureCache->Load(cacheKey, texelData, numScaledTexels))
+         return;
+   }
+
    std::vector<Uint32> unscaledTexelBuffer;
    if (m_scaleFactor > 1)
       unscaledTexelBuffer.resize(m_xres * m_yres);
@@ -113,11 +170,15 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
       ? unscaledTexelBuffer.data()
       : texelData;
 
-   for (unsigned int y = 0; y < origy; y++)
+   if (origx == m_xres)
+   {
+      // image lines are contiguous in the texture; convert all at once
+      PaletteConverter::Convert(pixels, texptr, origx * origy, palptr);
+   }
+   else
    {
-      Uint32* texptr2 = &texptr[y * m_xres];
-      for (unsigned int x = 0; x < origx; x++)
-         *texptr2++ = palptr[pixels[y * origx + x]];
+      for (unsigned int y = 0; y < origy; y++)
+         PaletteConverter::Convert(&pixels[y * origx], &texptr[y * m_xres], origx, palptr);
    }
 
    if (m_scaleFactor > 1)
@@ -128,6 +189,70 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
          texelData,
          m_xres,
          m_yres);
+
+      if (useTextureCache)
+         m_textureCache->Store(cacheKey, texelData, numScaledTexels);
+   }
+}
+
+/// Converts a rectangular area of image data to the texture. The whole image
+/// must have been converted with Convert() before, and the texture must not
+/// be scaled.
+/// \param image image to convert area from
+/// \param xpos x position of area
+/// \param ypos y position of area
+/// \param width width of area
+/// \param height height of area
+/// \param textureIndex index of texture to convert to
+void Texture::ConvertRect(IndexedImage& image, unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height, unsigned int textureIndex)
+{
+   UaAssert(image.GetXRes() <= m_xres && image.GetYRes() <= m_yres);
+
+   ConvertRectTo(image, xpos, ypos, width, height, xpos, ypos, textureIndex);
+}
+
+/// Converts a rectangular area of image data to another position of the
+/// texture, e.g. when the texture is an atlas that contains several images.
+/// The texture must have been converted with Convert() before, and must not
+/// be scaled.
+/// \param image image to convert area from
+/// \param xpos x position of area in the image
+/// \param ypos y position of area in the image
+/// \param width width of area
+/// \param height height of area
+/// \param destXPos x position of area in the texture
+/// \param destYPos y position of area in the texture
+/// \param textureIndex index of texture to convert to
+void Texture::ConvertRectTo(IndexedImage& image, unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height, unsigned int destXPos, unsigned int destYPos,
+   unsigned int textureIndex)
+{
+   UaAssert(m_scaleFactor == 1);
+   UaAssert(xpos + width <= image.GetXRes() && ypos + height <= image.GetYRes());
+   UaAssert(destXPos + width <= m_xres && destYPos + height <= m_yres);
+
+   const Uint8* pixels = static_cast<const IndexedImage&>(image).GetPixels().data();
+
+   if (m_paletteShader != nullptr)
+   {
+      Uint8* indexedTexels = &m_indexedTexels[textureIndex * m_xres * m_yres];
+      for (unsigned int y = 0; y < height; y++)
+      {
+         memcpy(&indexedTexels[(destYPos + y) * m_xres + destXPos],
+            &pixels[(ypos + y) * image.GetXRes() + xpos], width);
+      }
+
+      return;
+   }
+
+   Uint32* palptr = reinterpret_cast<Uint32*>(image.GetPalette()->Get());
+   Uint32* texelData = GetTexels(textureIndex);
+
+   for (unsigned int y = 0; y < height; y++)
+   {
+      PaletteConverter::Convert(&pixels[(ypos + y) * image.GetXRes() + xpos],
+         &texelData[(destYPos + y) * m_xres + destXPos], width, palptr);
    }
 }
 
@@ -140,6 +265,8 @@ void Texture::Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
 void Texture::Convert(unsigned int origx, unsigned int origy, Uint32* pixels,
    unsigned int textureIndex)
 {
+   UaAssertMsg(m_paletteShader == nullptr, "palette-indexed textures can't be converted from RGBA pixels");
+
    // determine texture resolution (must be 2^n)
    m_xres = 2;
    while (m_xres < origx && m_xres < 2048) m_xres <<= 1;
@@ -182,27 +309,69 @@ void Texture::Convert(unsigned int origx, unsigned int origy, Uint32* pixels,
 
 /// Use the texture in OpenGL. All further triangle, quad, etc. definitions
 /// use the texture, until another texture is used or
-/// glBindTexture(GL_TEXTURE_2D, 0) is called.
+/// glBindTexture(GL_TEXTURE_2D, 0) is called. When a residency manager is set
+/// and the texture image was evicted, it is uploaded again from the texels.
+/// When a palette shader is set, the shader is activated, else the palette
+/// shader that may be in use is deactivated.
 /// \param textureIndex index of texture to use
 void Texture::Use(unsigned int textureIndex)
 {
    if (textureIndex >= m_textureNames.size())
       return; // invalid texture index
 
+   if (m_paletteShader != nullptr)
+      m_paletteShader->Activate(m_xres, m_yres);
+   else
+      PaletteShader::Deactivate();
+
+   if (m_residencyManager != nullptr)
+   {
+      ResidencyInfo& info = m_residencyInfos[textureIndex];
+      info.m_lastUsedFrame = m_residencyManager->GetCurrentFrame();
+
+      if (info.m_isUploaded && !info.m_isResident)
+      {
+         Upload(textureIndex, info.m_useMipmaps); // also binds texture
+         return;
+      }
+   }
+
    glBindTexture(GL_TEXTURE_2D, m_textureNames[textureIndex]);
 }
 
 /// Uploads the Convert()ed texture to the graphics card. The texture doesn't
-/// have to be Use()d before uploading.
+/// have to be Use()d before uploading. Palette-indexed textures are uploaded
+/// as 8-bit textures, without mipmaps, since palette indices can't be
+/// averaged.
 /// \param textureIndex index of texture to upload
 /// \param mipmaps generates mipmaps when true
 void Texture::Upload(unsigned int textureIndex, bool useMipmaps)
 {
-   Use(textureIndex);
+   if (textureIndex >= m_textureNames.size())
+      return; // invalid texture index
+
+   glBindTexture(GL_TEXTURE_2D, m_textureNames[textureIndex]);
+
+   if (m_paletteShader != nullptr)
+   {
+      useMipmaps = false;
 
-   Uint32* tex = GetTexels(textureIndex);
+      // the shader samples texel centers; the default filter needs mipmaps
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
 
-   if (useMipmaps)
+      glTexImage2D(
+         GL_TEXTURE_2D,
+         0,
+         GL_LUMINANCE8,
+         m_xres,
+         m_yres,
+         0,
+         GL_LUMINANCE,
+         GL_UNSIGNED_BYTE,
+         &m_indexedTexels[textureIndex * m_xres * m_yres]);
+   }
+   else if (useMipmaps)
    {
       // build mipmapped textures
       gluBuild2DMipmaps(
@@ -212,7 +381,7 @@ void Texture::Upload(unsigned int textureIndex, bool useMipmaps)
          m_yres * m_scaleFactor,
          GL_RGBA,
          GL_UNSIGNED_BYTE,
-         tex);
+         GetTexels(textureIndex));
    }
    else
    {
@@ -226,13 +395,112 @@ void Texture::Upload(unsigned int textureIndex, bool useMipmaps)
          0,
          GL_RGBA,
          GL_UNSIGNED_BYTE,
-         tex);
+         GetTexels(textureIndex));
    }
 
    // check for errors
    GLenum error = glGetError();
    if (error != GL_NO_ERROR)
       UaTrace("Texture: error during uploading texture! (%u)\n", error);
+
+   ResidencyInfo& info = m_residencyInfos[textureIndex];
+   bool isReupload = info.m_isUploaded && !info.m_isResident;
+
+   info.m_isUploaded = true;
+   info.m_isResident = true;
+   info.m_useMipmaps = useMipmaps;
+
+   if (m_residencyManager != nullptr)
+   {
+      info.m_lastUsedFrame = m_residencyManager->GetCurrentFrame();
+
+      // mipmaps need another third of the texture size
+      size_t bytesPerTexel = m_paletteShader != nullptr ? sizeof(Uint8) : sizeof(Uint32);
+      size_t numBytes = size_t(GetXRes()) * GetYRes() * bytesPerTexel;
+      if (useMipmaps)
+         numBytes += numBytes / 3;
+
+      m_residencyManager->OnUpload(*this, textureIndex, numBytes, isReupload);
+   }
+}
+
+/// Uploads a rectangular area of the texture to the graphics card, e.g.
+/// after calling ConvertRect(). When the texture image wasn't uploaded yet or
+/// was evicted, the whole texture image is uploaded instead.
+/// \param xpos x position of area
+/// \param ypos y position of area
+/// \param width width of area
+/// \param height height of area
+/// \param textureIndex index of texture to upload
+void Texture::UploadRect(unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height, unsigned int textureIndex)
+{
+   if (textureIndex >= m_textureNames.size())
+      return; // invalid texture index
+
+   const ResidencyInfo& info = m_residencyInfos[textureIndex];
+   if (!info.m_isResident || info.m_useMipmaps || m_scaleFactor != 1)
+   {
+      Upload(textureIndex, info.m_useMipmaps);
+      return;
+   }
+
+   if (width == 0 || height == 0)
+      return;
+
+   glBindTexture(GL_TEXTURE_2D, m_textureNames[textureIndex]);
+
+   // the texels of the area aren't contiguous; let OpenGL skip the rest of each row
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, m_xres);
+
+   if (m_paletteShader != nullptr)
+   {
+      glTexSubImage2D(
+         GL_TEXTURE_2D,
+         0,
+         xpos,
+         ypos,
+         width,
+         height,
+         GL_LUMINANCE,
+         GL_UNSIGNED_BYTE,
+         &m_indexedTexels[textureIndex * m_xres * m_yres + ypos * m_xres + xpos]);
+   }
+   else
+   {
+      glTexSubImage2D(
+         GL_TEXTURE_2D,
+         0,
+         xpos,
+         ypos,
+         width,
+         height,
+         GL_RGBA,
+         GL_UNSIGNED_BYTE,
+         GetTexels(textureIndex) + ypos * m_xres + xpos);
+   }
+
+   glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+   // check for errors
+   GLenum error = glGetError();
+   if (error != GL_NO_ERROR)
+      UaTrace("Texture: error during uploading texture area! (%u)\n", error);
+
+   if (m_residencyManager != nullptr)
+      m_residencyInfos[textureIndex].m_lastUsedFrame = m_residencyManager->GetCurrentFrame();
+}
+
+/// Frees the texture memory of a texture image by deleting its texture name
+/// and using a new one. The texels are kept, so that the texture image can be
+/// uploaded again when it is used the next time.
+/// \param textureIndex index of texture image to evict
+void Texture::Evict(unsigned int textureIndex)
+{
+   glDeleteTextures(1, &m_textureNames[textureIndex]);
+   glGenTextures(1, &m_textureNames[textureIndex]);
+
+   m_residencyInfos[textureIndex].m_isResident = false;
 }
 
 /// Returns 32-bit texture pixels in GL_RGBA format for specified texture.
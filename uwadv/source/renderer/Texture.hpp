@@ -31,6 +31,9 @@
 
 class IndexedImage;
 class Palette256;
+class PaletteShader;
+class TextureCache;
+class TextureResidencyManager;
 
 /// \brief texture class; represents one or more texture images
 /// The Texture class can be used to store and upload textures to OpenGL.
@@ -54,6 +57,25 @@ public:
    /// cleans up texture name(s) after usage
    void Done();
 
+   /// sets texture cache to use for scaled textures
+   void SetTextureCache(TextureCache* textureCache)
+   {
+      m_textureCache = textureCache;
+   }
+
+   /// sets residency manager that tracks uploaded texture memory
+   void SetResidencyManager(TextureResidencyManager* residencyManager)
+   {
+      m_residencyManager = residencyManager;
+   }
+
+   /// sets palette shader to render texture with; when set, the texture
+   /// stores palette indices instead of RGBA texels and must not be scaled
+   void SetPaletteShader(PaletteShader* paletteShader)
+   {
+      m_paletteShader = paletteShader;
+   }
+
    /// converts image to texture
    void Convert(IndexedImage& img, unsigned int numTextures = 0);
 
@@ -61,6 +83,15 @@ public:
    void Convert(unsigned int xres, unsigned int yres, Uint32* pixels,
       unsigned int numTextures = 0);
 
+   /// converts rectangular area of image to already converted texture
+   void ConvertRect(IndexedImage& img, unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height, unsigned int textureIndex = 0);
+
+   /// converts rectangular area of image to another position of already converted texture
+   void ConvertRectTo(IndexedImage& img, unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height, unsigned int destXPos, unsigned int destYPos,
+      unsigned int textureIndex = 0);
+
    /// loads texture from (seekable) rwops stream
    void Load(Base::SDL_RWopsPtr rwops);
 
@@ -73,6 +104,10 @@ public:
    /// uploads a converted texture to OpenGL
    void Upload(unsigned int numTextures = 0, bool useMipmaps = false);
 
+   /// uploads rectangular area of an already uploaded texture to OpenGL
+   void UploadRect(unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height, unsigned int textureIndex = 0);
+
 
    // texture information
 
@@ -91,7 +126,7 @@ public:
 
    // raw texture access
 
-   /// returns array of texels
+   /// returns array of texels; not available when using a palette shader
    const Uint32* GetTexels(unsigned int textureIndex = 0) const;
 
    /// returns x resolution
@@ -106,14 +141,40 @@ public:
       return m_yres * m_scaleFactor;
    }
 
+   /// returns frame counter value when texture image was last used
+   Uint32 GetLastUsedFrame(unsigned int textureIndex) const
+   {
+      return m_residencyInfos[textureIndex].m_lastUsedFrame;
+   }
+
 private:
    /// converts pixels and a palette to texture
-   void Convert(Uint8* pixels, unsigned int origx, unsigned int origy,
+   void Convert(const Uint8* pixels, unsigned int origx, unsigned int origy,
       Palette256& palette, unsigned int numTextures);
 
    /// returns array of texels; non-const version
    Uint32* GetTexels(unsigned int textureIndex = 0);
 
+   /// frees texture memory of texture image; called by residency manager
+   void Evict(unsigned int textureIndex);
+
+private:
+   /// residency infos for a single texture image
+   struct ResidencyInfo
+   {
+      /// indicates if the texture image was uploaded at least once
+      bool m_isUploaded = false;
+
+      /// indicates if the texture image is currently uploaded
+      bool m_isResident = false;
+
+      /// indicates if the texture image was uploaded with mipmaps
+      bool m_useMipmaps = false;
+
+      /// frame counter value when the texture image was last used
+      Uint32 m_lastUsedFrame = 0;
+   };
+
 private:
    /// upper left texture coordinates
    double m_u, m_v;
@@ -124,12 +185,29 @@ private:
    /// texture pixels for all images
    std::vector<Uint32> m_texels;
 
+   /// palette indices for all images; used instead of m_texels when using a
+   /// palette shader
+   std::vector<Uint8> m_indexedTexels;
+
    /// texture name(s)
    std::vector<GLuint> m_textureNames;
 
    /// scale factor when scaling texture pixels; value values are 1, 2, 3 and 4
    unsigned int m_scaleFactor;
 
+   /// texture cache to look up scaled textures; may be null
+   TextureCache* m_textureCache;
+
+   /// residency manager to report uploaded textures to; may be null
+   TextureResidencyManager* m_residencyManager;
+
+   /// palette shader to render palette-indexed texture with; may be null
+   PaletteShader* m_paletteShader;
+
+   /// residency infos for all texture images
+   std::vector<ResidencyInfo> m_residencyInfos;
+
+   friend class TextureResidencyManager;
    friend class TextureManager;
    friend class Critter;
 };
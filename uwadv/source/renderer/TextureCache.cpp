@@ -0,0 +1,385 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureCache.cpp
+/// \brief on-disk cache for scaled textures
+//
+#include "pch.hpp"
+#include "TextureCache.hpp"
+#include "Settings.hpp"
+#include "File.hpp"
+#include "FileSystem.hpp"
+#include <vector>
+#include <algorithm>
+
+/// magic value at the start of each cached texture file ("UATC")
+const Uint32 c_textureCacheFileMagic = 0x43544155;
+
+/// magic value at the start of the cache index file ("UATI")
+const Uint32 c_textureCacheIndexMagic = 0x49544155;
+
+/// file format version of cache files; increase when the format or the
+/// scaler output changes
+const Uint32 c_textureCacheVersion = 1;
+
+/// size of the header of each cached texture file
+const size_t c_textureCacheFileHeaderSize = 5 * sizeof(Uint32);
+
+/// filename of the cache index file
+const char* c_textureCacheIndexFilename = "texcache.idx";
+
+TextureCache::TextureCache()
+   :m_maxCacheSize(0),
+   m_currentCacheSize(0),
+   m_accessCounter(0),
+   m_numHits(0),
+   m_numMisses(0),
+   m_numStores(0),
+   m_numEvictions(0)
+{
+}
+
+TextureCache::~TextureCache()
+{
+   Done();
+}
+
+/// Initializes the texture cache. The cache folder is created when it doesn't
+/// exist yet. When the folder can't be created, or when the cache size is set
+/// to 0, the cache stays disabled.
+/// \param settings settings to read cache folder and size from
+void TextureCache::Init(const Base::Settings& settings)
+{
+   m_cacheFolder = settings.GetString(Base::settingTextureCacheFolder);
+   m_maxCacheSize = static_cast<size_t>(settings.GetInt(Base::settingTextureCacheSize)) * 1024 * 1024;
+
+   if (m_cacheFolder.empty() || m_maxCacheSize == 0)
+   {
+      m_maxCacheSize = 0;
+      return;
+   }
+
+   try
+   {
+      if (!Base::FileSystem::FolderExists(m_cacheFolder))
+         Base::FileSystem::MakeFolder(m_cacheFolder);
+   }
+   catch (const Base::FileSystemException& ex)
+   {
+      UNUSED(ex);
+      UaTrace("texture cache disabled; couldn't create folder %s (%s)\n",
+         m_cacheFolder.c_str(), ex.what());
+
+      m_maxCacheSize = 0;
+      return;
+   }
+
+   LoadIndex();
+}
+
+/// Writes the index file with the current access order and dumps the cache
+/// statistics. The cache is disabled afterwards.
+void TextureCache::Done()
+{
+   if (!IsEnabled())
+      return;
+
+   SaveIndex();
+   DumpStatistics();
+
+   m_cacheEntries.clear();
+   m_currentCacheSize = 0;
+   m_maxCacheSize = 0;
+}
+
+/// Calculates a cache key, using the 64-bit FNV-1a hash function over all
+/// values that determine the contents of the scaled texture.
+/// \param pixels palette indexed source pixels
+/// \param xres x resolution of source image
+/// \param yres y resolution of source image
+/// \param palette palette to use, with 256 RGBA entries
+/// \param scaleFactor scale factor used for scaling
+/// \return calculated cache key
+Uint64 TextureCache::CalcKey(const Uint8* pixels, unsigned int xres, unsigned int yres,
+   const Uint8* palette, unsigned int scaleFactor)
+{
+   const Uint64 fnvPrime = 0x00000100000001b3ULL;
+   Uint64 hash = 0xcbf29ce484222325ULL;
+
+   auto hashBytes = [&](const Uint8* data, size_t length)
+   {
+      for (size_t index = 0; index < length; index++)
+      {
+         hash ^= data[index];
+         hash *= fnvPrime;
+      }
+   };
+
+   Uint32 header[4] = { c_textureCacheVersion, xres, yres, scaleFactor };
+   hashBytes(reinterpret_cast<const Uint8*>(header), sizeof(header));
+
+   hashBytes(palette, 256 * 4);
+   hashBytes(pixels, static_cast<size_t>(xres) * yres);
+
+   return hash;
+}
+
+/// Loads texels from a cached texture file. When the file can't be read or
+/// has the wrong size, the cache entry is removed.
+/// \param key cache key, calculated with CalcKey()
+/// \param texels texel array to load cached texels into
+/// \param numTexels number of texels to load
+/// \return true when the texels were loaded from cache
+bool TextureCache::Load(Uint64 key, Uint32* texels, size_t numTexels)
+{
+   if (!IsEnabled())
+      return false;
+
+   std::map<Uint64, CacheEntry>::iterator iter = m_cacheEntries.find(key);
+   if (iter == m_cacheEntries.end())
+   {
+      m_numMisses++;
+      return false;
+   }
+
+   Base::File file{ GetCacheFilename(key), Base::modeRead };
+   if (!file.IsOpen())
+   {
+      m_currentCacheSize -= iter->second.m_fileSize;
+      m_cacheEntries.erase(iter);
+
+      m_numMisses++;
+      return false;
+   }
+
+   Uint32 magic = file.Read32();
+   Uint32 version = file.Read32();
+   Uint32 keyLow = file.Read32();
+   Uint32 keyHigh = file.Read32();
+   Uint32 storedTexels = file.Read32();
+
+   size_t numBytes = numTexels * sizeof(Uint32);
+
+   if (magic != c_textureCacheFileMagic ||
+      version != c_textureCacheVersion ||
+      keyLow != static_cast<Uint32>(key & 0xffffffff) ||
+      keyHigh != static_cast<Uint32>(key >> 32) ||
+      storedTexels != numTexels ||
+      file.ReadBuffer(reinterpret_cast<Uint8*>(texels), numBytes) != numBytes)
+   {
+      UaTrace("texture cache: removing invalid cache file %s\n", GetCacheFilename(key).c_str());
+
+      file.Close();
+      RemoveEntry(key);
+
+      m_numMisses++;
+      return false;
+   }
+
+   iter->second.m_lastAccess = ++m_accessCounter;
+   m_numHits++;
+
+   return true;
+}
+
+/// Stores texels in a new cache file. When the cache would grow larger than
+/// the max. cache size, least recently used textures are removed first.
+/// \param key cache key, calculated with CalcKey()
+/// \param texels texels to store
+/// \param numTexels number of texels to store
+void TextureCache::Store(Uint64 key, const Uint32* texels, size_t numTexels)
+{
+   if (!IsEnabled())
+      return;
+
+   size_t fileSize = c_textureCacheFileHeaderSize + numTexels * sizeof(Uint32);
+   if (fileSize > m_maxCacheSize)
+      return; // would never fit
+
+   if (m_cacheEntries.find(key) != m_cacheEntries.end())
+      RemoveEntry(key);
+
+   EvictEntries(fileSize);
+
+   Base::File file{ GetCacheFilename(key), Base::modeWrite };
+   if (!file.IsOpen())
+      return;
+
+   // texels are stored in byte order R, G, B, A, so they can be written as-is
+   file.Write32(c_textureCacheFileMagic);
+   file.Write32(c_textureCacheVersion);
+   file.Write32(static_cast<Uint32>(key & 0xffffffff));
+   file.Write32(static_cast<Uint32>(key >> 32));
+   file.Write32(static_cast<Uint32>(numTexels));
+   file.WriteBuffer(reinterpret_cast<const Uint8*>(texels), numTexels * sizeof(Uint32));
+   file.Close();
+
+   CacheEntry& entry = m_cacheEntries[key];
+   entry.m_fileSize = fileSize;
+   entry.m_lastAccess = ++m_accessCounter;
+
+   m_currentCacheSize += fileSize;
+   m_numStores++;
+}
+
+void TextureCache::DumpStatistics() const
+{
+   unsigned int numLookups = m_numHits + m_numMisses;
+
+   UaTrace("texture cache statistics:\n"
+      " folder: %s\n"
+      " entries: %u, size: %u kB of %u kB\n"
+      " lookups: %u, hits: %u (%3.1f%%), misses: %u\n"
+      " stored: %u, evicted: %u\n",
+      m_cacheFolder.c_str(),
+      static_cast<unsigned int>(m_cacheEntries.size()),
+      static_cast<unsigned int>(m_currentCacheSize / 1024),
+      static_cast<unsigned int>(m_maxCacheSize / 1024),
+      numLookups, m_numHits,
+      numLookups == 0 ? 0.0 : m_numHits * 100.0 / numLookups,
+      m_numMisses,
+      m_numStores, m_numEvictions);
+}
+
+std::string TextureCache::GetCacheFilename(Uint64 key) const
+{
+   char buffer[32];
+   snprintf(buffer, sizeof(buffer), "%016" SDL_PRIx64 ".tex", key);
+
+   return m_cacheFolder + buffer;
+}
+
+/// Scans the cache folder for cached texture files, then reads the access
+/// order from the index file. Texture files that aren't in the index are
+/// treated as least recently used.
+void TextureCache::LoadIndex()
+{
+   m_cacheEntries.clear();
+   m_currentCacheSize = 0;
+   m_accessCounter = 0;
+
+   std::vector<std::string> fileList;
+   Base::FileSystem::FindFiles(m_cacheFolder + "*.tex", fileList, false);
+
+   for (const std::string& filename : fileList)
+   {
+      std::string::size_type pos = filename.find_last_of("\\/");
+      std::string name = pos == std::string::npos ? filename : filename.substr(pos + 1);
+
+      Uint64 key = static_cast<Uint64>(strtoull(name.c_str(), nullptr, 16));
+
+      Base::File file{ filename, Base::modeRead };
+      if (!file.IsOpen())
+         continue;
+
+      CacheEntry& entry = m_cacheEntries[key];
+      entry.m_fileSize = static_cast<size_t>(file.FileLength());
+      entry.m_lastAccess = 0;
+
+      m_currentCacheSize += entry.m_fileSize;
+   }
+
+   std::string indexFilename = m_cacheFolder + c_textureCacheIndexFilename;
+   if (Base::FileSystem::FileExists(indexFilename))
+   {
+      Base::File file{ indexFilename, Base::modeRead };
+
+      if (file.IsOpen() &&
+         file.Read32() == c_textureCacheIndexMagic &&
+         file.Read32() == c_textureCacheVersion)
+      {
+         m_accessCounter = file.Read32();
+         Uint32 numEntries = file.Read32();
+
+         for (Uint32 index = 0; index < numEntries; index++)
+         {
+            Uint64 key = file.Read32();
+            key |= static_cast<Uint64>(file.Read32()) << 32;
+            Uint32 lastAccess = file.Read32();
+
+            std::map<Uint64, CacheEntry>::iterator iter = m_cacheEntries.find(key);
+            if (iter != m_cacheEntries.end())
+               iter->second.m_lastAccess = lastAccess;
+         }
+      }
+   }
+
+   UaTrace("texture cache: %u textures in %s, %u kB\n",
+      static_cast<unsigned int>(m_cacheEntries.size()),
+      m_cacheFolder.c_str(),
+      static_cast<unsigned int>(m_currentCacheSize / 1024));
+
+   // the max. size may have been lowered since the last run
+   EvictEntries(0);
+}
+
+void TextureCache::SaveIndex() const
+{
+   Base::File file{ m_cacheFolder + c_textureCacheIndexFilename, Base::modeWrite };
+   if (!file.IsOpen())
+      return;
+
+   file.Write32(c_textureCacheIndexMagic);
+   file.Write32(c_textureCacheVersion);
+   file.Write32(m_accessCounter);
+   file.Write32(static_cast<Uint32>(m_cacheEntries.size()));
+
+   for (const std::pair<const Uint64, CacheEntry>& entry : m_cacheEntries)
+   {
+      file.Write32(static_cast<Uint32>(entry.first & 0xffffffff));
+      file.Write32(static_cast<Uint32>(entry.first >> 32));
+      file.Write32(entry.second.m_lastAccess);
+   }
+}
+
+void TextureCache::RemoveEntry(Uint64 key)
+{
+   std::map<Uint64, CacheEntry>::iterator iter = m_cacheEntries.find(key);
+   if (iter == m_cacheEntries.end())
+      return;
+
+   m_currentCacheSize -= iter->second.m_fileSize;
+   m_cacheEntries.erase(iter);
+
+   Base::FileSystem::RemoveFile(GetCacheFilename(key));
+}
+
+/// \param newEntrySize size of the new cache entry that must fit into the cache
+void TextureCache::EvictEntries(size_t newEntrySize)
+{
+   if (m_currentCacheSize + newEntrySize <= m_maxCacheSize)
+      return;
+
+   // sort all entries by last access, oldest first
+   std::vector<std::pair<Uint32, Uint64>> accessOrder;
+   accessOrder.reserve(m_cacheEntries.size());
+
+   for (const std::pair<const Uint64, CacheEntry>& entry : m_cacheEntries)
+      accessOrder.push_back(std::make_pair(entry.second.m_lastAccess, entry.first));
+
+   std::sort(accessOrder.begin(), accessOrder.end());
+
+   for (const std::pair<Uint32, Uint64>& entry : accessOrder)
+   {
+      if (m_currentCacheSize + newEntrySize <= m_maxCacheSize)
+         break;
+
+      RemoveEntry(entry.second);
+      m_numEvictions++;
+   }
+}
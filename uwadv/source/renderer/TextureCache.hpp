@@ -0,0 +1,127 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureCache.hpp
+/// \brief on-disk cache for scaled textures
+//
+#pragma once
+
+#include <string>
+#include <map>
+
+namespace Base
+{
+   class Settings;
+}
+
+/// \brief on-disk cache for scaled textures
+/// Scaling textures with hqx takes some time, but the source images, the
+/// palette and the scale factor never change between runs of the game. The
+/// texture cache stores the scaled 32-bit texels in a cache folder, using a
+/// key that is calculated from the source pixels, the palette and the scale
+/// factor. The cache folder is limited in size; when the size is exceeded,
+/// the least recently used textures are removed. The access order is kept
+/// in an index file in the cache folder.
+class TextureCache
+{
+public:
+   /// ctor
+   TextureCache();
+   /// dtor
+   ~TextureCache();
+   /// deleted copy ctor
+   TextureCache(const TextureCache&) = delete;
+   /// deleted assignment operator
+   TextureCache& operator=(const TextureCache&) = delete;
+
+   /// initializes texture cache; reads cache folder and size from settings
+   void Init(const Base::Settings& settings);
+
+   /// writes cache index and dumps statistics
+   void Done();
+
+   /// returns if the texture cache is enabled
+   bool IsEnabled() const { return m_maxCacheSize > 0; }
+
+   /// calculates cache key from source image, palette and scale factor
+   static Uint64 CalcKey(const Uint8* pixels, unsigned int xres, unsigned int yres,
+      const Uint8* palette, unsigned int scaleFactor);
+
+   /// loads texels from cache; returns false when texture isn't cached
+   bool Load(Uint64 key, Uint32* texels, size_t numTexels);
+
+   /// stores texels in cache
+   void Store(Uint64 key, const Uint32* texels, size_t numTexels);
+
+   /// dumps cache statistics
+   void DumpStatistics() const;
+
+private:
+   /// returns filename of cached texture file
+   std::string GetCacheFilename(Uint64 key) const;
+
+   /// reads all cached texture files and the index file
+   void LoadIndex();
+
+   /// writes index file with access order of all cached textures
+   void SaveIndex() const;
+
+   /// removes a single cache entry and its file
+   void RemoveEntry(Uint64 key);
+
+   /// evicts least recently used textures until new texture fits into cache
+   void EvictEntries(size_t newEntrySize);
+
+private:
+   /// infos about a single cached texture
+   struct CacheEntry
+   {
+      /// size of the cache file, in bytes
+      size_t m_fileSize;
+
+      /// access counter value when texture was last used
+      Uint32 m_lastAccess;
+   };
+
+   /// cache folder, ending with a path separator
+   std::string m_cacheFolder;
+
+   /// max. size of all cache files, in bytes; 0 when cache is disabled
+   size_t m_maxCacheSize;
+
+   /// current size of all cache files, in bytes
+   size_t m_currentCacheSize;
+
+   /// access counter, used to determine least recently used textures
+   Uint32 m_accessCounter;
+
+   /// mapping of cache key to cache entry
+   std::map<Uint64, CacheEntry> m_cacheEntries;
+
+   /// number of textures loaded from cache
+   unsigned int m_numHits;
+
+   /// number of textures that weren't found in the cache
+   unsigned int m_numMisses;
+
+   /// number of textures stored in the cache
+   unsigned int m_numStores;
+
+   /// number of textures removed from the cache
+   unsigned int m_numEvictions;
+};
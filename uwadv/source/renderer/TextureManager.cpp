@@ -25,11 +25,17 @@
 #include "GameInterface.hpp"
 #include "TextureLoader.hpp"
 #include "ImageManager.hpp"
+#include "PaletteShader.hpp"
 
 const double TextureManager::s_animationFramesPerSecond = 1.5;
 
 TextureManager::TextureManager()
-   :m_animationCount(0.0)
+   :m_animationStep(0),
+   m_paletteShaderAnimationStep(0),
+   m_textureCache(nullptr),
+   m_residencyManager(nullptr),
+   m_paletteShader(nullptr),
+   m_animationCount(0.0)
 {
 }
 
@@ -38,12 +44,72 @@ TextureManager::~TextureManager()
    Reset();
 }
 
-/// Initializes texture manager. All stock textures are loaded and animation
-/// infos are generated for animated textures.
+/// Initializes texture manager. All stock textures are loaded, and animated
+/// textures and the palette ranges that animate them are set up.
 /// \param game game interface
-void TextureManager::Init(IGame& game)
+/// \param textureCache texture cache for scaled textures; may be null
+/// \param residencyManager residency manager for uploaded textures; may be null
+/// \param paletteShader palette shader to render stock textures with; may be
+///        null
+void TextureManager::Init(IGame& game, TextureCache* textureCache,
+   TextureResidencyManager* residencyManager, PaletteShader* paletteShader)
 {
+   m_textureCache = textureCache;
+   m_residencyManager = residencyManager;
+   m_paletteShader = paletteShader;
    m_palette0 = game.GetImageManager().GetPalette(0);
+   m_animatedPalette = *m_palette0;
+   m_animationStep = m_paletteShaderAnimationStep = 0;
+
+   LoadStockTextureImages(game, m_allStockTextureImages);
+
+   Base::Settings& settings = game.GetSettings();
+
+   m_isAnimatedStockTexture.clear();
+   m_isAnimatedStockTexture.resize(m_allStockTextureImages.size(), false);
+   m_stockTextureAnimationSteps.clear();
+   m_stockTextureAnimationSteps.resize(m_allStockTextureImages.size(), 0);
+   m_paletteCycles.clear();
+
+   if (settings.GetGameType() == Base::gameUw1)
+   {
+      // lava: indices 16 through 23; water: indices 48 through 51
+      m_paletteCycles.push_back(PaletteCycle{ 16, 8, false });
+      m_paletteCycles.push_back(PaletteCycle{ 48, 4, true });
+
+      // set some animated textures
+      {
+         m_isAnimatedStockTexture[0x00ce] = true; // 206 lavafall
+         m_isAnimatedStockTexture[0x0129] = true; // 469 rivulets of lava
+         m_isAnimatedStockTexture[0x0117] = true; // 487 rivulets of lava
+         m_isAnimatedStockTexture[0x0118] = true; // 486 lava
+         m_isAnimatedStockTexture[0x0119] = true; // 485 lava
+
+         m_isAnimatedStockTexture[0x0120] = true; // 478 water
+         m_isAnimatedStockTexture[0x0121] = true; // 477 water
+         m_isAnimatedStockTexture[0x0122] = true; // 476 water
+         m_isAnimatedStockTexture[0x0110] = true; // 493 water
+         m_isAnimatedStockTexture[0x0111] = true; // 494 water
+      }
+   }
+   else if (settings.GetGameType() == Base::gameUw2)
+   {
+   }
+
+   // now that all texture images are loaded, we can resize the texture array
+   m_stockTextures.resize(m_allStockTextureImages.size());
+
+   // init stock texture objects
+   Reset();
+}
+
+/// Loads the images of all stock textures, using palette 0. The images are
+/// indexed by stock texture index.
+/// \param game game interface
+/// \param stockTextureImages image array to store stock texture images
+void TextureManager::LoadStockTextureImages(IGame& game, std::vector<IndexedImage>& stockTextureImages)
+{
+   Palette256Ptr palette0 = game.GetImageManager().GetPalette(0);
 
    Import::TextureLoader loader{ game.GetResourceManager() };
 
@@ -55,84 +121,56 @@ void TextureManager::Init(IGame& game)
       const char* wallTexturesFilename =
          settings.GetBool(Base::settingUw1IsUwdemo) ? "data/dw64.tr" : "data/w64.tr";
 
-      loader.LoadTextures(m_allStockTextureImages, Base::c_stockTexturesWall,
-         wallTexturesFilename, m_palette0);
+      loader.LoadTextures(stockTextureImages, Base::c_stockTexturesWall,
+         wallTexturesFilename, palette0);
 
       // load all floor textures
       const char* floorTexturesFilename =
          settings.GetBool(Base::settingUw1IsUwdemo) ? "data/df32.tr" : "data/f32.tr";
 
-      loader.LoadTextures(m_allStockTextureImages, Base::c_stockTexturesFloor,
-         floorTexturesFilename, m_palette0);
+      loader.LoadTextures(stockTextureImages, Base::c_stockTexturesFloor,
+         floorTexturesFilename, palette0);
    }
    else if (settings.GetGameType() == Base::gameUw2)
    {
       // load all textures
       const char* texturesFilename = "data/t64.tr";
 
-      loader.LoadTextures(m_allStockTextureImages, Base::c_stockTexturesWall,
-         texturesFilename, m_palette0);
+      loader.LoadTextures(stockTextureImages, Base::c_stockTexturesWall,
+         texturesFilename, palette0);
    }
 
    // load objects
    {
-      m_allStockTextureImages.resize(Base::c_stockTexturesObjects);
+      stockTextureImages.resize(Base::c_stockTexturesObjects);
 
       // add images to list; we can do this, since the list isn't clear()ed
       // before adding more images
-      game.GetImageManager().LoadList(m_allStockTextureImages, "objects");
+      game.GetImageManager().LoadList(stockTextureImages, "objects");
    }
 
    // load switches/levers/pull chains
    {
-      m_allStockTextureImages.resize(Base::c_stockTexturesSwitches);
-      game.GetImageManager().LoadList(m_allStockTextureImages, "tmflat");
+      stockTextureImages.resize(Base::c_stockTexturesSwitches);
+      game.GetImageManager().LoadList(stockTextureImages, "tmflat");
    }
 
    // load door textures
    {
-      m_allStockTextureImages.resize(Base::c_stockTexturesDoors);
-      game.GetImageManager().LoadList(m_allStockTextureImages, "doors");
+      stockTextureImages.resize(Base::c_stockTexturesDoors);
+      game.GetImageManager().LoadList(stockTextureImages, "doors");
    }
 
    // load tmobj textures
    {
-      m_allStockTextureImages.resize(Base::c_stockTexturesTmobj);
-      game.GetImageManager().LoadList(m_allStockTextureImages, "tmobj");
+      stockTextureImages.resize(Base::c_stockTexturesTmobj);
+      game.GetImageManager().LoadList(stockTextureImages, "tmobj");
    }
-
-   m_stockTextureAnimationInfos.resize(m_allStockTextureImages.size(),
-      std::make_pair<unsigned int, unsigned int>(0, 1));
-
-   if (settings.GetGameType() == Base::gameUw1)
-   {
-      // set some animated textures
-      {
-         m_stockTextureAnimationInfos[0x00ce].second = 8; // 206 lavafall
-         m_stockTextureAnimationInfos[0x0129].second = 8; // 469 rivulets of lava
-         m_stockTextureAnimationInfos[0x0117].second = 8; // 487 rivulets of lava
-         m_stockTextureAnimationInfos[0x0118].second = 8; // 486 lava
-         m_stockTextureAnimationInfos[0x0119].second = 8; // 485 lava
-
-         m_stockTextureAnimationInfos[0x0120].second = 4; // 478 water
-         m_stockTextureAnimationInfos[0x0121].second = 4; // 477 water
-         m_stockTextureAnimationInfos[0x0122].second = 4; // 476 water
-         m_stockTextureAnimationInfos[0x0110].second = 4; // 493 water
-         m_stockTextureAnimationInfos[0x0111].second = 4; // 494 water
-      }
-   }
-   else if (settings.GetGameType() == Base::gameUw2)
-   {
-   }
-
-   // now that all texture images are loaded, we can resize the texture array
-   m_stockTextures.resize(m_allStockTextureImages.size());
-
-   // init stock texture objects
-   Reset();
 }
 
-/// Does all tick processing for textures. Animates animated textures.
+/// Does all tick processing for textures. Animates animated textures by
+/// cycling the palette ranges. The textures themselves are updated when they
+/// are used the next time.
 /// \param tickRate tick rate in ticks/second
 void TextureManager::Tick(double tickRate)
 {
@@ -142,19 +180,11 @@ void TextureManager::Tick(double tickRate)
    {
       m_animationCount -= 1.0 / s_animationFramesPerSecond;
 
-      // next animation frame
-      size_t max = m_stockTextureAnimationInfos.size();
-      for (size_t index = 0; index < max; index++)
-      {
-         std::pair<unsigned int, unsigned int>& info = m_stockTextureAnimationInfos[index];
-
-         if (info.second > 1)
-         {
-            // this one has animation
-            if ((++info.first) >= info.second)
-               info.first = 0;
-         }
-      }
+      // next animation step
+      m_animationStep++;
+
+      for (const PaletteCycle& cycle : m_paletteCycles)
+         m_animatedPalette.Cycle(cycle);
    }
 }
 
@@ -171,7 +201,12 @@ void TextureManager::Reset()
    m_lastTextureName = 0;
 }
 
-/// Prepares a stock texture for use in OpenGL.
+/// Prepares a stock texture for use in OpenGL. When a palette shader is set,
+/// all textures are rendered with it and aren't scaled. Animated textures
+/// only use a single texture image; the shader animates them with the cycled
+/// palette, or else they are converted again when the animation step changed.
+/// Animated textures bypass the texture cache, since every animation step
+/// would be hashed, and loaded from or stored to the cache.
 /// \param index index of stock texture to prepare
 /// \param scaleFactor scale factor for stock texture; valid values are 1, 2,
 /// 3 and 4
@@ -183,66 +218,67 @@ void TextureManager::Prepare(unsigned int index, unsigned int scaleFactor)
    // image must not be empty, or the game data doesn't match the graphics
    UaAssert(!m_allStockTextureImages[index].GetPixels().empty());
 
-   unsigned int maxPaletteIndex = m_stockTextureAnimationInfos[index].second;
-   if (maxPaletteIndex < 1)
-      return; // not an available texture
+   bool usePaletteShader = m_paletteShader != nullptr;
 
-   m_stockTextures[index].Init(maxPaletteIndex, scaleFactor);
+   m_stockTextures[index].Init(1, usePaletteShader ? 1 : scaleFactor);
+   m_stockTextures[index].SetTextureCache(m_isAnimatedStockTexture[index] ? nullptr : m_textureCache);
+   m_stockTextures[index].SetResidencyManager(m_residencyManager);
+   m_stockTextures[index].SetPaletteShader(usePaletteShader ? m_paletteShader : nullptr);
 
-   if (maxPaletteIndex == 1)
+   if (!m_isAnimatedStockTexture[index] || usePaletteShader)
    {
       // only allow mipmaps for non-object images
       bool mipmap = (index < Base::c_stockTexturesObjects) || (index > Base::c_stockTexturesObjects + 0x0200);
 
-      // unanimated texture
       // convert to texture object
       m_stockTextures[index].Convert(m_allStockTextureImages[index], 0);
       m_stockTextures[index].Upload(0, mipmap); // upload texture with mipmaps
    }
    else
-   {
-      Palette256& pal = *m_palette0;
+      ConvertAnimatedTexture(index);
+}
 
-      unsigned int xres = m_allStockTextureImages[index].GetXRes();
-      unsigned int yres = m_allStockTextureImages[index].GetXRes();
-      Uint8* pixels = &m_allStockTextureImages[index].GetPixels()[0];
+/// Uses a stock texture. When using the palette shader and the animation
+/// step changed, the cycled palette is uploaded; else an animated texture is
+/// converted again with the cycled palette, when it's out of date.
+/// \param index index of stock texture to use
+void TextureManager::Use(unsigned int index)
+{
+   if (index >= m_stockTextures.size())
+      return; // not a valid index
 
-      // animated texture
-      if (maxPaletteIndex == 8)
-      {
-         // lava texture: indices 16 through 23
-         for (unsigned int i = 0; i < 8; i++)
-         {
-            m_stockTextures[index].Convert(pixels, xres, yres, pal, i);
-            m_stockTextures[index].Upload(i, true); // upload texture with mipmaps
-
-            // rotate entries
-            pal.Rotate(16, 8, false);
-         }
-      }
-      else if (maxPaletteIndex == 4)
+   if (m_paletteShader != nullptr)
+   {
+      if (m_paletteShaderAnimationStep != m_animationStep)
       {
-         // water texture: indices 48 through 51
-         for (unsigned int i = 0; i < 4; i++)
-         {
-            m_stockTextures[index].Convert(pixels, xres, yres, pal, i);
-            m_stockTextures[index].Upload(i, true); // upload texture with mipmaps
-
-            // rotate entries
-            pal.Rotate(48, 4, true);
-         }
+         m_paletteShader->SetPalette(m_animatedPalette);
+         m_paletteShaderAnimationStep = m_animationStep;
       }
    }
+   else if (m_isAnimatedStockTexture[index] &&
+      m_stockTextureAnimationSteps[index] != m_animationStep &&
+      !m_stockTextures[index].m_textureNames.empty())
+   {
+      ConvertAnimatedTexture(index);
+   }
+
+   m_stockTextures[index].Use(0);
+   m_renderStatistics.m_numTextureBinds++;
 }
 
-/// Uses a stock texture.
-/// \param index index of stock texture to use
-void TextureManager::Use(unsigned int index)
+/// Converts an animated stock texture to RGBA using the palette of the
+/// current animation step, and uploads it. Only the single texture image
+/// has to be kept, instead of one image per animation step.
+/// \param index index of animated stock texture
+void TextureManager::ConvertAnimatedTexture(unsigned int index)
 {
-   if (index >= m_stockTextures.size())
-      return; // not a valid index
+   const IndexedImage& image = m_allStockTextureImages[index];
+
+   m_stockTextures[index].Convert(image.GetPixels().data(),
+      image.GetXRes(), image.GetYRes(), m_animatedPalette, 0);
+   m_stockTextures[index].Upload(0, true); // upload texture with mipmaps
 
-   m_stockTextures[index].Use(m_stockTextureAnimationInfos[index].first);
+   m_stockTextureAnimationSteps[index] = m_animationStep;
 }
 
 /// Uses a new texture name. Returns false when the texture is already in use.
@@ -24,8 +24,12 @@
 #include <vector>
 #include "Texture.hpp"
 #include "IndexedImage.hpp"
+#include "RenderStatistics.hpp"
 
 class IGame;
+class TextureCache;
+class TextureResidencyManager;
+class PaletteShader;
 
 /// texture manager
 class TextureManager
@@ -41,9 +45,14 @@ public:
    TextureManager& operator=(const TextureManager&) = delete;
 
    /// initializes texture manager; loads stock textures
-   void Init(IGame& game);
+   void Init(IGame& game, TextureCache* textureCache = nullptr,
+      TextureResidencyManager* residencyManager = nullptr,
+      PaletteShader* paletteShader = nullptr);
 
-   /// called every game tick
+   /// loads images of all stock textures
+   static void LoadStockTextureImages(IGame& game, std::vector<IndexedImage>& stockTextureImages);
+
+   /// called every game tick; cycles palette of animated textures
    void Tick(double tickRate);
 
    /// resets usage of stock textures in OpenGL
@@ -64,6 +73,16 @@ public:
    /// sets new OpenGL color from palette 0
    void GetPaletteColor(Uint8 paletteIndex, Uint8& red, Uint8& green, Uint8& blue);
 
+   /// returns statistics of the current frame, collected by all users of the
+   /// texture manager
+   RenderStatistics& GetRenderStatistics() { return m_renderStatistics; }
+   /// returns statistics of the current frame; const version
+   const RenderStatistics& GetRenderStatistics() const { return m_renderStatistics; }
+
+protected:
+   /// converts and uploads animated stock texture with the current palette
+   void ConvertAnimatedTexture(unsigned int index);
+
 protected:
    /// frames per second for animated textures
    static const double s_animationFramesPerSecond;
@@ -77,12 +96,39 @@ protected:
    /// stock textures
    std::vector<Texture> m_stockTextures;
 
-   /// infos about current/max texture frame for all stock textures
-   std::vector<std::pair<unsigned int, unsigned int>> m_stockTextureAnimationInfos;
+   /// indicates which stock textures are animated by palette cycling
+   std::vector<bool> m_isAnimatedStockTexture;
+
+   /// animation step that animated RGBA stock textures were converted with
+   std::vector<unsigned int> m_stockTextureAnimationSteps;
+
+   /// palette ranges that are cycled to animate textures
+   std::vector<PaletteCycle> m_paletteCycles;
 
    /// palette 0 from image manager
    Palette256Ptr m_palette0;
 
+   /// palette 0 with all palette cycles applied for the current animation step
+   Palette256 m_animatedPalette;
+
+   /// current animation step
+   unsigned int m_animationStep;
+
+   /// animation step of the palette last uploaded to the palette shader
+   unsigned int m_paletteShaderAnimationStep;
+
+   /// texture cache for scaled stock textures; may be null
+   TextureCache* m_textureCache;
+
+   /// residency manager for uploaded stock textures; may be null
+   TextureResidencyManager* m_residencyManager;
+
+   /// palette shader to render stock textures with; may be null
+   PaletteShader* m_paletteShader;
+
    /// time counter for animated textures
    double m_animationCount;
+
+   /// render statistics of the current frame
+   RenderStatistics m_renderStatistics;
 };
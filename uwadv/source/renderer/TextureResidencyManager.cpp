@@ -0,0 +1,141 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureResidencyManager.cpp
+/// \brief texture memory budget and eviction of uploaded textures
+//
+#include "pch.hpp"
+#include "TextureResidencyManager.hpp"
+#include "Texture.hpp"
+#include <algorithm>
+
+TextureResidencyManager::TextureResidencyManager()
+   :m_currentFrame(0)
+{
+}
+
+/// \param settings settings to read texture memory budget from
+void TextureResidencyManager::Init(const Base::Settings& settings)
+{
+   SetBudget(static_cast<size_t>(settings.GetInt(Base::settingTextureMemoryBudget)) * 1024 * 1024);
+}
+
+/// Sets a new texture memory budget; when the currently uploaded textures
+/// exceed the budget, texture images are evicted.
+/// \param budgetBytes texture memory budget, in bytes; 0 means unlimited
+void TextureResidencyManager::SetBudget(size_t budgetBytes)
+{
+   m_statistics.m_budgetBytes = budgetBytes;
+
+   EvictTextures();
+}
+
+void TextureResidencyManager::DumpStatistics() const
+{
+   UaTrace("texture residency statistics:\n"
+      " resident: %u textures, %u kB of %u kB budget, peak %u kB\n"
+      " uploads: %u, re-uploads: %u, evictions: %u\n",
+      static_cast<unsigned int>(m_statistics.m_numResidentTextures),
+      static_cast<unsigned int>(m_statistics.m_residentBytes / 1024),
+      static_cast<unsigned int>(m_statistics.m_budgetBytes / 1024),
+      static_cast<unsigned int>(m_statistics.m_peakResidentBytes / 1024),
+      m_statistics.m_numUploads,
+      m_statistics.m_numReuploads,
+      m_statistics.m_numEvictions);
+}
+
+/// Records a texture image upload. When a texture image is uploaded again
+/// while it's still resident, e.g. for animations, only its size is updated.
+/// \param texture texture that was uploaded
+/// \param textureIndex index of texture image that was uploaded
+/// \param numBytes number of bytes uploaded, including mipmaps
+/// \param isReupload true when the image was evicted before
+void TextureResidencyManager::OnUpload(Texture& texture, unsigned int textureIndex, size_t numBytes, bool isReupload)
+{
+   size_t& residentSize = m_residentTextures[ResidentKey(&texture, textureIndex)];
+
+   m_statistics.m_residentBytes -= residentSize;
+   m_statistics.m_residentBytes += numBytes;
+   residentSize = numBytes;
+
+   m_statistics.m_numResidentTextures = m_residentTextures.size();
+   m_statistics.m_peakResidentBytes = std::max(m_statistics.m_peakResidentBytes, m_statistics.m_residentBytes);
+
+   if (isReupload)
+      m_statistics.m_numReuploads++;
+   else
+      m_statistics.m_numUploads++;
+
+   EvictTextures();
+}
+
+/// \param texture texture that was deleted
+/// \param textureIndex index of texture image that was deleted
+void TextureResidencyManager::OnRelease(Texture& texture, unsigned int textureIndex)
+{
+   auto iter = m_residentTextures.find(ResidentKey(&texture, textureIndex));
+   if (iter == m_residentTextures.end())
+      return;
+
+   m_statistics.m_residentBytes -= iter->second;
+   m_residentTextures.erase(iter);
+
+   m_statistics.m_numResidentTextures = m_residentTextures.size();
+}
+
+/// Evicts the least recently used texture images, until the uploaded bytes
+/// are below 7/8 of the budget, so that the next few uploads don't evict
+/// again. Texture images used in the current frame are kept, even when the
+/// budget can't be met.
+void TextureResidencyManager::EvictTextures()
+{
+   size_t budgetBytes = m_statistics.m_budgetBytes;
+   if (budgetBytes == 0 || m_statistics.m_residentBytes <= budgetBytes)
+      return;
+
+   // sort all texture images not used in this frame by last usage
+   std::vector<std::pair<Uint32, ResidentKey>> candidates;
+   for (auto& iter : m_residentTextures)
+   {
+      Uint32 lastUsedFrame = iter.first.first->GetLastUsedFrame(iter.first.second);
+      if (lastUsedFrame != m_currentFrame)
+         candidates.push_back(std::make_pair(lastUsedFrame, iter.first));
+   }
+
+   std::sort(candidates.begin(), candidates.end());
+
+   size_t targetBytes = budgetBytes - budgetBytes / 8;
+   for (auto& candidate : candidates)
+   {
+      if (m_statistics.m_residentBytes <= targetBytes)
+         break;
+
+      Texture& texture = *candidate.second.first;
+      unsigned int textureIndex = candidate.second.second;
+
+      auto iter = m_residentTextures.find(candidate.second);
+      m_statistics.m_residentBytes -= iter->second;
+      m_residentTextures.erase(iter);
+
+      texture.Evict(textureIndex);
+
+      m_statistics.m_numEvictions++;
+   }
+
+   m_statistics.m_numResidentTextures = m_residentTextures.size();
+}
@@ -0,0 +1,115 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureResidencyManager.hpp
+/// \brief texture memory budget and eviction of uploaded textures
+//
+#pragma once
+
+#include <map>
+
+namespace Base
+{
+   class Settings;
+}
+
+class Texture;
+
+/// texture residency statistics
+struct TextureResidencyStatistics
+{
+   /// number of texture images currently uploaded
+   size_t m_numResidentTextures = 0;
+
+   /// number of bytes currently uploaded
+   size_t m_residentBytes = 0;
+
+   /// max. number of bytes that were uploaded at the same time
+   size_t m_peakResidentBytes = 0;
+
+   /// texture memory budget, in bytes; 0 when unlimited
+   size_t m_budgetBytes = 0;
+
+   /// number of texture images uploaded for the first time
+   unsigned int m_numUploads = 0;
+
+   /// number of evicted texture images that were uploaded again
+   unsigned int m_numReuploads = 0;
+
+   /// number of evicted texture images
+   unsigned int m_numEvictions = 0;
+};
+
+/// \brief manages residency of uploaded textures
+/// Texture objects that have a residency manager set report the number of
+/// bytes uploaded for each texture image. When the uploaded bytes exceed the
+/// texture memory budget, the least recently used texture images are evicted
+/// from the graphics card. Texture images keep their converted texels, and
+/// evicted images are uploaded again when they are used the next time.
+/// Texture images used in the current frame are never evicted.
+class TextureResidencyManager
+{
+public:
+   /// ctor
+   TextureResidencyManager();
+   /// deleted copy ctor
+   TextureResidencyManager(const TextureResidencyManager&) = delete;
+   /// deleted assignment operator
+   TextureResidencyManager& operator=(const TextureResidencyManager&) = delete;
+
+   /// initializes residency manager; reads texture memory budget from settings
+   void Init(const Base::Settings& settings);
+
+   /// sets texture memory budget, in bytes; 0 means unlimited
+   void SetBudget(size_t budgetBytes);
+
+   /// starts a new rendered frame
+   void NextFrame() { m_currentFrame++; }
+
+   /// returns current frame counter
+   Uint32 GetCurrentFrame() const { return m_currentFrame; }
+
+   /// returns residency statistics
+   const TextureResidencyStatistics& GetStatistics() const { return m_statistics; }
+
+   /// dumps residency statistics
+   void DumpStatistics() const;
+
+   /// called by Texture when a texture image was uploaded
+   void OnUpload(Texture& texture, unsigned int textureIndex, size_t numBytes, bool isReupload);
+
+   /// called by Texture when a texture image was deleted
+   void OnRelease(Texture& texture, unsigned int textureIndex);
+
+private:
+   /// evicts least recently used texture images until the budget is met
+   void EvictTextures();
+
+private:
+   /// key of a resident texture image
+   typedef std::pair<Texture*, unsigned int> ResidentKey;
+
+   /// mapping of all resident texture images to their size, in bytes
+   std::map<ResidentKey, size_t> m_residentTextures;
+
+   /// current frame counter
+   Uint32 m_currentFrame;
+
+   /// residency statistics
+   TextureResidencyStatistics m_statistics;
+};
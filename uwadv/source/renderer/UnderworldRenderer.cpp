@@ -24,15 +24,50 @@
 #include "LevelTilemapRenderer.hpp"
 #include "RenderOptions.hpp"
 #include "Constants.hpp"
+#include "ImageManager.hpp"
 
 const double c_renderHeightScale = 0.125 * 0.25;
 
+namespace Detail
+{
+   /// offset of decals from the wall, so that picking prefers decals
+   const double c_pickDecalWallOffset = 0.02;
+
+   /// offset of tmap objects, so that picking prefers them over the wall
+   const double c_pickTmapObjectOffset = 0.01;
+
+   /// returns if two tiles result in the same tile geometry
+   bool IsSameTileGeometry(const Underworld::TileInfo& tileInfo1, const Underworld::TileInfo& tileInfo2)
+   {
+      return tileInfo1.m_type == tileInfo2.m_type &&
+         tileInfo1.m_floor == tileInfo2.m_floor &&
+         tileInfo1.m_ceiling == tileInfo2.m_ceiling &&
+         tileInfo1.m_slope == tileInfo2.m_slope &&
+         tileInfo1.m_textureWall == tileInfo2.m_textureWall &&
+         tileInfo1.m_textureFloor == tileInfo2.m_textureFloor &&
+         tileInfo1.m_textureCeiling == tileInfo2.m_textureCeiling &&
+         tileInfo1.m_isDoorPresent == tileInfo2.m_isDoorPresent;
+   }
+}
+
 UnderworldRenderer::UnderworldRenderer(IGame& game)
-   :m_selectionMode(false)
+   :m_snapshot(nullptr)
 {
-   m_textureManager.Init(game);
+   Base::Settings& settings = game.GetSettings();
+
+   m_textureCache.Init(settings);
+   m_textureResidencyManager.Init(settings);
+
+   // falls back to RGBA textures when shaders aren't available
+   bool usePaletteShader = settings.GetBool(Base::settingPaletteShader) &&
+      m_paletteShader.Init(*game.GetImageManager().GetPalette(0),
+         settings.GetBool(Base::settingPaletteSmoothing));
+
+   m_textureManager.Init(game, &m_textureCache, &m_textureResidencyManager,
+      usePaletteShader ? &m_paletteShader : nullptr);
    m_modelManager.Init(game);
-   m_critterManager.Init(game.GetSettings(), game.GetResourceManager(), game.GetImageManager());
+   m_critterManager.Init(game.GetSettings(), game.GetResourceManager(), game.GetImageManager(),
+      &m_textureResidencyManager);
 
    // when feature flag is set, just use the highest sacle factor; max.
    // texture size is 64x64, which results in max. texture sizes of 256x256.
@@ -57,6 +92,11 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
 {
    UaTrace("preparing textures for level... ");
 
+   // tile triangles are cached for the current level only
+   m_tilePickTriangles.clear();
+   m_tilePickTrianglesCached.clear();
+   m_tilePickTileInfos.clear();
+
    // reset stock texture usage
    m_textureManager.Reset();
 
@@ -108,6 +148,8 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
    m_critterManager.Prepare(&level.GetObjectList());
 
    UaTrace("done\n");
+
+   m_textureResidencyManager.DumpStatistics();
 }
 
 /// Renders the visible parts of a level.
@@ -117,10 +159,25 @@ void UnderworldRenderer::PrepareLevel(Underworld::Level& level)
 /// \param panAngle angle to pan up/down the view
 /// \param rotateAngle angle to rotate left/right the view
 /// \param fieldOfView angle of field of view
+/// \param snapshot snapshot with interpolated positions of objects; objects
+///        without a position in the snapshot are rendered at their position
+///        in the level; may be null
 void UnderworldRenderer::Render(const RenderOptions& renderOptions,
    const Underworld::Level& level, Vector3d pos,
-   double panAngle, double rotateAngle, double fieldOfView)
+   double panAngle, double rotateAngle, double fieldOfView,
+   const WorldSnapshot* snapshot)
 {
+   m_snapshot = snapshot;
+
+   // textures used from now on belong to the new frame
+   m_textureResidencyManager.NextFrame();
+
+   RenderStatistics& statistics = m_textureManager.GetRenderStatistics();
+   statistics.Reset();
+
+   const TextureResidencyStatistics& residencyStatistics = m_textureResidencyManager.GetStatistics();
+   unsigned int numUploadsBefore = residencyStatistics.m_numUploads + residencyStatistics.m_numReuploads;
+
    {
       // rotation
       glRotated(panAngle + 270.0, 1.0, 0.0, 0.0);
@@ -175,6 +232,62 @@ void UnderworldRenderer::Render(const RenderOptions& renderOptions,
             RenderObjects(renderOptions, viewerPos, level, tilePosX, tilePosY);
          }
    }
+
+   // render the 3d models collected after the last drawn object
+   glEnable(GL_BLEND);
+   glAlphaFunc(GL_GREATER, 0.1f);
+   glEnable(GL_ALPHA_TEST);
+
+   m_modelManager.RenderInstances(renderOptions, viewerPos, m_textureManager);
+
+   glDisable(GL_ALPHA_TEST);
+   glDisable(GL_BLEND);
+
+   // the user interface is rendered with the fixed-function pipeline
+   PaletteShader::Deactivate();
+
+   statistics.m_numTextureUploads =
+      residencyStatistics.m_numUploads + residencyStatistics.m_numReuploads - numUploadsBefore;
+
+   m_snapshot = nullptr;
+}
+
+/// Picks the nearest tile triangle or object along a ray, using the tile
+/// triangles and the same object geometry as used for rendering.
+/// \param renderOptions render options to use
+/// \param level the level to pick in
+/// \param pos position of the viewer, e.g. the player
+/// \param panAngle angle to pan up/down the view
+/// \param rotateAngle angle to rotate left/right the view
+/// \param direction normalized ray direction, in world coordinates
+/// \param maxDistance max. distance of picked triangles
+/// \param result picking result; only valid when true is returned
+/// \return true when a tile triangle or object was picked
+bool UnderworldRenderer::Pick(const RenderOptions& renderOptions,
+   const Underworld::Level& level, Vector3d pos, double panAngle, double rotateAngle,
+   const Vector3d& direction, double maxDistance, PickResult& result)
+{
+   // billboards face the viewer, so use the same vectors as when rendering
+   m_billboardRightVector = PickingRayCaster::TransformCameraToWorld(
+      Vector3d(1.0, 0.0, 0.0), panAngle, rotateAngle);
+   m_billboardUpVector = PickingRayCaster::TransformCameraToWorld(
+      Vector3d(0.0, 1.0, 0.0), panAngle, rotateAngle);
+
+   UpdateTilePickTriangles(level);
+
+   PickingRayCaster rayCaster(
+      [&](unsigned int x, unsigned int y, std::vector<PickTriangle>& allTriangles)
+      {
+         CollectTilePickTriangles(level, x, y, allTriangles);
+      },
+      [&](unsigned int x, unsigned int y, std::vector<PickTriangle>& allTriangles)
+      {
+         CollectObjectPickTriangles(renderOptions, level, x, y, allTriangles);
+      });
+
+   Vector3d origin(pos.x, pos.y, pos.z * c_renderHeightScale);
+
+   return rayCaster.Pick(origin, direction, maxDistance, result);
 }
 
 /// Renders all objects in a tile.
@@ -187,8 +300,6 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    const Vector3d& viewerPos, const Underworld::Level& level,
    unsigned int x, unsigned int y)
 {
-   glPushName((y << 8) + x);
-
    // enable alpha blending
    glEnable(GL_BLEND);
 
@@ -205,13 +316,8 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    {
       const Underworld::Object& obj = *objectList.GetObject(link);
 
-      // remember object list position for picking
-      glPushName(link);
-
       // render object
-      RenderObject(renderOptions, viewerPos, level, obj, x, y);
-
-      glPopName();
+      RenderObject(renderOptions, viewerPos, level, obj, link, x, y);
 
       // next object in link chain
       link = obj.GetObjectInfo().m_link;
@@ -220,21 +326,22 @@ void UnderworldRenderer::RenderObjects(const RenderOptions& renderOptions,
    // disable alpha blending again
    glDisable(GL_ALPHA_TEST);
    glDisable(GL_BLEND);
-
-   glPopName();
 }
 
-/// Renders an object at a time. When a 3d model for that object exists, the
-/// model is drawn instead.
+/// Renders an object at a time. When a 3d model for that object exists, a
+/// model instance is added instead. The collected model instances are drawn
+/// before the next object that isn't a model, and at the end of Render(), so
+/// that models and sprites are still blended in the order of the objects.
 /// \param renderOptions render options to use
 /// \param viewerPos viewer position
 /// \param level level in which object is; const object
 /// \param obj object to render; const object
+/// \param objectPos object list position of object
 /// \param x x tile coordinate of object
 /// \param y y tile coordinate of object
 void UnderworldRenderer::RenderObject(const RenderOptions& renderOptions,
    const Vector3d& viewerPos, const Underworld::Level& level,
-   const Underworld::Object& obj, unsigned int x, unsigned int y)
+   const Underworld::Object& obj, Uint16 objectPos, unsigned int x, unsigned int y)
 {
    // don't render invisible objects
    if (!renderOptions.m_renderHiddenObjects && obj.GetObjectInfo().m_isHidden)
@@ -251,44 +358,40 @@ void UnderworldRenderer::RenderObject(const RenderOptions& renderOptions,
    // get base coordinates
    Vector3d base = CalcObjectPosition(x, y, obj);
 
+   if (m_snapshot != nullptr)
+   {
+      const Vector3d* snapshotPos = m_snapshot->GetObjectPosition(objectPos);
+      if (snapshotPos != nullptr)
+         base = *snapshotPos;
+   }
+
    // check if a 3d model is available for that item
    if (m_modelManager.IsModelAvailable(itemId))
    {
       base.z = posInfo.m_zpos * c_renderHeightScale;
 
-      m_modelManager.Render(renderOptions, viewerPos, obj, m_textureManager, base);
+      m_modelManager.AddInstance(obj, base);
+      return;
    }
-   // critters
-   else if (itemId >= 0x0040 && itemId < 0x0080)
-   {
-      UaAssert(obj.IsNpcObject());
-      if (!obj.IsNpcObject())
-         return; // shouldn't happen
-
-      const Underworld::NpcObject& npc = obj.GetNpcObject();
-      const Underworld::NpcInfo& npcInfo = npc.GetNpcInfo();
-
-      // critter object
-      Critter& crit = m_critterManager.GetCritter(itemId - 0x0040);
-      unsigned int curframe = crit.GetFrame(npcInfo.m_animationState, npcInfo.m_animationFrame);
-      Texture& tex = crit.GetTexture(curframe);
-
-      tex.Use(0);
 
-      // adjust height for hotspot
-      base.z -= 0.0;
+   // draw models of the previous objects first; consecutive models are still
+   // drawn together
+   if (m_modelManager.HasInstances())
+      m_modelManager.RenderInstances(renderOptions, viewerPos, m_textureManager);
 
-      double u = crit.GetHotspotU(curframe) / tex.GetTexU();
-      double v = crit.GetHotspotV(curframe) / tex.GetTexV();
-
-      u = 1.0 - u * 2.0;
-      v = v - 1.0;
+   // critters
+   if (itemId >= 0x0040 && itemId < 0x0080)
+   {
+      double u = 0.0, v = 0.0;
+      const CritterFrameLocation* location = GetCritterFrame(obj, u, v);
+      if (location == nullptr)
+         return; // no frames available
 
-      // fix for rotworm; hotspot always too high
-      if (itemId == 0x0040) v += 0.25;
+      m_critterManager.GetAtlasTexture(location->m_atlasIndex).Use(0);
+      m_textureManager.GetRenderStatistics().m_numTextureBinds++;
 
       RenderSprite(renderOptions, base, 0.4, 0.88, true,
-         tex.GetTexU(), tex.GetTexV(), u, v);
+         location->m_u1, location->m_v1, location->m_u2, location->m_v2, u, v);
    }
    // switches/levers/buttons/pull chains
    else if ((itemId >= 0x0170 && itemId <= 0x017f) ||
@@ -321,43 +424,53 @@ void UnderworldRenderer::RenderObject(const RenderOptions& renderOptions,
 
       // normal object
       m_textureManager.Use(itemId + Base::c_stockTexturesObjects);
-      RenderSprite(renderOptions, base, 0.5 * quadWidth, quadWidth, false, 1.0, 1.0);
+      RenderSprite(renderOptions, base, 0.5 * quadWidth, quadWidth, false, 0.0, 0.0, 1.0, 1.0);
    }
 }
 
-/// \details renders the following objects:
-/// - 0x0161 a_lever
-/// - 0x0162 a_switch
-/// - 0x0166 some writing
-/// - 0x017x buttons/switches/levers/pull chain
-void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int x, unsigned int y)
+/// Determines the current frame of a critter object, and the offset to move
+/// the sprite to the frame's hotspot.
+/// \param obj NPC object
+/// \param moveU u-coordinate offset to move base to hotspot
+/// \param moveV v-coordinate offset to move base to hotspot
+/// \return frame location, or null when the critter has no frames
+const CritterFrameLocation* UnderworldRenderer::GetCritterFrame(const Underworld::Object& obj,
+   double& moveU, double& moveV)
 {
-   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
+   UaAssert(obj.IsNpcObject());
+   if (!obj.IsNpcObject())
+      return nullptr; // shouldn't happen
 
-   Vector3d base(static_cast<double>(x), static_cast<double>(y),
-      posInfo.m_zpos * c_renderHeightScale);
+   Uint16 itemId = obj.GetObjectInfo().m_itemID;
 
-   Vector2d to_right;
+   const Underworld::NpcObject& npc = obj.GetNpcObject();
+   const Underworld::NpcInfo& npcInfo = npc.GetNpcInfo();
 
-   const double wall_offset = m_selectionMode ? 0.02 : 0.00;
+   // critter object
+   Critter& crit = m_critterManager.GetCritter(itemId - 0x0040);
+   if (!crit.IsPrepared())
+      return nullptr;
 
-   switch (posInfo.m_heading)
-   {
-   case 0: to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wall_offset; break;
-   case 2: to_right.Set(0.0, -1.0); base.y += posInfo.m_ypos / 8.0; base.x += 1.0 - wall_offset; break;
-   case 4: to_right.Set(-1.0, 0.0); base.x += posInfo.m_xpos / 8.0; base.y += wall_offset; break;
-   case 6: to_right.Set(0.0, 1.0);  base.y += posInfo.m_ypos / 8.0; base.x += wall_offset; break;
+   unsigned int curframe = crit.GetFrame(npcInfo.m_animationState, npcInfo.m_animationFrame);
 
-   default:
-      // should not occur; use 0 as value
-      to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wall_offset; break;
-      break;
-   }
+   moveU = 1.0 - crit.GetHotspotU(curframe) * 2.0;
+   moveV = crit.GetHotspotV(curframe) - 1.0;
 
-   const double decalheight = 1.0 / 8.0;
+   // fix for rotworm; hotspot always too high
+   if (itemId == 0x0040) moveV += 0.25;
 
-   to_right.Normalize();
-   to_right *= decalheight;
+   return &crit.GetFrameLocation(curframe);
+}
+
+/// \details renders the following objects:
+/// - 0x0161 a_lever
+/// - 0x0162 a_switch
+/// - 0x0166 some writing
+/// - 0x017x buttons/switches/levers/pull chain
+void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int x, unsigned int y)
+{
+   Vector3d quad[4];
+   CalcDecalQuad(obj, x, y, 0.0, quad);
 
    // select texture
    const Underworld::ObjectInfo& info = obj.GetObjectInfo();
@@ -394,12 +507,14 @@ void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int
 
    // render quad
    glBegin(GL_QUADS);
-   glTexCoord2d(u1, v2); glVertex3d(base.x - to_right.x, base.y - to_right.y, base.z);
-   glTexCoord2d(u2, v2); glVertex3d(base.x + to_right.x, base.y + to_right.y, base.z);
-   glTexCoord2d(u2, v1); glVertex3d(base.x + to_right.x, base.y + to_right.y, base.z + 2 * decalheight);
-   glTexCoord2d(u1, v1); glVertex3d(base.x - to_right.x, base.y - to_right.y, base.z + 2 * decalheight);
+   glTexCoord2d(u1, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
 
+   m_textureManager.GetRenderStatistics().AddDrawCall(2);
+
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
@@ -407,49 +522,8 @@ void UnderworldRenderer::RenderDecal(const Underworld::Object& obj, unsigned int
 void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
    const Underworld::Object& obj, unsigned int x, unsigned int y)
 {
-   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
-
-   Vector3d pos(static_cast<double>(x), static_cast<double>(y),
-      posInfo.m_zpos * c_renderHeightScale);
-
-   unsigned int x_fr = posInfo.m_xpos;
-   unsigned int y_fr = posInfo.m_ypos;
-
-   // hack: fixing some tmap decals
-   if (x_fr > 4) x_fr++;
-   if (y_fr > 4) y_fr++;
-
-   // determine direction
-   Vector3d dir;
-   switch (posInfo.m_heading)
-   {
-   case 0: dir.Set(1.0, 0.0, 0.0); break;
-   case 2: dir.Set(0.0, 1.0, 0.0); break;
-   case 4: dir.Set(-1.0, 0.0, 0.0); break;
-   case 6: dir.Set(0.0, -1.0, 0.0); break;
-
-   case 1: dir.Set(1.0, -1.0, 0.0); break;
-   case 3: dir.Set(-1.0, -1.0, 0.0); break;
-   case 5: dir.Set(-1.0, 1.0, 0.0); break;
-   case 7: dir.Set(1.0, 1.0, 0.0); break;
-   }
-
-   dir.Normalize();
-   dir *= 0.5;
-
-   // add fractional position
-   pos.x += x_fr / 8.0;
-   pos.y += y_fr / 8.0;
-
-   if (m_selectionMode)
-   {
-      // in selection mode, offset object pos
-      Vector3d offset(dir);
-      offset.RotateZ(-90.0);
-      offset *= 0.01;
-
-      pos += offset;
-   }
+   Vector3d quad[4];
+   CalcTmapObjectQuad(obj, x, y, 0.0, quad);
 
    // enable polygon offset
    glPolygonOffset(-2.0, -2.0);
@@ -465,11 +539,13 @@ void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
    m_textureManager.Use(info.m_itemID + Base::c_stockTexturesObjects);
 
    glBegin(GL_QUADS);
-   glTexCoord2d(u2, v2); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z);
-   glTexCoord2d(u2, v1); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v1); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v2); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v2); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
+
+   m_textureManager.GetRenderStatistics().AddDrawCall(2);
 #endif
 
    m_textureManager.Use(info.m_owner);
@@ -477,17 +553,20 @@ void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
    u2 = v2 = 1.0;
 
    glBegin(GL_QUADS);
-   glTexCoord2d(u2, v2); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z);
-   glTexCoord2d(u2, v1); glVertex3d(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v1); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
-   glTexCoord2d(u1, v2); glVertex3d(pos.x - dir.x, pos.y - dir.y, pos.z);
+   glTexCoord2d(u2, v2); glVertex3d(quad[0].x, quad[0].y, quad[0].z);
+   glTexCoord2d(u2, v1); glVertex3d(quad[1].x, quad[1].y, quad[1].z);
+   glTexCoord2d(u1, v1); glVertex3d(quad[2].x, quad[2].y, quad[2].z);
+   glTexCoord2d(u1, v2); glVertex3d(quad[3].x, quad[3].y, quad[3].z);
    glEnd();
 
+   m_textureManager.GetRenderStatistics().AddDrawCall(2);
+
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
 /// Renders a billboarded drawn sprite; the texture has to be use()d before
-/// calling, and the max u and v coordinates have to be passed.
+/// calling, and the texture coordinates of the sprite have to be passed, e.g.
+/// the location of a frame in an atlas texture.
 /// Objects are drawn using the method described in the billboarding tutorial,
 /// "Cheating - Faster but not so easy". Billboarding tutorials:
 /// http://www.lighthouse3d.com/opengl/billboarding/
@@ -498,13 +577,16 @@ void UnderworldRenderer::RenderTmapObject(const RenderOptions& renderOptions,
 /// \param height relative height of object in relation to a tile
 /// \param ignoreUpVector ignores billboard up-vector when true; used for
 ///                        critters
-/// \param u maximum u texture coordinate
-/// \param v maximum v texture coordinate
+/// \param u1 upper left u texture coordinate
+/// \param v1 upper left v texture coordinate
+/// \param u2 lower right u texture coordinate
+/// \param v2 lower right v texture coordinate
 /// \param moveU u-coordinate offset to move base, e.g. to hotspot
 /// \param moveV v-coordinate offset to move base, e.g. to hotspot
 void UnderworldRenderer::RenderSprite(
    const RenderOptions& renderOptions, Vector3d base,
-   double width, double height, bool ignoreUpVector, double u, double v,
+   double width, double height, bool ignoreUpVector,
+   double u1, double v1, double u2, double v2,
    double moveU, double moveV)
 {
    // set texture parameter
@@ -514,32 +596,13 @@ void UnderworldRenderer::RenderSprite(
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 
-   // scale z axis before any calculation is done
-   base.z *= c_renderHeightScale;
-
-   // move base to new location
-   base += m_billboardRightVector * moveU * width;
-   base += m_billboardUpVector * moveV * height;
-
-   // calculate vectors for quad
-   Vector3d base2(base);
-
-   base -= m_billboardRightVector * width;
-   base2 += m_billboardRightVector * width;
-
-   Vector3d high1(base);
-   Vector3d high2(base2);
+   Vector3d quad[4];
+   CalcSpriteQuad(base, width, height, ignoreUpVector, moveU, moveV, quad);
 
-   if (ignoreUpVector)
-   {
-      high1.z += height;
-      high2.z += height;
-   }
-   else
-   {
-      high1 += m_billboardUpVector * height;
-      high2 += m_billboardUpVector * height;
-   }
+   const Vector3d& base1 = quad[0];
+   const Vector3d& base2 = quad[1];
+   const Vector3d& high2 = quad[2];
+   const Vector3d& high1 = quad[3];
 
    // enable polygon offset
    glPolygonOffset(-2.0, -2.0);
@@ -547,14 +610,17 @@ void UnderworldRenderer::RenderSprite(
 
    // render quad
    glBegin(GL_QUADS);
-   glTexCoord2d(0.0, v);   glVertex3d(base.x, base.y, base.z);
-   glTexCoord2d(u, v);   glVertex3d(base2.x, base2.y, base2.z);
-   glTexCoord2d(u, 0.0); glVertex3d(high2.x, high2.y, high2.z);
-   glTexCoord2d(0.0, 0.0); glVertex3d(high1.x, high1.y, high1.z);
+   glTexCoord2d(u1, v2); glVertex3d(base1.x, base1.y, base1.z);
+   glTexCoord2d(u2, v2); glVertex3d(base2.x, base2.y, base2.z);
+   glTexCoord2d(u2, v1); glVertex3d(high2.x, high2.y, high2.z);
+   glTexCoord2d(u1, v1); glVertex3d(high1.x, high1.y, high1.z);
    glEnd();
 
+   m_textureManager.GetRenderStatistics().AddDrawCall(2);
+
    if (renderOptions.m_renderBoundingBoxes && ignoreUpVector)
    {
+      PaletteShader::Deactivate();
       glDisable(GL_TEXTURE_2D);
 
       GLfloat lineWidth;
@@ -562,7 +628,7 @@ void UnderworldRenderer::RenderSprite(
       glLineWidth(5.0);
 
       glBegin(GL_LINE_LOOP);
-      glVertex3d(base.x, base.y, base.z);
+      glVertex3d(base1.x, base1.y, base1.z);
       glVertex3d(base2.x, base2.y, base2.z);
       glVertex3d(high2.x, high2.y, high2.z);
       glVertex3d(high1.x, high1.y, high1.z);
@@ -576,6 +642,324 @@ void UnderworldRenderer::RenderSprite(
    glDisable(GL_POLYGON_OFFSET_FILL);
 }
 
+/// Calculates the corners of a billboarded sprite quad, using the current
+/// billboard right and up vectors.
+/// \param base base coordinates of sprite; z coordinate is not scaled yet
+/// \param width relative width of object in relation to a tile
+/// \param height relative height of object in relation to a tile
+/// \param ignoreUpVector ignores billboard up-vector when true
+/// \param moveU u-coordinate offset to move base, e.g. to hotspot
+/// \param moveV v-coordinate offset to move base, e.g. to hotspot
+/// \param quad array to store the lower left, lower right, upper right and
+///        upper left corner
+void UnderworldRenderer::CalcSpriteQuad(Vector3d base, double width, double height,
+   bool ignoreUpVector, double moveU, double moveV, Vector3d quad[4]) const
+{
+   // scale z axis before any calculation is done
+   base.z *= c_renderHeightScale;
+
+   // move base to new location
+   base += m_billboardRightVector * moveU * width;
+   base += m_billboardUpVector * moveV * height;
+
+   // calculate vectors for quad
+   quad[0] = base - m_billboardRightVector * width;
+   quad[1] = base + m_billboardRightVector * width;
+
+   quad[3] = quad[0];
+   quad[2] = quad[1];
+
+   if (ignoreUpVector)
+   {
+      quad[3].z += height;
+      quad[2].z += height;
+   }
+   else
+   {
+      quad[3] += m_billboardUpVector * height;
+      quad[2] += m_billboardUpVector * height;
+   }
+}
+
+/// Calculates the corners of a decal quad on a tile wall.
+/// \param obj decal object
+/// \param x x tile coordinate of object
+/// \param y y tile coordinate of object
+/// \param wallOffset offset to move the decal away from the wall
+/// \param quad array to store the lower left, lower right, upper right and
+///        upper left corner
+void UnderworldRenderer::CalcDecalQuad(const Underworld::Object& obj, unsigned int x, unsigned int y,
+   double wallOffset, Vector3d quad[4])
+{
+   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
+
+   Vector3d base(static_cast<double>(x), static_cast<double>(y),
+      posInfo.m_zpos * c_renderHeightScale);
+
+   Vector2d to_right;
+
+   switch (posInfo.m_heading)
+   {
+   case 0: to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wallOffset; break;
+   case 2: to_right.Set(0.0, -1.0); base.y += posInfo.m_ypos / 8.0; base.x += 1.0 - wallOffset; break;
+   case 4: to_right.Set(-1.0, 0.0); base.x += posInfo.m_xpos / 8.0; base.y += wallOffset; break;
+   case 6: to_right.Set(0.0, 1.0);  base.y += posInfo.m_ypos / 8.0; base.x += wallOffset; break;
+
+   default:
+      // should not occur; use 0 as value
+      to_right.Set(1.0, 0.0);  base.x += posInfo.m_xpos / 8.0; base.y += 1.0 - wallOffset; break;
+      break;
+   }
+
+   const double decalheight = 1.0 / 8.0;
+
+   to_right.Normalize();
+   to_right *= decalheight;
+
+   quad[0].Set(base.x - to_right.x, base.y - to_right.y, base.z);
+   quad[1].Set(base.x + to_right.x, base.y + to_right.y, base.z);
+   quad[2].Set(base.x + to_right.x, base.y + to_right.y, base.z + 2 * decalheight);
+   quad[3].Set(base.x - to_right.x, base.y - to_right.y, base.z + 2 * decalheight);
+}
+
+/// Calculates the corners of a special tmap object quad.
+/// \param obj tmap object
+/// \param x x tile coordinate of object
+/// \param y y tile coordinate of object
+/// \param offset offset to move the quad to the front side
+/// \param quad array to store the lower right, upper right, upper left and
+///        lower left corner
+void UnderworldRenderer::CalcTmapObjectQuad(const Underworld::Object& obj, unsigned int x, unsigned int y,
+   double offset, Vector3d quad[4])
+{
+   const Underworld::ObjectPositionInfo& posInfo = obj.GetPosInfo();
+
+   Vector3d pos(static_cast<double>(x), static_cast<double>(y),
+      posInfo.m_zpos * c_renderHeightScale);
+
+   unsigned int x_fr = posInfo.m_xpos;
+   unsigned int y_fr = posInfo.m_ypos;
+
+   // hack: fixing some tmap decals
+   if (x_fr > 4) x_fr++;
+   if (y_fr > 4) y_fr++;
+
+   // determine direction
+   Vector3d dir;
+   switch (posInfo.m_heading)
+   {
+   case 0: dir.Set(1.0, 0.0, 0.0); break;
+   case 2: dir.Set(0.0, 1.0, 0.0); break;
+   case 4: dir.Set(-1.0, 0.0, 0.0); break;
+   case 6: dir.Set(0.0, -1.0, 0.0); break;
+
+   case 1: dir.Set(1.0, -1.0, 0.0); break;
+   case 3: dir.Set(-1.0, -1.0, 0.0); break;
+   case 5: dir.Set(-1.0, 1.0, 0.0); break;
+   case 7: dir.Set(1.0, 1.0, 0.0); break;
+   }
+
+   dir.Normalize();
+   dir *= 0.5;
+
+   // add fractional position
+   pos.x += x_fr / 8.0;
+   pos.y += y_fr / 8.0;
+
+   if (offset != 0.0)
+   {
+      Vector3d frontOffset(dir);
+      frontOffset.RotateZ(-90.0);
+      frontOffset *= offset;
+
+      pos += frontOffset;
+   }
+
+   quad[0].Set(pos.x + dir.x, pos.y + dir.y, pos.z);
+   quad[1].Set(pos.x + dir.x, pos.y + dir.y, pos.z + 1.0);
+   quad[2].Set(pos.x - dir.x, pos.y - dir.y, pos.z + 1.0);
+   quad[3].Set(pos.x - dir.x, pos.y - dir.y, pos.z);
+}
+
+/// Removes tiles from the tile triangle cache whose geometry changed since
+/// their triangles were cached, e.g. by traps or scripts changing tiles.
+/// The tile infos of all tiles are compared with the ones stored when the
+/// cache was last updated. Since walls depend on the adjacent tiles, the
+/// adjacent tiles of changed tiles are removed, too.
+/// \param level level to pick in
+void UnderworldRenderer::UpdateTilePickTriangles(const Underworld::Level& level)
+{
+   const unsigned int tilemapSize = Underworld::c_underworldTilemapSize;
+   const Underworld::Tilemap& tilemap = level.GetTilemap();
+
+   // PrepareLevel() was called, or wasn't called yet
+   if (m_tilePickTileInfos.empty())
+   {
+      m_tilePickTriangles.resize(tilemapSize * tilemapSize);
+      m_tilePickTrianglesCached.assign(m_tilePickTriangles.size(), false);
+
+      m_tilePickTileInfos.reserve(tilemapSize * tilemapSize);
+      for (unsigned int y = 0; y < tilemapSize; y++)
+         for (unsigned int x = 0; x < tilemapSize; x++)
+            m_tilePickTileInfos.push_back(tilemap.GetTileInfo(x, y));
+
+      return;
+   }
+
+   for (unsigned int y = 0; y < tilemapSize; y++)
+   {
+      for (unsigned int x = 0; x < tilemapSize; x++)
+      {
+         const Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(x, y);
+         Underworld::TileInfo& lastTileInfo = m_tilePickTileInfos[y * tilemapSize + x];
+
+         if (Detail::IsSameTileGeometry(tileInfo, lastTileInfo))
+            continue;
+
+         lastTileInfo = tileInfo;
+
+         m_tilePickTrianglesCached[y * tilemapSize + x] = false;
+
+         if (x > 0) m_tilePickTrianglesCached[y * tilemapSize + x - 1] = false;
+         if (x < tilemapSize - 1) m_tilePickTrianglesCached[y * tilemapSize + x + 1] = false;
+         if (y > 0) m_tilePickTrianglesCached[(y - 1) * tilemapSize + x] = false;
+         if (y < tilemapSize - 1) m_tilePickTrianglesCached[(y + 1) * tilemapSize + x] = false;
+      }
+   }
+}
+
+/// Collects the pickable triangles of a tile. The triangles are taken from
+/// the geometry provider once and then cached, until UpdateTilePickTriangles()
+/// finds that the tile or an adjacent tile changed.
+/// \param level level of the tile
+/// \param x x tile coordinate
+/// \param y y tile coordinate
+/// \param allTriangles triangle list to add triangles to
+void UnderworldRenderer::CollectTilePickTriangles(const Underworld::Level& level,
+   unsigned int x, unsigned int y, std::vector<PickTriangle>& allTriangles)
+{
+   size_t tileIndex = y * Underworld::c_underworldTilemapSize + x;
+
+   std::vector<PickTriangle>& tileTriangles = m_tilePickTriangles[tileIndex];
+
+   if (!m_tilePickTrianglesCached[tileIndex])
+   {
+      tileTriangles.clear();
+
+      std::vector<Triangle3dTextured> allTileTriangles;
+      GeometryProvider geometryProvider(level);
+      geometryProvider.GetTileTriangles(x, y, allTileTriangles);
+
+      tileTriangles.reserve(allTileTriangles.size());
+      for (const Triangle3dTextured& triangle : allTileTriangles)
+      {
+         PickTriangle pickTriangle;
+         for (unsigned int point = 0; point < 3; point++)
+         {
+            pickTriangle.m_points[point] = triangle.m_vertices[point].pos;
+            pickTriangle.m_points[point].z *= c_renderHeightScale;
+         }
+
+         pickTriangle.m_isObject = false;
+         pickTriangle.m_id = triangle.m_textureNumber;
+
+         tileTriangles.push_back(pickTriangle);
+      }
+
+      m_tilePickTrianglesCached[tileIndex] = true;
+   }
+
+   allTriangles.insert(allTriangles.end(), tileTriangles.begin(), tileTriangles.end());
+}
+
+/// Collects the pickable triangles of all objects in a tile. The same
+/// geometry as for rendering is used: sprite and decal quads, and the
+/// bounding triangles of 3d models.
+/// \param renderOptions render options to use
+/// \param level level of the tile
+/// \param x x tile coordinate
+/// \param y y tile coordinate
+/// \param allTriangles triangle list to add triangles to
+void UnderworldRenderer::CollectObjectPickTriangles(const RenderOptions& renderOptions,
+   const Underworld::Level& level, unsigned int x, unsigned int y,
+   std::vector<PickTriangle>& allTriangles)
+{
+   const Underworld::ObjectList& objectList = level.GetObjectList();
+
+   Uint16 link = objectList.GetListStart(x, y);
+   while (link != 0)
+   {
+      const Underworld::Object& obj = *objectList.GetObject(link);
+      const Underworld::ObjectInfo& info = obj.GetObjectInfo();
+
+      // next object in link chain
+      Uint16 objectPos = link;
+      link = info.m_link;
+
+      // skip the same objects as when rendering
+      if (!renderOptions.m_renderHiddenObjects && info.m_isHidden)
+         continue;
+
+      Uint16 itemId = info.m_itemID;
+      if ((itemId >= 0x00da && itemId <= 0x00df) || itemId == 0x012e)
+         continue;
+
+      Vector3d base = CalcObjectPosition(x, y, obj);
+      Vector3d quad[4];
+
+      if (m_modelManager.IsModelAvailable(itemId))
+      {
+         base.z = obj.GetPosInfo().m_zpos * c_renderHeightScale;
+
+         std::vector<Triangle3dTextured> modelTriangles;
+         m_modelManager.GetBoundingTriangles(obj, base, modelTriangles);
+
+         for (const Triangle3dTextured& triangle : modelTriangles)
+         {
+            allTriangles.push_back(PickTriangle(triangle.m_vertices[0].pos,
+               triangle.m_vertices[1].pos, triangle.m_vertices[2].pos,
+               true, objectPos));
+         }
+
+         if (!modelTriangles.empty())
+            continue;
+
+         // model has no bounding triangles; pick using a sprite quad
+         base.z = obj.GetPosInfo().m_zpos;
+         CalcSpriteQuad(base, 0.125, 0.25, false, 0.0, 0.0, quad);
+      }
+      else if (itemId >= 0x0040 && itemId < 0x0080)
+      {
+         double u = 0.0, v = 0.0;
+         if (GetCritterFrame(obj, u, v) == nullptr)
+            continue;
+
+         CalcSpriteQuad(base, 0.4, 0.88, true, u, v, quad);
+      }
+      else if ((itemId >= 0x0170 && itemId <= 0x017f) ||
+         itemId == 0x0161 || itemId == 0x0162 || itemId == 0x0166)
+      {
+         CalcDecalQuad(obj, x, y, Detail::c_pickDecalWallOffset, quad);
+      }
+      else if (itemId == 0x016e || itemId == 0x016f)
+      {
+         CalcTmapObjectQuad(obj, x, y, Detail::c_pickTmapObjectOffset, quad);
+      }
+      else
+      {
+         double quadWidth = 0.25;
+
+         if (itemId == 0x00d3 || itemId == 0x00d4) // a_stalactite / a_plant
+            base.z = level.GetTilemap().GetTileInfo(x, y).m_ceiling - quadWidth;
+
+         CalcSpriteQuad(base, 0.5 * quadWidth, quadWidth, false, 0.0, 0.0, quad);
+      }
+
+      allTriangles.push_back(PickTriangle(quad[0], quad[1], quad[2], true, objectPos));
+      allTriangles.push_back(PickTriangle(quad[0], quad[2], quad[3], true, objectPos));
+   }
+}
+
 /// calculates object position in 3D world
 Vector3d UnderworldRenderer::CalcObjectPosition(unsigned int x, unsigned int y,
    const Underworld::Object& obj)
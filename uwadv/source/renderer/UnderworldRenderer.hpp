@@ -21,9 +21,15 @@
 //
 #pragma once
 
+#include "TextureCache.hpp"
+#include "TextureResidencyManager.hpp"
+#include "PaletteShader.hpp"
 #include "TextureManager.hpp"
 #include "Critter.hpp"
 #include "Model3D.hpp"
+#include "WorldSnapshot.hpp"
+#include "PickingRayCaster.hpp"
+#include "Tilemap.hpp"
 
 namespace Underworld
 {
@@ -52,16 +58,28 @@ public:
    /// called for every game tick
    void Tick(double tickRate);
 
-   /// sets selection mode on or off
-   void SetSelectionMode(bool enabled) { m_selectionMode = enabled; }
-
    /// renders underworld level at given player pos and angles
    void Render(const RenderOptions& renderOptions, const Underworld::Level& level, Vector3d pos,
-      double panAngle, double rotateAngle, double fieldOfView);
+      double panAngle, double rotateAngle, double fieldOfView,
+      const WorldSnapshot* snapshot = nullptr);
+
+   /// picks nearest tile or object along a ray from the viewer position
+   bool Pick(const RenderOptions& renderOptions, const Underworld::Level& level, Vector3d pos,
+      double panAngle, double rotateAngle, const Vector3d& direction, double maxDistance,
+      PickResult& result);
 
    /// returns 3d models manager
    Model3DManager& GetModel3DManager() { return m_modelManager; }
 
+   /// returns texture residency manager
+   const TextureResidencyManager& GetTextureResidencyManager() const { return m_textureResidencyManager; }
+
+   /// returns statistics about the last rendered frame
+   const RenderStatistics& GetRenderStatistics() const { return m_textureManager.GetRenderStatistics(); }
+
+   /// returns statistics about the last rendered frame
+   RenderStatistics& GetRenderStatistics() { return m_textureManager.GetRenderStatistics(); }
+
    /// calculates object position in 3d world
    static Vector3d CalcObjectPosition(unsigned int x, unsigned int y,
       const Underworld::Object& object);
@@ -75,13 +93,18 @@ private:
    /// renders a single object
    void RenderObject(const RenderOptions& renderOptions,
       const Vector3d& viewerPos,  const Underworld::Level& level,
-      const Underworld::Object& object,
+      const Underworld::Object& object, Uint16 objectPos,
       unsigned int x, unsigned int y);
 
+   /// returns critter frame location of an NPC object and the hotspot offset;
+   /// returns null when no frames are available
+   const CritterFrameLocation* GetCritterFrame(const Underworld::Object& object,
+      double& moveU, double& moveV);
+
    /// renders a billboarded sprite
    void RenderSprite(const RenderOptions& renderOptions,
       Vector3d base, double width, double height,
-      bool ignoreUpVector, double u, double v,
+      bool ignoreUpVector, double u1, double v1, double u2, double v2,
       double moveU = 0.0, double moveV = 0.0);
 
    /// renders decal
@@ -96,7 +119,40 @@ private:
       double quadwidth, double quadheight,
       double u1, double v1, double u2, double v2);
 
+   /// calculates the corners of a billboarded sprite quad
+   void CalcSpriteQuad(Vector3d base, double width, double height,
+      bool ignoreUpVector, double moveU, double moveV, Vector3d quad[4]) const;
+
+   /// calculates the corners of a decal quad
+   static void CalcDecalQuad(const Underworld::Object& object, unsigned int x, unsigned int y,
+      double wallOffset, Vector3d quad[4]);
+
+   /// calculates the corners of a tmap object quad
+   static void CalcTmapObjectQuad(const Underworld::Object& object, unsigned int x, unsigned int y,
+      double offset, Vector3d quad[4]);
+
+   /// removes changed tiles from the tile triangle cache
+   void UpdateTilePickTriangles(const Underworld::Level& level);
+
+   /// collects pickable triangles of a tile, using the tile triangle cache
+   void CollectTilePickTriangles(const Underworld::Level& level,
+      unsigned int x, unsigned int y, std::vector<PickTriangle>& allTriangles);
+
+   /// collects pickable triangles of all objects in a tile
+   void CollectObjectPickTriangles(const RenderOptions& renderOptions,
+      const Underworld::Level& level, unsigned int x, unsigned int y,
+      std::vector<PickTriangle>& allTriangles);
+
 private:
+   /// cache for scaled textures
+   TextureCache m_textureCache;
+
+   /// residency manager for uploaded textures and critter frames
+   TextureResidencyManager m_textureResidencyManager;
+
+   /// shader for palette-indexed stock textures; only used when enabled
+   PaletteShader m_paletteShader;
+
    /// texture manager
    TextureManager m_textureManager;
 
@@ -109,9 +165,19 @@ private:
    /// scale factor for textures
    unsigned int m_scaleFactor;
 
-   /// indicates if in selection (picking) mode
-   bool m_selectionMode;
+   /// snapshot with interpolated object positions used for the current
+   /// frame; may be null
+   const WorldSnapshot* m_snapshot;
 
    /// billboard right and up vectors
    Vector3d m_billboardRightVector, m_billboardUpVector;
+
+   /// cached pickable tile triangles of the current level, by tile index
+   std::vector<std::vector<PickTriangle>> m_tilePickTriangles;
+
+   /// indicates which tiles are already in the tile triangle cache
+   std::vector<bool> m_tilePickTrianglesCached;
+
+   /// tile infos of all tiles, when the tile triangle cache was last updated
+   std::vector<Underworld::TileInfo> m_tilePickTileInfos;
 };
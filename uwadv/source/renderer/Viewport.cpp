@@ -73,11 +73,7 @@ void Viewport::SetupCamera2D()
 /// Sets up camera for 3D scene rendering.
 /// \param fieldOfView field of view angle
 /// \param farDistance distance from camera to far plane
-/// \param setPickMatrix indicates if pick matrix should also be set
-/// \param pickPosX X position for picking
-/// \param pickPosY Y position for picking
-void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
-   bool setPickMatrix, int pickPosX, int pickPosY)
+void Viewport::SetupCamera3D(double fieldOfView, double farDistance)
 {
    glViewport(m_viewport[0], m_viewport[1], m_viewport[2], m_viewport[3]);
 
@@ -85,14 +81,6 @@ void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
    glMatrixMode(GL_PROJECTION);
    glLoadIdentity();
 
-   if (setPickMatrix)
-   {
-      int windowWidth = 0, windowHeight = 0;
-      m_window.GetWindowSize(windowWidth, windowHeight);
-
-      gluPickMatrix(pickPosX, windowHeight - pickPosY, 5.0, 5.0, m_viewport);
-   }
-
    double aspectRatio = double(m_viewport[2]) / m_viewport[3];
    gluPerspective(fieldOfView, aspectRatio, c_nearDistance, farDistance);
 
@@ -100,3 +88,31 @@ void Viewport::SetupCamera3D(double fieldOfView, double farDistance,
    glMatrixMode(GL_MODELVIEW);
    glLoadIdentity();
 }
+
+/// Maps a window position, e.g. the mouse position, to a position on the 3D
+/// viewport, in normalized device coordinates.
+/// \param xpos x position in real window coordinates
+/// \param ypos y position in real window coordinates; 0 is the top
+/// \param viewportX x position on viewport, from -1.0 (left) to 1.0 (right)
+/// \param viewportY y position on viewport, from -1.0 (bottom) to 1.0 (top)
+/// \return false when the position is outside of the 3D viewport
+bool Viewport::MapWindowToViewport3D(int xpos, int ypos,
+   double& viewportX, double& viewportY) const
+{
+   if (m_viewport[2] <= 0 || m_viewport[3] <= 0)
+      return false;
+
+   int windowWidth = 0, windowHeight = 0;
+   m_window.GetWindowSize(windowWidth, windowHeight);
+
+   // use pixel centers, and flip y, since OpenGL window coordinates start at
+   // the bottom
+   double windowX = xpos + 0.5;
+   double windowY = windowHeight - ypos - 0.5;
+
+   viewportX = 2.0 * (windowX - m_viewport[0]) / m_viewport[2] - 1.0;
+   viewportY = 2.0 * (windowY - m_viewport[1]) / m_viewport[3] - 1.0;
+
+   return viewportX >= -1.0 && viewportX <= 1.0 &&
+      viewportY >= -1.0 && viewportY <= 1.0;
+}
@@ -32,6 +32,9 @@ class RenderWindow;
 class Viewport
 {
 public:
+   /// near plane distance
+   static const double c_nearDistance;
+
    /// ctor
    Viewport(RenderWindow& window)
       :m_window(window)
@@ -42,12 +45,23 @@ public:
    void SetViewport3D(unsigned int xpos, unsigned int ypos,
       unsigned int width, unsigned int height);
 
+   /// returns 3d viewport, in OpenGL window coordinates
+   void GetViewport3D(int& xpos, int& ypos, int& width, int& height) const
+   {
+      xpos = m_viewport[0];
+      ypos = m_viewport[1];
+      width = m_viewport[2];
+      height = m_viewport[3];
+   }
+
    /// sets up OpenGL for 2D user interface rendering using an ortho cam
    void SetupCamera2D();
 
    /// sets up camera for 3d scene rendering
-   void SetupCamera3D(double fieldOfView = 90.0, double farDistance = 16.0,
-      bool setPickMatrix = false, int pickPosX = 0, int pickPosY = 0);
+   void SetupCamera3D(double fieldOfView = 90.0, double farDistance = 16.0);
+
+   /// maps window position to position on the 3d viewport, from -1.0 to 1.0
+   bool MapWindowToViewport3D(int xpos, int ypos, double& viewportX, double& viewportY) const;
 
 private:
    /// render window
@@ -55,7 +69,4 @@ private:
 
    /// 3D viewport to use
    GLint m_viewport[4];
-
-   /// near plane distance
-   static const double c_nearDistance;
 };
@@ -0,0 +1,137 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorldSnapshot.cpp
+/// \brief snapshot of player pose and object positions
+//
+#include "pch.hpp"
+#include "WorldSnapshot.hpp"
+#include "UnderworldRenderer.hpp"
+#include "Underworld.hpp"
+#include <algorithm>
+
+namespace Detail
+{
+   /// max. distance the player or an object can move in a tick; when moving
+   /// farther, e.g. by teleporting, the position isn't interpolated
+   const double c_maxInterpolationDistance = 2.0;
+
+   /// interpolates position; returns current position when moving too far
+   Vector3d InterpolatePosition(const Vector3d& previous, const Vector3d& current, double factor)
+   {
+      Vector3d delta = current - previous;
+      if (delta.Length() > c_maxInterpolationDistance)
+         return current;
+
+      return previous + delta * factor;
+   }
+
+   /// interpolates angle in degrees, taking the shorter way around the circle
+   double InterpolateAngle(double previous, double current, double factor)
+   {
+      double delta = fmod(current - previous, 360.0);
+      if (delta > 180.0)
+         delta -= 360.0;
+      else if (delta < -180.0)
+         delta += 360.0;
+
+      return previous + delta * factor;
+   }
+} // namespace Detail
+
+void WorldSnapshot::Capture(const Underworld::Underworld& underworld)
+{
+   const Underworld::Player& player = underworld.GetPlayer();
+
+   m_level = player.GetAttribute(Underworld::attrMapLevel);
+   m_playerPos.Set(player.GetXPos(), player.GetYPos(), player.GetHeight());
+   m_panAngle = player.GetPanAngle();
+   m_rotateAngle = player.GetRotateAngle();
+
+   const Underworld::ObjectList& objectList = underworld.GetCurrentLevel().GetObjectList();
+
+   // keeps the storage of the last capture
+   m_objectPositions.clear();
+
+   // visits objects in object list order, so the list stays sorted
+   Uint16 maxObjectPos = objectList.GetObjectListSize();
+   for (Uint16 objectPos = 1; objectPos < maxObjectPos; objectPos++)
+   {
+      const Underworld::ObjectPtr obj = objectList.GetObject(objectPos);
+      if (obj == nullptr || !obj->IsNpcObject())
+         continue;
+
+      const Underworld::ObjectPositionInfo& posInfo = obj->GetPosInfo();
+      if (posInfo.m_tileX == Underworld::c_tileNotAPos || posInfo.m_tileY == Underworld::c_tileNotAPos)
+         continue;
+
+      ObjectPosition position;
+      position.m_objectPos = objectPos;
+      position.m_pos = UnderworldRenderer::CalcObjectPosition(posInfo.m_tileX, posInfo.m_tileY, *obj);
+
+      m_objectPositions.push_back(position);
+   }
+}
+
+/// When the snapshots were taken in different levels, the current snapshot
+/// is used. Objects that don't appear in both snapshots aren't interpolated.
+/// \param previous snapshot of the previous tick
+/// \param current snapshot of the current tick
+/// \param factor interpolation factor, in the range [0.0; 1.0]
+void WorldSnapshot::Interpolate(const WorldSnapshot& previous,
+   const WorldSnapshot& current, double factor)
+{
+   if (previous.m_level != current.m_level)
+   {
+      *this = current;
+      return;
+   }
+
+   m_level = current.m_level;
+   m_playerPos = Detail::InterpolatePosition(previous.m_playerPos, current.m_playerPos, factor);
+   m_panAngle = previous.m_panAngle + (current.m_panAngle - previous.m_panAngle) * factor;
+   m_rotateAngle = Detail::InterpolateAngle(previous.m_rotateAngle, current.m_rotateAngle, factor);
+
+   m_objectPositions = current.m_objectPositions;
+
+   // both lists are sorted by object list position
+   ObjectPositionList::const_iterator previousIter = previous.m_objectPositions.begin();
+   ObjectPositionList::const_iterator previousEnd = previous.m_objectPositions.end();
+
+   for (ObjectPosition& position : m_objectPositions)
+   {
+      while (previousIter != previousEnd && previousIter->m_objectPos < position.m_objectPos)
+         ++previousIter;
+
+      if (previousIter != previousEnd && previousIter->m_objectPos == position.m_objectPos)
+         position.m_pos = Detail::InterpolatePosition(previousIter->m_pos, position.m_pos, factor);
+   }
+}
+
+/// \param objectPos object list position of object
+/// \return interpolated position of object, or null when the snapshot has no
+/// position for the object
+const Vector3d* WorldSnapshot::GetObjectPosition(Uint16 objectPos) const
+{
+   ObjectPositionList::const_iterator iter = std::lower_bound(
+      m_objectPositions.begin(), m_objectPositions.end(), objectPos,
+      [](const ObjectPosition& position, Uint16 pos) { return position.m_objectPos < pos; });
+
+   return iter != m_objectPositions.end() && iter->m_objectPos == objectPos
+      ? &iter->m_pos : nullptr;
+}
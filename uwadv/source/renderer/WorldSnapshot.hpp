@@ -0,0 +1,89 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorldSnapshot.hpp
+/// \brief snapshot of player pose and object positions
+//
+#pragma once
+
+#include "Math.hpp"
+#include <vector>
+
+namespace Underworld
+{
+   class Underworld;
+}
+
+/// \brief Snapshot of the player pose and object positions
+/// A snapshot is taken after every simulation tick, when the player movement
+/// runs on its own thread. The renderer then renders an interpolated snapshot
+/// between the last two ticks, so that movement stays smooth when rendering
+/// at a higher rate than the tick rate. Only positions of NPC objects are
+/// stored, since other objects don't move on their own; the level itself
+/// isn't part of the snapshot. The storage of a snapshot is reused when
+/// capturing or interpolating again.
+struct WorldSnapshot
+{
+   /// position of a moving object in 3d world
+   struct ObjectPosition
+   {
+      /// object list position
+      Uint16 m_objectPos;
+
+      /// object position
+      Vector3d m_pos;
+   };
+
+   /// list with object positions, sorted by object list position
+   typedef std::vector<ObjectPosition> ObjectPositionList;
+
+   /// ctor
+   WorldSnapshot()
+      :m_level(0),
+      m_panAngle(0.0),
+      m_rotateAngle(0.0)
+   {
+   }
+
+   /// captures player pose and NPC object positions of the current level
+   void Capture(const Underworld::Underworld& underworld);
+
+   /// interpolates between two snapshots and stores the result in this
+   /// snapshot; factor 0.0 results in the previous, 1.0 in the current one
+   void Interpolate(const WorldSnapshot& previous,
+      const WorldSnapshot& current, double factor);
+
+   /// returns interpolated position of object, or null when the snapshot has
+   /// no position for the object
+   const Vector3d* GetObjectPosition(Uint16 objectPos) const;
+
+   /// level the snapshot was taken in
+   size_t m_level;
+
+   /// player position; z coordinate is the player height
+   Vector3d m_playerPos;
+
+   /// player pan angle
+   double m_panAngle;
+
+   /// player rotate angle
+   double m_rotateAngle;
+
+   /// positions of NPC objects
+   ObjectPositionList m_objectPositions;
+};
@@ -80,10 +80,10 @@ void IngameCompass::Init(IGame& game, unsigned int xpos,
    m_currentCompassImageIndex = 16;
 }
 
-void IngameCompass::Draw()
+/// Updates the compass image in Tick(), since the simulation thread may
+/// change the player pose while drawing.
+void IngameCompass::Tick()
 {
-   // check if we have to reupload the image
-
    // calculate current angle and images
    Underworld::Player& player = m_parent->GetGameInterface().GetUnderworld().
       GetPlayer();
@@ -102,8 +102,6 @@ void IngameCompass::Draw()
 
       Update();
    }
-
-   ImageQuad::Draw();
 }
 
 void IngameCompass::MouseEvent(bool buttonClicked, bool leftButton,
@@ -50,13 +50,13 @@ public:
    virtual void Init(IGame& game, unsigned int xpos,
       unsigned int ypos) override;
 
-   /// draws compass
-   virtual void Draw() override;
-
    // virtual methods from Window
    virtual void MouseEvent(bool buttonClicked, bool leftButton,
       bool buttonDown, unsigned int mouseX, unsigned int mouseY) override;
 
+   /// updates compass image from player angle
+   virtual void Tick() override;
+
 protected:
    /// current compass image
    unsigned int m_currentCompassImageIndex;
@@ -26,9 +26,11 @@
 #include "Player.hpp"
 #include "Audio.hpp"
 #include "AutomapGenerator.hpp"
+#include "AutomapImageCache.hpp"
 
-MapViewScreen::MapViewScreen(IGame& gameInterface)
+MapViewScreen::MapViewScreen(IGame& gameInterface, UI::AutomapImageCache& automapCache)
    :ImageScreen(gameInterface, 0, 0.5),
+   m_automapCache(automapCache),
    m_displayedLevel((size_t)-1)
 {
 }
@@ -45,6 +47,13 @@ void MapViewScreen::Init()
       m_game.GetAudioManager().StartMusicTrack(Audio::musicUw1_MapsAndLegends, false);
 }
 
+void MapViewScreen::Destroy()
+{
+   m_automapCache.ReturnLevelImage(GetImage());
+
+   ImageScreen::Destroy();
+}
+
 bool MapViewScreen::ProcessEvent(SDL_Event& event)
 {
    switch (event.type)
@@ -82,24 +91,21 @@ void MapViewScreen::DisplayLevelMap(size_t levelIndex)
    IndexedImage& image = GetImage();
 
    ImageManager& imageManager = m_game.GetImageManager();
-   imageManager.Load(image, "data/blnkmap.byt", 0, 1, imageByt);
 
    const Underworld::Level& level = m_game.GetUnderworld().GetLevelList().GetLevel(levelIndex);
    const Underworld::Tilemap& tilemap = level.GetTilemap();
 
    UI::AutomapGenerator generator{ m_game.GetResourceManager(), imageManager, tilemap };
 
-   generator.DrawLevelNumber(image, levelIndex, level.GetLevelName());
-   generator.DrawTiles(image);
-   generator.DrawMapNotes(image, level.GetMapNotes());
-
    const Underworld::Player& player = m_game.GetUnderworld().GetPlayer();
 
    size_t playerLevel = player.GetAttribute(Underworld::attrMapLevel);
    bool showPlayerPin = playerLevel == levelIndex;
 
-   if (showPlayerPin)
-      generator.DrawPlayerPin(image, player);
+   // only tiles changed since the map was last displayed are redrawn; the
+   // image is given back to the cache in Destroy()
+   m_automapCache.ShowLevelImage(image, generator, imageManager, levelIndex,
+      level.GetLevelName(), level.GetMapNotes(), showPlayerPin ? &player : nullptr);
 
    UpdateImage();
 }
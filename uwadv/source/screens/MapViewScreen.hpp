@@ -23,23 +23,32 @@
 
 #include "ImageScreen.hpp"
 
+namespace UI
+{
+   class AutomapImageCache;
+}
+
 /// level map view screen class
 class MapViewScreen : public ImageScreen
 {
 public:
    /// ctor
-   MapViewScreen(IGame& gameInterface);
+   MapViewScreen(IGame& gameInterface, UI::AutomapImageCache& automapCache);
    /// dtor
    virtual ~MapViewScreen() {}
 
    // virtual functions from Screen
    virtual void Init() override;
+   virtual void Destroy() override;
    virtual bool ProcessEvent(SDL_Event& event) override;
 
 private:
    /// displays level map with given index
    void DisplayLevelMap(size_t levelIndex);
 
+   /// automap image cache
+   UI::AutomapImageCache& m_automapCache;
+
    /// currently displayed level
    size_t m_displayedLevel;
 };
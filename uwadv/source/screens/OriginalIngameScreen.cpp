@@ -35,6 +35,7 @@
 #include "Model3D.hpp"
 #include "physics/PhysicsModel.hpp"
 #include "ImageManager.hpp"
+#include "PerformanceCounters.hpp"
 
 /// time to fade in/out
 const double OriginalIngameScreen::s_fadeTime = 0.5;
@@ -48,7 +49,8 @@ const unsigned int c_ingameScreenshotYRes = 100;
 OriginalIngameScreen::OriginalIngameScreen(IGame& game)
    :Screen(game), m_vitalityFlask(true), m_manaFlask(false),
    m_leftDragon(true), m_rightDragon(false),
-   m_playerPhysics(m_game.GetUnderworld().GetPlayer(), m_game.GetSettings().GetBool(Base::settingUwadvFeatures))
+   m_playerPhysics(m_game.GetUnderworld().GetPlayer(), m_game.GetSettings().GetBool(Base::settingUwadvFeatures)),
+   m_currentSnapshot(0)
 {
    m_compass.SetParent(this);
    m_runeShelf.SetParent(this);
@@ -100,6 +102,24 @@ void OriginalIngameScreen::Init()
 
    // init images/subwindows
 
+   // all controls except the 3d view and move arrows, which are invisible,
+   // are drawn from a single atlas texture
+   m_controlsAtlas.Init(m_game);
+
+   m_backgroundImage.SetAtlas(&m_controlsAtlas);
+   m_compass.SetAtlas(&m_controlsAtlas);
+   m_textScroll.SetAtlas(&m_controlsAtlas);
+   m_runeShelf.SetAtlas(&m_controlsAtlas);
+   m_spellArea.SetAtlas(&m_controlsAtlas);
+   m_vitalityFlask.SetAtlas(&m_controlsAtlas);
+   m_manaFlask.SetAtlas(&m_controlsAtlas);
+   m_gargoyleEyes.SetAtlas(&m_controlsAtlas);
+   m_leftDragon.SetAtlas(&m_controlsAtlas);
+   m_rightDragon.SetAtlas(&m_controlsAtlas);
+   m_commandButtons.SetAtlas(&m_controlsAtlas);
+   m_panel.SetAtlas(&m_controlsAtlas);
+   m_powerGem.SetAtlas(&m_controlsAtlas);
+
    // load background
    {
       if (settings.GetGameType() == Base::gameUw2)
@@ -213,6 +233,13 @@ void OriginalIngameScreen::Init()
    m_moveArrows.Init(m_game, 107, 154);
    RegisterWindow(&m_moveArrows);
 
+   // draws all controls registered before
+   RegisterWindow(&m_controlsAtlas);
+
+   // init performance HUD
+   m_performanceHud.Init(m_game, 2, 2);
+   RegisterWindow(&m_performanceHud);
+
    // init mouse cursor
    m_mouseCursor.Init(m_game, 0);
    m_mouseCursor.Show(true);
@@ -226,6 +253,8 @@ void OriginalIngameScreen::Suspend()
 {
    UaTrace("suspending orig. ingame user interface\n\n");
 
+   m_simulationThread.Stop();
+
    m_game.GetRenderWindow().Clear();
    m_game.GetRenderWindow().SwapBuffers();
 
@@ -242,6 +271,15 @@ void OriginalIngameScreen::Resume()
 
    m_game.GetPhysicsModel().AddTrackBody(&m_playerPhysics);
 
+   if (m_game.GetSettings().GetBool(Base::settingSimulationThread))
+   {
+      // start interpolating from the current pose
+      m_snapshots[0].Capture(m_game.GetUnderworld());
+      m_snapshots[1] = m_snapshots[0];
+
+      m_simulationThread.Start(m_game.GetTickRate(), [this]() { SimulationTick(); });
+   }
+
    // setup fade-in
    m_fadeState = 0;
    m_fading.Init(true, m_game.GetTickRate(), s_fadeTime);
@@ -270,8 +308,22 @@ void OriginalIngameScreen::Destroy()
    UaTrace("orig. ingame user interface finished\n\n");
 }
 
+/// When the simulation thread runs, the lock is only held while
+/// interpolating the snapshot. The simulation thread only moves the player;
+/// the level and the user interface are only changed on the main thread, so
+/// they are drawn while the simulation thread continues.
 void OriginalIngameScreen::Draw()
 {
+   if (m_simulationThread.IsRunning())
+   {
+      SimulationLock lock{ m_simulationThread };
+
+      // render between the last two ticks; lags behind by one tick
+      m_renderSnapshot.Interpolate(
+         m_snapshots[m_currentSnapshot ^ 1], m_snapshots[m_currentSnapshot],
+         m_simulationThread.GetTickFraction());
+   }
+
    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
    // 3d world
@@ -281,7 +333,10 @@ void OriginalIngameScreen::Draw()
       m_game.GetRenderer().SetupFor3D(m_viewOffset);
 
       // render a const world
-      m_game.GetRenderer().RenderUnderworld(m_game.GetUnderworld());
+      if (m_simulationThread.IsRunning())
+         m_game.GetRenderer().RenderUnderworld(m_game.GetUnderworld().GetCurrentLevel(), m_renderSnapshot);
+      else
+         m_game.GetRenderer().RenderUnderworld(m_game.GetUnderworld());
    }
 
    // render 2d user interface
@@ -322,6 +377,8 @@ void OriginalIngameScreen::Draw()
 
 bool OriginalIngameScreen::ProcessEvent(SDL_Event& event)
 {
+   SimulationLock lock{ m_simulationThread };
+
    return Screen::ProcessEvent(event);
 }
 
@@ -701,6 +758,12 @@ void OriginalIngameScreen::KeyEvent(bool keyDown, Base::KeyType key)
          m_game.GetDebugger().StartDebugger(&m_game);
       break;
 
+      // performance HUD key
+   case Base::keyUaPerformanceHud:
+      if (keyDown)
+         m_performanceHud.Toggle();
+      break;
+
       // exit screen key
    case Base::keyUaReturnMenu:
       if (keyDown)
@@ -709,11 +772,16 @@ void OriginalIngameScreen::KeyEvent(bool keyDown, Base::KeyType key)
 
       // "screenshot" key
    case Base::keyUaScreenshot:
+      if (keyDown)
+         m_game.GetRenderer().GetFrameCapture().SaveScreenshot();
+      break;
+
+      // "capture frames" key
+   case Base::keyUaCaptureFrames:
       if (keyDown)
       {
-         // TODO take a screenshot
-//         do_screenshot(false);
-//         save_screenshot();
+         FrameCapture& frameCapture = m_game.GetRenderer().GetFrameCapture();
+         frameCapture.SetStreaming(!frameCapture.IsStreaming());
       }
       break;
 
@@ -730,19 +798,19 @@ void OriginalIngameScreen::KeyEvent(bool keyDown, Base::KeyType key)
 
 void OriginalIngameScreen::Tick()
 {
+   SimulationLock lock{ m_simulationThread };
+
    Screen::Tick();
 
    // evaluate underworld;
    // only evaluate when the user is not in the options menu
    if (m_fadeoutAction == ingameActionNone && m_ingameMode != ingameModeOptions)
    {
-      m_game.GetGameLogic().EvaluateUnderworld(double(m_tickCount) / m_game.GetTickRate());
-
-      double elapsedTime = 1.0 / m_game.GetTickRate();
-      m_playerPhysics.RotateMove(elapsedTime);
-      m_game.GetPhysicsModel().EvaluatePhysics(elapsedTime);
-
-      m_tickCount++;
+      // when the simulation thread runs, it evaluates the physics instead
+      if (m_simulationThread.IsRunning())
+         EvaluateGameLogic();
+      else
+         EvaluateUnderworld();
 
       // do renderer-specific tick processing
       m_game.GetRenderer().Tick(m_game.GetTickRate());
@@ -767,6 +835,43 @@ void OriginalIngameScreen::Tick()
    //   Resume();
 }
 
+void OriginalIngameScreen::EvaluateUnderworld()
+{
+   EvaluateGameLogic();
+   EvaluatePhysics();
+}
+
+/// The game logic may change the level, e.g. when a move trigger runs a
+/// script, so it always runs on the main thread.
+void OriginalIngameScreen::EvaluateGameLogic()
+{
+   Base::PerformanceTimer logicTimer{ m_game.GetPerformanceCounters(), Base::phaseEvaluateUnderworld };
+   m_game.GetGameLogic().EvaluateUnderworld(double(m_tickCount) / m_game.GetTickRate());
+
+   m_tickCount++;
+}
+
+/// Moves the player; only changes the player pose.
+void OriginalIngameScreen::EvaluatePhysics()
+{
+   double elapsedTime = 1.0 / m_game.GetTickRate();
+   m_playerPhysics.RotateMove(elapsedTime);
+
+   Base::PerformanceTimer physicsTimer{ m_game.GetPerformanceCounters(), Base::phaseEvaluatePhysics };
+   m_game.GetPhysicsModel().EvaluatePhysics(elapsedTime);
+}
+
+/// Evaluates the physics, using the same condition as Tick(), and takes a
+/// snapshot for rendering afterwards. Called with the simulation lock held.
+void OriginalIngameScreen::SimulationTick()
+{
+   if (m_fadeoutAction == ingameActionNone && m_ingameMode != ingameModeOptions)
+      EvaluatePhysics();
+
+   m_currentSnapshot ^= 1;
+   m_snapshots[m_currentSnapshot].Capture(m_game.GetUnderworld());
+}
+
 void OriginalIngameScreen::ScheduleAction(IngameAction action, bool fadeoutBefore)
 {
    m_fadeoutAction = action;
@@ -818,6 +923,8 @@ void OriginalIngameScreen::DoAction(IngameAction action)
 
       // start "save game" screen
    case ingameActionSaveGame:
+      // wait for savegame preview image
+      m_game.GetRenderer().GetFrameCapture().Flush();
       m_game.ReplaceScreen(new SaveGameScreen(m_game, false, false), true);
       break;
 
@@ -827,6 +934,7 @@ void OriginalIngameScreen::DoAction(IngameAction action)
       {
          Base::Savegame sg = m_game.GetSavegamesManager().LoadQuicksaveSavegame();
          m_game.GetUnderworld().Load(sg);
+         m_automapCache.Clear();
          PrintScroll("quickloading done.");
       }
       break;
@@ -834,6 +942,9 @@ void OriginalIngameScreen::DoAction(IngameAction action)
       // quicksaving
    case ingameActionQuicksave:
    {
+      // wait for savegame preview image
+      m_game.GetRenderer().GetFrameCapture().Flush();
+
       // set player infos
       Base::SavegameInfo info;
       Underworld::Player& pl = m_game.GetUnderworld().GetPlayer();
@@ -858,7 +969,7 @@ void OriginalIngameScreen::DoAction(IngameAction action)
       break;
 
    case ingameActionShowMap:
-      m_game.ReplaceScreen(new MapViewScreen(m_game), true);
+      m_game.ReplaceScreen(new MapViewScreen(m_game, m_automapCache), true);
       break;
 
    default:
@@ -980,47 +1091,40 @@ void OriginalIngameScreen::ShowMap()
    ScheduleAction(ingameActionShowMap, true);
 }
 
+/// Renders the 3d view with the aspect ratio of the screenshot, but in
+/// window resolution, and starts capturing it. The captured image is
+/// downscaled to the screenshot size on the capture worker thread and is
+/// set in the savegames manager a frame later.
 void OriginalIngameScreen::DoSavegameScreenshot(
    unsigned int xres, unsigned int yres)
 {
-   std::vector<Uint32> screenshot_rgba;
-   unsigned int screenshot_xres, screenshot_yres;
+   Viewport& viewport = m_game.GetViewport();
 
    // set up viewport and camera
-   // note: viewport is set only for having a proper aspect ratio; the real
-   // viewport is set some more lines below
-   m_game.GetViewport().SetViewport3D(0, 0, xres, yres);
+   viewport.SetViewport3D(0, 0, xres, yres);
 
    Vector3d m_viewOffset(0, 0, 20.0);
    m_game.GetRenderer().SetupFor3D(m_viewOffset);
 
-   glViewport(0, 0, xres, yres);
-
    glClear(GL_COLOR_BUFFER_BIT);
 
    // render a const world
    m_game.GetRenderer().RenderUnderworld(m_game.GetUnderworld());
 
-   // prepare screenshot
-   screenshot_xres = xres;
-   screenshot_yres = yres;
-
-   screenshot_rgba.clear();
-   screenshot_rgba.resize(xres*yres, 0);
+   // start capturing rendered area
+   int viewportX = 0, viewportY = 0, viewportWidth = 0, viewportHeight = 0;
+   viewport.GetViewport3D(viewportX, viewportY, viewportWidth, viewportHeight);
 
-   // read in scanlines
-   glReadBuffer(GL_BACK);
-
-   for (unsigned int i = 0; i < yres; i++)
-   {
-      glReadPixels(0, yres - i - 1, xres, 1, GL_RGBA, GL_UNSIGNED_BYTE,
-         &screenshot_rgba[i*xres]);
-   }
+   IGame& game = m_game;
+   m_game.GetRenderer().GetFrameCapture().StartCapture(
+      viewportX, viewportY, viewportWidth, viewportHeight, xres, yres,
+      [&game](const CapturedFrame& frame)
+      {
+         // set in savegames manager
+         game.GetSavegamesManager().SetSaveScreenshot(
+            frame.m_xres, frame.m_yres, frame.m_pixels);
+      });
 
    // reset viewport to original
-   m_game.GetViewport().SetViewport3D(52, 19, 172, 112);
-
-   // set in savegames manager
-   m_game.GetSavegamesManager().SetSaveScreenshot(
-      screenshot_xres, screenshot_yres, screenshot_rgba);
+   viewport.SetViewport3D(52, 19, 172, 112);
 }
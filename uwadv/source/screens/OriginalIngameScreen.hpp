@@ -27,9 +27,14 @@
 #include "MouseCursor.hpp"
 #include "FadingHelper.hpp"
 #include "ImageQuad.hpp"
+#include "ImageQuadAtlas.hpp"
 #include "TextScroll.hpp"
 #include "IngameControls.hpp"
 #include "Panel.hpp"
+#include "PerformanceHud.hpp"
+#include "AutomapImageCache.hpp"
+#include "SimulationThread.hpp"
+#include "WorldSnapshot.hpp"
 #include "Underworld.hpp"
 #include "Math.hpp"
 #include "physics/PlayerPhysicsObject.hpp"
@@ -147,6 +152,18 @@ protected:
    /// takes a screenshot for savegame preview
    void DoSavegameScreenshot(unsigned int xres, unsigned int yres);
 
+   /// evaluates game logic and physics for one tick
+   void EvaluateUnderworld();
+
+   /// evaluates game logic for one tick
+   void EvaluateGameLogic();
+
+   /// evaluates player movement and physics for one tick
+   void EvaluatePhysics();
+
+   /// called by the simulation thread for every tick
+   void SimulationTick();
+
 protected:
    // constants
 
@@ -233,6 +250,15 @@ protected:
    /// move arrows
    IngameMoveArrows m_moveArrows;
 
+   /// atlas for the images of all controls; draws them in a single batch
+   ImageQuadAtlas m_controlsAtlas;
+
+   /// performance HUD; hidden by default
+   PerformanceHud m_performanceHud;
+
+   /// automap images of levels already displayed in the map view
+   UI::AutomapImageCache m_automapCache;
+
 
    // game related
 
@@ -247,4 +273,16 @@ protected:
 
    /// player physics tracking object
    PlayerPhysicsObject m_playerPhysics;
+
+   /// simulation thread; only runs when enabled in the settings
+   SimulationThread m_simulationThread;
+
+   /// snapshots of the last two simulation ticks
+   std::array<WorldSnapshot, 2> m_snapshots;
+
+   /// index of the snapshot of the last simulation tick
+   size_t m_currentSnapshot;
+
+   /// snapshot interpolated for the current frame
+   WorldSnapshot m_renderSnapshot;
 };
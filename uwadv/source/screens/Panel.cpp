@@ -158,6 +158,14 @@ void Panel::Init(IPanelParent* panelParent, unsigned int xpos,
    UpdatePanel();
 }
 
+void Panel::SetAtlas(ImageQuadAtlas* atlas)
+{
+   ImageQuad::SetAtlas(atlas);
+
+   m_chainsTopImage.SetAtlas(atlas);
+   m_chainsBottomImage.SetAtlas(atlas);
+}
+
 void Panel::Destroy()
 {
    ImageQuad::Destroy();
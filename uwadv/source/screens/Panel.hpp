@@ -62,6 +62,9 @@ public:
    virtual void Init(IPanelParent* panelParent, unsigned int xpos,
       unsigned int ypos);
 
+   /// sets atlas for the panel and the chain images
+   virtual void SetAtlas(ImageQuadAtlas* atlas) override;
+
    // virtual functions from Window
    virtual void Destroy() override;
    virtual void Draw() override;
@@ -0,0 +1,169 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PerformanceHud.cpp
+/// \brief performance HUD window
+//
+#include "pch.hpp"
+#include "PerformanceHud.hpp"
+#include "PerformanceCounters.hpp"
+#include "Renderer.hpp"
+
+namespace Detail
+{
+   /// width of the phase name column, in pixels
+   const unsigned int c_nameColumnWidth = 36;
+
+   /// width of a histogram, in pixels; one pixel per frame
+   const unsigned int c_histogramWidth = 128;
+
+   /// width of the column with average and maximum times, in pixels
+   const unsigned int c_timesColumnWidth = 48;
+
+   /// height of a histogram row, in pixels
+   const unsigned int c_rowHeight = 10;
+
+   /// height of a render statistics text row, in pixels
+   const unsigned int c_textRowHeight = 8;
+
+   /// frame time that fills the whole histogram height; one frame at 60 fps
+   const double c_histogramFullTime = 1000.0 / 60.0;
+
+   /// palette index for HUD texts
+   const Uint8 c_textColor = 11;
+
+   /// palette index for histogram bars
+   const Uint8 c_barColor = 73;
+
+   /// palette index for histogram bars exceeding the full height
+   const Uint8 c_overBudgetColor = 42;
+
+   /// palette index for HUD background
+   const Uint8 c_backgroundColor = 1;
+}
+
+void PerformanceHud::Init(IGame& game, unsigned int xpos, unsigned int ypos)
+{
+   m_game = &game;
+
+   m_font.Load(game.GetResourceManager(), fontNormal);
+
+   GetImage().Create(
+      Detail::c_nameColumnWidth + Detail::c_histogramWidth + Detail::c_timesColumnWidth,
+      Base::phaseMax * Detail::c_rowHeight + 3 * Detail::c_textRowHeight + 1);
+
+   ImageQuad::Init(game, xpos, ypos);
+}
+
+/// Enables the performance counters when the HUD gets visible, and disables
+/// them when it's hidden again.
+void PerformanceHud::Toggle()
+{
+   m_isVisible = !m_isVisible;
+
+   m_game->GetPerformanceCounters().SetEnabled(m_isVisible);
+}
+
+void PerformanceHud::Destroy()
+{
+   if (m_isVisible)
+      Toggle();
+
+   ImageQuad::Destroy();
+}
+
+void PerformanceHud::Draw()
+{
+   if (!m_isVisible)
+      return;
+
+   UpdateImage();
+   Update();
+
+   ImageQuad::Draw();
+}
+
+/// Draws a row for each phase, with the phase name, a histogram of the phase
+/// times of the last frames and the average and maximum time, and three rows
+/// with the render statistics of the last frame.
+void PerformanceHud::UpdateImage()
+{
+   const Base::PerformanceCounters& counters = m_game->GetPerformanceCounters();
+
+   IndexedImage& image = GetImage();
+   image.Clear(Detail::c_backgroundColor);
+
+   char buffer[64];
+
+   for (unsigned int phaseIndex = 0; phaseIndex < Base::phaseMax; phaseIndex++)
+   {
+      Base::PerformancePhase phase = static_cast<Base::PerformancePhase>(phaseIndex);
+      unsigned int rowYPos = phaseIndex * Detail::c_rowHeight;
+
+      DrawText(1, rowYPos + 2, Base::PerformanceCounters::GetPhaseName(phase));
+
+      // histogram, the most recent frame on the right side
+      size_t firstFrame = Base::PerformanceCounters::s_historySize - Detail::c_histogramWidth;
+      for (unsigned int column = 0; column < Detail::c_histogramWidth; column++)
+      {
+         double frameTime = counters.GetFrameTime(phase, firstFrame + column);
+
+         unsigned int barHeight = static_cast<unsigned int>(
+            frameTime / Detail::c_histogramFullTime * (Detail::c_rowHeight - 1) + 0.5);
+
+         bool overBudget = barHeight >= Detail::c_rowHeight;
+         if (overBudget)
+            barHeight = Detail::c_rowHeight - 1;
+
+         if (barHeight > 0)
+            image.FillRect(Detail::c_nameColumnWidth + column,
+               rowYPos + Detail::c_rowHeight - 1 - barHeight,
+               1, barHeight,
+               overBudget ? Detail::c_overBudgetColor : Detail::c_barColor);
+      }
+
+      snprintf(buffer, sizeof(buffer), "%.1f/%.1f",
+         counters.GetAverageTime(phase), counters.GetMaxTime(phase));
+
+      DrawText(Detail::c_nameColumnWidth + Detail::c_histogramWidth + 2, rowYPos + 2, buffer);
+   }
+
+   // render statistics of last frame
+   const RenderStatistics& statistics = m_game->GetRenderer().GetRenderStatistics();
+   unsigned int statisticsYPos = Base::phaseMax * Detail::c_rowHeight + 1;
+
+   snprintf(buffer, sizeof(buffer), "tiles %u  triangles %u",
+      statistics.m_numVisibleTiles, statistics.m_numTriangles);
+   DrawText(1, statisticsYPos, buffer);
+
+   snprintf(buffer, sizeof(buffer), "draw calls %u  binds %u  uploads %u",
+      statistics.m_numDrawCalls, statistics.m_numTextureBinds, statistics.m_numTextureUploads);
+   DrawText(1, statisticsYPos + Detail::c_textRowHeight, buffer);
+
+   snprintf(buffer, sizeof(buffer), "3d view %ux%u",
+      statistics.m_renderXRes, statistics.m_renderYRes);
+   DrawText(1, statisticsYPos + 2 * Detail::c_textRowHeight, buffer);
+}
+
+void PerformanceHud::DrawText(unsigned int xpos, unsigned int ypos, const char* text)
+{
+   IndexedImage textImage;
+   m_font.CreateString(textImage, text, Detail::c_textColor);
+
+   GetImage().PasteImage(textImage, xpos, ypos, true);
+}
@@ -0,0 +1,71 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PerformanceHud.hpp
+/// \brief performance HUD window
+//
+#pragma once
+
+#include "ImageQuad.hpp"
+#include "Font.hpp"
+
+/// \brief performance HUD
+/// Shows rolling histograms of the frame phase times collected by the
+/// performance counters, and render statistics of the last frame. The
+/// performance counters are only enabled while the HUD is visible, so that a
+/// hidden HUD costs no time.
+class PerformanceHud : public ImageQuad
+{
+public:
+   /// ctor
+   PerformanceHud()
+      :m_game(nullptr),
+      m_isVisible(false)
+   {
+   }
+
+   /// initializes performance HUD
+   virtual void Init(IGame& game, unsigned int xpos, unsigned int ypos) override;
+
+   /// shows or hides the HUD
+   void Toggle();
+
+   /// returns if the HUD is currently visible
+   bool IsVisible() const { return m_isVisible; }
+
+   // virtual functions from Window
+   virtual void Destroy() override;
+   virtual void Draw() override;
+
+private:
+   /// draws counters and histograms into the quad image
+   void UpdateImage();
+
+   /// draws text into the quad image
+   void DrawText(unsigned int xpos, unsigned int ypos, const char* text);
+
+private:
+   /// game interface
+   IGame* m_game;
+
+   /// font for HUD texts
+   Font m_font;
+
+   /// indicates if the HUD is visible
+   bool m_isVisible;
+};
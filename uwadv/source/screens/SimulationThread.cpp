@@ -0,0 +1,157 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SimulationThread.cpp
+/// \brief thread running game simulation with a fixed tick rate
+//
+#include "pch.hpp"
+#include "SimulationThread.hpp"
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+namespace Detail
+{
+   /// max. number of ticks to catch up; when the simulation falls behind
+   /// farther, e.g. when debugging, the missed ticks are dropped
+   const Uint64 c_maxCatchUpTicks = 5;
+} // namespace Detail
+
+SimulationThread::SimulationThread()
+   :m_thread(nullptr),
+   m_lock(SDL_CreateMutex()),
+   m_tickInterval(1),
+   m_lastTick(0),
+   m_stopThread(false),
+   m_lockCount(0)
+{
+}
+
+SimulationThread::~SimulationThread()
+{
+   Stop();
+
+   SDL_DestroyMutex(m_lock);
+}
+
+/// \param tickRate number of ticks per second
+/// \param tickFunc function that is called on every tick, with the lock held
+void SimulationThread::Start(double tickRate, std::function<void()> tickFunc)
+{
+   UaAssert(m_thread == nullptr);
+
+   m_tickFunc = tickFunc;
+   m_tickInterval = static_cast<Uint64>(SDL_GetPerformanceFrequency() / tickRate);
+   m_lastTick = SDL_GetPerformanceCounter();
+   m_stopThread = false;
+
+   m_thread = SDL_CreateThread(ThreadProc, "simulation-thread", this);
+
+   UaTrace("simulation thread started, with %.1f ticks/s\n", tickRate);
+}
+
+/// Stop() may be called from the main thread while holding the lock, e.g.
+/// when a tick on the main thread switches to another screen. The lock is
+/// released while waiting for the thread, which doesn't run another tick
+/// after it was told to stop.
+void SimulationThread::Stop()
+{
+   if (m_thread == nullptr)
+      return;
+
+   m_stopThread = true;
+
+   unsigned int lockCount = m_lockCount;
+   for (unsigned int count = 0; count < lockCount; count++)
+      SDL_UnlockMutex(m_lock);
+
+   SDL_WaitThread(m_thread, nullptr);
+   m_thread = nullptr;
+
+   for (unsigned int count = 0; count < lockCount; count++)
+      SDL_LockMutex(m_lock);
+
+   UaTrace("simulation thread stopped\n");
+}
+
+void SimulationThread::Lock()
+{
+   SDL_LockMutex(m_lock);
+   m_lockCount++;
+}
+
+void SimulationThread::Unlock()
+{
+   UaAssert(m_lockCount > 0);
+
+   m_lockCount--;
+   SDL_UnlockMutex(m_lock);
+}
+
+double SimulationThread::GetTickFraction() const
+{
+   Uint64 elapsed = SDL_GetPerformanceCounter() - m_lastTick;
+
+   return std::min(1.0, static_cast<double>(elapsed) / m_tickInterval);
+}
+
+int SimulationThread::ThreadProc(void* param)
+{
+   SimulationThread* simulationThread = reinterpret_cast<SimulationThread*>(param);
+   simulationThread->Run();
+
+   return 0;
+}
+
+void SimulationThread::Run()
+{
+   Uint64 nextTick = m_lastTick + m_tickInterval;
+
+   while (!m_stopThread)
+   {
+      Uint64 now = SDL_GetPerformanceCounter();
+
+      if (now < nextTick)
+      {
+         // sleep until next tick is due
+         Uint64 remainingMilliseconds = (nextTick - now) * 1000 / SDL_GetPerformanceFrequency();
+         SDL_Delay(static_cast<Uint32>(std::max<Uint64>(remainingMilliseconds, 1)));
+         continue;
+      }
+
+      // drop ticks when falling behind too far
+      if (now - nextTick > Detail::c_maxCatchUpTicks * m_tickInterval)
+         nextTick = now;
+
+      SDL_LockMutex(m_lock);
+
+      // the main thread may have stopped the thread while waiting for the lock
+      if (m_stopThread)
+      {
+         SDL_UnlockMutex(m_lock);
+         break;
+      }
+
+      m_tickFunc();
+
+      m_lastTick = nextTick;
+
+      SDL_UnlockMutex(m_lock);
+
+      nextTick += m_tickInterval;
+   }
+}
@@ -0,0 +1,124 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SimulationThread.hpp
+/// \brief thread running game simulation with a fixed tick rate
+//
+#pragma once
+
+#include <functional>
+#include <atomic>
+
+struct SDL_Thread;
+struct SDL_mutex;
+
+/// \brief Thread that runs the game simulation with a fixed tick rate
+/// The tick function is called on its own thread, with the simulation lock
+/// held. The main thread must hold the lock, too, while it accesses state
+/// that the tick function changes, e.g. while processing input. The lock is
+/// recursive and may only be taken by the main thread. The thread catches up
+/// when a tick took longer than the tick interval, so the simulation keeps
+/// its pace even when rendering stalls.
+class SimulationThread
+{
+public:
+   /// ctor
+   SimulationThread();
+   /// dtor; stops thread
+   ~SimulationThread();
+
+   /// deleted copy ctor
+   SimulationThread(const SimulationThread&) = delete;
+   /// deleted assignment operator
+   SimulationThread& operator=(const SimulationThread&) = delete;
+
+   /// starts simulation thread
+   void Start(double tickRate, std::function<void()> tickFunc);
+
+   /// stops simulation thread; may be called with the lock held
+   void Stop();
+
+   /// returns if simulation thread is running
+   bool IsRunning() const { return m_thread != nullptr; }
+
+   /// locks simulation state
+   void Lock();
+
+   /// unlocks simulation state
+   void Unlock();
+
+   /// returns time since the last tick, as fraction of the tick interval,
+   /// in the range [0.0; 1.0]
+   double GetTickFraction() const;
+
+private:
+   /// thread procedure
+   static int ThreadProc(void* param);
+
+   /// runs the tick loop until stopped
+   void Run();
+
+private:
+   /// simulation thread; null when not running
+   SDL_Thread* m_thread;
+
+   /// lock for simulation state
+   SDL_mutex* m_lock;
+
+   /// tick function
+   std::function<void()> m_tickFunc;
+
+   /// tick interval, in performance counter ticks
+   Uint64 m_tickInterval;
+
+   /// performance counter value of the last tick
+   std::atomic<Uint64> m_lastTick;
+
+   /// indicates that the thread should stop
+   std::atomic<bool> m_stopThread;
+
+   /// number of times the main thread currently holds the lock
+   unsigned int m_lockCount;
+};
+
+/// \brief Holds the simulation lock as long as the object lives
+class SimulationLock
+{
+public:
+   /// ctor; locks simulation state
+   explicit SimulationLock(SimulationThread& simulationThread)
+      :m_simulationThread(simulationThread)
+   {
+      m_simulationThread.Lock();
+   }
+
+   /// dtor; unlocks simulation state
+   ~SimulationLock()
+   {
+      m_simulationThread.Unlock();
+   }
+
+   /// deleted copy ctor
+   SimulationLock(const SimulationLock&) = delete;
+   /// deleted assignment operator
+   SimulationLock& operator=(const SimulationLock&) = delete;
+
+private:
+   /// simulation thread to lock
+   SimulationThread& m_simulationThread;
+};
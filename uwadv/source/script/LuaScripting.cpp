@@ -27,6 +27,7 @@
 #include "uwadv/DebugServer.hpp"
 #include "Settings.hpp"
 #include "ResourceManager.hpp"
+#include "PerformanceCounters.hpp"
 
 extern "C"
 {
@@ -53,6 +54,15 @@ void LuaScripting::Init(IBasicGame* game)
    LuaCodeDebugger::Init(m_game->GetDebugger());
 }
 
+/// Calls a Lua function and measures the time spent in Lua, for the
+/// performance counters.
+void LuaScripting::CheckedCall(int numArgs, int numResults)
+{
+   Base::PerformanceTimer luaTimer{ m_game->GetPerformanceCounters(), Base::phaseLua };
+
+   LuaCodeDebugger::CheckedCall(numArgs, numResults);
+}
+
 bool LuaScripting::LoadScript(const char* basename)
 {
    return LuaScripting::LoadScript(*this, m_game->GetSettings(), m_game->GetResourceManager(), basename);
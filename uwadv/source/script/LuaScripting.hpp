@@ -55,6 +55,9 @@ public:
       unsigned int param) override;
    virtual void OnChangingLevel() override;
 
+   /// lua function call, with timing for performance counters
+   virtual void CheckedCall(int numArgs, int numResults) override;
+
 private:
    /// returns scripting class from Lua state
    static LuaScripting& GetScriptingFromSelf(lua_State* L);
@@ -163,15 +163,15 @@
 #define PIXEL33_81    Interp8(dp+dpL+dpL+dpL+3, w[5], w[6]);
 #define PIXEL33_82    Interp8(dp+dpL+dpL+dpL+3, w[5], w[8]);
 
-HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres )
+HQX_API void HQX_CALLCONV hq4x_32_rows( const uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres, int firstRow, int numRows, const uint8_t * patterns )
 {
     int  i, j, k;
     int  prevline, nextline;
     uint32_t w[10];
     int dpL = (drb >> 2);
     int spL = (srb >> 2);
-    uint8_t *sRowP = (uint8_t *) sp;
-    uint8_t *dRowP = (uint8_t *) dp;
+    uint8_t *sRowP = (uint8_t *) sp + firstRow * srb;
+    uint8_t *dRowP = (uint8_t *) dp + firstRow * drb * 4;
     uint32_t yuv1, yuv2;
 
     //   +----+----+----+
@@ -185,7 +185,10 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * sp, uint32_t srb, uint32_
     //   | w7 | w8 | w9 |
     //   +----+----+----+
 
-    for (j=0; j<Yres; j++)
+    sp = (uint32_t *) sRowP;
+    dp = (uint32_t *) dRowP;
+
+    for (j=firstRow; j<firstRow+numRows; j++)
     {
         if (j>0)      prevline = -spL; else prevline = 0;
         if (j<Yres-1) nextline =  spL; else nextline = 0;
@@ -225,19 +228,27 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * sp, uint32_t srb, uint32_
             int pattern = 0;
             int flag = 1;
 
-            yuv1 = rgb_to_yuv(w[5]);
-
-            for (k=1; k<=9; k++)
+            if (patterns != NULL)
             {
-                if (k==5) continue;
+                /* use precomputed pattern */
+                pattern = *patterns++;
+            }
+            else
+            {
+                yuv1 = rgb_to_yuv(w[5]);
 
-                if ( w[k] != w[5] )
+                for (k=1; k<=9; k++)
                 {
-                    yuv2 = rgb_to_yuv(w[k]);
-                    if (yuv_diff(yuv1, yuv2))
-                        pattern |= flag;
+                    if (k==5) continue;
+
+                    if ( w[k] != w[5] )
+                    {
+                        yuv2 = rgb_to_yuv(w[k]);
+                        if (yuv_diff(yuv1, yuv2))
+                            pattern |= flag;
+                    }
+                    flag <<= 1;
                 }
-                flag <<= 1;
             }
 
             switch (pattern)
@@ -5226,6 +5237,11 @@ HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * sp, uint32_t srb, uint32_
     }
 }
 
+HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * sp, uint32_t srb, uint32_t * dp, uint32_t drb, int Xres, int Yres )
+{
+    hq4x_32_rows(sp, srb, dp, drb, Xres, Yres, 0, Yres, NULL);
+}
+
 HQX_API void HQX_CALLCONV hq4x_32( const uint32_t * sp, uint32_t * dp, int Xres, int Yres )
 {
     uint32_t rowBytesL = Xres * sizeof(uint32_t);
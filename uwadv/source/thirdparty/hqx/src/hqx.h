@@ -52,4 +52,13 @@ HQX_API void HQX_CALLCONV hq2x_32_rb( const uint32_t * src, uint32_t src_rowByte
 HQX_API void HQX_CALLCONV hq3x_32_rb( const uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 HQX_API void HQX_CALLCONV hq4x_32_rb( const uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height );
 
+/* Scales the rows [firstRow, firstRow + numRows) of an image; src and dest
+ * point to the first row of the whole image, so that neighbour rows outside of
+ * the given range are used as well. When patterns is not NULL, it contains
+ * precomputed neighbour difference patterns, one byte per source pixel of the
+ * given rows. Different row ranges may be scaled concurrently. */
+HQX_API void HQX_CALLCONV hq2x_32_rows( const uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int firstRow, int numRows, const uint8_t * patterns );
+HQX_API void HQX_CALLCONV hq3x_32_rows( const uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int firstRow, int numRows, const uint8_t * patterns );
+HQX_API void HQX_CALLCONV hq4x_32_rows( const uint32_t * src, uint32_t src_rowBytes, uint32_t * dest, uint32_t dest_rowBytes, int width, int height, int firstRow, int numRows, const uint8_t * patterns );
+
 #endif
@@ -33,6 +33,7 @@
 #include "LevelList.hpp"
 #include "File.hpp"
 #include "Settings.hpp"
+#include "PerformanceCounters.hpp"
 #include "ResourceManager.hpp"
 #include "ImageManager.hpp"
 #include "LevelList.hpp"
@@ -118,6 +119,9 @@ private:
    /// settings
    Base::Settings m_settings;
 
+   /// performance counters; never enabled
+   Base::PerformanceCounters m_performanceCounters;
+
    /// resource manager
    Base::ResourceManager m_resourceManager;
 
@@ -213,6 +217,11 @@ private:
       throw std::runtime_error("object not available");
    }
 
+   virtual Base::PerformanceCounters& GetPerformanceCounters() override
+   {
+      return m_performanceCounters;
+   }
+
    virtual void InitGame() override
    {
    }
@@ -0,0 +1,874 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file uwbench-render.cpp
+/// \brief headless renderer benchmark program
+/// \details
+/// the program renders a level of the game in an offscreen OpenGL context,
+/// flying a camera along a scripted or recorded path through the level, and
+/// reports frame times and render statistics as JSON, e.g. for comparing
+/// against a baseline in continuous integration builds.
+///
+/// the offscreen context is created with SDL's "offscreen" video driver, which
+/// uses an EGL pbuffer surface; on machines without a GPU, Mesa's llvmpipe
+/// software renderer can be used by setting LIBGL_ALWAYS_SOFTWARE=1. Another
+/// video driver can be selected by setting SDL_VIDEODRIVER.
+///
+/// with the "software" backend, the level is rendered by the multithreaded
+/// SoftwareRenderer prototype instead, and no OpenGL context is created at
+/// all. The prototype renders tiles and 3d models only, and isn't available
+/// in the game itself.
+///
+/// the recorded path file contains one camera position per line, with the
+/// values "xpos ypos height panAngle rotateAngle", in player coordinates.
+///
+/// with the -k option, no level is rendered; instead the throughput of the
+/// SIMD pixel kernels used for palette conversion and transparent blits is
+/// measured, using a pixel buffer of the offscreen surface size.
+//
+#include <SDL.h>
+#include "File.hpp"
+#include "Settings.hpp"
+#include "PerformanceCounters.hpp"
+#include "ResourceManager.hpp"
+#include "ImageManager.hpp"
+#include "GameInterface.hpp"
+#include "Underworld.hpp"
+#include "LevelImporter.hpp"
+#include "RenderWindow.hpp"
+#include "Viewport.hpp"
+#include "Renderer.hpp"
+#include "SoftwareRenderer.hpp"
+#include "PaletteConverter.hpp"
+#include "ImageBlitter.hpp"
+#include "CpuFeatures.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <stdexcept>
+#include <functional>
+#include <cmath>
+
+/// single camera position of a camera path
+struct CameraPosition
+{
+   double m_xpos;
+   double m_ypos;
+   double m_height;
+   double m_panAngle;
+   double m_rotateAngle;
+};
+
+/// statistics of a single rendered frame
+struct FrameStatistics
+{
+   /// frame time, in milliseconds
+   double m_frameTime;
+
+   /// render statistics of the frame
+   RenderStatistics m_renderStatistics;
+};
+
+/// renderer benchmark class
+class RenderBenchmark : public IGame
+{
+public:
+   /// ctor
+   RenderBenchmark()
+      :m_resourceManager(m_settings),
+      m_imageManager(m_resourceManager),
+      m_underworldPath("./"),
+      m_levelIndex(0),
+      m_numFrames(600),
+      m_numWarmupFrames(10),
+      m_width(640),
+      m_height(400),
+      m_useSoftwareRenderer(false),
+      m_numThreads(0),
+      m_runKernelBenchmark(false)
+   {
+   }
+
+   /// parses command line arguments
+   bool ParseArgs(int argc, char* argv[]);
+
+   /// runs the benchmark
+   bool Run();
+
+private:
+   /// prints usage of the program
+   static void PrintUsage();
+
+   /// creates offscreen render window and initializes renderer
+   void InitRenderer();
+
+   /// loads all levels and prepares the level to render
+   void LoadLevel();
+
+   /// loads recorded camera path from file
+   bool LoadCameraPath();
+
+   /// creates scripted camera path through all non-solid tiles of the level
+   void CreateCameraPath();
+
+   /// renders a single frame and returns its statistics
+   FrameStatistics RenderFrame(const CameraPosition& cameraPos);
+
+   /// saves the last rendered frame as bitmap file
+   void SaveScreenshot();
+
+   /// writes benchmark result as JSON
+   void WriteResult(const std::vector<FrameStatistics>& allFrames);
+
+   /// measures throughput of the pixel kernels and writes result as JSON
+   void RunKernelBenchmark();
+
+   /// returns throughput of given pixel function, in megapixels per second
+   double MeasureThroughput(const std::function<void()>& pixelFunc) const;
+
+   /// opens JSON output file, or returns stdout
+   FILE* OpenOutputFile() const;
+
+   /// returns percentile value of sorted values
+   static double GetPercentile(const std::vector<double>& sortedValues, double percentile);
+
+   /// writes JSON object with mean, percentiles and max of given values
+   static void WriteValues(FILE* fd, const char* name, std::vector<double> values, bool isLast);
+
+private:
+   /// settings
+   Base::Settings m_settings;
+
+   /// performance counters; never enabled
+   Base::PerformanceCounters m_performanceCounters;
+
+   /// resource manager
+   Base::ResourceManager m_resourceManager;
+
+   /// image manager
+   ImageManager m_imageManager;
+
+   /// underworld object
+   Underworld::Underworld m_underworld;
+
+   /// offscreen render window
+   std::unique_ptr<RenderWindow> m_renderWindow;
+
+   /// render viewport
+   std::unique_ptr<Viewport> m_viewport;
+
+   /// renderer
+   Renderer m_renderer;
+
+   /// software renderer
+   SoftwareRenderer m_softwareRenderer;
+
+   /// camera path
+   std::vector<CameraPosition> m_cameraPath;
+
+   /// path to underworld game files
+   std::string m_underworldPath;
+
+   /// filename of recorded camera path; empty when using scripted path
+   std::string m_cameraPathFilename;
+
+   /// filename of JSON output; empty when writing to stdout
+   std::string m_outputFilename;
+
+   /// filename of bitmap file for the last frame; empty when not saving
+   std::string m_screenshotFilename;
+
+   /// level to render
+   unsigned int m_levelIndex;
+
+   /// number of frames to render
+   unsigned int m_numFrames;
+
+   /// number of warmup frames that aren't measured, e.g. for texture uploads
+   unsigned int m_numWarmupFrames;
+
+   /// width of offscreen surface
+   int m_width;
+
+   /// height of offscreen surface
+   int m_height;
+
+   /// indicates if the software renderer is used instead of OpenGL
+   bool m_useSoftwareRenderer;
+
+   /// number of threads for the software renderer; 0 uses one per CPU
+   unsigned int m_numThreads;
+
+   /// indicates if the pixel kernels are measured instead of rendering a level
+   bool m_runKernelBenchmark;
+
+private:
+   // IGame virtual methods
+
+   virtual double GetTickRate() override
+   {
+      return 20.0;
+   }
+
+   virtual bool PauseGame(bool /*pause*/) override
+   {
+      return false;
+   }
+
+   virtual Base::Settings& GetSettings() override
+   {
+      return m_settings;
+   }
+
+   virtual Base::ResourceManager& GetResourceManager() override
+   {
+      return m_resourceManager;
+   }
+
+   virtual Base::SavegamesManager& GetSavegamesManager() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual IScripting& GetScripting() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual IDebugServer& GetDebugger() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual GameStrings& GetGameStrings() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual Underworld::Underworld& GetUnderworld() override
+   {
+      return m_underworld;
+   }
+
+   virtual Underworld::GameLogic& GetGameLogic() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual IUserInterface* GetUserInterface() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual Base::PerformanceCounters& GetPerformanceCounters() override
+   {
+      return m_performanceCounters;
+   }
+
+   virtual void InitGame() override
+   {
+   }
+
+   virtual void DoneGame() override
+   {
+   }
+
+   virtual Audio::AudioManager& GetAudioManager() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual ImageManager& GetImageManager() override
+   {
+      return m_imageManager;
+   }
+
+   virtual Renderer& GetRenderer() override
+   {
+      return m_renderer;
+   }
+
+   virtual RenderWindow& GetRenderWindow() override
+   {
+      return *m_renderWindow;
+   }
+
+   virtual Viewport& GetViewport() override
+   {
+      return *m_viewport;
+   }
+
+   virtual PhysicsModel& GetPhysicsModel() override
+   {
+      throw std::runtime_error("object not available");
+   }
+
+   virtual void ReplaceScreen(Screen* /*newScreen*/, bool /*saveCurrent*/) override
+   {
+   }
+
+   virtual void RemoveScreen() override
+   {
+   }
+
+   virtual void RegisterUserInterface(IUserInterface* /*userInterface*/) override
+   {
+   }
+
+   virtual unsigned int GetScreenXRes() override
+   {
+      return m_width;
+   }
+
+   virtual unsigned int GetScreenYRes() override
+   {
+      return m_height;
+   }
+};
+
+void RenderBenchmark::PrintUsage()
+{
+   printf("Syntax: uwbench-render <options>\n"
+      "Options:\n"
+      "  -d<basepath> sets uw1/uw2 path; default: ./\n"
+      "  -l<level>    level to render, starting at 0; default: 0\n"
+      "  -f<frames>   number of frames to render; default: 600\n"
+      "  -w<frames>   number of warmup frames not measured; default: 10\n"
+      "  -s<w>x<h>    size of offscreen surface; default: 640x400\n"
+      "  -p<file>     recorded camera path file; default: scripted path\n"
+      "  -o<file>     JSON output file; default: stdout\n"
+      "  -b<backend>  renderer backend, \"gl\" or \"software\"; default: gl\n"
+      "  -t<threads>  number of software renderer threads; default: one per CPU\n"
+      "  -i<file>     saves last frame as bitmap file; default: not saved\n"
+      "  -k           measures pixel kernel throughput instead of rendering\n");
+}
+
+bool RenderBenchmark::ParseArgs(int argc, char* argv[])
+{
+   for (int argIndex = 1; argIndex < argc; argIndex++)
+   {
+      std::string arg{ argv[argIndex] };
+      if (arg.length() < 2 || arg[0] != '-')
+      {
+         PrintUsage();
+         return false;
+      }
+
+      std::string value = arg.substr(2);
+
+      switch (arg[1])
+      {
+      case 'd': m_underworldPath = value; break;
+      case 'l': m_levelIndex = static_cast<unsigned int>(std::stoul(value)); break;
+      case 'f': m_numFrames = static_cast<unsigned int>(std::stoul(value)); break;
+      case 'w': m_numWarmupFrames = static_cast<unsigned int>(std::stoul(value)); break;
+      case 'p': m_cameraPathFilename = value; break;
+      case 'o': m_outputFilename = value; break;
+      case 'i': m_screenshotFilename = value; break;
+      case 'k': m_runKernelBenchmark = true; break;
+      case 't': m_numThreads = static_cast<unsigned int>(std::stoul(value)); break;
+      case 'b':
+         if (value != "gl" && value != "software")
+         {
+            printf("invalid renderer backend: %s\n", value.c_str());
+            return false;
+         }
+
+         m_useSoftwareRenderer = value == "software";
+         break;
+
+      case 's':
+         if (sscanf(value.c_str(), "%dx%d", &m_width, &m_height) != 2 ||
+            m_width <= 0 || m_height <= 0)
+         {
+            printf("invalid surface size: %s\n", value.c_str());
+            return false;
+         }
+         break;
+
+      default:
+         PrintUsage();
+         return false;
+      }
+   }
+
+   if (!m_underworldPath.empty() &&
+      m_underworldPath.back() != '/' && m_underworldPath.back() != '\\')
+      m_underworldPath += '/';
+
+   return m_numFrames > 0;
+}
+
+bool RenderBenchmark::Run()
+{
+   if (m_runKernelBenchmark)
+   {
+      try
+      {
+         RunKernelBenchmark();
+      }
+      catch (const std::exception& ex)
+      {
+         printf("error: %s\n", ex.what());
+         return false;
+      }
+
+      return true;
+   }
+
+   try
+   {
+      InitRenderer();
+      LoadLevel();
+
+      if (!m_cameraPathFilename.empty())
+      {
+         if (!LoadCameraPath())
+            return false;
+      }
+      else
+         CreateCameraPath();
+
+      if (m_cameraPath.empty())
+      {
+         printf("camera path is empty\n");
+         return false;
+      }
+
+      std::vector<FrameStatistics> allFrames;
+      allFrames.reserve(m_numFrames);
+
+      for (unsigned int frameIndex = 0; frameIndex < m_numWarmupFrames + m_numFrames; frameIndex++)
+      {
+         const CameraPosition& cameraPos = m_cameraPath[frameIndex % m_cameraPath.size()];
+
+         FrameStatistics frame = RenderFrame(cameraPos);
+
+         if (frameIndex >= m_numWarmupFrames)
+            allFrames.push_back(frame);
+
+         // advance animated textures
+         if (!m_useSoftwareRenderer)
+            m_renderer.Tick(GetTickRate());
+      }
+
+      if (!m_screenshotFilename.empty())
+         SaveScreenshot();
+
+      WriteResult(allFrames);
+   }
+   catch (const std::exception& ex)
+   {
+      printf("error: %s\n", ex.what());
+      return false;
+   }
+
+   if (!m_useSoftwareRenderer)
+      m_renderer.Done();
+
+   m_viewport.reset();
+   m_renderWindow.reset();
+
+   SDL_Quit();
+
+   return true;
+}
+
+/// Creates the render window using SDL's offscreen video driver, unless the
+/// SDL_VIDEODRIVER environment variable selects another driver. The window
+/// is never shown and its buffers are never swapped. The software renderer
+/// needs no window.
+void RenderBenchmark::InitRenderer()
+{
+   if (m_useSoftwareRenderer)
+      return;
+
+   SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+
+   m_renderWindow = std::make_unique<RenderWindow>(m_width, m_height, "uwbench-render", false);
+
+   // don't wait for vsync
+   SDL_GL_SetSwapInterval(0);
+
+   Renderer::PrintOpenGLDiagnostics();
+
+   m_viewport = std::make_unique<Viewport>(*m_renderWindow);
+   m_viewport->SetViewport3D(0, 0, 320, 200);
+
+   m_renderer.SetViewport(m_viewport.get());
+}
+
+void RenderBenchmark::LoadLevel()
+{
+   m_settings.SetValue(Base::settingUnderworldPath, m_underworldPath);
+
+   m_resourceManager.DetectGameType(m_settings);
+
+   m_imageManager.Init();
+
+   Underworld::LevelList& levelList = m_underworld.GetLevelList();
+
+   Import::LevelImporter importer{ m_resourceManager };
+   importer.LoadLevels(m_settings, levelList);
+
+   if (m_levelIndex >= levelList.GetNumLevels())
+      throw std::runtime_error("invalid level index");
+
+   m_underworld.GetPlayer().SetAttribute(Underworld::attrMapLevel, static_cast<Uint16>(m_levelIndex));
+
+   Uint64 start = SDL_GetPerformanceCounter();
+
+   if (m_useSoftwareRenderer)
+   {
+      m_softwareRenderer.Init(*this, m_width, m_height, m_numThreads);
+   }
+   else
+   {
+      m_renderer.InitGame(*this);
+
+      start = SDL_GetPerformanceCounter();
+
+      m_renderer.PrepareLevel(levelList.GetLevel(m_levelIndex));
+   }
+
+   UaTrace("preparing level took %.1f ms\n",
+      (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+}
+
+bool RenderBenchmark::LoadCameraPath()
+{
+   FILE* fd = fopen(m_cameraPathFilename.c_str(), "rt");
+   if (fd == NULL)
+   {
+      printf("couldn't open camera path file: %s\n", m_cameraPathFilename.c_str());
+      return false;
+   }
+
+   CameraPosition cameraPos;
+   while (fscanf(fd, "%lf %lf %lf %lf %lf",
+      &cameraPos.m_xpos, &cameraPos.m_ypos, &cameraPos.m_height,
+      &cameraPos.m_panAngle, &cameraPos.m_rotateAngle) == 5)
+   {
+      m_cameraPath.push_back(cameraPos);
+   }
+
+   fclose(fd);
+
+   return true;
+}
+
+/// Creates a camera path that visits all non-solid tiles of the level, in
+/// scanline order, while the camera slowly rotates. The path is always the
+/// same for a level, so that results of different runs can be compared.
+void RenderBenchmark::CreateCameraPath()
+{
+   const Underworld::Tilemap& tilemap = m_underworld.GetCurrentLevel().GetTilemap();
+
+   std::vector<std::pair<unsigned int, unsigned int>> allOpenTiles;
+   for (unsigned int ypos = 0; ypos < 64; ypos++)
+      for (unsigned int xpos = 0; xpos < 64; xpos++)
+         if (tilemap.GetTileInfo(xpos, ypos).m_type != Underworld::tileSolid)
+            allOpenTiles.push_back(std::make_pair(xpos, ypos));
+
+   if (allOpenTiles.empty())
+      return;
+
+   for (unsigned int frameIndex = 0; frameIndex < m_numFrames; frameIndex++)
+   {
+      size_t tileIndex = size_t(frameIndex) * allOpenTiles.size() / m_numFrames;
+
+      CameraPosition cameraPos;
+      cameraPos.m_xpos = allOpenTiles[tileIndex].first + 0.5;
+      cameraPos.m_ypos = allOpenTiles[tileIndex].second + 0.5;
+      cameraPos.m_height = tilemap.GetFloorHeight(cameraPos.m_xpos, cameraPos.m_ypos);
+      cameraPos.m_panAngle = 0.0;
+      cameraPos.m_rotateAngle = fmod(frameIndex * 4.0, 360.0);
+
+      m_cameraPath.push_back(cameraPos);
+   }
+}
+
+/// Renders a single frame, like the ingame screen does, and waits until the
+/// OpenGL implementation or the software renderer has finished rendering.
+FrameStatistics RenderBenchmark::RenderFrame(const CameraPosition& cameraPos)
+{
+   Underworld::Player& player = m_underworld.GetPlayer();
+   player.SetPos(cameraPos.m_xpos, cameraPos.m_ypos);
+   player.SetHeight(cameraPos.m_height);
+   player.SetPanAngle(cameraPos.m_panAngle);
+   player.SetRotateAngle(cameraPos.m_rotateAngle);
+
+   Uint64 start = SDL_GetPerformanceCounter();
+
+   if (m_useSoftwareRenderer)
+   {
+      m_softwareRenderer.SetupFor3D(Vector3d(0.0, 0.0, 0.0));
+      m_softwareRenderer.RenderUnderworld(m_underworld);
+
+      FrameStatistics frame;
+      frame.m_frameTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+      frame.m_renderStatistics = m_softwareRenderer.GetRenderStatistics();
+
+      return frame;
+   }
+
+   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+   m_renderer.SetupFor3D(Vector3d(0.0, 0.0, 0.0));
+   m_renderer.RenderUnderworld(m_underworld);
+
+   glFinish();
+
+   FrameStatistics frame;
+   frame.m_frameTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+   frame.m_renderStatistics = m_renderer.GetRenderStatistics();
+
+   return frame;
+}
+
+/// Saves the last rendered frame. OpenGL frames are read back from the back
+/// buffer and flipped, since OpenGL stores the bottom line first.
+void RenderBenchmark::SaveScreenshot()
+{
+   std::vector<Uint32> pixels;
+
+   SDL_Surface* surface = nullptr;
+   if (m_useSoftwareRenderer)
+      surface = m_softwareRenderer.CreateSurface();
+   else
+   {
+      pixels.resize(m_width * m_height);
+      glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+      for (int ypos = 0; ypos < m_height / 2; ypos++)
+         std::swap_ranges(pixels.begin() + ypos * m_width, pixels.begin() + (ypos + 1) * m_width,
+            pixels.begin() + (m_height - 1 - ypos) * m_width);
+
+      surface = SDL_CreateRGBSurfaceWithFormatFrom(pixels.data(),
+         m_width, m_height, 32, m_width * sizeof(Uint32), SDL_PIXELFORMAT_RGBA32);
+   }
+
+   if (surface == nullptr)
+      throw std::runtime_error("couldn't create screenshot surface");
+
+   int result = SDL_SaveBMP(surface, m_screenshotFilename.c_str());
+   SDL_FreeSurface(surface);
+
+   if (result != 0)
+      throw std::runtime_error("couldn't save screenshot file");
+}
+
+double RenderBenchmark::GetPercentile(const std::vector<double>& sortedValues, double percentile)
+{
+   if (sortedValues.empty())
+      return 0.0;
+
+   // nearest-rank method
+   size_t rank = static_cast<size_t>(ceil(percentile / 100.0 * sortedValues.size()));
+   return sortedValues[rank > 0 ? rank - 1 : 0];
+}
+
+void RenderBenchmark::WriteValues(FILE* fd, const char* name, std::vector<double> values, bool isLast)
+{
+   std::sort(values.begin(), values.end());
+
+   double sum = 0.0;
+   for (double value : values)
+      sum += value;
+
+   fprintf(fd, "  \"%s\": { \"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, \"max\": %.3f }%s\n",
+      name,
+      values.empty() ? 0.0 : sum / values.size(),
+      GetPercentile(values, 50.0),
+      GetPercentile(values, 90.0),
+      GetPercentile(values, 99.0),
+      values.empty() ? 0.0 : values.back(),
+      isLast ? "" : ",");
+}
+
+FILE* RenderBenchmark::OpenOutputFile() const
+{
+   if (m_outputFilename.empty())
+      return stdout;
+
+   FILE* fd = fopen(m_outputFilename.c_str(), "wt");
+   if (fd == NULL)
+      throw std::runtime_error("couldn't open output file");
+
+   return fd;
+}
+
+void RenderBenchmark::WriteResult(const std::vector<FrameStatistics>& allFrames)
+{
+   FILE* fd = OpenOutputFile();
+
+   std::vector<double> frameTimes, drawCalls, triangles, textureBinds, visibleTiles;
+   unsigned int numTextureUploads = 0;
+
+   for (const FrameStatistics& frame : allFrames)
+   {
+      frameTimes.push_back(frame.m_frameTime);
+      drawCalls.push_back(frame.m_renderStatistics.m_numDrawCalls);
+      triangles.push_back(frame.m_renderStatistics.m_numTriangles);
+      textureBinds.push_back(frame.m_renderStatistics.m_numTextureBinds);
+      visibleTiles.push_back(frame.m_renderStatistics.m_numVisibleTiles);
+      numTextureUploads += frame.m_renderStatistics.m_numTextureUploads;
+   }
+
+   const char* rendererName = m_useSoftwareRenderer
+      ? "software"
+      : reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+   fprintf(fd, "{\n");
+   fprintf(fd, "  \"renderer\": \"%s\",\n", rendererName != NULL ? rendererName : "unknown");
+   if (m_useSoftwareRenderer)
+      fprintf(fd, "  \"threads\": %u,\n", m_softwareRenderer.GetRasterizer().GetNumThreads());
+   fprintf(fd, "  \"level\": %u,\n", m_levelIndex);
+   fprintf(fd, "  \"width\": %d,\n", m_width);
+   fprintf(fd, "  \"height\": %d,\n", m_height);
+   fprintf(fd, "  \"frames\": %u,\n", static_cast<unsigned int>(allFrames.size()));
+   fprintf(fd, "  \"warmup_frames\": %u,\n", m_numWarmupFrames);
+   fprintf(fd, "  \"texture_uploads\": %u,\n", numTextureUploads);
+   WriteValues(fd, "frame_time_ms", frameTimes, false);
+   WriteValues(fd, "draw_calls", drawCalls, false);
+   WriteValues(fd, "triangles", triangles, false);
+   WriteValues(fd, "texture_binds", textureBinds, false);
+   WriteValues(fd, "visible_tiles", visibleTiles, true);
+   fprintf(fd, "}\n");
+
+   if (fd != stdout)
+      fclose(fd);
+}
+
+/// Measures the palette conversion and transparent blit kernels that are
+/// supported on this CPU, and the per-pixel loops that Texture::Convert() and
+/// IndexedImage::PasteRect() used before the kernels were added. The pixel
+/// buffer has the size of the offscreen surface, and each kernel processes it
+/// once per frame. The transparent blit is done line by line, as in
+/// IndexedImage::PasteRect().
+void RenderBenchmark::RunKernelBenchmark()
+{
+   const unsigned int xres = static_cast<unsigned int>(m_width);
+   const unsigned int yres = static_cast<unsigned int>(m_height);
+   const size_t numPixels = size_t(xres) * yres;
+
+   // all palette indices; every third pixel is transparent
+   std::vector<Uint8> pixels(numPixels);
+   for (size_t index = 0; index < numPixels; index++)
+      pixels[index] = index % 3 == 0 ? 0 : static_cast<Uint8>(index * 37 + (index >> 8));
+
+   std::vector<Uint32> palette(256);
+   for (Uint32 index = 0; index < 256; index++)
+      palette[index] = 0xff000000 | (index << 16) | ((255 - index) << 8) | (index ^ 0x5a);
+
+   std::vector<Uint32> texels(numPixels);
+   std::vector<Uint8> dest(numPixels);
+
+   const Base::SimdKernel allKernels[] = { Base::kernelScalar, Base::kernelSSE2, Base::kernelAVX2 };
+
+   FILE* fd = OpenOutputFile();
+
+   fprintf(fd, "{\n");
+   fprintf(fd, "  \"best_kernel\": \"%s\",\n", Base::GetSimdKernelName(Base::GetBestSimdKernel()));
+   fprintf(fd, "  \"width\": %u,\n", xres);
+   fprintf(fd, "  \"height\": %u,\n", yres);
+   fprintf(fd, "  \"frames\": %u,\n", m_numFrames);
+
+   // palette conversion, in megapixels per second
+   fprintf(fd, "  \"palette_conversion_mps\": { \"loop\": %.1f",
+      MeasureThroughput([&]()
+         {
+            for (size_t index = 0; index < numPixels; index++)
+               texels[index] = palette[pixels[index]];
+         }));
+
+   for (Base::SimdKernel kernel : allKernels)
+   {
+      if (!Base::IsSimdKernelSupported(kernel))
+         continue;
+
+      fprintf(fd, ", \"%s\": %.1f", Base::GetSimdKernelName(kernel),
+         MeasureThroughput([&]()
+            {
+               PaletteConverter::Convert(kernel, pixels.data(), texels.data(), numPixels, palette.data());
+            }));
+   }
+
+   fprintf(fd, " },\n");
+
+   // transparent blit, in megapixels per second
+   fprintf(fd, "  \"transparent_blit_mps\": { \"loop\": %.1f",
+      MeasureThroughput([&]()
+         {
+            for (size_t index = 0; index < numPixels; index++)
+            {
+               Uint8 pixel = pixels[index];
+               if (pixel != 0)
+                  dest[index] = pixel;
+            }
+         }));
+
+   for (Base::SimdKernel kernel : allKernels)
+   {
+      if (!Base::IsSimdKernelSupported(kernel))
+         continue;
+
+      fprintf(fd, ", \"%s\": %.1f", Base::GetSimdKernelName(kernel),
+         MeasureThroughput([&]()
+            {
+               for (unsigned int y = 0; y < yres; y++)
+                  ImageBlitter::CopyTransparent(kernel, &pixels[y * xres], &dest[y * xres], xres);
+            }));
+   }
+
+   fprintf(fd, " }\n");
+   fprintf(fd, "}\n");
+
+   if (fd != stdout)
+      fclose(fd);
+}
+
+/// Calls the pixel function once for each warmup frame and then once for
+/// each measured frame, and only measures the latter.
+/// \param pixelFunc function that processes the whole pixel buffer once
+/// \return throughput, in megapixels per second
+double RenderBenchmark::MeasureThroughput(const std::function<void()>& pixelFunc) const
+{
+   for (unsigned int frameIndex = 0; frameIndex < m_numWarmupFrames; frameIndex++)
+      pixelFunc();
+
+   Uint64 start = SDL_GetPerformanceCounter();
+
+   for (unsigned int frameIndex = 0; frameIndex < m_numFrames; frameIndex++)
+      pixelFunc();
+
+   double seconds = static_cast<double>(SDL_GetPerformanceCounter() - start) /
+      SDL_GetPerformanceFrequency();
+
+   double megapixels = double(m_width) * m_height * m_numFrames / 1e6;
+   return seconds > 0.0 ? megapixels / seconds : 0.0;
+}
+
+int main(int argc, char* argv[])
+{
+   RenderBenchmark benchmark;
+   if (!benchmark.ParseArgs(argc, argv))
+      return 1;
+
+   return benchmark.Run() ? 0 : 1;
+}
@@ -39,6 +39,9 @@ const unsigned int c_mapOffsetX = 4;
 /// pixel Y offset for map
 const unsigned int c_mapOffsetY = 2;
 
+/// tile state of tiles that have to be redrawn
+const Uint16 c_invalidTileState = 0xffff;
+
 /// palette 0 indices for wall pixels
 const std::vector<Uint8> c_wallPaletteIndices = { 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48 };
 
@@ -106,21 +109,140 @@ void AutomapGenerator::DrawTiles(IndexedImage& image) const
    }
 }
 
+/// Redraws all tiles whose tile type or automap flag changed since the tile
+/// states were taken, and all tiles adjacent to them, since wall pixels of
+/// solid tiles and door pixels depend on the adjacent tiles. The pixels of
+/// redrawn tiles are restored from the background image first. When the
+/// tile states are empty, all tiles are drawn.
+/// \param image automap image to update
+/// \param backgroundImage image with blank map, e.g. to restore pixels of
+///        tiles that are undiscovered again, e.g. after loading a savegame
+/// \param tileStates tile states of all tiles at the time they were drawn;
+///        updated to the current tile states
+/// \return number of redrawn tiles
+unsigned int AutomapGenerator::UpdateTiles(IndexedImage& image,
+   const IndexedImage& backgroundImage, std::vector<Uint16>& tileStates) const
+{
+   if (tileStates.size() != 64 * 64)
+      tileStates.assign(64 * 64, c_invalidTileState);
+
+   std::array<bool, 64 * 64> isDirtyTile = {};
+   bool anyTileChanged = false;
+
+   for (unsigned int tileX = 0; tileX < 64; tileX++)
+   {
+      for (unsigned int tileY = 0; tileY < 64; tileY++)
+      {
+         Uint16 tileState = GetTileState(tileX, tileY);
+         Uint16& lastTileState = tileStates[tileY * 64 + tileX];
+
+         if (tileState == lastTileState)
+            continue;
+
+         lastTileState = tileState;
+         anyTileChanged = true;
+
+         // also mark adjacent tiles, wrapping around like FillOpenTilePixels()
+         isDirtyTile[tileY * 64 + tileX] = true;
+         isDirtyTile[tileY * 64 + (tileX + 1) % 64] = true;
+         isDirtyTile[tileY * 64 + (tileX + 63) % 64] = true;
+         isDirtyTile[((tileY + 1) % 64) * 64 + tileX] = true;
+         isDirtyTile[((tileY + 63) % 64) * 64 + tileX] = true;
+      }
+   }
+
+   if (!anyTileChanged)
+      return 0;
+
+   unsigned int numRedrawnTiles = 0;
+
+   for (unsigned int tileX = 0; tileX < 64; tileX++)
+   {
+      for (unsigned int tileY = 0; tileY < 64; tileY++)
+      {
+         if (!isDirtyTile[tileY * 64 + tileX])
+            continue;
+
+         unsigned int x = tileX * c_tileSize + c_mapOffsetX + 1;
+         unsigned int y = (63 - tileY) * c_tileSize + c_mapOffsetY + 1;
+
+         image.PasteRect(backgroundImage, x, y, c_tileSize, c_tileSize, x, y);
+
+         Underworld::AutomapFlag automapFlag = m_tilemap.GetTileInfo(tileX, tileY).m_automapFlag;
+         if (automapFlag != Underworld::AutomapFlag::automapUndiscovered)
+            DrawTile(image, tileX, tileY);
+
+         numRedrawnTiles++;
+      }
+   }
+
+   return numRedrawnTiles;
+}
+
 void AutomapGenerator::DrawMapNotes(IndexedImage& image, const Underworld::MapNotes& mapNotes) const
 {
    // TODO
 }
 
 void AutomapGenerator::DrawPlayerPin(IndexedImage& image, const Underworld::Player& player) const
+{
+   unsigned int xpos, ypos, width, height;
+   GetPlayerPinArea(player, xpos, ypos, width, height);
+
+   image.PasteImage(m_playerPinImage, xpos, ypos, true);
+}
+
+/// \param player player to draw the pin for
+/// \param xpos x position of pin
+/// \param ypos y position of pin
+/// \param width width of pin
+/// \param height height of pin
+void AutomapGenerator::GetPlayerPinArea(const Underworld::Player& player, unsigned int& xpos,
+   unsigned int& ypos, unsigned int& width, unsigned int& height) const
 {
    unsigned int playerX = static_cast<unsigned int>(player.GetXPos());
    unsigned int playerY = static_cast<unsigned int>(player.GetYPos());
 
-   image.PasteImage(
-      m_playerPinImage,
-      playerX * c_tileSize + c_mapOffsetX + 1,
-      (63 - playerY) * c_tileSize + c_mapOffsetY + 3 - m_playerPinImage.GetYRes(),
-      true);
+   xpos = playerX * c_tileSize + c_mapOffsetX + 1;
+   ypos = (63 - playerY) * c_tileSize + c_mapOffsetY + 3 - m_playerPinImage.GetYRes();
+   width = m_playerPinImage.GetXRes();
+   height = m_playerPinImage.GetYRes();
+}
+
+/// Invalidates the tile states of all tiles that overlap the given area, so
+/// that the next call to UpdateTiles() redraws them, e.g. after something
+/// was drawn over the tiles.
+/// \param tileStates tile states of all tiles at the time they were drawn
+/// \param xpos x position of area
+/// \param ypos y position of area
+/// \param width width of area
+/// \param height height of area
+void AutomapGenerator::InvalidateTiles(std::vector<Uint16>& tileStates, unsigned int xpos,
+   unsigned int ypos, unsigned int width, unsigned int height)
+{
+   if (tileStates.size() != 64 * 64)
+      return;
+
+   for (unsigned int tileX = 0; tileX < 64; tileX++)
+   {
+      for (unsigned int tileY = 0; tileY < 64; tileY++)
+      {
+         unsigned int x = tileX * c_tileSize + c_mapOffsetX + 1;
+         unsigned int y = (63 - tileY) * c_tileSize + c_mapOffsetY + 1;
+
+         if (x < xpos + width && x + c_tileSize > xpos &&
+            y < ypos + height && y + c_tileSize > ypos)
+            tileStates[tileY * 64 + tileX] = c_invalidTileState;
+      }
+   }
+}
+
+Uint16 AutomapGenerator::GetTileState(unsigned int tileX, unsigned int tileY) const
+{
+   const Underworld::TileInfo& tileInfo = m_tilemap.GetTileInfo(tileX, tileY);
+
+   return static_cast<Uint16>((static_cast<unsigned int>(tileInfo.m_type) << 8) |
+      static_cast<unsigned int>(tileInfo.m_automapFlag));
 }
 
 void AutomapGenerator::DrawTile(IndexedImage& image, unsigned int tileX, unsigned int tileY) const
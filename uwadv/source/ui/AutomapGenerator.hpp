@@ -22,6 +22,7 @@
 #pragma once
 
 #include "Font.hpp"
+#include "Tilemap.hpp"
 #include <array>
 
 class IndexedImage;
@@ -34,11 +35,8 @@ namespace Base
 
 namespace Underworld
 {
-   class Tilemap;
    class MapNotes;
    class Player;
-   enum TilemapTileType;
-   enum AutomapFlag;
 }
 
 namespace UI
@@ -58,13 +56,28 @@ namespace UI
       /// generates the automap image
       void DrawTiles(IndexedImage& image) const;
 
+      /// redraws all tiles that changed since the tile states were taken
+      unsigned int UpdateTiles(IndexedImage& image, const IndexedImage& backgroundImage,
+         std::vector<Uint16>& tileStates) const;
+
       /// draws all map notes
       void DrawMapNotes(IndexedImage& image, const Underworld::MapNotes& mapNotes) const;
 
       /// draws the player's pin
       void DrawPlayerPin(IndexedImage& image, const Underworld::Player& player) const;
 
+      /// returns image area covered by the player's pin
+      void GetPlayerPinArea(const Underworld::Player& player, unsigned int& xpos,
+         unsigned int& ypos, unsigned int& width, unsigned int& height) const;
+
+      /// invalidates tile states of all tiles in given image area
+      static void InvalidateTiles(std::vector<Uint16>& tileStates, unsigned int xpos,
+         unsigned int ypos, unsigned int width, unsigned int height);
+
    private:
+      /// returns tile state, combining tile type and automap flag
+      Uint16 GetTileState(unsigned int tileX, unsigned int tileY) const;
+
       /// draws single tile
       void DrawTile(IndexedImage& image, unsigned int tileX, unsigned int tileY) const;
 
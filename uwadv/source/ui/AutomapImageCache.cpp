@@ -0,0 +1,106 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file AutomapImageCache.cpp
+/// \brief cache for automap images
+//
+#include "pch.hpp"
+#include "AutomapImageCache.hpp"
+#include "AutomapGenerator.hpp"
+#include "ImageManager.hpp"
+
+using UI::AutomapImageCache;
+
+/// Updates the automap image of the level and swaps its pixels with the
+/// pixels of the given image, which must have the same size as the blank map
+/// image. When the level is displayed the first time, the image is created
+/// from the blank map image, and all tiles are drawn; later on, only changed
+/// tiles are redrawn. The map notes and the player pin are drawn on top.
+/// \param image image to show the automap image in
+/// \param generator automap generator for the level's tilemap
+/// \param imageManager image manager to load blank map image
+/// \param levelIndex index of level
+/// \param levelName level name
+/// \param mapNotes map notes of the level
+/// \param player player to draw the pin for; null when the player is in
+///        another level
+void AutomapImageCache::ShowLevelImage(IndexedImage& image, const AutomapGenerator& generator,
+   ImageManager& imageManager, size_t levelIndex, const std::string& levelName,
+   const Underworld::MapNotes& mapNotes, const Underworld::Player* player)
+{
+   UaAssert(m_shownLevel == c_noLevelShown);
+
+   if (m_blankMapImage.GetXRes() == 0)
+      imageManager.Load(m_blankMapImage, "data/blnkmap.byt", 0, 1, imageByt);
+
+   UaAssert(image.GetXRes() == m_blankMapImage.GetXRes() &&
+      image.GetYRes() == m_blankMapImage.GetYRes());
+
+   LevelImage& levelImage = m_allLevelImages[levelIndex];
+
+   if (levelImage.m_tileStates.empty())
+   {
+      levelImage.m_image = m_blankMapImage;
+      generator.DrawLevelNumber(levelImage.m_image, levelIndex, levelName);
+   }
+
+   generator.UpdateTiles(levelImage.m_image, m_blankMapImage, levelImage.m_tileStates);
+
+   // \todo restore the map notes area in ReturnLevelImage() when map notes are drawn
+   generator.DrawMapNotes(levelImage.m_image, mapNotes);
+
+   m_pinWidth = m_pinHeight = 0;
+   if (player != nullptr)
+   {
+      generator.GetPlayerPinArea(*player, m_pinX, m_pinY, m_pinWidth, m_pinHeight);
+      generator.DrawPlayerPin(levelImage.m_image, *player);
+   }
+
+   image.GetPixels().swap(levelImage.m_image.GetPixels());
+   m_shownLevel = levelIndex;
+}
+
+/// Swaps the pixels back into the cached automap image. The area covered by
+/// the player pin is restored from the blank map image, and the tiles below
+/// are redrawn the next time the automap image is shown.
+/// \param image image the automap image was shown in
+void AutomapImageCache::ReturnLevelImage(IndexedImage& image)
+{
+   if (m_shownLevel == c_noLevelShown)
+      return;
+
+   LevelImage& levelImage = m_allLevelImages[m_shownLevel];
+   m_shownLevel = c_noLevelShown;
+
+   image.GetPixels().swap(levelImage.m_image.GetPixels());
+
+   if (m_pinWidth > 0)
+   {
+      levelImage.m_image.PasteRect(m_blankMapImage, m_pinX, m_pinY,
+         m_pinWidth, m_pinHeight, m_pinX, m_pinY);
+
+      AutomapGenerator::InvalidateTiles(levelImage.m_tileStates,
+         m_pinX, m_pinY, m_pinWidth, m_pinHeight);
+   }
+}
+
+void AutomapImageCache::Clear()
+{
+   m_allLevelImages.clear();
+   m_shownLevel = c_noLevelShown;
+}
@@ -0,0 +1,96 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file AutomapImageCache.hpp
+/// \brief cache for automap images
+//
+#pragma once
+
+#include "IndexedImage.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+class ImageManager;
+
+namespace Underworld
+{
+   class MapNotes;
+   class Player;
+}
+
+namespace UI
+{
+   class AutomapGenerator;
+
+   /// \brief cache for automap images
+   /// Keeps the automap image of every level that was displayed, together
+   /// with the state of all tiles at the time they were drawn. When the
+   /// automap of a level is displayed again, only the tiles that changed in
+   /// the meantime, e.g. by revealing tiles while walking around, and their
+   /// adjacent tiles are redrawn. The image is shown by swapping its pixels
+   /// with the pixels of the screen's image, so it isn't copied.
+   class AutomapImageCache
+   {
+   public:
+      /// ctor
+      AutomapImageCache()
+         :m_shownLevel(c_noLevelShown),
+         m_pinX(0), m_pinY(0), m_pinWidth(0), m_pinHeight(0)
+      {
+      }
+
+      /// updates automap image of given level and swaps it into given image
+      void ShowLevelImage(IndexedImage& image, const AutomapGenerator& generator,
+         ImageManager& imageManager, size_t levelIndex, const std::string& levelName,
+         const Underworld::MapNotes& mapNotes, const Underworld::Player* player);
+
+      /// swaps the shown automap image back into the cache
+      void ReturnLevelImage(IndexedImage& image);
+
+      /// clears all cached automap images
+      void Clear();
+
+   private:
+      /// cached automap image of a single level
+      struct LevelImage
+      {
+         /// automap image, without map notes and player pin
+         IndexedImage m_image;
+
+         /// tile states of all tiles, at the time they were drawn
+         std::vector<Uint16> m_tileStates;
+      };
+
+      /// value for m_shownLevel when no automap image is shown
+      static const size_t c_noLevelShown = static_cast<size_t>(-1);
+
+      /// level index of the automap image that is currently shown
+      size_t m_shownLevel;
+
+      /// area covered by the player pin in the shown automap image
+      unsigned int m_pinX, m_pinY, m_pinWidth, m_pinHeight;
+
+      /// blank map image
+      IndexedImage m_blankMapImage;
+
+      /// cached automap images, by level index
+      std::map<size_t, LevelImage> m_allLevelImages;
+   };
+
+} // namespace UI
@@ -22,6 +22,14 @@
 #include "pch.hpp"
 #include "Cutscene.hpp"
 #include "CutsceneLoader.hpp"
+#include <SDL_thread.h>
+#include <SDL_mutex.h>
+
+namespace Detail
+{
+   /// number of frames the worker thread decodes ahead
+   const size_t c_numRingFrames = 4;
+}
 
 /*
 void Cutscene::Load(Base::Settings& settings, unsigned int main,
@@ -34,39 +42,90 @@ void Cutscene::Load(Base::Settings& settings, unsigned int main,
 }
 */
 
+Cutscene::Cutscene()
+   :m_numRecords(0),
+   m_currentFrame((unsigned int)-1),
+   m_isUploaded(false),
+   m_dirtyStart(0),
+   m_dirtyEnd(0),
+   m_workerThread(nullptr),
+   m_lock(SDL_CreateMutex()),
+   m_ringCondition(SDL_CreateCond()),
+   m_stopWorker(false),
+   m_ringStart(0),
+   m_ringCount(0),
+   m_nextDecodeFrame(0),
+   m_decodeGeneration(0)
+{
+}
+
+Cutscene::~Cutscene()
+{
+   StopWorker();
+
+   SDL_DestroyCond(m_ringCondition);
+   SDL_DestroyMutex(m_lock);
+}
+
 void Cutscene::Load(Base::ResourceManager& resourceManager, const char* relativeFilename)
 {
+   StopWorker();
+
    Import::CutsceneLoader::LoadCutscene(
       resourceManager, relativeFilename,
       m_image, m_largePageDescriptorList, m_largePages, m_numRecords);
 
    m_currentFrame = (unsigned int)-1;
+   m_isUploaded = false;
+   m_dirtyStart = m_dirtyEnd = 0;
+
+   StartWorker();
+}
+
+void Cutscene::Destroy()
+{
+   StopWorker();
+
+   ImageQuad::Destroy();
 }
 
+/// Advances the image to the given frame and uploads the area of the image
+/// that changed since the last call. When the frame number is smaller than
+/// the current frame, decoding starts again from the first frame.
+/// \param frameNumber frame number to show
 void Cutscene::UpdateFrame(unsigned int frameNumber)
 {
    if (m_currentFrame != frameNumber)
-   {
-      // when we are at the max, start again from the first
-      if (m_currentFrame > frameNumber)
-      {
-         m_currentFrame = 0;
-         DecodeFrame(0);
-      }
+      AdvanceToFrame(frameNumber);
 
-      // decode all frames between the current and the wanted frame
-      while (m_currentFrame < frameNumber)
-      {
-         m_currentFrame++;
-         DecodeFrame(m_currentFrame);
-      }
+   // update image quad
+   if (!m_isUploaded)
+   {
+      Update();
+      m_isUploaded = true;
+   }
+   else if (m_dirtyEnd > m_dirtyStart)
+   {
+      // upload all lines that contain changed pixels
+      unsigned int xres = m_image.GetXRes();
+      unsigned int firstLine = m_dirtyStart / xres;
+      unsigned int lastLine = (m_dirtyEnd - 1) / xres;
+
+      if (firstLine == lastLine)
+         UpdateRect(m_dirtyStart % xres, firstLine, m_dirtyEnd - m_dirtyStart, 1);
+      else
+         UpdateRect(0, firstLine, xres, lastLine - firstLine + 1);
    }
 
-   // update image quad
-   Update();
+   m_dirtyStart = m_dirtyEnd = 0;
 }
 
-void Cutscene::DecodeFrame(unsigned int frameNumber)
+/// \param frameNumber frame number to decode
+/// \param pixels pixels of the previous frame; the frame is decoded into it
+/// \param dirtyStart returns index of first changed pixel
+/// \param dirtyEnd returns index after the last changed pixel
+void Cutscene::DecodeFrame(unsigned int frameNumber, Uint8* pixels,
+   unsigned int& dirtyStart, unsigned int& dirtyEnd) const
 {
    size_t largepages = m_largePageDescriptorList.size();
 
@@ -81,8 +140,8 @@ void Cutscene::DecodeFrame(unsigned int frameNumber)
       throw Base::Exception("could not find frame in large pages");
 
    // calculate large page pointer
-   Uint16* curlp16 = reinterpret_cast<Uint16*>(&m_largePages[0x10000 * i]);
-   Uint8* curlp = reinterpret_cast<Uint8*>(curlp16);
+   const Uint16* curlp16 = reinterpret_cast<const Uint16*>(&m_largePages[0x10000 * i]);
+   const Uint8* curlp = reinterpret_cast<const Uint8*>(curlp16);
 
    unsigned int destframe = frameNumber - m_largePageDescriptorList[i].m_base;
 
@@ -97,18 +156,207 @@ void Cutscene::DecodeFrame(unsigned int frameNumber)
 #endif
 
    // calculate start of "record" struct
-   Uint8* src = curlp + 8 + m_largePageDescriptorList[i].m_records * 2 + offset;
-   Uint16* src16 = reinterpret_cast<Uint16*>(src);
+   const Uint8* src = curlp + 8 + m_largePageDescriptorList[i].m_records * 2 + offset;
+   const Uint16* src16 = reinterpret_cast<const Uint16*>(src);
 
    // add extra offset
    if (src[1])
       src += (src16[1] + (src16[1] & 1));
 
    // extract the pixel data
-   Import::CutsceneLoader::ExtractCutsceneData(&src[4], &m_image.GetPixels()[0],
-      m_image.GetXRes() * m_image.GetYRes());
+   Import::CutsceneLoader::ExtractCutsceneData(const_cast<Uint8*>(&src[4]), pixels,
+      static_cast<unsigned int>(m_decodePixels.size()), dirtyStart, dirtyEnd);
+}
+
+/// Takes decoded frames from the ring until the wanted frame is reached,
+/// waiting for the worker thread when necessary. The frames in the ring are
+/// consecutive, wrapping around to the first frame after the last one. When
+/// no worker thread is running, the frames are decoded directly.
+/// \param frameNumber frame number to advance to
+void Cutscene::AdvanceToFrame(unsigned int frameNumber)
+{
+   if (frameNumber >= m_numRecords)
+   {
+      UaAssertMsg(false, "invalid cutscene frame number");
+      return;
+   }
+
+   // when jumping back, start again from the first frame; after the last
+   // frame, the worker already continues with the first frame
+   bool restart = m_currentFrame != (unsigned int)-1 &&
+      m_currentFrame > frameNumber &&
+      m_currentFrame + 1 != m_numRecords;
+
+   if (m_workerThread == nullptr)
+   {
+      if (restart || m_currentFrame + 1 == m_numRecords)
+         m_currentFrame = (unsigned int)-1;
+
+      // decode all frames between the current and the wanted frame
+      while (m_currentFrame != frameNumber)
+      {
+         m_currentFrame++;
+
+         unsigned int dirtyStart = 0, dirtyEnd = 0;
+         DecodeFrame(m_currentFrame, m_image.GetPixels().data(), dirtyStart, dirtyEnd);
+         AddDirtyRange(dirtyStart, dirtyEnd);
+      }
+
+      return;
+   }
+
+   SDL_LockMutex(m_lock);
+
+   if (restart)
+   {
+      m_ringStart = 0;
+      m_ringCount = 0;
+      m_nextDecodeFrame = 0;
+      m_decodeGeneration++;
+
+      // the worker's pixels may be ahead of the current image
+      AddDirtyRange(0, static_cast<unsigned int>(m_image.GetPixels().size()));
+
+      SDL_CondBroadcast(m_ringCondition);
+   }
+
+   do
+   {
+      while (m_ringCount == 0)
+         SDL_CondWait(m_ringCondition, m_lock);
+
+      DecodedFrame& decodedFrame = m_ring[m_ringStart];
+
+      // swap pixels; the worker overwrites the old image pixels in place
+      std::swap(m_image.GetPixels(), decodedFrame.m_pixels);
+      AddDirtyRange(decodedFrame.m_dirtyStart, decodedFrame.m_dirtyEnd);
+      m_currentFrame = decodedFrame.m_frameNumber;
+
+      m_ringStart = (m_ringStart + 1) % m_ring.size();
+      m_ringCount--;
+
+      SDL_CondBroadcast(m_ringCondition);
+
+   } while (m_currentFrame != frameNumber);
+
+   SDL_UnlockMutex(m_lock);
+}
+
+/// \param dirtyStart index of first changed pixel
+/// \param dirtyEnd index after the last changed pixel
+void Cutscene::AddDirtyRange(unsigned int dirtyStart, unsigned int dirtyEnd)
+{
+   if (dirtyEnd <= dirtyStart)
+      return;
+
+   if (m_dirtyEnd <= m_dirtyStart)
+   {
+      m_dirtyStart = dirtyStart;
+      m_dirtyEnd = dirtyEnd;
+   }
+   else
+   {
+      m_dirtyStart = std::min(m_dirtyStart, dirtyStart);
+      m_dirtyEnd = std::max(m_dirtyEnd, dirtyEnd);
+   }
+}
+
+void Cutscene::StartWorker()
+{
+   if (m_numRecords == 0)
+      return;
+
+   size_t numPixels = m_image.GetPixels().size();
+
+   m_decodePixels = m_image.GetPixels();
+
+   m_ring.resize(Detail::c_numRingFrames);
+   for (DecodedFrame& decodedFrame : m_ring)
+      decodedFrame.m_pixels.resize(numPixels);
+
+   m_ringStart = 0;
+   m_ringCount = 0;
+   m_nextDecodeFrame = 0;
+   m_stopWorker = false;
+
+   m_workerThread = SDL_CreateThread(ThreadProc, "cutscene-thread", this);
+
+   if (m_workerThread == nullptr)
+      UaTrace("cutscene: couldn't start worker thread, decoding frames on the calling thread\n");
+}
+
+void Cutscene::StopWorker()
+{
+   if (m_workerThread == nullptr)
+      return;
+
+   SDL_LockMutex(m_lock);
+   m_stopWorker = true;
+   SDL_CondBroadcast(m_ringCondition);
+   SDL_UnlockMutex(m_lock);
+
+   SDL_WaitThread(m_workerThread, nullptr);
+   m_workerThread = nullptr;
 }
 
+int Cutscene::ThreadProc(void* param)
+{
+   Cutscene* cutscene = reinterpret_cast<Cutscene*>(param);
+   cutscene->RunWorker();
+   return 0;
+}
+
+/// Decodes the next frame while there's space in the ring. The large pages
+/// aren't modified while the worker is running, so frames are decoded
+/// without holding the lock.
+void Cutscene::RunWorker()
+{
+   SDL_LockMutex(m_lock);
+
+   while (!m_stopWorker)
+   {
+      if (m_ringCount == m_ring.size())
+      {
+         SDL_CondWait(m_ringCondition, m_lock);
+         continue;
+      }
+
+      unsigned int frameNumber = m_nextDecodeFrame;
+      unsigned int decodeGeneration = m_decodeGeneration;
+
+      SDL_UnlockMutex(m_lock);
+
+      unsigned int dirtyStart = 0, dirtyEnd = 0;
+      try
+      {
+         DecodeFrame(frameNumber, m_decodePixels.data(), dirtyStart, dirtyEnd);
+      }
+      catch (const Base::Exception& ex)
+      {
+         // still pass on the frame, so that UpdateFrame() doesn't wait forever
+         UaTrace("cutscene: error decoding frame %u: %s\n", frameNumber, ex.what());
+      }
+
+      SDL_LockMutex(m_lock);
+
+      // drop frame when decoding was restarted in the meantime
+      if (decodeGeneration != m_decodeGeneration)
+         continue;
+
+      DecodedFrame& decodedFrame = m_ring[(m_ringStart + m_ringCount) % m_ring.size()];
+      decodedFrame.m_frameNumber = frameNumber;
+      decodedFrame.m_pixels.assign(m_decodePixels.begin(), m_decodePixels.end());
+      decodedFrame.m_dirtyStart = dirtyStart;
+      decodedFrame.m_dirtyEnd = dirtyEnd;
+
+      m_ringCount++;
+      m_nextDecodeFrame = frameNumber + 1 < m_numRecords ? frameNumber + 1 : 0;
+
+      SDL_CondBroadcast(m_ringCondition);
+   }
+
+   SDL_UnlockMutex(m_lock);
+}
 
 #ifdef PROFILING_CUTSCENE
 
@@ -25,6 +25,10 @@
 #include "ImageQuad.hpp"
 #include "Texture.hpp"
 
+struct SDL_Thread;
+struct SDL_mutex;
+struct SDL_cond;
+
 namespace Base
 {
    class ResourceManager;
@@ -39,15 +43,23 @@ struct LargePageDescriptor
 };
 
 /// \brief cutscene animation class
+/// Frames are decoded ahead on a worker thread into a small ring of frames,
+/// so that decoding doesn't stall rendering. Since each frame only contains
+/// the changes to the previous frame, only the changed area of the image is
+/// uploaded to the texture.
 /// \note initialize via ImageQuad::Init(); before or after loading
 class Cutscene : public ImageQuad
 {
 public:
    /// ctor
-   Cutscene()
-   {
-      m_currentFrame = (unsigned int)-1;
-   }
+   Cutscene();
+   /// dtor; stops worker thread
+   virtual ~Cutscene();
+
+   /// deleted copy ctor
+   Cutscene(const Cutscene&) = delete;
+   /// deleted assignment operator
+   Cutscene& operator=(const Cutscene&) = delete;
 
    /// loads a cutscene by relative filename
    void Load(Base::ResourceManager& resourceManager, const char* relativeFilename);
@@ -58,11 +70,49 @@ public:
    /// extracts a new frame into the current image
    void UpdateFrame(unsigned int frameNumber);
 
+   // virtual functions from Window
+   virtual void Destroy() override;
+
 protected:
-   /// decodes one frame
-   void DecodeFrame(unsigned int frameNumber);
+   /// decodes one frame into given pixels, returning the range of changed pixels
+   void DecodeFrame(unsigned int frameNumber, Uint8* pixels,
+      unsigned int& dirtyStart, unsigned int& dirtyEnd) const;
+
+   /// advances current image to given frame, using the frames of the worker thread
+   void AdvanceToFrame(unsigned int frameNumber);
+
+   /// adds range of changed pixels to the dirty range
+   void AddDirtyRange(unsigned int dirtyStart, unsigned int dirtyEnd);
+
+   /// starts worker thread decoding frames
+   void StartWorker();
+
+   /// stops worker thread
+   void StopWorker();
+
+   /// worker thread procedure
+   static int ThreadProc(void* param);
+
+   /// decodes frames until stopped
+   void RunWorker();
 
 protected:
+   /// frame decoded by the worker thread
+   struct DecodedFrame
+   {
+      /// frame number
+      unsigned int m_frameNumber = 0;
+
+      /// frame pixels
+      std::vector<Uint8> m_pixels;
+
+      /// index of first pixel that changed compared to the previous frame
+      unsigned int m_dirtyStart = 0;
+
+      /// index after the last pixel that changed
+      unsigned int m_dirtyEnd = 0;
+   };
+
    /// number of records in file
    unsigned int m_numRecords;
 
@@ -74,4 +124,43 @@ protected:
 
    /// all large pages
    std::vector<Uint8> m_largePages;
+
+   /// indicates if the texture was uploaded since loading
+   bool m_isUploaded;
+
+   /// index of first pixel that changed since the last upload
+   unsigned int m_dirtyStart;
+
+   /// index after the last pixel that changed since the last upload
+   unsigned int m_dirtyEnd;
+
+   /// worker thread; null when frames are decoded on the calling thread
+   SDL_Thread* m_workerThread;
+
+   /// lock for all members that are shared with the worker thread
+   SDL_mutex* m_lock;
+
+   /// condition that is signaled when a frame was decoded or taken from the ring
+   SDL_cond* m_ringCondition;
+
+   /// indicates if the worker thread should stop
+   bool m_stopWorker;
+
+   /// ring of decoded frames
+   std::vector<DecodedFrame> m_ring;
+
+   /// index of the oldest decoded frame in the ring
+   size_t m_ringStart;
+
+   /// number of decoded frames in the ring
+   size_t m_ringCount;
+
+   /// number of the next frame the worker thread decodes
+   unsigned int m_nextDecodeFrame;
+
+   /// counts restarts of decoding; frames decoded before a restart are dropped
+   unsigned int m_decodeGeneration;
+
+   /// pixels the worker thread decodes frames into; only used by the worker
+   std::vector<Uint8> m_decodePixels;
 };
@@ -34,33 +34,44 @@
 #include <cstring>
 
 Font::Font()
-   :m_charSize(0),
+   :m_fontId(fontNormal),
+   m_charSize(0),
    m_spaceWidth(0),
    m_charHeight(0),
    m_rowWidth(0),
    m_maxWidth(0),
    m_numChars(0)
 {
+   std::fill(std::begin(m_charWidths), std::end(m_charWidths), Uint16(0));
 }
 
-unsigned int Font::CalcLength(const std::string& text) const
+/// Determines the width of every char once, so that calculating the length
+/// of a string only needs a table lookup per char, and converts the glyph
+/// pixels to masks.
+void Font::PrepareGlyphs()
 {
-   unsigned int width = 0;
-   size_t len = text.length();
-
-   for (size_t i = 0; i < len; i++)
+   for (unsigned int ch = 0; ch < 256; ch++)
    {
-      // count length for each char
-      unsigned char ch = static_cast<unsigned char>(text[i]);
-
       if (ch >= m_numChars)
-         width += m_maxWidth;
+         m_charWidths[ch] = m_maxWidth;
       else if (ch == 0x20)
-         width += m_spaceWidth;
+         m_charWidths[ch] = m_spaceWidth;
       else
-         width += m_charLengths[ch];
+         m_charWidths[ch] = m_charLengths[ch];
    }
 
+   m_glyphMasks.resize(m_fontData.size());
+   for (size_t index = 0; index < m_fontData.size(); index++)
+      m_glyphMasks[index] = m_fontData[index] == 1 ? 0xff : 0x00;
+}
+
+unsigned int Font::CalcLength(const std::string& text) const
+{
+   unsigned int width = 0;
+
+   for (char ch : text)
+      width += GetCharWidth(ch);
+
    return width;
 }
 
@@ -91,14 +102,16 @@ void Font::CreateString(IndexedImage& image, const std::string& text,
          }
 
          unsigned int clen = m_charLengths[ch];
+         const Uint8* glyph = &m_glyphMasks[ch * m_charHeight * m_maxWidth];
 
          for (unsigned int y = 0; y < m_charHeight; y++)
+         {
+            const Uint8* mask = &glyph[y * m_maxWidth];
+            Uint8* dest = &pixels[y * width + pos];
+
             for (unsigned int x = 0; x < clen; x++)
-            {
-               bool pixset =
-                  m_fontData[ch * m_charHeight * m_maxWidth + y * m_maxWidth + x] == 1;
-               pixels[y * width + x + pos] = pixset ? foregroundIndex : 0;
-            }
+               dest[x] = mask[x] & foregroundIndex;
+         }
 
          pos += clen;
       }
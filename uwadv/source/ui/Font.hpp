@@ -58,9 +58,18 @@ public:
    /// loads a font
    void Load(Base::ResourceManager& resourceManager, FontId fontId);
 
+   /// returns id of loaded font
+   FontId GetFontId() const { return m_fontId; }
+
    /// returns height of chars in pixels
    unsigned int GetCharHeight() const { return m_charHeight; }
 
+   /// returns width of a single char in pixels
+   unsigned int GetCharWidth(char ch) const
+   {
+      return m_charWidths[static_cast<unsigned char>(ch)];
+   }
+
    /// calculates and returns length of string in pixel
    unsigned int CalcLength(const std::string& text) const;
 
@@ -71,9 +80,23 @@ public:
 protected:
    friend Import::FontLoader;
 
+   /// prepares char widths and glyph masks after loading
+   void PrepareGlyphs();
+
+   /// id of loaded font
+   FontId m_fontId;
+
    /// font data
    std::vector<Uint8> m_fontData;
 
+   /// glyph pixels, with the same layout as m_fontData, but with 0xff for
+   /// solid pixels, so that a foreground index can be masked with it
+   std::vector<Uint8> m_glyphMasks;
+
+   /// width of every possible char, in pixels, including space and chars
+   /// not in the font
+   Uint16 m_charWidths[256];
+
    /// length info for every char in font
    std::vector<Uint8> m_charLengths;
 
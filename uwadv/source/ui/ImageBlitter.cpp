@@ -0,0 +1,126 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ImageBlitter.cpp
+/// \brief palette-indexed pixel blitting
+//
+#include "pch.hpp"
+#include "ImageBlitter.hpp"
+
+namespace Detail
+{
+   /// copies pixels using a plain scalar loop
+   void CopyTransparentScalar(const Uint8* source, Uint8* dest, size_t numPixels)
+   {
+      for (size_t index = 0; index < numPixels; index++)
+      {
+         Uint8 pixel = source[index];
+         if (pixel != 0)
+            dest[index] = pixel;
+      }
+   }
+
+#ifdef HAVE_X86_INTRINSICS
+   /// copies pixels using SSE2; source and dest pixels are blended using a
+   /// mask of the transparent source pixels
+   void CopyTransparentSSE2(const Uint8* source, Uint8* dest, size_t numPixels)
+   {
+      size_t index = 0;
+      size_t numBlocks = numPixels & ~size_t(15);
+
+      __m128i zero = _mm_setzero_si128();
+
+      for (; index < numBlocks; index += 16)
+      {
+         __m128i sourcePixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+         __m128i destPixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dest + index));
+
+         // keep dest pixels where the source pixel is transparent
+         __m128i mask = _mm_cmpeq_epi8(sourcePixels, zero);
+         __m128i value = _mm_or_si128(
+            _mm_and_si128(mask, destPixels),
+            _mm_andnot_si128(mask, sourcePixels));
+
+         _mm_storeu_si128(reinterpret_cast<__m128i*>(dest + index), value);
+      }
+
+      CopyTransparentScalar(source + index, dest + index, numPixels - index);
+   }
+
+   /// copies pixels using AVX2, blending source and dest pixels with a
+   /// single blend instruction
+   TARGET_AVX2
+   void CopyTransparentAVX2(const Uint8* source, Uint8* dest, size_t numPixels)
+   {
+      size_t index = 0;
+      size_t numBlocks = numPixels & ~size_t(31);
+
+      __m256i zero = _mm256_setzero_si256();
+
+      for (; index < numBlocks; index += 32)
+      {
+         __m256i sourcePixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + index));
+         __m256i destPixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dest + index));
+
+         // keep dest pixels where the source pixel is transparent
+         __m256i mask = _mm256_cmpeq_epi8(sourcePixels, zero);
+         __m256i value = _mm256_blendv_epi8(sourcePixels, destPixels, mask);
+
+         _mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + index), value);
+      }
+
+      CopyTransparentScalar(source + index, dest + index, numPixels - index);
+   }
+#endif
+
+} // namespace Detail
+
+/// \param source source pixels
+/// \param dest destination pixels; must not overlap with the source pixels
+/// \param numPixels number of pixels to copy
+void ImageBlitter::CopyTransparent(const Uint8* source, Uint8* dest, size_t numPixels)
+{
+   CopyTransparent(Base::GetBestSimdKernel(), source, dest, numPixels);
+}
+
+/// Copies pixels using the given kernel. The kernel must be supported by the
+/// CPU; check with Base::IsSimdKernelSupported() first.
+/// \param kernel kernel to use for copying
+/// \param source source pixels
+/// \param dest destination pixels; must not overlap with the source pixels
+/// \param numPixels number of pixels to copy
+void ImageBlitter::CopyTransparent(Base::SimdKernel kernel, const Uint8* source, Uint8* dest,
+   size_t numPixels)
+{
+   switch (kernel)
+   {
+#ifdef HAVE_X86_INTRINSICS
+   case Base::kernelSSE2:
+      Detail::CopyTransparentSSE2(source, dest, numPixels);
+      break;
+
+   case Base::kernelAVX2:
+      Detail::CopyTransparentAVX2(source, dest, numPixels);
+      break;
+#endif
+
+   default:
+      Detail::CopyTransparentScalar(source, dest, numPixels);
+      break;
+   }
+}
@@ -0,0 +1,42 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ImageBlitter.hpp
+/// \brief palette-indexed pixel blitting
+//
+#pragma once
+
+#include "CpuFeatures.hpp"
+
+/// \brief Copies palette-indexed pixels, omitting transparent pixels
+/// The transparent copy has several kernels, using SSE2 instructions to blend
+/// 16 pixels at once or AVX2 instructions to blend 32 pixels at once, when
+/// available, or a plain scalar loop. The best kernel for the current CPU is
+/// selected at runtime, using Base::GetBestSimdKernel(). All kernels produce
+/// the same result. Opaque copies and fills use memcpy() and memset(), which
+/// are already vectorized by the C runtime.
+class ImageBlitter
+{
+public:
+   /// copies pixels, omitting pixels with index 0, using the best available kernel
+   static void CopyTransparent(const Uint8* source, Uint8* dest, size_t numPixels);
+
+   /// copies pixels, omitting pixels with index 0, using given kernel
+   static void CopyTransparent(Base::SimdKernel kernel, const Uint8* source, Uint8* dest,
+      size_t numPixels);
+};
@@ -23,6 +23,7 @@
 #include "ImageQuad.hpp"
 #include "Renderer.hpp"
 #include "ImageManager.hpp"
+#include "ImageQuadAtlas.hpp"
 
 /// \brief Does image quad initialisation; Window::create() is called and needed
 /// texture(s) are init'ed. When there's no palette for the image yet, palette
@@ -40,7 +41,15 @@ void ImageQuad::Init(IGame& game, unsigned int xpos,
    if (m_image.GetPalette().get() == NULL)
       m_image.SetPalette(game.GetImageManager().GetPalette(0));
 
-   m_texture.Init(1);
+   if (m_atlas != nullptr && !m_atlas->IsAvailable())
+      m_atlas = nullptr;
+
+   m_atlasSlot = -1;
+   if (m_atlas == nullptr)
+      m_texture.Init(1);
+
+   m_isTextureValid = false;
+   m_isUpdatePending = false;
 
    m_smoothUI = game.GetSettings().GetBool(Base::settingUISmooth);
 }
@@ -84,14 +93,64 @@ void ImageQuad::AddBorder(IndexedImage& borderImage)
 }
 
 /// Updates image quad texture(s) with changes from the quad image available
-/// through GetImage(). The method determines if the texture will get larger
-/// than 256 in height or width and uses a split-texture approach then. This
-/// is required for older cards that only support textures up to 256x256.
+/// through GetImage(). When only an area of the image changed since the last
+/// update, the area is converted and uploaded in the next Draw(), combined
+/// with all other changes until then. Otherwise the whole image is uploaded
+/// immediately.
 void ImageQuad::Update()
+{
+   if (CanUpdatePartially())
+   {
+      m_isUpdatePending = true;
+      return;
+   }
+
+   UpdateAll();
+}
+
+/// Returns if the texture can be updated with only the changed area of the
+/// image; this isn't possible when the image size or the palette changed
+/// since the last full update, or when a split-texture is used.
+bool ImageQuad::CanUpdatePartially()
+{
+   if (!m_isTextureValid || m_splitTextures ||
+      m_windowWidth != m_image.GetXRes() ||
+      m_windowHeight != m_image.GetYRes())
+      return false;
+
+   Palette256Ptr palette = m_image.GetPalette();
+   return palette != nullptr &&
+      m_texturePalette.size() == 256 * 4 &&
+      memcmp(m_texturePalette.data(), palette->Get(), 256 * 4) == 0;
+}
+
+/// The method determines if the texture will get larger than 256 in height
+/// or width and uses a split-texture approach then. This is required for
+/// older cards that only support textures up to 256x256. Images stored in an
+/// atlas are never split.
+void ImageQuad::UpdateAll()
 {
    m_windowWidth = m_image.GetXRes();
    m_windowHeight = m_image.GetYRes();
 
+   if (m_atlas != nullptr)
+   {
+      if (UpdateAtlasSlot())
+      {
+         m_splitTextures = false;
+         FinishUpdateAll();
+         return;
+      }
+
+      // atlas is full; use own texture from now on
+      UaTrace("image quad: %ux%u image doesn't fit into atlas, using own texture\n",
+         m_windowWidth, m_windowHeight);
+
+      m_atlas = nullptr;
+      m_atlasSlot = -1;
+      m_texture.Init(1);
+   }
+
    m_splitTextures = m_windowWidth > 254;
 
    if (m_splitTextures)
@@ -143,18 +202,104 @@ void ImageQuad::Update()
       m_texture.Convert(m_image);
       m_texture.Upload(0);
    }
+
+   FinishUpdateAll();
+}
+
+/// Converts the whole image into its atlas slot. A new slot is allocated
+/// when the image size changed, e.g. after adding a border.
+/// \return false when the image doesn't fit into the atlas anymore
+bool ImageQuad::UpdateAtlasSlot()
+{
+   if (m_atlasSlot < 0 ||
+      !m_atlas->IsSlotSize(m_atlasSlot, m_image.GetXRes(), m_image.GetYRes()))
+   {
+      m_atlasSlot = m_atlas->AllocateSlot(m_image.GetXRes(), m_image.GetYRes());
+      if (m_atlasSlot < 0)
+         return false;
+   }
+
+   m_atlas->UpdateSlot(m_atlasSlot, m_image, 0, 0, m_image.GetXRes(), m_image.GetYRes());
+   return true;
+}
+
+void ImageQuad::FinishUpdateAll()
+{
+   m_isTextureValid = true;
+   m_isUpdatePending = false;
+   m_image.ClearDirtyRect();
+
+   Palette256Ptr palette = m_image.GetPalette();
+   if (palette != nullptr)
+      m_texturePalette.assign(palette->Get(), palette->Get() + 256 * 4);
+   else
+      m_texturePalette.clear();
+}
+
+/// Updates only a rectangular area of the image quad texture, e.g. when only
+/// a part of an animation frame has changed. When the image size or the
+/// palette changed since the last full update, or a split-texture is used,
+/// the whole texture is updated instead.
+/// \param xpos x position of changed area, in image coordinates
+/// \param ypos y position of changed area
+/// \param width width of changed area
+/// \param height height of changed area
+void ImageQuad::UpdateRect(unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height)
+{
+   if (!CanUpdatePartially())
+   {
+      UpdateAll();
+      return;
+   }
+
+   if (m_atlas != nullptr)
+   {
+      m_atlas->UpdateSlot(m_atlasSlot, m_image, xpos, ypos, width, height);
+      return;
+   }
+
+   m_texture.ConvertRect(m_image, xpos, ypos, width, height);
+   m_texture.UploadRect(xpos, ypos, width, height);
 }
 
 /// Cleans up texture(s) used for rendering the image quad.
 void ImageQuad::Destroy()
 {
    m_texture.Done();
+   m_atlasSlot = -1;
+   m_isTextureValid = false;
+   m_isUpdatePending = false;
 }
 
 /// Draws the image quad. The method takes into account if a border was added
-/// with AddBorder(), and if a split-texture has to be used.
+/// with AddBorder(), and if a split-texture has to be used. Image quads
+/// stored in an atlas only queue their quad; it's drawn by the atlas.
 void ImageQuad::Draw()
 {
+   if (m_isUpdatePending)
+   {
+      m_isUpdatePending = false;
+
+      if (m_image.IsDirty())
+      {
+         unsigned int xpos, ypos, width, height;
+         m_image.GetDirtyRect(xpos, ypos, width, height);
+
+         UpdateRect(xpos, ypos, width, height);
+         m_image.ClearDirtyRect();
+      }
+   }
+
+   if (m_atlas != nullptr)
+   {
+      if (m_isTextureValid)
+         m_atlas->AddQuad(m_atlasSlot, m_windowXPos, m_windowYPos,
+            m_windowWidth, m_windowHeight, m_hasBorder);
+
+      return;
+   }
+
    double u = m_texture.GetTexU(), v = m_texture.GetTexV();
    m_texture.Use(0);
 
@@ -26,6 +26,8 @@
 #include "IndexedImage.hpp"
 #include "Texture.hpp"
 
+class ImageQuadAtlas;
+
 /// \brief image quad class
 /// The ImageQuad class is a Window that draws an IndexedImage on an OpenGL
 /// screen managed by Screen. It supports images up to 320x200 (the
@@ -36,13 +38,27 @@
 /// GetImage().
 /// The settings value in settingUISmooth determines if the image quad is
 /// drawn using smooth (filtered) pixels.
+/// Update() only converts and uploads the area of the image that changed, as
+/// recorded in the image's dirty rectangle. All updates up to the next
+/// Draw() are combined into a single upload.
+/// When an ImageQuadAtlas is set with SetAtlas(), the image is stored in the
+/// atlas texture instead, and drawn together with all other image quads of
+/// the atlas.
 class ImageQuad : public Window
 {
 public:
    /// ctor
    ImageQuad()
-      :m_splitTextures(false), m_hasBorder(false)
+      :m_splitTextures(false), m_hasBorder(false),
+      m_isTextureValid(false), m_isUpdatePending(false),
+      m_atlas(nullptr), m_atlasSlot(-1)
+   {
+   }
+
+   /// sets atlas to store and draw image in; must be called before Init()
+   virtual void SetAtlas(ImageQuadAtlas* atlas)
    {
+      m_atlas = atlas;
    }
 
    /// initializes image quad window
@@ -60,10 +76,27 @@ public:
    /// updates internal texture when image was changed
    void Update();
 
+   /// updates internal texture when only an area of the image was changed
+   void UpdateRect(unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height);
+
    // virtual functions from Window
    virtual void Destroy() override;
    virtual void Draw() override;
 
+private:
+   /// returns if the texture can be updated with only the changed area
+   bool CanUpdatePartially();
+
+   /// converts and uploads the whole image
+   void UpdateAll();
+
+   /// converts the whole image into the atlas; returns false when it's full
+   bool UpdateAtlasSlot();
+
+   /// remembers the state of the converted image after a full update
+   void FinishUpdateAll();
+
 protected:
    /// the image to draw
    IndexedImage m_image;
@@ -79,4 +112,19 @@ protected:
 
    /// indicates if images are drawn using smooth (filtered) pixels
    bool m_smoothUI;
+
+   /// indicates if the texture contains the whole converted image
+   bool m_isTextureValid;
+
+   /// indicates if the changed area of the image is uploaded in the next Draw()
+   bool m_isUpdatePending;
+
+   /// palette the texture was converted with
+   std::vector<Uint8> m_texturePalette;
+
+   /// atlas the image is stored in; null when using an own texture
+   ImageQuadAtlas* m_atlas;
+
+   /// slot index of the image in the atlas; -1 when not allocated yet
+   int m_atlasSlot;
 };
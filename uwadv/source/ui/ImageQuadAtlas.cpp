@@ -0,0 +1,229 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ImageQuadAtlas.cpp
+/// \brief atlas texture for image quads
+//
+#include "pch.hpp"
+#include "ImageQuadAtlas.hpp"
+#include "IndexedImage.hpp"
+
+namespace Detail
+{
+   /// width and height of the atlas texture; holds the 320x200 background
+   /// image and all controls of the ingame screen
+   const unsigned int c_atlasSize = 512;
+
+   /// padding between slots; keeps filtered pixels from bleeding into
+   /// neighbouring images
+   const unsigned int c_slotPadding = 1;
+}
+
+ImageQuadAtlas::ImageQuadAtlas()
+   :m_isAvailable(false),
+   m_smoothUI(false),
+   m_packer(Detail::c_atlasSize, Detail::c_atlasSize, Detail::c_slotPadding),
+   m_isDirty(false),
+   m_dirtyX0(0),
+   m_dirtyY0(0),
+   m_dirtyX1(0),
+   m_dirtyY1(0)
+{
+}
+
+/// Creates and uploads the empty atlas texture. The atlas isn't available
+/// when the maximum texture size is too small for it; image quads then use
+/// their own textures.
+/// \param game reference to game interface
+void ImageQuadAtlas::Init(IGame& game)
+{
+   Window::Create(0, 0, 0, 0);
+
+   m_smoothUI = game.GetSettings().GetBool(Base::settingUISmooth);
+
+   GLint maxTextureSize = 0;
+   glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+   m_isAvailable = maxTextureSize >= static_cast<GLint>(Detail::c_atlasSize);
+   if (!m_isAvailable)
+      return;
+
+   m_packer = RectanglePacker(Detail::c_atlasSize, Detail::c_atlasSize, Detail::c_slotPadding);
+   m_slots.clear();
+   m_batchedQuads.clear();
+   m_isDirty = false;
+
+   std::vector<Uint32> pixels(Detail::c_atlasSize * Detail::c_atlasSize, 0);
+
+   m_texture.Init(1);
+   m_texture.Convert(Detail::c_atlasSize, Detail::c_atlasSize, pixels.data());
+   m_texture.Upload(0);
+}
+
+/// \param width width of image
+/// \param height height of image
+/// \return slot index, or -1 when the atlas is full
+int ImageQuadAtlas::AllocateSlot(unsigned int width, unsigned int height)
+{
+   Slot slot = {};
+   if (!m_isAvailable ||
+      !m_packer.Insert(width, height, slot.m_xpos, slot.m_ypos))
+      return -1;
+
+   slot.m_width = width;
+   slot.m_height = height;
+
+   m_slots.push_back(slot);
+   return static_cast<int>(m_slots.size() - 1);
+}
+
+/// \param slotIndex slot index, as returned by AllocateSlot()
+/// \param width image width
+/// \param height image height
+/// \return true when the slot has exactly the given size
+bool ImageQuadAtlas::IsSlotSize(int slotIndex, unsigned int width, unsigned int height) const
+{
+   UaAssert(slotIndex >= 0 && static_cast<size_t>(slotIndex) < m_slots.size());
+
+   const Slot& slot = m_slots[slotIndex];
+   return slot.m_width == width && slot.m_height == height;
+}
+
+/// The area is converted right away, but uploaded in the next Draw() call,
+/// together with all other changed areas.
+/// \param slotIndex slot index, as returned by AllocateSlot()
+/// \param image image to convert area from; must have the slot size
+/// \param xpos x position of changed area, in image coordinates
+/// \param ypos y position of changed area
+/// \param width width of changed area
+/// \param height height of changed area
+void ImageQuadAtlas::UpdateSlot(int slotIndex, IndexedImage& image,
+   unsigned int xpos, unsigned int ypos, unsigned int width, unsigned int height)
+{
+   UaAssert(slotIndex >= 0 && static_cast<size_t>(slotIndex) < m_slots.size());
+
+   const Slot& slot = m_slots[slotIndex];
+   UaAssert(image.GetXRes() == slot.m_width && image.GetYRes() == slot.m_height);
+
+   if (width == 0 || height == 0)
+      return;
+
+   unsigned int destXPos = slot.m_xpos + xpos;
+   unsigned int destYPos = slot.m_ypos + ypos;
+
+   m_texture.ConvertRectTo(image, xpos, ypos, width, height, destXPos, destYPos);
+
+   if (!m_isDirty)
+   {
+      m_dirtyX0 = destXPos;
+      m_dirtyY0 = destYPos;
+      m_dirtyX1 = destXPos + width;
+      m_dirtyY1 = destYPos + height;
+      m_isDirty = true;
+   }
+   else
+   {
+      m_dirtyX0 = std::min(m_dirtyX0, destXPos);
+      m_dirtyY0 = std::min(m_dirtyY0, destYPos);
+      m_dirtyX1 = std::max(m_dirtyX1, destXPos + width);
+      m_dirtyY1 = std::max(m_dirtyY1, destYPos + height);
+   }
+}
+
+/// Queues a quad that is drawn with the next Draw() call. When the image has
+/// a border (see ImageQuad::AddBorder()), the border pixels are only used
+/// for filtering, and the quad is one pixel smaller on each side.
+/// \param slotIndex slot index, as returned by AllocateSlot()
+/// \param xpos x position of the window, in 320x200 screen coordinates
+/// \param ypos y position of the window
+/// \param width width of the window
+/// \param height height of the window
+/// \param hasBorder indicates if the image has a border
+void ImageQuadAtlas::AddQuad(int slotIndex, unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height, bool hasBorder)
+{
+   UaAssert(slotIndex >= 0 && static_cast<size_t>(slotIndex) < m_slots.size());
+
+   const Slot& slot = m_slots[slotIndex];
+   unsigned int inset = hasBorder ? 1 : 0;
+
+   BatchedQuad quad;
+   quad.m_x0 = xpos + inset;
+   quad.m_x1 = xpos + width - inset;
+   quad.m_y0 = 200 - ypos - inset;
+   quad.m_y1 = 200 - ypos - height + inset;
+
+   quad.m_u0 = double(slot.m_xpos + inset) / Detail::c_atlasSize;
+   quad.m_u1 = double(slot.m_xpos + slot.m_width - inset) / Detail::c_atlasSize;
+   quad.m_v0 = double(slot.m_ypos + inset) / Detail::c_atlasSize;
+   quad.m_v1 = double(slot.m_ypos + slot.m_height - inset) / Detail::c_atlasSize;
+
+   m_batchedQuads.push_back(quad);
+}
+
+/// Frees the atlas texture; all slots are invalid afterwards.
+void ImageQuadAtlas::Destroy()
+{
+   m_texture.Done();
+
+   m_slots.clear();
+   m_batchedQuads.clear();
+   m_isDirty = false;
+   m_isAvailable = false;
+}
+
+/// Uploads the changed areas of the atlas, then draws all queued quads with
+/// a single draw call.
+void ImageQuadAtlas::Draw()
+{
+   if (m_isDirty)
+      UploadChanges();
+
+   if (m_batchedQuads.empty())
+      return;
+
+   m_texture.Use(0);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_smoothUI ? GL_LINEAR : GL_NEAREST);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_smoothUI ? GL_LINEAR : GL_NEAREST);
+
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+   glBegin(GL_QUADS);
+
+   for (const BatchedQuad& quad : m_batchedQuads)
+   {
+      glTexCoord2d(quad.m_u0, quad.m_v1); glVertex2i(quad.m_x0, quad.m_y1);
+      glTexCoord2d(quad.m_u1, quad.m_v1); glVertex2i(quad.m_x1, quad.m_y1);
+      glTexCoord2d(quad.m_u1, quad.m_v0); glVertex2i(quad.m_x1, quad.m_y0);
+      glTexCoord2d(quad.m_u0, quad.m_v0); glVertex2i(quad.m_x0, quad.m_y0);
+   }
+
+   glEnd();
+
+   m_batchedQuads.clear();
+}
+
+void ImageQuadAtlas::UploadChanges()
+{
+   m_texture.UploadRect(m_dirtyX0, m_dirtyY0,
+      m_dirtyX1 - m_dirtyX0, m_dirtyY1 - m_dirtyY0);
+
+   m_isDirty = false;
+}
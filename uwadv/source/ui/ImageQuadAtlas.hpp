@@ -0,0 +1,124 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ImageQuadAtlas.hpp
+/// \brief atlas texture for image quads
+//
+#pragma once
+
+#include "Window.hpp"
+#include "GameInterface.hpp"
+#include "Texture.hpp"
+#include "RectanglePacker.hpp"
+#include <vector>
+
+class IndexedImage;
+
+/// \brief atlas texture for image quads
+/// Packs the images of several ImageQuad windows into a single texture and
+/// draws them with a single texture bind and draw call, instead of binding
+/// a texture and drawing a quad for every window. Image quads are added to
+/// the atlas by calling ImageQuad::SetAtlas() before initializing them.
+/// Changed image areas are converted into the atlas right away, and all
+/// changes are uploaded together before drawing.
+/// The atlas itself is a Window that has no size, so that it never receives
+/// mouse events. The image quads only queue their quads when drawn; the
+/// queued quads are drawn when the atlas window is drawn. Therefore the
+/// atlas must be registered with Screen::RegisterWindow() after all windows
+/// that use it, and windows that are drawn in between must not overlap
+/// them. When the image of an image quad doesn't fit into the atlas
+/// anymore, the image quad uses its own texture again.
+class ImageQuadAtlas : public Window
+{
+public:
+   /// ctor
+   ImageQuadAtlas();
+
+   /// initializes atlas texture
+   void Init(IGame& game);
+
+   /// returns if the atlas can be used
+   bool IsAvailable() const { return m_isAvailable; }
+
+   /// allocates area for an image of given size; returns -1 when it doesn't fit
+   int AllocateSlot(unsigned int width, unsigned int height);
+
+   /// returns if the slot has the given size
+   bool IsSlotSize(int slotIndex, unsigned int width, unsigned int height) const;
+
+   /// converts rectangular area of image into the slot
+   void UpdateSlot(int slotIndex, IndexedImage& image, unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height);
+
+   /// queues quad that shows the slot image at given window position
+   void AddQuad(int slotIndex, unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height, bool hasBorder);
+
+   // virtual functions from Window
+   virtual void Destroy() override;
+   virtual void Draw() override;
+
+private:
+   /// area of the atlas that contains the image of a single image quad
+   struct Slot
+   {
+      /// slot position in the atlas
+      unsigned int m_xpos, m_ypos;
+
+      /// slot size
+      unsigned int m_width, m_height;
+   };
+
+   /// quad that is drawn with the next Draw() call
+   struct BatchedQuad
+   {
+      /// quad coordinates, in 320x200 screen coordinates
+      unsigned int m_x0, m_y0, m_x1, m_y1;
+
+      /// texture coordinates
+      double m_u0, m_v0, m_u1, m_v1;
+   };
+
+   /// uploads the changed area of the atlas
+   void UploadChanges();
+
+private:
+   /// indicates if the atlas can be used
+   bool m_isAvailable;
+
+   /// indicates if images are drawn using smooth (filtered) pixels
+   bool m_smoothUI;
+
+   /// atlas texture
+   Texture m_texture;
+
+   /// packer that places slots in the atlas
+   RectanglePacker m_packer;
+
+   /// all allocated slots
+   std::vector<Slot> m_slots;
+
+   /// quads to draw in the next Draw() call
+   std::vector<BatchedQuad> m_batchedQuads;
+
+   /// indicates if the atlas has changes that weren't uploaded yet
+   bool m_isDirty;
+
+   /// area of the atlas that changed since the last upload
+   unsigned int m_dirtyX0, m_dirtyY0, m_dirtyX1, m_dirtyY1;
+};
@@ -21,9 +21,11 @@
 //
 #include "pch.hpp"
 #include "IndexedImage.hpp"
+#include "ImageBlitter.hpp"
 
 IndexedImage::IndexedImage()
-   :m_xres(0), m_yres(0)
+   :m_xres(0), m_yres(0),
+   m_dirtyX1(0), m_dirtyY1(0), m_dirtyX2(0), m_dirtyY2(0)
 {
 }
 
@@ -32,6 +34,9 @@ void IndexedImage::Create(unsigned int width, unsigned int height)
    m_xres = width;
    m_yres = height;
    m_pixels.resize(width*height);
+
+   ClearDirtyRect();
+   MarkDirty(0, 0, width, height);
 }
 
 /// when image to paste and image that is pasted is the same one, then
@@ -56,27 +61,22 @@ void IndexedImage::PasteRect(const IndexedImage& from_img, unsigned int fromx, u
    const Uint8* src = &from_img.GetPixels()[fromx + fromy * sxres];
    Uint8* dest = &m_pixels[destx + desty * m_xres];
 
+   MarkDirty(destx, desty, width, height);
+
    if (!transparent)
    {
-      // non-transparent paste
-      for (unsigned int y = 0; y < height; y++)
-         memcpy(&dest[y * m_xres], &src[y*sxres], width);
+      // non-transparent paste; copy all lines at once when they are contiguous
+      if (width == sxres && width == m_xres)
+         memcpy(dest, src, width * height);
+      else
+         for (unsigned int y = 0; y < height; y++)
+            memcpy(&dest[y * m_xres], &src[y*sxres], width);
    }
    else
    {
       // paste that omits transparent parts
       for (unsigned int y = 0; y < height; y++)
-      {
-         const Uint8* src_line = &src[y*sxres];
-         Uint8* dest_line = &dest[y * m_xres];
-
-         for (unsigned int x = 0; x < width; x++)
-         {
-            Uint8 pixel = src_line[x];
-            if (pixel != 0)
-               dest_line[x] = pixel;
-         }
-      }
+         ImageBlitter::CopyTransparent(&src[y*sxres], &dest[y * m_xres], width);
    }
 }
 
@@ -86,15 +86,73 @@ void IndexedImage::FillRect(unsigned int startx, unsigned int starty,
    // get pixel and ptr
    Uint8* ptr = &m_pixels[0] + starty * m_xres + startx;
 
-   // fill line by line
-   for (unsigned int y = 0; y < height; y++)
-      memset(&ptr[y * m_xres], color, width);
+   MarkDirty(startx, starty, width, height);
+
+   // fill all lines at once when they are contiguous, else line by line
+   if (width == m_xres)
+      memset(ptr, color, width * height);
+   else
+      for (unsigned int y = 0; y < height; y++)
+         memset(&ptr[y * m_xres], color, width);
 }
 
 void IndexedImage::Clear(Uint8 index)
 {
    if (!m_pixels.empty())
       memset(&m_pixels[0], index, m_pixels.size());
+
+   MarkDirty(0, 0, m_xres, m_yres);
+}
+
+/// \param xpos returns x position of dirty rectangle
+/// \param ypos returns y position
+/// \param width returns width of dirty rectangle; 0 when nothing changed
+/// \param height returns height of dirty rectangle; 0 when nothing changed
+void IndexedImage::GetDirtyRect(unsigned int& xpos, unsigned int& ypos,
+   unsigned int& width, unsigned int& height) const
+{
+   if (!IsDirty())
+   {
+      xpos = ypos = width = height = 0;
+      return;
+   }
+
+   xpos = m_dirtyX1;
+   ypos = m_dirtyY1;
+   width = m_dirtyX2 - m_dirtyX1;
+   height = m_dirtyY2 - m_dirtyY1;
+}
+
+/// Enlarges the dirty rectangle so that it also encloses the given area. The
+/// image manipulation methods call this, but code that changes pixels through
+/// other means must call it, too, or use the non-const GetPixels(), which
+/// marks the whole image as changed.
+/// \param xpos x position of changed area
+/// \param ypos y position of changed area
+/// \param width width of changed area
+/// \param height height of changed area
+void IndexedImage::MarkDirty(unsigned int xpos, unsigned int ypos,
+   unsigned int width, unsigned int height)
+{
+   unsigned int x2 = std::min(xpos + width, m_xres);
+   unsigned int y2 = std::min(ypos + height, m_yres);
+
+   if (xpos >= x2 || ypos >= y2)
+      return;
+
+   if (!IsDirty())
+   {
+      m_dirtyX1 = xpos;
+      m_dirtyY1 = ypos;
+      m_dirtyX2 = x2;
+      m_dirtyY2 = y2;
+      return;
+   }
+
+   m_dirtyX1 = std::min(m_dirtyX1, xpos);
+   m_dirtyY1 = std::min(m_dirtyY1, ypos);
+   m_dirtyX2 = std::max(m_dirtyX2, x2);
+   m_dirtyY2 = std::max(m_dirtyY2, y2);
 }
 
 void IndexedImage::CreateNewPalette()
@@ -85,8 +85,35 @@ public:
    void Clear(Uint8 index = 0);
 
 
-   /// returns the pixel vector
-   std::vector<Uint8>& GetPixels() { return m_pixels; }
+   // dirty rectangle
+
+   /// returns if any pixels were changed since the last call to ClearDirtyRect()
+   bool IsDirty() const
+   {
+      return m_dirtyX2 > m_dirtyX1 && m_dirtyY2 > m_dirtyY1;
+   }
+
+   /// returns rectangle enclosing all changed pixels
+   void GetDirtyRect(unsigned int& xpos, unsigned int& ypos,
+      unsigned int& width, unsigned int& height) const;
+
+   /// marks a rectangular area as changed
+   void MarkDirty(unsigned int xpos, unsigned int ypos,
+      unsigned int width, unsigned int height);
+
+   /// resets the dirty rectangle, e.g. after uploading changed pixels
+   void ClearDirtyRect()
+   {
+      m_dirtyX1 = m_dirtyY1 = m_dirtyX2 = m_dirtyY2 = 0;
+   }
+
+
+   /// returns the pixel vector; marks whole image as changed
+   std::vector<Uint8>& GetPixels()
+   {
+      MarkDirty(0, 0, m_xres, m_yres);
+      return m_pixels;
+   }
 
    /// returns a const pixel vector
    const std::vector<Uint8>& GetPixels() const { return m_pixels; }
@@ -112,4 +139,7 @@ protected:
 
    /// smart pointer to palette to use
    Palette256Ptr m_palette;
+
+   /// rectangle enclosing all changed pixels; x2 and y2 are exclusive
+   unsigned int m_dirtyX1, m_dirtyY1, m_dirtyX2, m_dirtyY2;
 };
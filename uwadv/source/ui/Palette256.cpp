@@ -61,3 +61,17 @@ void Palette256::Rotate(Uint8 start, Uint8 len, bool forward)
       memcpy(m_palette[start], save, sizeof(m_palette[0]));
    }
 }
+
+/// Rotates the palette range of the cycle once per animation step. Cycling
+/// a range by its length restores the original palette.
+/// \param cycle palette cycle to apply
+/// \param numSteps number of animation steps to cycle
+void Palette256::Cycle(const PaletteCycle& cycle, unsigned int numSteps)
+{
+   if (cycle.m_length < 2)
+      return;
+
+   numSteps %= cycle.m_length;
+   for (unsigned int step = 0; step < numSteps; step++)
+      Rotate(cycle.m_start, cycle.m_length, cycle.m_forward);
+}
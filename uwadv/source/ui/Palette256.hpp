@@ -26,6 +26,22 @@
 #include "Base.hpp"
 #include "Settings.hpp"
 
+/// \brief range of palette entries that is cycled to animate colors
+/// The original games animate e.g. water and lava by rotating the entries of
+/// a palette range by one entry at each animation step, instead of storing
+/// separate animation frames.
+struct PaletteCycle
+{
+   /// first palette index of the range
+   Uint8 m_start;
+
+   /// number of palette entries in the range
+   Uint8 m_length;
+
+   /// rotation direction; true moves entries to lower indices
+   bool m_forward;
+};
+
 /// palette with 256 entries, 4 color values per entry
 class Palette256
 {
@@ -55,6 +71,9 @@ public:
    /// rotates palette indices
    void Rotate(Uint8 start, Uint8 len, bool forward);
 
+   /// cycles palette range by given number of animation steps
+   void Cycle(const PaletteCycle& cycle, unsigned int numSteps = 1);
+
 private:
    /// a GL_RGBA compatible palette
    Uint8 m_palette[256][4];
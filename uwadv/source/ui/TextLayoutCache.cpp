@@ -0,0 +1,81 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextLayoutCache.cpp
+/// \brief cache for rendered text images
+//
+#include "pch.hpp"
+#include "TextLayoutCache.hpp"
+
+/// Returns the cached image and marks it as most recently used. The pointer
+/// is valid until the next call to Store() or Clear().
+/// \param fontId font the text was rendered with
+/// \param text text that was rendered
+/// \return cached image, or null when not cached
+const IndexedImage* TextLayoutCache::Find(FontId fontId, const std::string& text)
+{
+   auto iter = m_entryMap.find(MakeKey(fontId, text));
+   if (iter == m_entryMap.end())
+      return nullptr;
+
+   m_allEntries.splice(m_allEntries.begin(), m_allEntries, iter->second);
+
+   return &iter->second->second;
+}
+
+/// Stores the image and evicts the least recently used images when the cache
+/// is full. An already cached image for the same key is replaced.
+/// \param fontId font the text was rendered with
+/// \param text text that was rendered
+/// \param image rendered text image
+/// \return stored image
+const IndexedImage& TextLayoutCache::Store(FontId fontId, const std::string& text, IndexedImage&& image)
+{
+   std::string key = MakeKey(fontId, text);
+
+   auto iter = m_entryMap.find(key);
+   if (iter != m_entryMap.end())
+   {
+      m_allEntries.erase(iter->second);
+      m_entryMap.erase(iter);
+   }
+
+   while (!m_allEntries.empty() && m_allEntries.size() >= m_maxEntries)
+   {
+      m_entryMap.erase(m_allEntries.back().first);
+      m_allEntries.pop_back();
+   }
+
+   m_allEntries.emplace_front(key, std::move(image));
+   m_entryMap[key] = m_allEntries.begin();
+
+   return m_allEntries.front().second;
+}
+
+void TextLayoutCache::Clear()
+{
+   m_allEntries.clear();
+   m_entryMap.clear();
+}
+
+std::string TextLayoutCache::MakeKey(FontId fontId, const std::string& text)
+{
+   std::string key(1, static_cast<char>('0' + fontId));
+   key.append(text);
+   return key;
+}
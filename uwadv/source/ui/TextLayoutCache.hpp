@@ -0,0 +1,72 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextLayoutCache.hpp
+/// \brief cache for rendered text images
+//
+#pragma once
+
+#include "IndexedImage.hpp"
+#include "Font.hpp"
+#include <list>
+#include <string>
+#include <unordered_map>
+
+/// \brief cache for rendered text images
+/// Keeps the images of recently rendered text strings, keyed by font and
+/// text. When the cache is full, the least recently used image is evicted.
+/// This avoids rasterizing the same text again, e.g. when a text scroll
+/// shows the same lines after scrolling through its history.
+class TextLayoutCache
+{
+public:
+   /// ctor
+   TextLayoutCache(size_t maxEntries = 128)
+      :m_maxEntries(maxEntries)
+   {
+   }
+
+   /// returns cached image of text in given font; null when not cached
+   const IndexedImage* Find(FontId fontId, const std::string& text);
+
+   /// stores image of text in given font and returns the stored image
+   const IndexedImage& Store(FontId fontId, const std::string& text, IndexedImage&& image);
+
+   /// returns number of cached images
+   size_t GetSize() const { return m_allEntries.size(); }
+
+   /// clears all cached images
+   void Clear();
+
+private:
+   /// cache entry, with key and text image
+   typedef std::pair<std::string, IndexedImage> CacheEntry;
+
+   /// creates cache key from font and text
+   static std::string MakeKey(FontId fontId, const std::string& text);
+
+private:
+   /// max. number of cached images
+   size_t m_maxEntries;
+
+   /// all cache entries; most recently used first
+   std::list<CacheEntry> m_allEntries;
+
+   /// mapping from cache key to cache entry
+   std::unordered_map<std::string, std::list<CacheEntry>::iterator> m_entryMap;
+};
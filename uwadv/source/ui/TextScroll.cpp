@@ -115,22 +115,7 @@ bool TextScroll::Print(const char* text)
          }
 
          // cut down string on ' ' boundaries, until it fits into the image
-         while (CalcColoredLength(part.c_str()) > lineWidth)
-         {
-            std::string::size_type pos2 = part.find_last_of(' ');
-
-            if (pos2 != std::string::npos)
-            {
-               // cut at space char
-               part.erase(pos2);
-            }
-            else
-            {
-               // string too long, without a space in between
-               // erase char per char
-               part.erase(part.size() - 1);
-            }
-         }
+         part.erase(FindLineBreak(line, lineWidth));
 
          // move part over to m_textLines vector
          m_textLines.push_back(part);
@@ -216,8 +201,6 @@ void TextScroll::UpdateScroll()
 {
    m_image.Clear(m_backgroundColor);
 
-   IndexedImage tempImage;
-
    // process all lines visible in the scroll
    size_t max = std::min(m_maxLines, m_textLines.size());
    for (size_t lineIndex = 0; lineIndex < max; lineIndex++)
@@ -225,11 +208,13 @@ void TextScroll::UpdateScroll()
       // check if we are at the end of the m_textLines vector
       if (lineIndex + m_firstVisibleLine >= m_textLines.size()) break;
 
-      // create line string
-      CreateColoredString(tempImage, m_textLines[m_firstVisibleLine + lineIndex].c_str());
+      // get line image; the reference stays valid until the next call
+      const IndexedImage& tempImage = GetColoredStringImage(m_textLines[m_firstVisibleLine + lineIndex]);
       if (tempImage.GetXRes() == 0)
          continue; // empty line
 
+      unsigned int lineImageWidth = tempImage.GetXRes();
+
       // calc y position
       unsigned int ypos = static_cast<unsigned int>(lineIndex * m_normalFont.GetCharHeight() + m_scrollBaseY);
 
@@ -240,15 +225,12 @@ void TextScroll::UpdateScroll()
       // add [MORE] string on proper line
       if (m_isWaitingMore && m_moreLineIndex == lineIndex + m_firstVisibleLine)
       {
-         IndexedImage img_more;
-         CreateColoredString(img_more, c_textScrollMoreText);
+         const IndexedImage& img_more = GetColoredStringImage(c_textScrollMoreText);
 
          // paste string after end of last line
          m_image.PasteRect(img_more, 0, 0, img_more.GetXRes(), img_more.GetYRes(),
-            tempImage.GetXRes(), ypos, true);
+            lineImageWidth, ypos, true);
       }
-
-      tempImage.Clear();
    }
 
    // update quad texture
@@ -276,6 +258,55 @@ unsigned int TextScroll::CalcColoredLength(const char* text)
    return m_normalFont.CalcLength(line);
 }
 
+/// Determines where to break a line that is too long for the scroll. The
+/// line is broken at the last space where the text before it still fits. When
+/// not even the first word fits, it is broken within the word. Each char is
+/// measured only once, instead of measuring the remaining line again after
+/// cutting off each word.
+/// \param line text line, possibly with color codes
+/// \param lineWidth available width, in pixels
+/// \return number of chars of the line that fit into the width
+size_t TextScroll::FindLineBreak(const std::string& line, unsigned int lineWidth)
+{
+   size_t lastSpacePos = std::string::npos;
+   unsigned int width = 0;
+
+   size_t len = line.size();
+   for (size_t pos = 0; pos < len; pos++)
+   {
+      char ch = line[pos];
+
+      // the text before the space fits, since the width is checked after each char
+      if (ch == ' ')
+         lastSpacePos = pos;
+
+      // skip color codes
+      if (ch == '\\' && pos + 1 < len && line[pos + 1] >= '0' && line[pos + 1] <= '9')
+      {
+         pos++;
+         continue;
+      }
+
+      width += m_normalFont.GetCharWidth(ch);
+
+      if (width > lineWidth)
+      {
+         if (lastSpacePos != std::string::npos)
+            return lastSpacePos;
+
+         // string too long, without a space in between; erase char per char
+         // from the first word
+         std::string part = line.substr(0, line.find(' '));
+         while (CalcColoredLength(part.c_str()) > lineWidth)
+            part.erase(part.size() - 1);
+
+         return part.size();
+      }
+   }
+
+   return len; // whole line fits
+}
+
 /// Creates an image from given text. Recognizes color codes and creates
 /// appropriately colored text.
 /// \todo check for color codes
@@ -351,6 +382,23 @@ void TextScroll::CreateColoredString(IndexedImage& image, const char* text)
    } while (!line.empty());
 }
 
+/// Returns the image of the given text, with color codes processed. Images
+/// of lines that were shown recently are taken from the layout cache, so that
+/// scrolling through the text doesn't render the same lines again.
+/// \param text string with text
+/// \return text image; valid until the next call
+const IndexedImage& TextScroll::GetColoredStringImage(const std::string& text)
+{
+   const IndexedImage* cachedImage = m_lineImageCache.Find(m_normalFont.GetFontId(), text);
+   if (cachedImage != nullptr)
+      return *cachedImage;
+
+   IndexedImage image;
+   CreateColoredString(image, text.c_str());
+
+   return m_lineImageCache.Store(m_normalFont.GetFontId(), text, std::move(image));
+}
+
 /// Clears the scroll's contents and updates the image quad.
 void TextScroll::ClearScroll()
 {
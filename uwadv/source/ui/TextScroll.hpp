@@ -24,6 +24,7 @@
 #include <vector>
 #include "ImageQuad.hpp"
 #include "Font.hpp"
+#include "TextLayoutCache.hpp"
 
 /// textscroll color codes for call to TextScroll::SetColorCode()
 enum TextScrollColorCode
@@ -102,9 +103,15 @@ protected:
    /// calculates image width of a string; ignores color codes
    unsigned int CalcColoredLength(const char* text);
 
+   /// returns number of chars of the line that fit into the given width
+   size_t FindLineBreak(const std::string& line, unsigned int lineWidth);
+
    /// creates image from string; processes color codes
    void CreateColoredString(IndexedImage& img, const char* text);
 
+   /// returns image of string, from the layout cache when possible
+   const IndexedImage& GetColoredStringImage(const std::string& text);
+
 protected:
    /// background color
    Uint8 m_backgroundColor;
@@ -115,6 +122,9 @@ protected:
    /// font to render text
    Font m_normalFont;
 
+   /// images of recently shown lines
+   TextLayoutCache m_lineImageCache;
+
    /// maximal number of lines to show
    size_t m_maxLines;
 
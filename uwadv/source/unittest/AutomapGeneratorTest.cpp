@@ -0,0 +1,96 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file AutomapGeneratorTest.cpp
+/// \brief AutomapGenerator test
+//
+#include "pch.hpp"
+#include "Settings.hpp"
+#include "ResourceManager.hpp"
+#include "ImageManager.hpp"
+#include "IndexedImage.hpp"
+#include "AutomapGenerator.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief AutomapGenerator class tests
+   /// Tests that updating an automap image only redraws changed tiles.
+   TEST_CLASS(AutomapGeneratorTest)
+   {
+      /// Tests that only changed tiles and their adjacent tiles are redrawn.
+      TEST_METHOD(TestUpdateOnlyChangedTiles)
+      {
+         Base::Settings& settings = GetTestSettings();
+
+         settings.SetValue(Base::settingGamePrefix, std::string("uw1"));
+         settings.SetValue(Base::settingUnderworldPath, settings.GetString(Base::settingUw1Path));
+
+         Base::ResourceManager resourceManager{ settings };
+
+         ImageManager imageManager{ resourceManager };
+         imageManager.Init();
+
+         Underworld::Tilemap tilemap;
+         tilemap.Create();
+
+         UI::AutomapGenerator generator{ resourceManager, imageManager, tilemap };
+
+         IndexedImage backgroundImage;
+         backgroundImage.Create(320, 200);
+         backgroundImage.Clear(0);
+
+         IndexedImage image = backgroundImage;
+         std::vector<Uint16> tileStates;
+
+         Assert::AreEqual(64U * 64U, generator.UpdateTiles(image, backgroundImage, tileStates),
+            L"first update must draw all tiles");
+
+         image.ClearDirtyRect();
+
+         Assert::AreEqual(0U, generator.UpdateTiles(image, backgroundImage, tileStates),
+            L"unchanged tiles must not be redrawn");
+         Assert::IsFalse(image.IsDirty());
+
+         // reveal a single tile
+         Underworld::TileInfo& tileInfo = tilemap.GetTileInfo(10, 20);
+         tileInfo.m_type = Underworld::tileOpen;
+         tileInfo.m_automapFlag = Underworld::automapDefault;
+
+         Assert::AreEqual(5U, generator.UpdateTiles(image, backgroundImage, tileStates),
+            L"changed tile and adjacent tiles must be redrawn");
+
+         // tiles 9..11 in x direction, and 19..21 in y direction, which is flipped
+         unsigned int xpos, ypos, width, height;
+         image.GetDirtyRect(xpos, ypos, width, height);
+
+         Assert::AreEqual(9U * 3U + 5U, xpos);
+         Assert::AreEqual((63U - 21U) * 3U + 3U, ypos);
+         Assert::AreEqual(3U * 3U, width);
+         Assert::AreEqual(3U * 3U, height);
+
+         // invalidating the area of a single tile redraws it and its adjacent tiles
+         image.ClearDirtyRect();
+         UI::AutomapGenerator::InvalidateTiles(tileStates, xpos + 3, ypos + 3, 3, 3);
+
+         Assert::AreEqual(5U, generator.UpdateTiles(image, backgroundImage, tileStates),
+            L"invalidated tile and adjacent tiles must be redrawn");
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,103 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file CutsceneLoaderTest.cpp
+/// \brief CutsceneLoader test
+//
+#include "pch.hpp"
+#include "CutsceneLoader.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief CutsceneLoader class tests
+   /// Tests extracting frame records and the returned range of changed
+   /// pixels, which is used to only upload the changed part of a frame.
+   TEST_CLASS(CutsceneLoaderTest)
+   {
+      /// Tests that skipped pixels keep their value and aren't part of the
+      /// returned range.
+      TEST_METHOD(TestExtractSkipDumpRun)
+      {
+         Uint8 source[] =
+         {
+            0x80 | 5,      // short skip, 5 pixels
+            3, 1, 2, 3,    // short dump, 3 pixels
+            0x80 | 2,      // short skip, 2 pixels
+            0, 4, 9,       // short run, 4 pixels of value 9
+            0x80, 0, 0     // end of frame
+         };
+
+         std::vector<Uint8> pixels(20, 0xcc);
+         unsigned int dirtyStart = 0, dirtyEnd = 0;
+
+         Import::CutsceneLoader::ExtractCutsceneData(source, pixels.data(),
+            static_cast<unsigned int>(pixels.size()), dirtyStart, dirtyEnd);
+
+         std::vector<Uint8> expected
+         {
+            0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 1, 2, 3, 0xcc, 0xcc,
+            9, 9, 9, 9, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc
+         };
+
+         Assert::IsTrue(expected == pixels, L"pixels must match");
+         Assert::AreEqual(5u, dirtyStart, L"dirty range must start at first written pixel");
+         Assert::AreEqual(14u, dirtyEnd, L"dirty range must end after last written pixel");
+      }
+
+      /// Tests that a frame that only skips pixels returns an empty range.
+      TEST_METHOD(TestExtractOnlySkip)
+      {
+         Uint8 source[] =
+         {
+            0x80, 0x10, 0x00, // long skip, 16 pixels
+            0x80, 0, 0        // end of frame
+         };
+
+         std::vector<Uint8> pixels(16, 0xcc);
+         unsigned int dirtyStart = 42, dirtyEnd = 42;
+
+         Import::CutsceneLoader::ExtractCutsceneData(source, pixels.data(),
+            static_cast<unsigned int>(pixels.size()), dirtyStart, dirtyEnd);
+
+         Assert::IsTrue(std::vector<Uint8>(16, 0xcc) == pixels, L"pixels must be unchanged");
+         Assert::IsTrue(dirtyEnd <= dirtyStart, L"dirty range must be empty");
+      }
+
+      /// Tests that long dumps and runs are limited to the number of pixels.
+      TEST_METHOD(TestExtractLongOperationsAtEnd)
+      {
+         Uint8 source[] =
+         {
+            0x80, 0x02, 0x80, 7, 8, // long dump, 2 pixels
+            0x80, 0x10, 0xc0, 5,    // long run, 16 pixels of value 5
+         };
+
+         std::vector<Uint8> pixels(8, 0xcc);
+         unsigned int dirtyStart = 0, dirtyEnd = 0;
+
+         Import::CutsceneLoader::ExtractCutsceneData(source, pixels.data(),
+            static_cast<unsigned int>(pixels.size()), dirtyStart, dirtyEnd);
+
+         Assert::IsTrue(std::vector<Uint8>{ 7, 8, 5, 5, 5, 5, 5, 5 } == pixels, L"pixels must match");
+         Assert::AreEqual(0u, dirtyStart, L"dirty range must start at first pixel");
+         Assert::AreEqual(8u, dirtyEnd, L"dirty range must end at last pixel");
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,122 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file DynamicResolutionTest.cpp
+/// \brief DynamicResolutionController test
+//
+#include "pch.hpp"
+#include "DynamicResolution.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief DynamicResolutionController class tests
+   /// Tests choosing the render scale, with simulated render times that are
+   /// proportional to the number of rendered pixels.
+   TEST_CLASS(DynamicResolutionTest)
+   {
+      /// returns simulated render time for a full resolution render time
+      static double GetRenderTime(const DynamicResolutionController& controller, double fullTime)
+      {
+         return fullTime * controller.GetScale() * controller.GetScale();
+      }
+
+      /// Tests that the scale stays at full resolution when rendering is
+      /// fast enough.
+      TEST_METHOD(TestFullResolutionUnderBudget)
+      {
+         DynamicResolutionController controller(12.0);
+
+         for (unsigned int frame = 0; frame < 200; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 8.0));
+
+         Assert::AreEqual(1.0, controller.GetScale());
+      }
+
+      /// Tests that the scale is lowered until the render time fits the
+      /// budget, and is raised again when rendering gets faster.
+      TEST_METHOD(TestScaleFollowsBudget)
+      {
+         DynamicResolutionController controller(12.0);
+
+         for (unsigned int frame = 0; frame < 200; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 20.0));
+
+         Assert::IsTrue(controller.GetScale() < 1.0, L"scale must be lowered");
+         Assert::IsTrue(GetRenderTime(controller, 20.0) <= 12.0, L"render time must fit budget");
+
+         // too slow even at the lowest scale
+         for (unsigned int frame = 0; frame < 200; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 100.0));
+
+         Assert::AreEqual(DynamicResolutionController::c_minScale, controller.GetScale());
+
+         for (unsigned int frame = 0; frame < 1000; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 6.0));
+
+         Assert::AreEqual(1.0, controller.GetScale(), L"scale must be raised to full resolution");
+      }
+
+      /// Tests that noisy render times near the budget don't make the scale
+      /// oscillate.
+      TEST_METHOD(TestHysteresis)
+      {
+         DynamicResolutionController controller(12.0);
+
+         // let the scale settle first
+         for (unsigned int frame = 0; frame < 200; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 16.0));
+
+         unsigned int numScaleChanges = 0;
+         double lastScale = controller.GetScale();
+
+         for (unsigned int frame = 0; frame < 2000; frame++)
+         {
+            // +/- 15% noise, alternating between frames
+            double noise = (frame % 2) == 0 ? 1.15 : 0.85;
+            controller.AddRenderTime(GetRenderTime(controller, 16.0) * noise);
+
+            if (controller.GetScale() != lastScale)
+            {
+               numScaleChanges++;
+               lastScale = controller.GetScale();
+            }
+         }
+
+         Assert::IsTrue(numScaleChanges <= 2, L"scale must not oscillate");
+         Assert::IsTrue(GetRenderTime(controller, 16.0) <= 12.0, L"render time must fit budget");
+      }
+
+      /// Tests that resetting the controller returns to full resolution.
+      TEST_METHOD(TestReset)
+      {
+         DynamicResolutionController controller(5.0);
+
+         for (unsigned int frame = 0; frame < 100; frame++)
+            controller.AddRenderTime(GetRenderTime(controller, 20.0));
+
+         Assert::IsTrue(controller.GetScale() < 1.0);
+
+         controller.Reset();
+         Assert::AreEqual(1.0, controller.GetScale());
+         Assert::AreEqual(0.0, controller.GetAverageRenderTime());
+      }
+   };
+
+} // namespace UnitTest
@@ -0,0 +1,95 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FrameCaptureTest.cpp
+/// \brief FrameCapture test
+//
+#include "pch.hpp"
+#include "FrameCapture.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief FrameCapture class tests
+   /// Tests downscaling captured frames; reading back frames needs an OpenGL
+   /// context and isn't tested here.
+   TEST_CLASS(FrameCaptureTest)
+   {
+      /// Tests downscaling by an integer factor, averaging every channel.
+      TEST_METHOD(TestDownscaleIntegerFactor)
+      {
+         CapturedFrame source;
+         source.m_xres = 4;
+         source.m_yres = 2;
+         source.m_pixels = {
+            0xff000000, 0xff0000ff, 0x10101010, 0x10101010,
+            0xff00ff00, 0xffff0000, 0x30303030, 0x30303030,
+         };
+
+         CapturedFrame target;
+         target.m_xres = 2;
+         target.m_yres = 1;
+
+         FrameCapture::Downscale(source, target);
+
+         Assert::AreEqual(size_t(2), target.m_pixels.size());
+         Assert::AreEqual(Uint32(0xff404040), target.m_pixels[0], L"channels must be averaged");
+         Assert::AreEqual(Uint32(0x20202020), target.m_pixels[1], L"channels must be averaged");
+      }
+
+      /// Tests downscaling a window sized frame to the savegame preview size,
+      /// which isn't an integer factor.
+      TEST_METHOD(TestDownscaleNonIntegerFactor)
+      {
+         CapturedFrame source;
+         source.m_xres = 430;
+         source.m_yres = 280;
+         source.m_pixels.assign(source.m_xres * source.m_yres, 0xff336699);
+
+         CapturedFrame target;
+         target.m_xres = 160;
+         target.m_yres = 100;
+
+         FrameCapture::Downscale(source, target);
+
+         Assert::AreEqual(size_t(160 * 100), target.m_pixels.size());
+
+         for (Uint32 pixel : target.m_pixels)
+            Assert::AreEqual(Uint32(0xff336699), pixel, L"uniform frame must stay uniform");
+      }
+
+      /// Tests that upscaling duplicates pixels.
+      TEST_METHOD(TestUpscale)
+      {
+         CapturedFrame source;
+         source.m_xres = 2;
+         source.m_yres = 1;
+         source.m_pixels = { 0x11111111, 0x22222222 };
+
+         CapturedFrame target;
+         target.m_xres = 4;
+         target.m_yres = 2;
+
+         FrameCapture::Downscale(source, target);
+
+         Assert::AreEqual(Uint32(0x11111111), target.m_pixels[1]);
+         Assert::AreEqual(Uint32(0x22222222), target.m_pixels[6]);
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,123 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file FramePacerTest.cpp
+/// \brief FramePacer test
+//
+#include "pch.hpp"
+#include "FramePacer.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief FramePacer class tests
+   /// Tests pacing frames with a frame rate cap, and the pacing statistics.
+   TEST_CLASS(FramePacerTest)
+   {
+      /// Tests that frames are paced with the capped frame rate.
+      TEST_METHOD(TestFrameRateCap)
+      {
+         const unsigned int frameRate = 100;
+         const unsigned int numFrames = 20;
+
+         FramePacer pacer;
+         pacer.Init(frameRate, false, 60);
+
+         Uint64 start = SDL_GetPerformanceCounter();
+
+         for (unsigned int frame = 0; frame < numFrames; frame++)
+            pacer.WaitForNextFrame();
+
+         double seconds = double(SDL_GetPerformanceCounter() - start) / SDL_GetPerformanceFrequency();
+
+         Assert::IsTrue(seconds >= double(numFrames - 1) / frameRate, L"frames must not be faster than the cap");
+         Assert::AreEqual(numFrames, pacer.GetStatistics().m_numFrames);
+         Assert::IsTrue(pacer.GetStatistics().m_maxErrorMilliseconds >= 0.0);
+      }
+
+      /// Tests that the pacer doesn't pace frames when vsync is enabled and
+      /// the cap is above the refresh rate, and swapping buffers blocks.
+      TEST_METHOD(TestVsyncPacing)
+      {
+         FramePacer pacer;
+         pacer.Init(200, true, 60);
+
+         Assert::AreEqual(Uint64(0), pacer.GetFrameInterval(), L"vsync must pace frames");
+
+         pacer.Init(30, true, 60);
+         Assert::AreEqual(SDL_GetPerformanceFrequency() / 30, pacer.GetFrameInterval(),
+            L"cap below refresh rate must pace frames");
+
+         pacer.Init(0, false, 0);
+         Assert::AreEqual(SDL_GetPerformanceFrequency() / 60, pacer.GetFrameInterval(),
+            L"without vsync and cap, frames must be paced with the refresh rate");
+      }
+
+      /// Tests that frames paced by vsync are recorded in the statistics, and
+      /// that a frame that missed a vsync counts as late. Uses a simulated
+      /// clock with microsecond ticks, which advances by one tick on every
+      /// read, so that the test doesn't depend on real sleep times.
+      TEST_METHOD(TestVsyncStatistics)
+      {
+         const unsigned int refreshRate = 100;
+         const Uint64 ticksPerMillisecond = 1000;
+
+         Uint64 counter = 0;
+         FramePacer pacer{
+            [&counter]() { return counter++; },
+            [&counter](Uint32 milliseconds) { counter += milliseconds * ticksPerMillisecond; },
+            1000 * ticksPerMillisecond };
+
+         pacer.Init(0, true, refreshRate);
+
+         // buffer swaps that don't block are paced by the pacer
+         for (unsigned int frame = 0; frame < 5; frame++)
+            pacer.WaitForNextFrame();
+
+         Assert::AreEqual(5U, pacer.GetStatistics().m_numFrames, L"vsync frames must be recorded");
+         Assert::AreEqual(0U, pacer.GetStatistics().m_numLateFrames, L"paced frames must not be late");
+         Assert::IsTrue(counter >= 5 * 1000 / refreshRate * ticksPerMillisecond,
+            L"frames must be paced with the refresh rate");
+
+         // simulate a frame that took three refresh intervals
+         pacer.ResetStatistics();
+         counter += 3 * 1000 / refreshRate * ticksPerMillisecond;
+         pacer.WaitForNextFrame();
+
+         Assert::AreEqual(1U, pacer.GetStatistics().m_numFrames);
+         Assert::AreEqual(1U, pacer.GetStatistics().m_numLateFrames, L"frame that missed a vsync must be late");
+         Assert::AreEqual(20.0, pacer.GetStatistics().m_maxErrorMilliseconds, 0.1,
+            L"frame must be two refresh intervals late");
+      }
+
+      /// Tests that waiting for a deadline doesn't return early.
+      TEST_METHOD(TestWaitUntil)
+      {
+         FramePacer pacer;
+
+         for (unsigned int run = 0; run < 10; run++)
+         {
+            Uint64 deadline = SDL_GetPerformanceCounter() + SDL_GetPerformanceFrequency() / 400;
+            pacer.WaitUntil(deadline);
+
+            Assert::IsTrue(SDL_GetPerformanceCounter() >= deadline, L"must not return before deadline");
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,111 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file ImageBlitterTest.cpp
+/// \brief ImageBlitter test
+//
+#include "pch.hpp"
+#include "ImageBlitter.hpp"
+#include "IndexedImage.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief ImageBlitter class tests
+   /// Tests that all blit kernels produce the same pixels as the scalar
+   /// kernel. The throughput of the kernels is measured by uwbench-render.
+   TEST_CLASS(ImageBlitterTest)
+   {
+      /// all blit kernels
+      static constexpr Base::SimdKernel c_allKernels[] =
+      {
+         Base::kernelScalar,
+         Base::kernelSSE2,
+         Base::kernelAVX2,
+      };
+
+      /// creates test pixels with all palette indices; every third pixel is
+      /// transparent
+      static std::vector<Uint8> CreateTestPixels(size_t numPixels)
+      {
+         std::vector<Uint8> pixels(numPixels);
+         for (size_t index = 0; index < numPixels; index++)
+            pixels[index] = index % 3 == 0 ? 0 : static_cast<Uint8>(index * 37 + (index >> 8));
+
+         return pixels;
+      }
+
+      /// Tests that all supported kernels produce the same result as the
+      /// scalar kernel, for pixel counts that are no multiple of the SIMD
+      /// register size, too, and that no pixel after the end is written.
+      TEST_METHOD(TestAllKernelsMatchScalar)
+      {
+         for (size_t numPixels : { 0, 1, 3, 15, 16, 17, 31, 33, 64 * 64 + 5 })
+         {
+            std::vector<Uint8> source = CreateTestPixels(numPixels);
+
+            std::vector<Uint8> expected(numPixels + 1, 0xcd);
+            ImageBlitter::CopyTransparent(Base::kernelScalar,
+               source.data(), expected.data(), numPixels);
+
+            for (Base::SimdKernel kernel : c_allKernels)
+            {
+               if (!Base::IsSimdKernelSupported(kernel))
+                  continue;
+
+               std::vector<Uint8> dest(numPixels + 1, 0xcd);
+               ImageBlitter::CopyTransparent(kernel, source.data(), dest.data(), numPixels);
+
+               Assert::IsTrue(expected == dest, L"pixels must match scalar kernel");
+            }
+         }
+      }
+
+      /// Tests that transparent pastes and fills of an image keep the pixels
+      /// outside of the pasted area and under transparent source pixels.
+      TEST_METHOD(TestTransparentPasteAndFill)
+      {
+         IndexedImage source;
+         source.Create(37, 5);
+         source.GetPixels() = CreateTestPixels(37 * 5);
+
+         IndexedImage image;
+         image.Create(64, 8);
+         image.Clear(7);
+         image.FillRect(0, 6, 64, 2, 9);
+         image.PasteRect(source, 0, 0, 37, 5, 3, 1, true);
+
+         for (unsigned int y = 0; y < 8; y++)
+         {
+            for (unsigned int x = 0; x < 64; x++)
+            {
+               Uint8 expected = y >= 6 ? 9 : 7;
+               if (x >= 3 && x < 3 + 37 && y >= 1 && y < 1 + 5)
+               {
+                  Uint8 sourcePixel = source.GetPixels()[(y - 1) * 37 + (x - 3)];
+                  if (sourcePixel != 0)
+                     expected = sourcePixel;
+               }
+
+               Assert::AreEqual(expected, image.GetPixels()[y * 64 + x], L"pixel must match");
+            }
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,103 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file IndexedImageTest.cpp
+/// \brief IndexedImage test
+//
+#include "pch.hpp"
+#include "IndexedImage.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief IndexedImage class tests
+   /// Tests the dirty rectangle that is used to only upload changed areas of
+   /// an image.
+   TEST_CLASS(IndexedImageTest)
+   {
+      /// checks that the dirty rectangle has the expected values
+      static void CheckDirtyRect(const IndexedImage& image,
+         unsigned int expectedXPos, unsigned int expectedYPos,
+         unsigned int expectedWidth, unsigned int expectedHeight)
+      {
+         unsigned int xpos, ypos, width, height;
+         image.GetDirtyRect(xpos, ypos, width, height);
+
+         Assert::IsTrue(image.IsDirty(), L"image must be dirty");
+         Assert::AreEqual(expectedXPos, xpos, L"x position must match");
+         Assert::AreEqual(expectedYPos, ypos, L"y position must match");
+         Assert::AreEqual(expectedWidth, width, L"width must match");
+         Assert::AreEqual(expectedHeight, height, L"height must match");
+      }
+
+      /// Tests that a newly created image is dirty as a whole.
+      TEST_METHOD(TestCreateMarksWholeImage)
+      {
+         IndexedImage image;
+         Assert::IsFalse(image.IsDirty(), L"empty image must not be dirty");
+
+         image.Create(64, 32);
+         CheckDirtyRect(image, 0, 0, 64, 32);
+
+         image.ClearDirtyRect();
+         Assert::IsFalse(image.IsDirty(), L"image must not be dirty after clearing");
+      }
+
+      /// Tests that all changes are combined to a rectangle enclosing all of
+      /// them, and that areas are clipped to the image size.
+      TEST_METHOD(TestChangesAreCombined)
+      {
+         IndexedImage image;
+         image.Create(64, 32);
+         image.ClearDirtyRect();
+
+         image.FillRect(10, 4, 5, 2, 1);
+         CheckDirtyRect(image, 10, 4, 5, 2);
+
+         IndexedImage source;
+         source.Create(8, 8);
+         image.PasteImage(source, 60, 28);
+         CheckDirtyRect(image, 10, 4, 54, 28);
+
+         image.ClearDirtyRect();
+         image.PasteRect(source, 2, 2, 3, 3, 0, 0, true);
+         CheckDirtyRect(image, 0, 0, 3, 3);
+      }
+
+      /// Tests that clearing the image and non-const pixel access mark the
+      /// whole image as dirty, but const pixel access doesn't.
+      TEST_METHOD(TestClearAndPixelAccess)
+      {
+         IndexedImage image;
+         image.Create(16, 16);
+         image.ClearDirtyRect();
+
+         const IndexedImage& constImage = image;
+         Assert::AreEqual(size_t(16 * 16), constImage.GetPixels().size(), L"pixel count must match");
+         Assert::IsFalse(image.IsDirty(), L"const pixel access must not mark image");
+
+         image.Clear(3);
+         CheckDirtyRect(image, 0, 0, 16, 16);
+
+         image.ClearDirtyRect();
+         image.GetPixels()[0] = 1;
+         CheckDirtyRect(image, 0, 0, 16, 16);
+      }
+   };
+} // namespace UnitTest
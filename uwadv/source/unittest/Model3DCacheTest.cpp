@@ -0,0 +1,193 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Model3DCacheTest.cpp
+/// \brief Model3DCache test
+//
+#include "pch.hpp"
+#include "Model3DCache.hpp"
+#include "Model3DBuiltIn.hpp"
+#include "Settings.hpp"
+#include "File.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief Model3DCache class tests
+   /// Tests the on-disk cache for decoded 3d models.
+   TEST_CLASS(Model3DCacheTest)
+   {
+      /// returns settings that use given folder as cache folder
+      static Base::Settings GetCacheSettings(const TempFolder& testFolder)
+      {
+         Base::Settings settings;
+         settings.SetValue(Base::settingTextureCacheFolder, testFolder.GetPathName() + "/");
+         return settings;
+      }
+
+      /// creates a builtin model with some triangles
+      static std::shared_ptr<Model3D> CreateTestModel(unsigned int numTriangles)
+      {
+         std::vector<Triangle3dTextured> triangles(numTriangles);
+         for (unsigned int index = 0; index < numTriangles; index++)
+         {
+            Triangle3dTextured& triangle = triangles[index];
+            triangle.m_textureNumber = static_cast<Uint16>(index);
+            triangle.m_colorIndex = static_cast<Uint8>(index + 1);
+            triangle.m_flatShaded = (index & 1) != 0;
+
+            for (unsigned int vertexIndex = 0; vertexIndex < 3; vertexIndex++)
+            {
+               Vertex3d& vertex = triangle.m_vertices[vertexIndex];
+               vertex.pos.Set(index + 0.25, vertexIndex * 0.5, -1.125);
+               vertex.u = vertexIndex / 3.0;
+               vertex.v = index / 7.0;
+            }
+         }
+
+         return std::make_shared<Model3DBuiltIn>(Vector3d(0.5, 0.25, 1.0), triangles);
+      }
+
+      /// Tests that the cache key depends on source data, model type and variant.
+      TEST_METHOD(TestCalcKey)
+      {
+         std::vector<Uint8> sourceData(1024, 0x42);
+
+         Uint64 key1 = Model3DCache::CalcKey(sourceData, Model3DCache::cachedModelBuiltIn);
+         Uint64 key2 = Model3DCache::CalcKey(sourceData, Model3DCache::cachedModelVrml);
+         Uint64 key3 = Model3DCache::CalcKey(sourceData, Model3DCache::cachedModelBuiltIn, 1);
+
+         sourceData[512] = 0x43;
+         Uint64 key4 = Model3DCache::CalcKey(sourceData, Model3DCache::cachedModelBuiltIn);
+
+         Assert::AreNotEqual(key1, key2, L"model type must change key");
+         Assert::AreNotEqual(key1, key3, L"variant must change key");
+         Assert::AreNotEqual(key1, key4, L"source data must change key");
+      }
+
+      /// Tests storing builtin models and loading them again, also after
+      /// re-opening the cache.
+      TEST_METHOD(TestStoreAndLoadBuiltInModels)
+      {
+         TempFolder testFolder;
+         Base::Settings settings = GetCacheSettings(testFolder);
+
+         std::vector<std::shared_ptr<Model3D>> models;
+         models.push_back(std::make_shared<Model3DBuiltIn>());
+         models.push_back(CreateTestModel(5));
+         models.push_back(CreateTestModel(1));
+
+         {
+            Model3DCache cache;
+            cache.Init(settings);
+            Assert::IsTrue(cache.IsEnabled());
+
+            std::vector<std::shared_ptr<Model3D>> loadedModels;
+            Assert::IsFalse(cache.LoadBuiltInModels(0x1234, loadedModels), L"cache must be empty");
+
+            cache.StoreBuiltInModels(0x1234, models);
+         }
+
+         Model3DCache cache;
+         cache.Init(settings);
+
+         std::vector<std::shared_ptr<Model3D>> loadedModels;
+         Assert::IsTrue(cache.LoadBuiltInModels(0x1234, loadedModels), L"models must be cached after re-opening");
+         Assert::AreEqual(models.size(), loadedModels.size(), L"number of models must be equal");
+
+         for (size_t modelIndex = 0; modelIndex < models.size(); modelIndex++)
+         {
+            const Model3DBuiltIn& model = static_cast<const Model3DBuiltIn&>(*models[modelIndex]);
+            const Model3DBuiltIn& loadedModel = static_cast<const Model3DBuiltIn&>(*loadedModels[modelIndex]);
+
+            Assert::IsTrue(model.GetExtents().x == loadedModel.GetExtents().x &&
+               model.GetExtents().y == loadedModel.GetExtents().y &&
+               model.GetExtents().z == loadedModel.GetExtents().z, L"extents must be equal");
+
+            const std::vector<Triangle3dTextured>& triangles = model.GetTriangles();
+            const std::vector<Triangle3dTextured>& loadedTriangles = loadedModel.GetTriangles();
+            Assert::AreEqual(triangles.size(), loadedTriangles.size(), L"number of triangles must be equal");
+
+            for (size_t triangleIndex = 0; triangleIndex < triangles.size(); triangleIndex++)
+            {
+               const Triangle3dTextured& triangle = triangles[triangleIndex];
+               const Triangle3dTextured& loadedTriangle = loadedTriangles[triangleIndex];
+
+               Assert::AreEqual(triangle.m_textureNumber, loadedTriangle.m_textureNumber);
+               Assert::AreEqual(triangle.m_colorIndex, loadedTriangle.m_colorIndex);
+               Assert::AreEqual(triangle.m_flatShaded, loadedTriangle.m_flatShaded);
+
+               for (unsigned int vertexIndex = 0; vertexIndex < 3; vertexIndex++)
+               {
+                  const Vertex3d& vertex = triangle.m_vertices[vertexIndex];
+                  const Vertex3d& loadedVertex = loadedTriangle.m_vertices[vertexIndex];
+
+                  Assert::IsTrue(vertex.pos.x == loadedVertex.pos.x &&
+                     vertex.pos.y == loadedVertex.pos.y &&
+                     vertex.pos.z == loadedVertex.pos.z &&
+                     vertex.u == loadedVertex.u &&
+                     vertex.v == loadedVertex.v, L"vertices must be equal");
+               }
+            }
+         }
+      }
+
+      /// Tests that a truncated cache file is treated as not cached.
+      TEST_METHOD(TestInvalidCacheFile)
+      {
+         TempFolder testFolder;
+
+         Model3DCache cache;
+         cache.Init(GetCacheSettings(testFolder));
+
+         std::vector<std::shared_ptr<Model3D>> models;
+         models.push_back(CreateTestModel(10));
+         cache.StoreBuiltInModels(1, models);
+
+         // truncate cache file
+         {
+            Base::File file(testFolder.GetPathName() + "/0000000000000001.m3d", Base::modeWrite);
+            file.Write8(0x55);
+         }
+
+         std::vector<std::shared_ptr<Model3D>> loadedModels;
+         Assert::IsFalse(cache.LoadBuiltInModels(1, loadedModels), L"truncated file must not be loaded");
+         Assert::IsTrue(loadedModels.empty());
+      }
+
+      /// Tests that an empty cache folder disables the cache.
+      TEST_METHOD(TestDisabledCache)
+      {
+         Base::Settings settings;
+         settings.SetValue(Base::settingTextureCacheFolder, std::string());
+
+         Model3DCache cache;
+         cache.Init(settings);
+
+         Assert::IsFalse(cache.IsEnabled());
+
+         std::vector<std::shared_ptr<Model3D>> models;
+         models.push_back(CreateTestModel(1));
+         cache.StoreBuiltInModels(1, models);
+
+         std::vector<std::shared_ptr<Model3D>> loadedModels;
+         Assert::IsFalse(cache.LoadBuiltInModels(1, loadedModels));
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,105 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file Palette256Test.cpp
+/// \brief Palette256 test
+//
+#include "pch.hpp"
+#include "Palette256.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief Palette256 class tests
+   /// Tests palette cycling that is used to animate textures.
+   TEST_CLASS(Palette256Test)
+   {
+      /// creates a test palette where every entry is different
+      static Palette256 CreateTestPalette()
+      {
+         Palette256 palette;
+         for (unsigned int index = 0; index < 256; index++)
+         {
+            palette.Set(static_cast<Uint8>(index), 0, static_cast<Uint8>(index));
+            palette.Set(static_cast<Uint8>(index), 1, static_cast<Uint8>(255 - index));
+            palette.Set(static_cast<Uint8>(index), 2, static_cast<Uint8>(index ^ 0x5a));
+            palette.Set(static_cast<Uint8>(index), 3, 255);
+         }
+
+         return palette;
+      }
+
+      /// returns if two palettes are equal
+      static bool IsEqual(Palette256& palette1, Palette256& palette2)
+      {
+         return memcmp(palette1.Get(), palette2.Get(), 256 * 4) == 0;
+      }
+
+      /// Tests that cycling moves the entries of the range by one entry per
+      /// step, in both directions, and leaves other entries unchanged.
+      TEST_METHOD(TestCycleMovesRangeEntries)
+      {
+         Palette256 original = CreateTestPalette();
+
+         Palette256 forward = original;
+         forward.Cycle(PaletteCycle{ 48, 4, true });
+
+         Palette256 backward = original;
+         backward.Cycle(PaletteCycle{ 16, 8, false });
+
+         for (unsigned int index = 0; index < 256; index++)
+         {
+            Uint8 expectedForward = index >= 48 && index < 52
+               ? Uint8(48 + (index - 48 + 1) % 4)
+               : Uint8(index);
+            Uint8 expectedBackward = index >= 16 && index < 24
+               ? Uint8(16 + (index - 16 + 7) % 8)
+               : Uint8(index);
+
+            Assert::AreEqual(expectedForward, forward.Get()[index * 4], L"forward cycled entry must match");
+            Assert::AreEqual(expectedBackward, backward.Get()[index * 4], L"backward cycled entry must match");
+         }
+      }
+
+      /// Tests that cycling multiple steps at once is the same as cycling
+      /// step by step, and that cycling by the range length restores the
+      /// palette.
+      TEST_METHOD(TestCycleMultipleSteps)
+      {
+         PaletteCycle cycle{ 16, 8, false };
+
+         Palette256 original = CreateTestPalette();
+
+         Palette256 stepByStep = original;
+         for (unsigned int step = 0; step < 3; step++)
+            stepByStep.Cycle(cycle);
+
+         Palette256 atOnce = original;
+         atOnce.Cycle(cycle, 3);
+
+         Assert::IsTrue(IsEqual(stepByStep, atOnce), L"palettes must be equal");
+
+         atOnce.Cycle(cycle, 5);
+         Assert::IsTrue(IsEqual(original, atOnce), L"full cycle must restore palette");
+
+         atOnce.Cycle(cycle, 8 * 100);
+         Assert::IsTrue(IsEqual(original, atOnce), L"multiple full cycles must restore palette");
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,110 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PaletteConverterTest.cpp
+/// \brief PaletteConverter test
+//
+#include "pch.hpp"
+#include "PaletteConverter.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief PaletteConverter class tests
+   /// Tests that all conversion kernels produce the same texels as the scalar
+   /// kernel. The throughput of the kernels is measured by uwbench-render.
+   TEST_CLASS(PaletteConverterTest)
+   {
+      /// all conversion kernels
+      static constexpr Base::SimdKernel c_allKernels[] =
+      {
+         Base::kernelScalar,
+         Base::kernelSSE2,
+         Base::kernelAVX2,
+      };
+
+      /// creates a test palette where every entry is different
+      static std::vector<Uint32> CreateTestPalette()
+      {
+         std::vector<Uint32> palette(256);
+         for (Uint32 index = 0; index < 256; index++)
+            palette[index] = 0xff000000 | (index << 16) | ((255 - index) << 8) | (index ^ 0x5a);
+
+         return palette;
+      }
+
+      /// creates test pixels with all palette indices
+      static std::vector<Uint8> CreateTestPixels(size_t numPixels)
+      {
+         std::vector<Uint8> pixels(numPixels);
+         for (size_t index = 0; index < numPixels; index++)
+            pixels[index] = static_cast<Uint8>(index * 37 + (index >> 8));
+
+         return pixels;
+      }
+
+      /// Tests that all supported kernels produce the same result as the
+      /// scalar kernel, for pixel counts that are no multiple of the SIMD
+      /// register size, too.
+      TEST_METHOD(TestAllKernelsMatchScalar)
+      {
+         std::vector<Uint32> palette = CreateTestPalette();
+
+         for (size_t numPixels : { 0, 1, 3, 4, 7, 8, 15, 17, 64 * 64 + 5 })
+         {
+            std::vector<Uint8> pixels = CreateTestPixels(numPixels);
+
+            for (int transparentIndex : { PaletteConverter::c_noTransparentIndex, 0, 42 })
+            {
+               std::vector<Uint32> expected(numPixels + 1, 0xbaadf00d);
+               PaletteConverter::Convert(Base::kernelScalar,
+                  pixels.data(), expected.data(), numPixels, palette.data(), transparentIndex);
+
+               for (Base::SimdKernel kernel : c_allKernels)
+               {
+                  if (!Base::IsSimdKernelSupported(kernel))
+                     continue;
+
+                  std::vector<Uint32> texels(numPixels + 1, 0xbaadf00d);
+                  PaletteConverter::Convert(kernel,
+                     pixels.data(), texels.data(), numPixels, palette.data(), transparentIndex);
+
+                  Assert::IsTrue(expected == texels, L"texels must match scalar kernel");
+               }
+            }
+         }
+      }
+
+      /// Tests that the transparent index is converted to a zero texel.
+      TEST_METHOD(TestTransparentIndex)
+      {
+         std::vector<Uint32> palette = CreateTestPalette();
+         std::vector<Uint8> pixels{ 0, 1, 2, 0, 3, 0, 0, 4, 0 };
+         std::vector<Uint32> texels(pixels.size());
+
+         PaletteConverter::Convert(pixels.data(), texels.data(), pixels.size(), palette.data(), 0);
+
+         for (size_t index = 0; index < pixels.size(); index++)
+         {
+            Uint32 expected = pixels[index] == 0 ? 0 : palette[pixels[index]];
+            Assert::AreEqual(expected, texels[index], L"transparent pixels must be zero");
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,84 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PerformanceCountersTest.cpp
+/// \brief PerformanceCounters test
+//
+#include "pch.hpp"
+#include "PerformanceCounters.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief PerformanceCounters class tests
+   /// Tests collecting frame times in the performance counters history.
+   TEST_CLASS(PerformanceCountersTest)
+   {
+      /// Tests that disabled counters don't collect any times.
+      TEST_METHOD(TestDisabledCounters)
+      {
+         Base::PerformanceCounters counters;
+         Assert::IsFalse(counters.IsEnabled());
+
+         Assert::AreEqual<Uint64>(0, counters.StartTiming(), L"disabled counters must not start timing");
+
+         {
+            Base::PerformanceTimer timer{ counters, Base::phaseRender };
+            SDL_Delay(2);
+         }
+
+         counters.NextFrame();
+
+         Assert::AreEqual(0.0, counters.GetMaxTime(Base::phaseRender));
+         Assert::AreEqual(0.0, counters.GetFrameTime(Base::phaseRender, Base::PerformanceCounters::s_historySize - 1));
+      }
+
+      /// Tests that timed phases are stored as the most recent frame in the
+      /// history, and that other phases stay at zero.
+      TEST_METHOD(TestFrameHistory)
+      {
+         Base::PerformanceCounters counters;
+         counters.SetEnabled(true);
+
+         {
+            Base::PerformanceTimer timer{ counters, Base::phaseRender };
+            SDL_Delay(2);
+         }
+
+         counters.NextFrame();
+         counters.NextFrame();
+
+         const size_t lastFrame = Base::PerformanceCounters::s_historySize - 1;
+
+         Assert::IsTrue(counters.GetFrameTime(Base::phaseRender, lastFrame - 1) >= 1.0,
+            L"timed frame must be the second most recent one");
+         Assert::AreEqual(0.0, counters.GetFrameTime(Base::phaseRender, lastFrame),
+            L"most recent frame must not contain any time");
+         Assert::AreEqual(0.0, counters.GetMaxTime(Base::phaseSwap),
+            L"phases that weren't timed must stay at zero");
+
+         Assert::AreEqual(counters.GetFrameTime(Base::phaseRender, lastFrame - 1),
+            counters.GetMaxTime(Base::phaseRender));
+
+         // disabling clears the history
+         counters.SetEnabled(false);
+         Assert::AreEqual(0.0, counters.GetMaxTime(Base::phaseRender));
+      }
+   };
+} // namespace UnitTest
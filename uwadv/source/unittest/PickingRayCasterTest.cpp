@@ -0,0 +1,177 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file PickingRayCasterTest.cpp
+/// \brief PickingRayCaster test
+//
+#include "pch.hpp"
+#include "PickingRayCaster.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief PickingRayCaster class tests
+   /// Tests ray direction calculation, tile traversal, ray/triangle
+   /// intersection and picking of tile and object triangles.
+   TEST_CLASS(PickingRayCasterTest)
+   {
+      /// adds a wall quad facing the x axis, at given x coordinate
+      static void AddWall(std::vector<PickTriangle>& allTriangles, double x,
+         unsigned int tileY, bool isObject, unsigned int id)
+      {
+         Vector3d point1(x, tileY, 0.0), point2(x, tileY + 1.0, 0.0);
+         Vector3d point3(x, tileY + 1.0, 1.0), point4(x, tileY, 1.0);
+
+         allTriangles.push_back(PickTriangle(point1, point2, point3, isObject, id));
+         allTriangles.push_back(PickTriangle(point1, point3, point4, isObject, id));
+      }
+
+      /// Tests calculating ray directions for the center and the top of the
+      /// viewport, for different rotate angles.
+      TEST_METHOD(TestCalcRayDirection)
+      {
+         Vector3d direction = PickingRayCaster::CalcRayDirection(0.0, 0.0, 90.0, 1.0, 0.0, 0.0);
+         Assert::AreEqual(1.0, direction.x, 1e-6, L"rotate angle 0 must look along x axis");
+         Assert::AreEqual(0.0, direction.y, 1e-6);
+         Assert::AreEqual(0.0, direction.z, 1e-6);
+
+         direction = PickingRayCaster::CalcRayDirection(0.0, 0.0, 90.0, 1.0, 0.0, 90.0);
+         Assert::AreEqual(0.0, direction.x, 1e-6);
+         Assert::AreEqual(1.0, direction.y, 1e-6, L"rotate angle 90 must look along y axis");
+
+         direction = PickingRayCaster::CalcRayDirection(0.0, 1.0, 90.0, 1.0, 0.0, 0.0);
+         Assert::AreEqual(sqrt(0.5), direction.x, 1e-6);
+         Assert::AreEqual(sqrt(0.5), direction.z, 1e-6, L"top of viewport must look up");
+
+         direction = PickingRayCaster::CalcRayDirection(1.0, 0.0, 90.0, 1.0, 0.0, 0.0);
+         Assert::IsTrue(direction.y < 0.0, L"right side of viewport must look to the right");
+      }
+
+      /// Tests that tiles are visited in front-to-back order, and that
+      /// traversal stops at the tilemap border and at the max. distance.
+      TEST_METHOD(TestTraverseTiles)
+      {
+         std::vector<std::pair<unsigned int, unsigned int>> allTiles;
+         std::vector<double> allDistances;
+
+         auto visitTile = [&](unsigned int tileX, unsigned int tileY, double enterDistance)
+         {
+            allTiles.push_back(std::make_pair(tileX, tileY));
+            allDistances.push_back(enterDistance);
+            return true;
+         };
+
+         PickingRayCaster::TraverseTiles(Vector3d(0.5, 0.5, 0.0), Vector3d(1.0, 0.5, 0.0), 2.0, visitTile);
+
+         std::vector<std::pair<unsigned int, unsigned int>> expectedTiles{ {0, 0}, {1, 0}, {1, 1}, {2, 1} };
+         Assert::IsTrue(expectedTiles == allTiles, L"tiles must be visited in order");
+         Assert::AreEqual(0.0, allDistances[0], 1e-6);
+         Assert::AreEqual(0.5, allDistances[1], 1e-6);
+         Assert::AreEqual(1.0, allDistances[2], 1e-6);
+         Assert::AreEqual(1.5, allDistances[3], 1e-6);
+
+         // ray starting outside, leaving the tilemap at the other side
+         allTiles.clear();
+         PickingRayCaster::TraverseTiles(Vector3d(-10.0, 5.5, 0.0), Vector3d(1.0, 0.0, 0.0), 100.0, visitTile);
+
+         Assert::AreEqual<size_t>(64, allTiles.size(), L"ray must pass all tiles of a row");
+         Assert::AreEqual(0u, allTiles.front().first);
+         Assert::AreEqual(63u, allTiles.back().first);
+         Assert::AreEqual(5u, allTiles.back().second);
+
+         // ray pointing away from the tilemap
+         allTiles.clear();
+         PickingRayCaster::TraverseTiles(Vector3d(-1.0, 5.5, 0.0), Vector3d(-1.0, 0.0, 0.0), 100.0, visitTile);
+         Assert::IsTrue(allTiles.empty(), L"ray must not visit any tile");
+      }
+
+      /// Tests ray/triangle intersection, for hits, misses and triangles
+      /// behind the ray origin.
+      TEST_METHOD(TestIntersectTriangle)
+      {
+         Vector3d point1(2.0, -1.0, -1.0), point2(2.0, 1.0, -1.0), point3(2.0, 0.0, 1.0);
+
+         double distance = 0.0;
+         Assert::IsTrue(PickingRayCaster::IntersectTriangle(
+            Vector3d(0.0, 0.0, 0.0), Vector3d(1.0, 0.0, 0.0), point1, point2, point3, distance));
+         Assert::AreEqual(2.0, distance, 1e-6);
+
+         Assert::IsTrue(PickingRayCaster::IntersectTriangle(
+            Vector3d(4.0, 0.0, 0.0), Vector3d(-1.0, 0.0, 0.0), point1, point2, point3, distance),
+            L"back side must be hit, too");
+
+         Assert::IsFalse(PickingRayCaster::IntersectTriangle(
+            Vector3d(0.0, 0.0, 0.0), Vector3d(-1.0, 0.0, 0.0), point1, point2, point3, distance),
+            L"triangle behind origin must not be hit");
+
+         Assert::IsFalse(PickingRayCaster::IntersectTriangle(
+            Vector3d(0.0, 2.0, 0.0), Vector3d(1.0, 0.0, 0.0), point1, point2, point3, distance),
+            L"ray passing triangle must not hit");
+
+         Assert::IsFalse(PickingRayCaster::IntersectTriangle(
+            Vector3d(0.0, 0.0, 0.0), Vector3d(0.0, 1.0, 0.0), point1, point2, point3, distance),
+            L"parallel ray must not hit");
+      }
+
+      /// Tests picking the nearest tile or object triangle, including an
+      /// object extending from a neighbouring tile, and an object behind a
+      /// wall.
+      TEST_METHOD(TestPick)
+      {
+         // wall at x = 12.0, in tile 11/10; object at x = 11.5, stored in
+         // tile 11/11 but extending into tile 11/10; object behind wall
+         PickingRayCaster rayCaster(
+            [](unsigned int tileX, unsigned int tileY, std::vector<PickTriangle>& allTriangles)
+            {
+               if (tileX == 11 && tileY == 10)
+                  AddWall(allTriangles, 12.0, 10, false, 0x0042);
+            },
+            [](unsigned int tileX, unsigned int tileY, std::vector<PickTriangle>& allTriangles)
+            {
+               if (tileX == 11 && tileY == 11)
+                  AddWall(allTriangles, 11.5, 10, true, 0x0123);
+
+               if (tileX == 13 && tileY == 10)
+                  AddWall(allTriangles, 13.5, 10, true, 0x0234);
+            });
+
+         PickResult result;
+         Vector3d direction(1.0, 0.0, 0.0);
+
+         Assert::IsTrue(rayCaster.Pick(Vector3d(5.0, 10.5, 0.5), direction, 16.0, result));
+         Assert::IsTrue(result.m_isObject, L"object in front of wall must be picked");
+         Assert::AreEqual(0x0123u, result.m_id);
+         Assert::AreEqual(11u, result.m_tileX, L"tile of object must be returned");
+         Assert::AreEqual(11u, result.m_tileY);
+         Assert::AreEqual(6.5, result.m_distance, 1e-6);
+
+         Assert::IsTrue(rayCaster.Pick(Vector3d(11.75, 10.5, 0.5), direction, 16.0, result));
+         Assert::IsFalse(result.m_isObject, L"wall must be picked when in front of object");
+         Assert::AreEqual(0x0042u, result.m_id);
+         Assert::AreEqual(11u, result.m_tileX);
+         Assert::AreEqual(10u, result.m_tileY);
+
+         Assert::IsFalse(rayCaster.Pick(Vector3d(5.0, 10.5, 0.5), direction, 6.0, result),
+            L"triangles beyond max. distance must not be picked");
+
+         Assert::IsFalse(rayCaster.Pick(Vector3d(5.0, 10.5, 2.0), direction, 16.0, result),
+            L"ray passing above all triangles must not pick");
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,105 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file RectanglePackerTest.cpp
+/// \brief RectanglePacker test
+//
+#include "pch.hpp"
+#include "RectanglePacker.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief RectanglePacker class tests
+   /// Tests packing rectangles, e.g. critter frames into atlas textures.
+   TEST_CLASS(RectanglePackerTest)
+   {
+      /// placed rectangle
+      struct PlacedRect
+      {
+         unsigned int m_xpos, m_ypos, m_width, m_height;
+      };
+
+      /// returns if two rectangles overlap, including padding
+      static bool IsOverlapping(const PlacedRect& rect1, const PlacedRect& rect2, unsigned int padding)
+      {
+         return rect1.m_xpos < rect2.m_xpos + rect2.m_width + padding &&
+            rect2.m_xpos < rect1.m_xpos + rect1.m_width + padding &&
+            rect1.m_ypos < rect2.m_ypos + rect2.m_height + padding &&
+            rect2.m_ypos < rect1.m_ypos + rect1.m_height + padding;
+      }
+
+      /// Tests that packed rectangles lie inside the area and don't overlap,
+      /// including the padding between rectangles.
+      TEST_METHOD(TestRectanglesDontOverlap)
+      {
+         const unsigned int size = 256, padding = 1;
+         RectanglePacker packer{ size, size, padding };
+
+         std::vector<PlacedRect> allRects;
+         for (unsigned int index = 0; index < 100; index++)
+         {
+            PlacedRect rect = { 0, 0, 5 + (index * 7) % 23, 30 - index / 5 };
+
+            if (!packer.Insert(rect.m_width, rect.m_height, rect.m_xpos, rect.m_ypos))
+               continue;
+
+            Assert::IsTrue(rect.m_xpos + rect.m_width <= size, L"rectangle must be inside area");
+            Assert::IsTrue(rect.m_ypos + rect.m_height <= size, L"rectangle must be inside area");
+
+            for (const PlacedRect& otherRect : allRects)
+               Assert::IsFalse(IsOverlapping(rect, otherRect, padding), L"rectangles must not overlap");
+
+            allRects.push_back(rect);
+         }
+
+         Assert::IsTrue(allRects.size() > 50, L"most rectangles must fit into area");
+         Assert::IsTrue(packer.GetUsedHeight() <= size);
+      }
+
+      /// Tests that rectangles of the same size are packed in rows, and that
+      /// inserting fails when the area is full.
+      TEST_METHOD(TestFullArea)
+      {
+         RectanglePacker packer{ 64, 64 };
+
+         unsigned int xpos = 0, ypos = 0;
+         for (unsigned int index = 0; index < 16; index++)
+         {
+            Assert::IsTrue(packer.Insert(16, 16, xpos, ypos));
+            Assert::AreEqual((index % 4) * 16, xpos);
+            Assert::AreEqual((index / 4) * 16, ypos);
+         }
+
+         Assert::AreEqual(64U, packer.GetUsedHeight());
+         Assert::IsFalse(packer.Insert(1, 1, xpos, ypos), L"area must be full");
+      }
+
+      /// Tests that rectangles larger than the area are rejected.
+      TEST_METHOD(TestTooLargeRectangle)
+      {
+         RectanglePacker packer{ 32, 32 };
+
+         unsigned int xpos = 0, ypos = 0;
+         Assert::IsFalse(packer.Insert(33, 1, xpos, ypos));
+         Assert::IsFalse(packer.Insert(1, 33, xpos, ypos));
+         Assert::AreEqual(0U, packer.GetUsedHeight());
+      }
+   };
+} // namespace UnitTest
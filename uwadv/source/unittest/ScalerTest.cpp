@@ -29,6 +29,35 @@ namespace UnitTest
    /// \brief Scaler class tests
    TEST_CLASS(ScalerTest)
    {
+      /// all pattern kernels
+      static constexpr Scaler::PatternKernel c_allKernels[] =
+      {
+         Scaler::kernelReference,
+         Scaler::kernelScalar,
+         Scaler::kernelSSE2,
+      };
+
+      /// creates test bitmap with random pixels; when numColors is not 0,
+      /// only the given number of similar colors is used, so that the bitmap
+      /// has both flat areas and edges
+      static std::vector<Uint32> CreateTestBitmap(Uint32 width, Uint32 height, unsigned int numColors)
+      {
+         std::vector<Uint32> bitmap(width * height);
+
+         Uint32 seed = 0x12345678;
+         for (Uint32& pixel : bitmap)
+         {
+            seed = seed * 1664525 + 1013904223;
+            Uint32 random = seed >> 8;
+
+            pixel = numColors == 0
+               ? random | (seed << 24)
+               : 0xff000000 | ((random % numColors) * 0x00141414);
+         }
+
+         return bitmap;
+      }
+
       /// Tests scaling by scale factor 2x
       TEST_METHOD(TestScaler2x)
       {
@@ -73,5 +102,76 @@ namespace UnitTest
 
          Assert::AreEqual(0xbaadf00d, dest[destSize], L"guard value must not be overwritten");
       }
+
+      /// Tests that all pattern kernels and band counts produce the same
+      /// result as the unmodified hqx implementation, using a single band
+      TEST_METHOD(TestKernelsAndBandsMatchReference)
+      {
+         const Uint32 sizes[][2] = { { 1, 1 }, { 3, 5 }, { 7, 1 }, { 1, 9 }, { 64, 64 }, { 65, 33 } };
+
+         for (auto size : sizes)
+         {
+            for (unsigned int numColors : { 0, 3, 16 })
+            {
+               std::vector<Uint32> source = CreateTestBitmap(size[0], size[1], numColors);
+
+               for (unsigned int scaleFactor = 2; scaleFactor <= 4; scaleFactor++)
+               {
+                  size_t destSize = source.size() * scaleFactor * scaleFactor;
+
+                  std::vector<Uint32> expected(destSize + 1, 0xbaadf00d);
+                  Scaler::Scale(scaleFactor, source.data(), expected.data(), size[0], size[1],
+                     Scaler::kernelReference, 1);
+
+                  for (Scaler::PatternKernel kernel : c_allKernels)
+                  {
+                     if (!Scaler::IsKernelSupported(kernel))
+                        continue;
+
+                     for (unsigned int numBands : { 1, 2, 3, 7, 16 })
+                     {
+                        std::vector<Uint32> dest(destSize + 1, 0xbaadf00d);
+                        Scaler::Scale(scaleFactor, source.data(), dest.data(), size[0], size[1],
+                           kernel, numBands);
+
+                        Assert::IsTrue(expected == dest, L"scaled bitmap must match hqx result");
+                     }
+                  }
+               }
+            }
+         }
+      }
+
+      /// Measures the time to scale a large bitmap with all kernels, with one
+      /// band and with the default number of bands, and writes the results to
+      /// the trace output.
+      TEST_METHOD(TestScalerThroughput)
+      {
+         const Uint32 width = 320, height = 200;
+         const unsigned int numRuns = 10;
+
+         std::vector<Uint32> source = CreateTestBitmap(width, height, 5);
+         std::vector<Uint32> dest(source.size() * 4 * 4);
+
+         double frequency = static_cast<double>(SDL_GetPerformanceFrequency());
+
+         for (Scaler::PatternKernel kernel : c_allKernels)
+         {
+            if (!Scaler::IsKernelSupported(kernel))
+               continue;
+
+            for (unsigned int numBands : { 1U, Scaler::GetNumBands(width, height) })
+            {
+               Uint64 start = SDL_GetPerformanceCounter();
+
+               for (unsigned int run = 0; run < numRuns; run++)
+                  Scaler::Scale(4, source.data(), dest.data(), width, height, kernel, numBands);
+
+               double milliseconds = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency / numRuns;
+               UaTrace("hq4x scaling %ux%u, kernel %u, %u band(s): %.2f ms\n",
+                  width, height, kernel, numBands, milliseconds);
+            }
+         }
+      }
    };
 } // namespace UnitTest
@@ -0,0 +1,288 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file SoftwareRasterizerTest.cpp
+/// \brief SoftwareRasterizer test
+//
+#include "pch.hpp"
+#include "SoftwareRasterizer.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief SoftwareRasterizer class tests
+   /// Tests rasterizing triangles with a camera at the origin that looks
+   /// along the x axis, with y pointing left and z pointing up.
+   TEST_CLASS(SoftwareRasterizerTest)
+   {
+      /// color used to clear the color buffer
+      static constexpr Uint32 c_clearColor = 0xff000000;
+
+      /// sets up camera at the origin, looking along the x axis
+      static void SetupCamera(SoftwareRasterizer& rasterizer)
+      {
+         rasterizer.SetCamera(Vector3d(0.0, 0.0, 0.0), 0.0, 0.0, 90.0, 0.05, 16.0);
+      }
+
+      /// creates a vertex in front of the camera; screenX and screenY are the
+      /// position on screen at distance 1.0, from -1.0 to 1.0
+      static SoftwareVertex CreateVertex(double distance, double screenX, double screenY,
+         double u = 0.0, double v = 0.0)
+      {
+         SoftwareVertex vertex;
+         vertex.m_pos.Set(distance, -screenX * distance, screenY * distance);
+         vertex.m_u = u;
+         vertex.m_v = v;
+         return vertex;
+      }
+
+      /// adds a quad that faces the camera, in counter-clockwise order
+      static void AddQuad(SoftwareRasterizer& rasterizer, double distance,
+         double left, double bottom, double right, double top,
+         const SoftwareTexture* texture, Uint32 color, bool reverseOrder = false)
+      {
+         SoftwareVertex vertex0 = CreateVertex(distance, left, bottom, 0.0, 1.0);
+         SoftwareVertex vertex1 = CreateVertex(distance, right, bottom, 1.0, 1.0);
+         SoftwareVertex vertex2 = CreateVertex(distance, right, top, 1.0, 0.0);
+         SoftwareVertex vertex3 = CreateVertex(distance, left, top, 0.0, 0.0);
+
+         if (reverseOrder)
+         {
+            rasterizer.AddTriangle(vertex0, vertex2, vertex1, texture, color);
+            rasterizer.AddTriangle(vertex0, vertex3, vertex2, texture, color);
+         }
+         else
+         {
+            rasterizer.AddTriangle(vertex0, vertex1, vertex2, texture, color);
+            rasterizer.AddTriangle(vertex0, vertex2, vertex3, texture, color);
+         }
+      }
+
+      /// returns number of pixels that don't have the clear color
+      static size_t CountCoveredPixels(const SoftwareRasterizer& rasterizer)
+      {
+         const std::vector<Uint32>& colorBuffer = rasterizer.GetColorBuffer();
+         return static_cast<size_t>(std::count_if(colorBuffer.begin(), colorBuffer.end(),
+            [](Uint32 color) { return color != c_clearColor; }));
+      }
+
+      /// Tests rendering a textured quad that covers the whole screen, and
+      /// that back faces are culled.
+      TEST_METHOD(TestTexturedQuad)
+      {
+         // 2x2 texture with four colors
+         SoftwareTexture texture;
+         texture.m_xres = 2;
+         texture.m_yres = 2;
+         texture.m_texels = { 0xff0000ff, 0xff00ff00, 0xffff0000, 0xffffffff };
+
+         SoftwareRasterizer rasterizer;
+         rasterizer.Init(64, 64, 1);
+         SetupCamera(rasterizer);
+
+         rasterizer.BeginFrame(c_clearColor);
+         AddQuad(rasterizer, 2.0, -1.0, -1.0, 1.0, 1.0, &texture, 0xffffffff);
+         rasterizer.EndFrame();
+
+         const std::vector<Uint32>& colorBuffer = rasterizer.GetColorBuffer();
+         Assert::AreEqual(64u * 64u, static_cast<unsigned int>(colorBuffer.size()));
+
+         // each quadrant shows one texel
+         Assert::AreEqual(texture.m_texels[0], colorBuffer[8 * 64 + 8]);
+         Assert::AreEqual(texture.m_texels[1], colorBuffer[8 * 64 + 56]);
+         Assert::AreEqual(texture.m_texels[2], colorBuffer[56 * 64 + 8]);
+         Assert::AreEqual(texture.m_texels[3], colorBuffer[56 * 64 + 56]);
+         Assert::AreEqual(size_t(64 * 64), CountCoveredPixels(rasterizer));
+
+         // back faces are culled
+         rasterizer.BeginFrame(c_clearColor);
+         AddQuad(rasterizer, 2.0, -1.0, -1.0, 1.0, 1.0, &texture, 0xffffffff, true);
+         rasterizer.EndFrame();
+
+         Assert::AreEqual(size_t(0), CountCoveredPixels(rasterizer));
+      }
+
+      /// Tests that the nearest triangle is visible, regardless of the order
+      /// the triangles are added.
+      TEST_METHOD(TestDepthBuffer)
+      {
+         const Uint32 nearColor = 0xff0000ff;
+         const Uint32 farColor = 0xff00ff00;
+
+         SoftwareRasterizer rasterizer;
+         rasterizer.Init(64, 64, 1);
+         SetupCamera(rasterizer);
+
+         for (bool nearFirst : { false, true })
+         {
+            rasterizer.BeginFrame(c_clearColor);
+
+            if (nearFirst)
+               AddQuad(rasterizer, 1.0, -0.5, -0.5, 0.5, 0.5, nullptr, nearColor);
+
+            AddQuad(rasterizer, 4.0, -1.0, -1.0, 1.0, 1.0, nullptr, farColor);
+
+            if (!nearFirst)
+               AddQuad(rasterizer, 1.0, -0.5, -0.5, 0.5, 0.5, nullptr, nearColor);
+
+            rasterizer.EndFrame();
+
+            const std::vector<Uint32>& colorBuffer = rasterizer.GetColorBuffer();
+            Assert::AreEqual(nearColor, colorBuffer[32 * 64 + 32]);
+            Assert::AreEqual(farColor, colorBuffer[2 * 64 + 2]);
+         }
+      }
+
+      /// Tests that texels with low alpha values don't write to the color
+      /// and depth buffers.
+      TEST_METHOD(TestAlphaTest)
+      {
+         const Uint32 farColor = 0xff00ff00;
+
+         SoftwareTexture texture;
+         texture.m_xres = 2;
+         texture.m_yres = 1;
+         texture.m_texels = { 0x00ffffff, 0xff0000ff };
+
+         SoftwareRasterizer rasterizer;
+         rasterizer.Init(64, 64, 1);
+         SetupCamera(rasterizer);
+
+         rasterizer.BeginFrame(c_clearColor);
+         AddQuad(rasterizer, 1.0, -1.0, -1.0, 1.0, 1.0, &texture, 0xffffffff);
+         AddQuad(rasterizer, 4.0, -1.0, -1.0, 1.0, 1.0, nullptr, farColor);
+         rasterizer.EndFrame();
+
+         const std::vector<Uint32>& colorBuffer = rasterizer.GetColorBuffer();
+         Assert::AreEqual(farColor, colorBuffer[32 * 64 + 8], L"transparent texel must not hide far quad");
+         Assert::AreEqual(texture.m_texels[1], colorBuffer[32 * 64 + 56]);
+      }
+
+      /// Tests that pixels on the edge shared by two triangles are drawn
+      /// exactly once, and that there are no gaps between the triangles.
+      TEST_METHOD(TestSharedEdges)
+      {
+         SoftwareRasterizer rasterizer;
+         rasterizer.Init(64, 64, 1);
+         SetupCamera(rasterizer);
+
+         // quad from pixel 16 to 40; the diagonal passes through pixel centers
+         SoftwareVertex vertex0 = CreateVertex(1.0, -0.5, -0.25);
+         SoftwareVertex vertex1 = CreateVertex(1.0, 0.25, -0.25);
+         SoftwareVertex vertex2 = CreateVertex(1.0, 0.25, 0.5);
+         SoftwareVertex vertex3 = CreateVertex(1.0, -0.5, 0.5);
+
+         rasterizer.BeginFrame(c_clearColor);
+         rasterizer.AddTriangle(vertex0, vertex1, vertex2, nullptr);
+         rasterizer.EndFrame();
+         size_t numFirstPixels = CountCoveredPixels(rasterizer);
+
+         rasterizer.BeginFrame(c_clearColor);
+         rasterizer.AddTriangle(vertex0, vertex2, vertex3, nullptr);
+         rasterizer.EndFrame();
+         size_t numSecondPixels = CountCoveredPixels(rasterizer);
+
+         rasterizer.BeginFrame(c_clearColor);
+         rasterizer.AddTriangle(vertex0, vertex1, vertex2, nullptr);
+         rasterizer.AddTriangle(vertex0, vertex2, vertex3, nullptr);
+         rasterizer.EndFrame();
+         size_t numQuadPixels = CountCoveredPixels(rasterizer);
+
+         Assert::AreEqual(size_t(24 * 24), numQuadPixels, L"quad must have no gaps");
+         Assert::AreEqual(numQuadPixels, numFirstPixels + numSecondPixels,
+            L"shared edge pixels must be drawn only once");
+      }
+
+      /// Tests that triangles reaching behind the camera are clipped against
+      /// the near plane.
+      TEST_METHOD(TestNearPlaneClipping)
+      {
+         SoftwareRasterizer rasterizer;
+         rasterizer.Init(64, 64, 1);
+         SetupCamera(rasterizer);
+
+         // floor below the camera, reaching from behind to in front of it
+         SoftwareVertex vertex0, vertex1, vertex2, vertex3;
+         vertex0.m_pos.Set(-4.0, -4.0, -0.5);
+         vertex1.m_pos.Set(8.0, -4.0, -0.5);
+         vertex2.m_pos.Set(8.0, 4.0, -0.5);
+         vertex3.m_pos.Set(-4.0, 4.0, -0.5);
+
+         rasterizer.BeginFrame(c_clearColor);
+         rasterizer.AddTriangle(vertex0, vertex1, vertex2, nullptr, 0xffffffff, false);
+         rasterizer.AddTriangle(vertex0, vertex2, vertex3, nullptr, 0xffffffff, false);
+         rasterizer.EndFrame();
+
+         const std::vector<Uint32>& colorBuffer = rasterizer.GetColorBuffer();
+
+         for (unsigned int x = 0; x < 64; x++)
+         {
+            Assert::AreEqual(c_clearColor, colorBuffer[x], L"floor must not be visible above horizon");
+            Assert::AreEqual(0xffffffffu, colorBuffer[63 * 64 + x], L"floor must be visible below camera");
+         }
+      }
+
+      /// Tests that rendering with multiple threads produces exactly the same
+      /// image as rendering with a single thread.
+      TEST_METHOD(TestMultipleThreadsMatchSingleThread)
+      {
+         SoftwareTexture texture;
+         texture.m_xres = 4;
+         texture.m_yres = 4;
+         for (unsigned int index = 0; index < 16; index++)
+            texture.m_texels.push_back(0xff000000 | (index * 0x0f0f0f));
+
+         auto renderScene = [&](SoftwareRasterizer& rasterizer)
+         {
+            SetupCamera(rasterizer);
+            rasterizer.SetFogDensity(0.2);
+            rasterizer.BeginFrame(c_clearColor);
+
+            // overlapping quads at the same depth, so that the order matters
+            for (unsigned int index = 0; index < 200; index++)
+            {
+               double left = -1.2 + (index % 17) * 0.11;
+               double bottom = -1.2 + (index % 13) * 0.15;
+               double distance = 1.0 + (index % 3);
+
+               AddQuad(rasterizer, distance, left, bottom, left + 0.7, bottom + 0.6,
+                  &texture, 0xff000000 | (index * 0x010305));
+            }
+
+            rasterizer.EndFrame();
+         };
+
+         SoftwareRasterizer singleThreaded;
+         singleThreaded.Init(200, 120, 1);
+         renderScene(singleThreaded);
+
+         SoftwareRasterizer multiThreaded;
+         multiThreaded.Init(200, 120, 4);
+         Assert::AreEqual(4u, multiThreaded.GetNumThreads());
+
+         for (unsigned int run = 0; run < 3; run++)
+         {
+            renderScene(multiThreaded);
+
+            Assert::IsTrue(singleThreaded.GetColorBuffer() == multiThreaded.GetColorBuffer(),
+               L"color buffers must match");
+         }
+      }
+   };
+} // namespace UnitTest
@@ -0,0 +1,93 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextLayoutCacheTest.cpp
+/// \brief TextLayoutCache test
+//
+#include "pch.hpp"
+#include "TextLayoutCache.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief TextLayoutCache class tests
+   /// Tests storing, finding and evicting text images.
+   TEST_CLASS(TextLayoutCacheTest)
+   {
+      /// creates a text image with given width
+      static IndexedImage CreateTextImage(unsigned int width)
+      {
+         IndexedImage image;
+         image.Create(width, 6);
+         return image;
+      }
+
+      /// Tests that stored images are found again, keyed by font and text.
+      TEST_METHOD(TestStoreAndFind)
+      {
+         TextLayoutCache cache;
+
+         Assert::IsNull(cache.Find(fontNormal, "Hello"), L"image must not be cached yet");
+
+         cache.Store(fontNormal, "Hello", CreateTextImage(20));
+
+         const IndexedImage* image = cache.Find(fontNormal, "Hello");
+         Assert::IsNotNull(image, L"image must be cached");
+         Assert::AreEqual(20u, image->GetXRes(), L"image width must match");
+
+         Assert::IsNull(cache.Find(fontBig, "Hello"), L"image of other font must not be found");
+         Assert::IsNull(cache.Find(fontNormal, "Hello!"), L"image of other text must not be found");
+      }
+
+      /// Tests that the least recently used image is evicted when the cache
+      /// is full.
+      TEST_METHOD(TestEvictLeastRecentlyUsed)
+      {
+         TextLayoutCache cache{ 2 };
+
+         cache.Store(fontNormal, "first", CreateTextImage(1));
+         cache.Store(fontNormal, "second", CreateTextImage(2));
+
+         // use first image, so that the second one is the least recently used
+         Assert::IsNotNull(cache.Find(fontNormal, "first"), L"first image must be cached");
+
+         cache.Store(fontNormal, "third", CreateTextImage(3));
+
+         Assert::AreEqual(size_t(2), cache.GetSize(), L"cache must not grow beyond max. size");
+         Assert::IsNotNull(cache.Find(fontNormal, "first"), L"first image must still be cached");
+         Assert::IsNull(cache.Find(fontNormal, "second"), L"second image must be evicted");
+         Assert::IsNotNull(cache.Find(fontNormal, "third"), L"third image must be cached");
+      }
+
+      /// Tests that storing an image again replaces the cached image.
+      TEST_METHOD(TestStoreReplacesImage)
+      {
+         TextLayoutCache cache;
+
+         cache.Store(fontNormal, "text", CreateTextImage(1));
+         cache.Store(fontNormal, "text", CreateTextImage(5));
+
+         Assert::AreEqual(size_t(1), cache.GetSize(), L"cache must contain one image");
+         Assert::AreEqual(5u, cache.Find(fontNormal, "text")->GetXRes(), L"image must be replaced");
+
+         cache.Clear();
+         Assert::AreEqual(size_t(0), cache.GetSize(), L"cache must be empty");
+      }
+   };
+} // namespace UnitTest
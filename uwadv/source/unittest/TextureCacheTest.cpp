@@ -0,0 +1,141 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file TextureCacheTest.cpp
+/// \brief TextureCache test
+//
+#include "pch.hpp"
+#include "TextureCache.hpp"
+#include "Settings.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief TextureCache class tests
+   /// Tests the on-disk cache for scaled textures.
+   TEST_CLASS(TextureCacheTest)
+   {
+      /// returns settings that use given folder as texture cache folder
+      static Base::Settings GetCacheSettings(const TempFolder& testFolder, int cacheSizeMegabytes)
+      {
+         Base::Settings settings;
+         settings.SetValue(Base::settingTextureCacheFolder, testFolder.GetPathName() + "/");
+         settings.SetValue(Base::settingTextureCacheSize, cacheSizeMegabytes);
+         return settings;
+      }
+
+      /// Tests that the cache key depends on pixels, palette and scale factor.
+      TEST_METHOD(TestCalcKey)
+      {
+         std::vector<Uint8> pixels(16 * 16, 1);
+         std::vector<Uint8> palette(256 * 4, 0x80);
+
+         Uint64 key1 = TextureCache::CalcKey(pixels.data(), 16, 16, palette.data(), 2);
+         Uint64 key2 = TextureCache::CalcKey(pixels.data(), 16, 16, palette.data(), 4);
+
+         pixels[42] = 2;
+         Uint64 key3 = TextureCache::CalcKey(pixels.data(), 16, 16, palette.data(), 2);
+
+         palette[4] = 0x81;
+         Uint64 key4 = TextureCache::CalcKey(pixels.data(), 16, 16, palette.data(), 2);
+
+         Assert::AreNotEqual(key1, key2, L"scale factor must change key");
+         Assert::AreNotEqual(key1, key3, L"pixels must change key");
+         Assert::AreNotEqual(key3, key4, L"palette must change key");
+      }
+
+      /// Tests storing texels and loading them again, also after re-opening
+      /// the cache.
+      TEST_METHOD(TestStoreAndLoad)
+      {
+         TempFolder testFolder;
+         Base::Settings settings = GetCacheSettings(testFolder, 1);
+
+         std::vector<Uint32> texels(64 * 64);
+         for (size_t index = 0; index < texels.size(); index++)
+            texels[index] = static_cast<Uint32>(index * 0x01020304);
+
+         {
+            TextureCache cache;
+            cache.Init(settings);
+            Assert::IsTrue(cache.IsEnabled());
+
+            std::vector<Uint32> loaded(texels.size());
+            Assert::IsFalse(cache.Load(0x1234, loaded.data(), loaded.size()), L"cache must be empty");
+
+            cache.Store(0x1234, texels.data(), texels.size());
+
+            Assert::IsTrue(cache.Load(0x1234, loaded.data(), loaded.size()));
+            Assert::IsTrue(texels == loaded, L"loaded texels must be equal");
+         }
+
+         TextureCache cache;
+         cache.Init(settings);
+
+         std::vector<Uint32> loaded(texels.size());
+         Assert::IsTrue(cache.Load(0x1234, loaded.data(), loaded.size()), L"texels must be cached after re-opening");
+         Assert::IsTrue(texels == loaded, L"loaded texels must be equal");
+
+         Assert::IsFalse(cache.Load(0x1234, loaded.data(), loaded.size() / 2), L"texel count must match");
+      }
+
+      /// Tests that the least recently used textures are evicted when the cache
+      /// size is exceeded.
+      TEST_METHOD(TestLeastRecentlyUsedEviction)
+      {
+         TempFolder testFolder;
+
+         TextureCache cache;
+         cache.Init(GetCacheSettings(testFolder, 1));
+
+         // each entry has 256 kB, so only three entries fit into the cache
+         std::vector<Uint32> texels(256 * 256, 0xff00ff00);
+         std::vector<Uint32> loaded(texels.size());
+
+         cache.Store(1, texels.data(), texels.size());
+         cache.Store(2, texels.data(), texels.size());
+         cache.Store(3, texels.data(), texels.size());
+
+         // use entry 1, so that entry 2 is the least recently used one
+         Assert::IsTrue(cache.Load(1, loaded.data(), loaded.size()));
+
+         cache.Store(4, texels.data(), texels.size());
+
+         Assert::IsTrue(cache.Load(1, loaded.data(), loaded.size()));
+         Assert::IsFalse(cache.Load(2, loaded.data(), loaded.size()), L"least recently used entry must be evicted");
+         Assert::IsTrue(cache.Load(3, loaded.data(), loaded.size()));
+         Assert::IsTrue(cache.Load(4, loaded.data(), loaded.size()));
+      }
+
+      /// Tests that a cache size of 0 disables the cache.
+      TEST_METHOD(TestDisabledCache)
+      {
+         TempFolder testFolder;
+
+         TextureCache cache;
+         cache.Init(GetCacheSettings(testFolder, 0));
+
+         Assert::IsFalse(cache.IsEnabled());
+
+         std::vector<Uint32> texels(16 * 16, 0);
+         cache.Store(1, texels.data(), texels.size());
+         Assert::IsFalse(cache.Load(1, texels.data(), texels.size()));
+      }
+   };
+} // namespace UnitTest
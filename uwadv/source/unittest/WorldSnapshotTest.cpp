@@ -0,0 +1,117 @@
+//
+// Underworld Adventures - an Ultima Underworld remake project
+// Copyright (c) 2022 Underworld Adventures Team
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+/// \file WorldSnapshotTest.cpp
+/// \brief WorldSnapshot test
+//
+#include "pch.hpp"
+#include "WorldSnapshot.hpp"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UnitTest
+{
+   /// \brief WorldSnapshot class tests
+   /// Tests interpolating between snapshots of two simulation ticks.
+   TEST_CLASS(WorldSnapshotTest)
+   {
+      /// creates a snapshot with given player pose and one NPC object
+      static WorldSnapshot CreateSnapshot(double xpos, double ypos, double rotateAngle, Vector3d npcPos)
+      {
+         WorldSnapshot snapshot;
+         snapshot.m_level = 1;
+         snapshot.m_playerPos.Set(xpos, ypos, 0.5);
+         snapshot.m_panAngle = 0.0;
+         snapshot.m_rotateAngle = rotateAngle;
+         snapshot.m_objectPositions.push_back(WorldSnapshot::ObjectPosition{ 42, npcPos });
+         return snapshot;
+      }
+
+      /// Tests interpolating player position and object positions.
+      TEST_METHOD(TestInterpolatePositions)
+      {
+         WorldSnapshot previous = CreateSnapshot(32.0, 32.0, 90.0, Vector3d(10.0, 10.0, 8.0));
+         WorldSnapshot current = CreateSnapshot(33.0, 32.5, 90.0, Vector3d(11.0, 10.0, 8.0));
+
+         WorldSnapshot snapshot;
+         snapshot.Interpolate(previous, current, 0.5);
+
+         Assert::AreEqual(32.5, snapshot.m_playerPos.x, 1e-6);
+         Assert::AreEqual(32.25, snapshot.m_playerPos.y, 1e-6);
+         Assert::IsNotNull(snapshot.GetObjectPosition(42));
+         Assert::AreEqual(10.5, snapshot.GetObjectPosition(42)->x, 1e-6);
+         Assert::IsNull(snapshot.GetObjectPosition(41), L"object without position must return null");
+         Assert::IsNull(snapshot.GetObjectPosition(1000), L"object after last position must return null");
+
+         snapshot.Interpolate(previous, current, 0.0);
+         Assert::AreEqual(32.0, snapshot.m_playerPos.x, 1e-6, L"factor 0.0 must return previous pose");
+
+         snapshot.Interpolate(previous, current, 1.0);
+         Assert::AreEqual(33.0, snapshot.m_playerPos.x, 1e-6, L"factor 1.0 must return current pose");
+      }
+
+      /// Tests that objects are only interpolated when in both snapshots.
+      TEST_METHOD(TestInterpolateObjectsInOneSnapshot)
+      {
+         WorldSnapshot previous = CreateSnapshot(32.0, 32.0, 0.0, Vector3d(10.0, 10.0, 8.0));
+         previous.m_objectPositions.insert(previous.m_objectPositions.begin(),
+            WorldSnapshot::ObjectPosition{ 7, Vector3d(4.0, 4.0, 0.0) });
+
+         WorldSnapshot current = CreateSnapshot(32.0, 32.0, 0.0, Vector3d(11.0, 10.0, 8.0));
+         current.m_objectPositions.push_back(WorldSnapshot::ObjectPosition{ 50, Vector3d(20.0, 20.0, 0.0) });
+
+         WorldSnapshot snapshot;
+         snapshot.Interpolate(previous, current, 0.5);
+
+         Assert::IsNull(snapshot.GetObjectPosition(7), L"object only in previous snapshot must return null");
+         Assert::AreEqual(10.5, snapshot.GetObjectPosition(42)->x, 1e-6);
+         Assert::IsNotNull(snapshot.GetObjectPosition(50));
+         Assert::AreEqual(20.0, snapshot.GetObjectPosition(50)->x, 1e-6, L"new object must use current position");
+      }
+
+      /// Tests that the rotate angle is interpolated the shorter way around.
+      TEST_METHOD(TestInterpolateAngleWrapAround)
+      {
+         WorldSnapshot previous = CreateSnapshot(32.0, 32.0, 350.0, Vector3d());
+         WorldSnapshot current = CreateSnapshot(32.0, 32.0, 10.0, Vector3d());
+
+         WorldSnapshot snapshot;
+         snapshot.Interpolate(previous, current, 0.5);
+
+         double angle = fmod(snapshot.m_rotateAngle + 360.0, 360.0);
+         Assert::AreEqual(0.0, angle, 1e-6, L"angle must be interpolated across 0 degrees");
+      }
+
+      /// Tests that teleporting and changing levels isn't interpolated.
+      TEST_METHOD(TestNoInterpolationWhenTeleporting)
+      {
+         WorldSnapshot previous = CreateSnapshot(32.0, 32.0, 0.0, Vector3d());
+         WorldSnapshot current = CreateSnapshot(10.0, 50.0, 0.0, Vector3d());
+
+         WorldSnapshot snapshot;
+         snapshot.Interpolate(previous, current, 0.5);
+         Assert::AreEqual(10.0, snapshot.m_playerPos.x, 1e-6, L"teleport must not be interpolated");
+
+         current = CreateSnapshot(32.5, 32.0, 0.0, Vector3d());
+         current.m_level = 2;
+
+         snapshot.Interpolate(previous, current, 0.5);
+         Assert::AreEqual(32.5, snapshot.m_playerPos.x, 1e-6, L"level change must not be interpolated");
+      }
+   };
+} // namespace UnitTest
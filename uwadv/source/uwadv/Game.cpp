@@ -302,6 +302,8 @@ void Game::UpdateCaption(const char* windowTitle)
 
 void Game::OnTick(bool& resetTickTimer)
 {
+   Base::PerformanceTimer tickTimer{ m_performanceCounters, Base::phaseTick };
+
    // do game logic
    m_currentScreen->Tick();
 
@@ -322,8 +324,24 @@ void Game::OnTick(bool& resetTickTimer)
 void Game::OnRender()
 {
    // draw the screen
-   m_currentScreen->Draw();
-   m_renderWindow->SwapBuffers();
+   {
+      Base::PerformanceTimer renderTimer{ m_performanceCounters, Base::phaseRender };
+      m_currentScreen->Draw();
+   }
+
+   // capture frame before the back buffer is swapped
+   {
+      int windowWidth = 0, windowHeight = 0;
+      m_renderWindow->GetWindowSize(windowWidth, windowHeight);
+      m_renderer.GetFrameCapture().NextFrame(windowWidth, windowHeight);
+   }
+
+   {
+      Base::PerformanceTimer swapTimer{ m_performanceCounters, Base::phaseSwap };
+      m_renderWindow->SwapBuffers();
+   }
+
+   m_performanceCounters.NextFrame();
 }
 
 void Game::Done()
@@ -380,6 +398,10 @@ void Game::InitSDL()
 
    m_renderer.SetViewport(m_viewport.get());
 
+   int maxFrameRate = std::max(0, m_settings.GetInt(Base::settingMaxFrameRate));
+   GetFramePacer().Init(static_cast<unsigned int>(maxFrameRate),
+      m_renderWindow->IsVsyncEnabled(), m_renderWindow->GetRefreshRate());
+
    Renderer::PrintOpenGLDiagnostics();
 }
 
@@ -24,6 +24,7 @@
 #include <SDL.h>
 #include "base/Settings.hpp"
 #include "base/ResourceManager.hpp"
+#include "base/PerformanceCounters.hpp"
 #include "ui/Screen.hpp"
 #include "audio/Audio.hpp"
 #include "ui/IndexedImage.hpp"
@@ -113,6 +114,11 @@ public:
       return m_userInterface;
    }
 
+   virtual Base::PerformanceCounters& GetPerformanceCounters() override
+   {
+      return m_performanceCounters;
+   }
+
    // IGame methods
    virtual void InitGame() override;
    virtual void DoneGame() override;
@@ -253,4 +259,7 @@ private:
 
    /// underworld debugger - server side
    DebugServer m_debugServer;
+
+   /// performance counters for the performance HUD
+   Base::PerformanceCounters m_performanceCounters;
 };
@@ -23,6 +23,7 @@
 #include "base/Settings.hpp"
 #include "base/ResourceManager.hpp"
 #include "base/TextFile.hpp"
+#include "base/PerformanceCounters.hpp"
 #include "script/IScripting.hpp"
 #include "underworld/Underworld.hpp"
 #include "import/Import.hpp"
@@ -62,6 +63,7 @@ public:
    virtual Underworld::Underworld& GetUnderworld() override { return m_gameLogic->GetUnderworld(); }
    virtual Underworld::GameLogic& GetGameLogic() override { return *m_gameLogic.get(); }
    virtual IUserInterface* GetUserInterface() override { return this; }
+   virtual Base::PerformanceCounters& GetPerformanceCounters() override { return m_performanceCounters; }
 
    // virtual IGame methods
    virtual void InitGame();
@@ -119,6 +121,9 @@ private:
    /// underworld debugger - server side
    DebugServer m_debugServer;
 
+   /// performance counters; never enabled
+   Base::PerformanceCounters m_performanceCounters;
+
    /// game strings
    GameStrings m_gameStrings;
 